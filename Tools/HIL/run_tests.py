@@ -133,6 +133,9 @@ class TestHardwareMethods(unittest.TestCase):
     def test_microbench_hrt(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "microbench_hrt"))
 
+    def test_microbench_kalman(self):
+        self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "microbench_kalman"))
+
     def test_microbench_math(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "microbench_math"))
 
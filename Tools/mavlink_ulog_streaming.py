@@ -28,8 +28,13 @@ except ImportError as e:
 class MavlinkLogStreaming():
     '''Streams log data via MAVLink.
        Assumptions:
-       - the sender only sends one acked message at a time
+       - the sender can have several acked messages in flight, which might
+         arrive out of order: they are reordered by sequence
        - the data is in the ULog format '''
+
+    REORDER_TIMEOUT = 0.5 # [s] give up waiting for a missing sequence after this
+    REORDER_MAX_PENDING = 64 # maximum number of messages waiting for a missing sequence
+
     def __init__(self, portname, baudrate, output_filename, debug=0):
         self.baudrate = 0
         self._debug = debug
@@ -46,6 +51,8 @@ class MavlinkLogStreaming():
         self.file = open(output_filename,'wb')
         self.start_time = timer()
         self.last_sequence = -1
+        self.pending = {} # sequence: (data, first message start), received out of order
+        self.pending_since = 0
         self.logging_started = False
         self.num_dropouts = 0
         self.target_component = 1
@@ -83,8 +90,7 @@ class MavlinkLogStreaming():
                         mavutil.mavlink.MAV_AUTOPILOT_GENERIC, 0, 0, 0)
                 next_heartbeat_time = heartbeat_time + 1
 
-            m, first_msg_start, num_drops = self.read_message()
-            if m is not None:
+            for m, first_msg_start, num_drops in self.read_message():
                 self.process_streamed_ulog_data(m, first_msg_start, num_drops)
 
                 # status output
@@ -104,8 +110,8 @@ class MavlinkLogStreaming():
 
 
     def read_message(self):
-        ''' read a single mavlink message, handle ACK & return a tuple of (data, first
-        message start, num dropouts) '''
+        ''' read a single mavlink message, handle ACK & return a list of tuples of
+        (data, first message start, num dropouts) that are ready, in sequence order '''
         m = self.mav.recv_match(type=['LOGGING_DATA_ACKED',
                             'LOGGING_DATA', 'COMMAND_ACK'], blocking=True,
                             timeout=0.05)
@@ -120,7 +126,7 @@ class MavlinkLogStreaming():
                         print('Logging started. Waiting for Header...')
                     else:
                         raise Exception('Logging start failed', m.result)
-                return None, 0, 0
+                return []
 
             # m is either 'LOGGING_DATA_ACKED' or 'LOGGING_DATA':
             is_newer, num_drops = self.check_sequence(m.sequence)
@@ -132,29 +138,65 @@ class MavlinkLogStreaming():
                         self.target_component, m.sequence)
 
             if is_newer:
-                if num_drops > 0:
-                    self.num_dropouts += num_drops
-
                 if m.get_type() == 'LOGGING_DATA':
                     if not self.got_header_section:
                         print('Header received in {:0.2f}s'.format(timer()-self.start_time))
                         self.logging_started = True
                         self.got_header_section = True
-                self.last_sequence = m.sequence
-                return m.data[:m.length], m.first_message_offset, num_drops
 
-            else:
-                self.debug('dup/reordered message '+str(m.sequence))
+                if num_drops == 0 or self.last_sequence == -1:
+                    self.last_sequence = m.sequence
+                    return [(m.data[:m.length], m.first_message_offset, 0)] + \
+                        self.pop_pending(False)
 
-        return None, 0, 0
+                # a gap: wait for the missing messages (retransmission or reordering)
+                if len(self.pending) == 0:
+                    self.pending_since = timer()
+                self.pending[m.sequence] = (m.data[:m.length], m.first_message_offset)
+
+            else:
+                self.debug('dup/old message '+str(m.sequence))
+
+        return self.pop_pending(False)
+
+
+    def pop_pending(self, force):
+        ''' return pending messages that are now in sequence. If the gap does not
+        get filled in time, give up and count it as dropouts '''
+        ret = []
+        if len(self.pending) == 0:
+            return ret
+        if not force and (len(self.pending) > self.REORDER_MAX_PENDING or
+                          timer() - self.pending_since > self.REORDER_TIMEOUT):
+            force = True
+        while len(self.pending) > 0:
+            next_sequence = (self.last_sequence + 1) & 0xffff
+            if next_sequence in self.pending:
+                data, first_msg_start = self.pending.pop(next_sequence)
+                ret.append((data, first_msg_start, 0))
+                self.last_sequence = next_sequence
+            elif force:
+                # skip to the oldest pending message
+                seq = min(self.pending, key=lambda s: (s - next_sequence) & 0xffff)
+                num_drops = (seq - next_sequence) & 0xffff
+                self.num_dropouts += num_drops
+                data, first_msg_start = self.pending.pop(seq)
+                ret.append((data, first_msg_start, num_drops))
+                self.last_sequence = seq
+                force = False
+            else:
+                break
+        if len(self.pending) > 0 and len(ret) > 0:
+            self.pending_since = timer()
+        return ret
 
 
     def check_sequence(self, seq):
         ''' check if a sequence is newer than the previously received one & if
-        there were dropped messages between the last and this '''
+        there were dropped (or not yet received) messages between the last and this '''
         if self.last_sequence == -1:
             return True, 0
-        if seq == self.last_sequence: # duplicate
+        if seq == self.last_sequence or seq in self.pending: # duplicate
             return False, 0
         if seq > self.last_sequence:
             # account for wrap-arounds, sequence is 2 bytes
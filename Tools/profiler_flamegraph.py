@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+
+"""
+Turn the profiler_sample messages of a ULog file (see the profiler module) into
+folded stacks, the input format of flamegraph.pl
+(https://github.com/brendangregg/FlameGraph) and https://www.speedscope.app.
+
+Each stack starts with the work queue and work item that were running when the
+sample was taken, followed by the functions from the outermost to the innermost.
+Addresses are resolved with addr2line against the given ELF file (the px4 binary
+for SITL, the .elf for NuttX boards).
+
+Example:
+  ./Tools/profiler_flamegraph.py log.ulg -e build/px4_sitl_default/bin/px4 > stacks.folded
+  flamegraph.pl stacks.folded > flamegraph.svg
+"""
+
+from __future__ import print_function
+
+import argparse
+import collections
+import subprocess
+import sys
+
+try:
+    from pyulog import ULog
+except ImportError as e:
+    print("Failed to import pyulog: " + str(e))
+    print("")
+    print("You may need to install it using:")
+    print("    pip3 install --user pyulog")
+    print("")
+    sys.exit(1)
+
+
+def read_samples(ulog_file):
+    """ return a list of (thread label, [addresses innermost first]) """
+    ulog = ULog(ulog_file, ['profiler_sample'])
+    samples = []
+    dropped = 0
+
+    for d in ulog.data_list:
+        data = d.data
+        count = len(data['timestamp'])
+
+        for i in range(count):
+            wq_name = ulog_string(data, 'wq_name', i)
+            item_name = ulog_string(data, 'item_name', i)
+
+            if wq_name:
+                label = [wq_name, item_name if item_name else '[idle]']
+            else:
+                label = ['tid ' + str(data['tid'][i])]
+
+            depth = data['depth'][i]
+            addresses = [int(data['addresses[{:}]'.format(k)][i]) for k in range(depth)]
+            samples.append((label, addresses))
+            dropped += data['dropped'][i]
+
+    return samples, dropped
+
+
+def ulog_string(data, field, index):
+    """ reassemble a char[] field (stored as one column per character) """
+    chars = []
+    k = 0
+
+    while '{:}[{:}]'.format(field, k) in data:
+        c = int(data['{:}[{:}]'.format(field, k)][index])
+
+        if c == 0:
+            break
+
+        chars.append(chr(c))
+        k += 1
+
+    return ''.join(chars)
+
+
+def symbolize(elf, addresses, addr2line):
+    """ map addresses to function names using addr2line """
+    addresses = sorted(addresses)
+    names = {}
+
+    if not elf or not addresses:
+        return {a: '0x{:x}'.format(a) for a in addresses}
+
+    query = '\n'.join('0x{:x}'.format(a) for a in addresses) + '\n'
+    result = subprocess.run([addr2line, '-f', '-C', '-e', elf], input=query,
+                            stdout=subprocess.PIPE, universal_newlines=True, check=True)
+    lines = result.stdout.splitlines()
+
+    # two output lines per address: function and file:line
+    for i, address in enumerate(addresses):
+        name = lines[2 * i] if 2 * i < len(lines) else '??'
+        names[address] = name if name != '??' else '0x{:x}'.format(address)
+
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert profiler samples of a ULog file to folded stacks')
+    parser.add_argument('ulog', help='ULog file')
+    parser.add_argument('-e', '--elf', help='ELF file to resolve the addresses with (default: print raw addresses)')
+    parser.add_argument('-o', '--output', help='output file (default: stdout)')
+    parser.add_argument('--addr2line', default='addr2line',
+                        help='addr2line binary, e.g. arm-none-eabi-addr2line for NuttX targets')
+    parser.add_argument('--no-items', action='store_true',
+                        help='do not prefix the stacks with the work queue and work item')
+    args = parser.parse_args()
+
+    samples, dropped = read_samples(args.ulog)
+
+    if not samples:
+        print('no profiler_sample messages in ' + args.ulog, file=sys.stderr)
+        return 1
+
+    # return addresses point after the call instruction: look up the call itself
+    lookup = set()
+
+    for _, addresses in samples:
+        for k, address in enumerate(addresses):
+            lookup.add(address if k == 0 else address - 1)
+
+    names = symbolize(args.elf, lookup, args.addr2line)
+
+    stacks = collections.Counter()
+
+    for label, addresses in samples:
+        frames = [names[address if k == 0 else address - 1] for k, address in enumerate(addresses)]
+        frames.reverse()
+
+        if not args.no_items:
+            frames = label + frames
+
+        stacks[';'.join(f.replace(';', ':') for f in frames)] += 1
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+
+    for stack, count in sorted(stacks.items()):
+        out.write('{:} {:}\n'.format(stack, count))
+
+    if args.output:
+        out.close()
+
+    print('{:} samples, {:} dropped'.format(len(samples), dropped), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+
+"""
+Lockstep step-rate benchmark of the SITL simulator interface.
+
+Stands in for the simulator: it listens on the simulator TCP port, sends the
+HIL_SENSOR messages of a step and waits for the HIL_ACTUATOR_CONTROLS of that
+step before the next one. The vehicle sits level on the ground, PX4 runs as
+fast as it can and the result is the number of lockstep steps per second and
+the round trip time of a step.
+
+Usage:
+    Tools/sitl_step_benchmark.py --duration 30
+    make px4_sitl none_iris    # in another terminal
+"""
+
+from __future__ import print_function
+import os
+import socket
+import sys
+import time
+from argparse import ArgumentParser
+
+os.environ['MAVLINK20'] = '1'
+
+try:
+    from pymavlink.dialects.v20 import common as mavlink2
+except ImportError as e:
+    print("Failed to import pymavlink: " + str(e))
+    print("")
+    print("You may need to install it with:")
+    print("    pip3 install --user pymavlink")
+    print("")
+    sys.exit(1)
+
+
+FIELDS_IMU = 0b111111           # accel and gyro
+FIELDS_ALL = 0b1111111111111    # accel, gyro, mag, baro, differential pressure
+
+
+class StandInSimulator():
+    def __init__(self, port, rate, batch, timeout):
+        self.dt_us = int(1e6 / rate)
+        self.batch = batch
+        self.timeout = timeout
+        self.time_usec = 1000000
+        self.mav = mavlink2.MAVLink(None, srcSystem=1, srcComponent=51)
+        self.mav.robust_parsing = True
+
+        server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind(('127.0.0.1', port))
+        server.listen(1)
+        print("Waiting for PX4 to connect on TCP port %u" % port)
+        self.sock, _ = server.accept()
+        server.close()
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        print("PX4 connected")
+
+        self.controls = 0
+
+    def pack(self, msg):
+        data = msg.pack(self.mav)
+        self.mav.seq = (self.mav.seq + 1) % 256
+        return data
+
+    def send_step(self):
+        """ HIL_SENSOR messages of one step in one packet, mag and baro with the last one """
+        packet = b''
+
+        for k in range(self.batch):
+            self.time_usec += self.dt_us
+            fields = FIELDS_ALL if k == self.batch - 1 else FIELDS_IMU
+            packet += self.pack(self.mav.hil_sensor_encode(
+                self.time_usec, 0., 0., -9.81, 0., 0., 0., 0.21, 0., 0.42,
+                1013.25, 0., 0., 20., fields))
+
+        self.sock.sendall(packet)
+
+    def receive(self, timeout):
+        """ @return the number of HIL_ACTUATOR_CONTROLS received within the timeout """
+        self.sock.settimeout(timeout)
+
+        try:
+            data = self.sock.recv(4096)
+
+        except socket.timeout:
+            return 0
+
+        if not data:
+            raise ConnectionError("PX4 disconnected")
+
+        received = 0
+
+        for msg in self.mav.parse_buffer(data) or []:
+            if msg.get_type() == 'HIL_ACTUATOR_CONTROLS':
+                received += 1
+
+        self.controls += received
+        return received
+
+    def step(self):
+        """ @return round trip time [s], None on a timeout """
+        start = time.perf_counter()
+        self.send_step()
+        deadline = start + self.timeout
+
+        while True:
+            remaining = deadline - time.perf_counter()
+
+            if remaining <= 0:
+                return None
+
+            if self.receive(remaining) > 0:
+                return time.perf_counter() - start
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument('--port', type=int, default=4560, help="simulator TCP port (default: 4560)")
+    parser.add_argument('--duration', type=float, default=30., help="measurement time [s] (default: 30)")
+    parser.add_argument('--warmup', type=float, default=10., help="time after the first controls excluded [s] (default: 10)")
+    parser.add_argument('--rate', type=float, default=250., help="IMU rate [Hz] (default: 250)")
+    parser.add_argument('--batch', type=int, default=1, help="HIL_SENSOR messages per step (default: 1)")
+    parser.add_argument('--timeout', type=float, default=0.5, help="wait for the controls of a step [s] (default: 0.5)")
+    args = parser.parse_args()
+
+    sim = StandInSimulator(args.port, args.rate, args.batch, args.timeout)
+
+    # run in real time until PX4 sends controls, then wait for the startup to settle
+    sim.receive(5.)
+
+    while sim.controls == 0:
+        sim.send_step()
+        sim.receive(sim.dt_us * args.batch * 1e-6)
+
+    print("Lockstep running, warming up for %.0f s" % args.warmup)
+    end = time.perf_counter() + args.warmup
+
+    while time.perf_counter() < end:
+        sim.step()
+
+    print("Measuring for %.0f s" % args.duration)
+    round_trips = []
+    timeouts = 0
+    sim_start = sim.time_usec
+    start = time.perf_counter()
+    end = start + args.duration
+
+    while time.perf_counter() < end:
+        rtt = sim.step()
+
+        if rtt is None:
+            timeouts += 1
+
+        else:
+            round_trips.append(rtt)
+
+    elapsed = time.perf_counter() - start
+    steps = len(round_trips) + timeouts
+
+    if not round_trips:
+        print("No controls received")
+        sys.exit(1)
+
+    round_trips.sort()
+    print("steps:            %u (%u timeouts)" % (steps, timeouts))
+    print("step rate:        %.1f steps/s" % (steps / elapsed))
+    print("realtime factor:  %.2f" % ((sim.time_usec - sim_start) * 1e-6 / elapsed))
+    print("round trip [us]:  mean %.0f, median %.0f, 99%% %.0f, max %.0f" % (
+        1e6 * sum(round_trips) / len(round_trips),
+        1e6 * round_trips[len(round_trips) // 2],
+        1e6 * round_trips[min(len(round_trips) - 1, int(0.99 * len(round_trips)))],
+        1e6 * round_trips[-1]))
+
+
+if __name__ == '__main__':
+    main()
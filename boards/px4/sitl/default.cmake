@@ -49,6 +49,7 @@ px4_add_board(
 		mc_rate_control
 		#micrortps_bridge
 		navigator
+		profiler
 		rc_update
 		replay
 		rover_pos_control
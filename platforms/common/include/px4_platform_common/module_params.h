@@ -75,22 +75,50 @@ protected:
 	/**
 	 * @brief Call this method whenever the module gets a parameter change notification.
 	 *        It will automatically call updateParams() for all children, which then call updateParamsImpl().
+	 *        updateParamsImpl() is skipped if none of the class' own parameters changed since the last call.
 	 */
 	virtual void updateParams()
 	{
+		const uint16_t generation = param_generation();
+		bool changed = !_param_generation_valid;
+
 		for (const auto &child : _children) {
 			child->updateParams();
+			changed = changed || child->paramsChanged();
+		}
+
+		if (!_param_generation_valid || paramsChangedSince(_param_generation)) {
+			updateParamsImpl();
+			changed = true;
 		}
 
-		updateParamsImpl();
+		_param_generation = generation;
+		_param_generation_valid = true;
+		_params_changed = changed;
 	}
 
+	/**
+	 * @brief Check if the last call to updateParams() changed any parameter of this class or its children.
+	 *        Can be used in an updateParams() override to skip expensive reconfiguration.
+	 */
+	bool paramsChanged() const { return _params_changed; }
+
 	/**
 	 * @brief The implementation for this is generated with the macro DEFINE_PARAMETERS()
 	 */
 	virtual void updateParamsImpl() {}
 
+	/**
+	 * @brief Check if any of the parameters of this class changed after the given generation.
+	 *        The implementation for this is generated with the macro DEFINE_PARAMETERS()
+	 */
+	virtual bool paramsChangedSince(uint16_t /* generation */) const { return false; }
+
 private:
 	/** @list _children The module parameter list of inheriting classes. */
 	List<ModuleParams *> _children;
+
+	uint16_t _param_generation{0};
+	bool _param_generation_valid{false};
+	bool _params_changed{false};
 };
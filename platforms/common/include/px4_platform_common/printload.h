@@ -59,6 +59,10 @@ struct print_load_s {
 	uint64_t interval_start_time{0};
 	uint64_t last_times[CONFIG_MAX_TASKS] {};
 	float interval_time_us{0.f};
+
+#if defined(__PX4_LINUX)
+	int last_tids[CONFIG_MAX_TASKS] {}; ///< thread id corresponding to last_times (in clock ticks)
+#endif
 };
 
 __BEGIN_DECLS
@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace px4
+{
+
+struct thread_perf_sample_t {
+	uint64_t cycles{0};
+	uint64_t instructions{0};
+	uint64_t cache_misses{0};
+	uint64_t context_switches{0};
+
+	thread_perf_sample_t &operator+=(const thread_perf_sample_t &rhs)
+	{
+		cycles += rhs.cycles;
+		instructions += rhs.instructions;
+		cache_misses += rhs.cache_misses;
+		context_switches += rhs.context_switches;
+		return *this;
+	}
+
+	thread_perf_sample_t operator-(const thread_perf_sample_t &rhs) const
+	{
+		thread_perf_sample_t result;
+		result.cycles = cycles - rhs.cycles;
+		result.instructions = instructions - rhs.instructions;
+		result.cache_misses = cache_misses - rhs.cache_misses;
+		result.context_switches = context_switches - rhs.context_switches;
+		return result;
+	}
+};
+
+/**
+ * CPU cycles, instructions, cache misses and context switches of the calling thread,
+ * using perf_event_open() on Linux. Not available on other platforms.
+ *
+ * Counters the kernel or the hardware does not support (e.g. in a VM) stay at 0.
+ */
+class ThreadPerfCounters
+{
+public:
+	ThreadPerfCounters() = default;
+	~ThreadPerfCounters() { close(); }
+
+	// no copy, assignment, move, move assignment
+	ThreadPerfCounters(const ThreadPerfCounters &) = delete;
+	ThreadPerfCounters &operator=(const ThreadPerfCounters &) = delete;
+	ThreadPerfCounters(ThreadPerfCounters &&) = delete;
+	ThreadPerfCounters &operator=(ThreadPerfCounters &&) = delete;
+
+	/**
+	 * Open the counters for the calling thread.
+	 * @return true if at least one counter is available
+	 */
+	bool open();
+
+	void close();
+
+	bool is_open() const { return _group_fd >= 0; }
+
+	/**
+	 * Read the current counter values (one system call for all counters).
+	 */
+	bool read(thread_perf_sample_t &sample) const;
+
+private:
+	enum Counter {
+		CYCLES = 0,
+		INSTRUCTIONS,
+		CACHE_MISSES,
+		CONTEXT_SWITCHES,
+		NUM_COUNTERS
+	};
+
+	int _group_fd{-1};
+	int _fds[NUM_COUNTERS] {-1, -1, -1, -1};
+	int8_t _group_index[NUM_COUNTERS] {-1, -1, -1, -1}; ///< position of each counter in the group read
+	uint8_t _num_open{0};
+};
+
+} // namespace px4
@@ -72,6 +72,11 @@ public:
 
 	virtual void print_run_status();
 
+	/**
+	 * Print the perf_event counters per run (if the work queue is profiled).
+	 */
+	void print_perf_status();
+
 	/**
 	 * Switch to a different WorkQueue.
 	 * NOTE: Caller is responsible for synchronization.
@@ -108,7 +113,7 @@ protected:
 		}
 	}
 
-	friend void WorkQueue::Run();
+	friend class WorkQueue;
 	virtual void Run() = 0;
 
 	/**
@@ -130,6 +135,10 @@ protected:
 	const char 	*_item_name;
 	uint32_t	_run_count{0};
 
+	// perf_event counters accumulated over all runs while the work queue is profiled
+	thread_perf_sample_t	_perf_sample{};
+	uint32_t		_perf_run_count{0};
+
 private:
 
 	WorkQueue	*_wq{nullptr};
@@ -34,6 +34,7 @@
 #pragma once
 
 #include "WorkQueueManager.hpp"
+#include "ThreadPerfCounters.hpp"
 
 #include <containers/BlockingList.hpp>
 #include <containers/List.hpp>
@@ -48,6 +49,8 @@ namespace px4
 
 class WorkItem;
 
+struct wq_running_slot_t;
+
 class WorkQueue : public IntrusiveSortedListNode<WorkQueue *>
 {
 public:
@@ -73,6 +76,12 @@ public:
 
 	void print_status(bool last = false);
 
+	/**
+	 * Call cb with the perf_event counters of the thread (item_name == nullptr) and then
+	 * of each work item, if the thread is being profiled.
+	 */
+	void for_each_perf_sample(wq_perf_sample_cb_t cb, void *arg);
+
 	// WorkQueues sorted numerically by relative priority (-1 to -255)
 	bool operator<=(const WorkQueue &rhs) const { return _config.relative_priority >= rhs.get_config().relative_priority; }
 
@@ -82,6 +91,12 @@ private:
 
 	inline void SignalWorkerThread();
 
+	void update_profiling();
+	void profile_item_run(WorkItem *item, const thread_perf_sample_t &before);
+
+	void register_running_slot();
+	void unregister_running_slot();
+
 #ifdef __PX4_NUTTX
 	// In NuttX work can be enqueued from an ISR
 	void work_lock() { _flags = enter_critical_section(); }
@@ -104,6 +119,18 @@ private:
 	int _lockstep_component {-1};
 #endif // ENABLE_LOCKSTEP_SCHEDULER
 
+	// perf_event profiling, only touched by the work queue thread (except _perf_thread_sample, protected by work_lock)
+	ThreadPerfCounters		_perf_counters;
+	thread_perf_sample_t		_perf_start;
+	thread_perf_sample_t		_perf_thread_sample;
+	uint32_t			_perf_run_count{0};
+	int				_perf_tid{-1};
+	bool				_perf_active{false};
+	bool				_perf_failed{false};
+
+	// entry in the running item table (see WorkQueueRunningItem()), only touched by the work queue thread
+	wq_running_slot_t		*_running_slot{nullptr};
+
 };
 
 } // namespace px4
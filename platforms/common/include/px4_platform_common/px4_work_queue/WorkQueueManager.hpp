@@ -35,6 +35,8 @@
 
 #include <stdint.h>
 
+#include "ThreadPerfCounters.hpp"
+
 namespace px4
 {
 
@@ -110,6 +112,46 @@ int WorkQueueManagerStop();
  */
 int WorkQueueManagerStatus();
 
+/**
+ * Enable or disable the perf_event profiling of all work queue threads and their work items
+ * (cycles, instructions, cache misses and context switches per WorkItem::Run()). Linux only.
+ *
+ * @return PX4_OK if supported
+ */
+int WorkQueueManagerProfile(bool enable);
+
+/**
+ * Whether profiling is enabled (see WorkQueueManagerProfile()).
+ */
+bool WorkQueueManagerProfiling();
+
+/**
+ * Profiling callback.
+ * @param wq_name work queue name
+ * @param tid thread id of the work queue
+ * @param item_name work item name, nullptr for the totals of the work queue thread
+ * @param sample counters accumulated since profiling was enabled
+ * @param run_count number of runs since profiling was enabled
+ */
+typedef void (*wq_perf_sample_cb_t)(const char *wq_name, int tid, const char *item_name,
+				    const thread_perf_sample_t &sample, uint32_t run_count, void *arg);
+
+/**
+ * Call cb for each profiled work queue thread and work item.
+ */
+void WorkQueueManagerForEachPerfSample(wq_perf_sample_cb_t cb, void *arg);
+
+/**
+ * Look up the work item a work queue thread is currently running. This does not take any
+ * locks and is safe to call from a signal handler or an interrupt (e.g. by a sampling profiler).
+ *
+ * @param tid thread id (Linux) or task id (NuttX) of the work queue thread
+ * @param wq_name set to the work queue name if tid belongs to a work queue thread
+ * @return the name of the work item being run, nullptr if tid is not a work queue thread or the
+ *  work queue is idle
+ */
+const char *WorkQueueRunningItem(int tid, const char **wq_name);
+
 /**
  * Create (or find) a work queue with a particular configuration.
  *
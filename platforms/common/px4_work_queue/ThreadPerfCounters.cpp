@@ -0,0 +1,145 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include <px4_platform_common/px4_work_queue/ThreadPerfCounters.hpp>
+
+#if defined(__PX4_LINUX)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+namespace px4
+{
+
+#if defined(__PX4_LINUX)
+
+static int perf_event_open(uint32_t type, uint64_t config, int group_fd)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	// hardware counters only for user space (allowed without privileges), context switches happen in the kernel
+	attr.exclude_kernel = (type == PERF_TYPE_HARDWARE);
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+
+	// calling thread, any CPU
+	return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+bool ThreadPerfCounters::open()
+{
+	close();
+
+	static constexpr struct {
+		uint32_t type;
+		uint64_t config;
+	} events[NUM_COUNTERS] = {
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+		{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+	};
+
+	// the first counter that can be opened becomes the group leader, so all are read at once
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		_fds[i] = perf_event_open(events[i].type, events[i].config, _group_fd);
+
+		if (_fds[i] >= 0) {
+			if (_group_fd < 0) {
+				_group_fd = _fds[i];
+			}
+
+			_group_index[i] = _num_open++;
+		}
+	}
+
+	if (_group_fd < 0) {
+		return false;
+	}
+
+	ioctl(_group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return true;
+}
+
+void ThreadPerfCounters::close()
+{
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		if (_fds[i] >= 0) {
+			::close(_fds[i]);
+			_fds[i] = -1;
+		}
+
+		_group_index[i] = -1;
+	}
+
+	_group_fd = -1;
+	_num_open = 0;
+}
+
+bool ThreadPerfCounters::read(thread_perf_sample_t &sample) const
+{
+	// PERF_FORMAT_GROUP: number of counters, followed by the values in the order they were added
+	uint64_t values[1 + NUM_COUNTERS];
+
+	if (_group_fd < 0 || ::read(_group_fd, values, sizeof(values)) < (ssize_t)sizeof(uint64_t)) {
+		return false;
+	}
+
+	auto value = [&](Counter counter) -> uint64_t {
+		const int index = _group_index[counter];
+		return (index >= 0 && (uint64_t)index < values[0]) ? values[1 + index] : 0;
+	};
+
+	sample.cycles = value(CYCLES);
+	sample.instructions = value(INSTRUCTIONS);
+	sample.cache_misses = value(CACHE_MISSES);
+	sample.context_switches = value(CONTEXT_SWITCHES);
+	return true;
+}
+
+#else
+
+bool ThreadPerfCounters::open() { return false; }
+void ThreadPerfCounters::close() {}
+bool ThreadPerfCounters::read(thread_perf_sample_t &sample) const { return false; }
+
+#endif // __PX4_LINUX
+
+} // namespace px4
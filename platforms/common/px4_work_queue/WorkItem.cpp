@@ -140,4 +140,23 @@ void WorkItem::print_run_status()
 	_run_count = 0;
 }
 
+void WorkItem::print_perf_status()
+{
+	if (_perf_run_count == 0) {
+		PX4_INFO_RAW("not run\n");
+		return;
+	}
+
+	const double runs = _perf_run_count;
+	const double ipc = _perf_sample.cycles > 0 ? (double)_perf_sample.instructions / (double)_perf_sample.cycles : 0.0;
+
+	// cache misses per 1000 instructions (MPKI)
+	const double mpki = _perf_sample.instructions > 0 ?
+			    1000.0 * (double)_perf_sample.cache_misses / (double)_perf_sample.instructions : 0.0;
+
+	PX4_INFO_RAW("per run: %8.0f cycles %8.0f instr, IPC %4.2f, %6.1f cache misses (%5.2f MPKI), %5.3f ctx sw\n",
+		     (double)_perf_sample.cycles / runs, (double)_perf_sample.instructions / runs, ipc,
+		     (double)_perf_sample.cache_misses / runs, mpki, (double)_perf_sample.context_switches / runs);
+}
+
 } // namespace px4
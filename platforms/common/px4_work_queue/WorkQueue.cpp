@@ -34,15 +34,91 @@
 #include <px4_platform_common/px4_work_queue/WorkQueue.hpp>
 #include <px4_platform_common/px4_work_queue/WorkItem.hpp>
 
+#include <errno.h>
 #include <string.h>
 
 #include <px4_platform_common/tasks.h>
 #include <px4_platform_common/time.h>
 #include <drivers/drv_hrt.h>
 
+#if defined(__PX4_LINUX)
+#include <sys/syscall.h>
+#endif
+#include <unistd.h>
+
 namespace px4
 {
 
+/**
+ * Thread id to running work item table, readable without locks (e.g. from a signal handler or
+ * an interrupt). Slots are claimed by the work queue threads and never move.
+ */
+struct wq_running_slot_t {
+	px4::atomic<int> tid{0};	///< 0 if unused, -1 while being claimed
+	px4::atomic<const char *> wq_name{nullptr};
+	px4::atomic<const char *> item_name{nullptr};
+};
+
+static wq_running_slot_t running_slots[32];
+
+static int current_tid()
+{
+#if defined(__PX4_LINUX)
+	return syscall(SYS_gettid);
+#elif defined(__PX4_NUTTX)
+	return getpid();
+#else
+	return -1; // no per-thread id
+#endif
+}
+
+const char *WorkQueueRunningItem(int tid, const char **wq_name)
+{
+	if (tid <= 0) {
+		return nullptr;
+	}
+
+	for (auto &slot : running_slots) {
+		if (slot.tid.load() == tid) {
+			const char *item_name = slot.item_name.load();
+			*wq_name = slot.wq_name.load();
+			return item_name;
+		}
+	}
+
+	return nullptr;
+}
+
+void WorkQueue::register_running_slot()
+{
+	const int tid = current_tid();
+
+	if (tid <= 0) {
+		return;
+	}
+
+	for (auto &slot : running_slots) {
+		int expected = 0;
+
+		if (slot.tid.compare_exchange(&expected, -1)) {
+			slot.item_name.store(nullptr);
+			slot.wq_name.store(_config.name);
+			slot.tid.store(tid);
+			_running_slot = &slot;
+			return;
+		}
+	}
+}
+
+void WorkQueue::unregister_running_slot()
+{
+	if (_running_slot) {
+		_running_slot->item_name.store(nullptr);
+		_running_slot->tid.store(0);
+		_running_slot = nullptr;
+	}
+}
+
 WorkQueue::WorkQueue(const wq_config_t &config) :
 	_config(config)
 {
@@ -150,10 +226,14 @@ void WorkQueue::Clear()
 
 void WorkQueue::Run()
 {
+	register_running_slot();
+
 	while (!should_exit()) {
 		// loop as the wait may be interrupted by a signal
 		do {} while (px4_sem_wait(&_process_lock) != 0);
 
+		update_profiling();
+
 		work_lock();
 
 		// process queued work
@@ -162,8 +242,26 @@ void WorkQueue::Run()
 
 			work_unlock(); // unlock work queue to run (item may requeue itself)
 			work->RunPreamble();
-			work->Run();
+
+			if (_running_slot) {
+				_running_slot->item_name.store(work->ItemName());
+			}
+
+			if (_perf_active) {
+				thread_perf_sample_t before;
+				_perf_counters.read(before);
+				work->Run();
+				profile_item_run(work, before);
+
+			} else {
+				work->Run();
+			}
+
 			// Note: after Run() we cannot access work anymore, as it might have been deleted
+			if (_running_slot) {
+				_running_slot->item_name.store(nullptr);
+			}
+
 			work_lock(); // re-lock
 		}
 
@@ -179,13 +277,119 @@ void WorkQueue::Run()
 		work_unlock();
 	}
 
+	unregister_running_slot();
+
 	PX4_DEBUG("%s: exiting", _config.name);
 }
 
+void WorkQueue::update_profiling()
+{
+	const bool enable = WorkQueueManagerProfiling();
+
+	if (enable && !_perf_active && !_perf_failed) {
+		if (!_perf_counters.open()) {
+			PX4_WARN("%s: perf_event_open failed (%s)", get_name(), strerror(errno));
+			_perf_failed = true;
+			return;
+		}
+
+		_perf_counters.read(_perf_start);
+
+		{
+			LockGuard lg{_work_items.mutex()};
+
+			for (WorkItem *item : _work_items) {
+				item->_perf_sample = {};
+				item->_perf_run_count = 0;
+			}
+		}
+
+		work_lock();
+#if defined(__PX4_LINUX)
+		_perf_tid = syscall(SYS_gettid);
+#endif
+		_perf_thread_sample = {};
+		_perf_run_count = 0;
+		_perf_active = true;
+		work_unlock();
+
+	} else if (!enable && (_perf_active || _perf_failed)) {
+		work_lock();
+		_perf_active = false;
+		_perf_failed = false;
+		work_unlock();
+
+		_perf_counters.close();
+	}
+}
+
+void WorkQueue::profile_item_run(WorkItem *item, const thread_perf_sample_t &before)
+{
+	thread_perf_sample_t after;
+
+	if (!_perf_counters.read(after)) {
+		return;
+	}
+
+	{
+		// the item might have been deleted in Run(), so only touch it if it's still attached
+		LockGuard lg{_work_items.mutex()};
+
+		for (WorkItem *attached : _work_items) {
+			if (attached == item) {
+				item->_perf_sample += after - before;
+				item->_perf_run_count++;
+				break;
+			}
+		}
+	}
+
+	work_lock();
+	_perf_thread_sample = after - _perf_start;
+	_perf_run_count++;
+	work_unlock();
+}
+
+void WorkQueue::for_each_perf_sample(wq_perf_sample_cb_t cb, void *arg)
+{
+	work_lock();
+	const bool active = _perf_active;
+	const thread_perf_sample_t thread_sample = _perf_thread_sample;
+	const uint32_t run_count = _perf_run_count;
+	const int tid = _perf_tid;
+	work_unlock();
+
+	if (!active) {
+		return;
+	}
+
+	cb(get_name(), tid, nullptr, thread_sample, run_count, arg);
+
+	LockGuard lg{_work_items.mutex()};
+
+	for (WorkItem *item : _work_items) {
+		cb(get_name(), tid, item->ItemName(), item->_perf_sample, item->_perf_run_count, arg);
+	}
+}
+
 void WorkQueue::print_status(bool last)
 {
 	const size_t num_items = _work_items.size();
-	PX4_INFO_RAW("%-16s\n", get_name());
+
+	work_lock();
+	const bool perf_active = _perf_active;
+	const thread_perf_sample_t thread_sample = _perf_thread_sample;
+	const uint32_t run_count = _perf_run_count;
+	work_unlock();
+
+	if (perf_active) {
+		PX4_INFO_RAW("%-16s (%" PRIu32 " runs, %" PRIu64 " Mcycles, %" PRIu64 " context switches)\n", get_name(), run_count,
+			     thread_sample.cycles / 1000000, thread_sample.context_switches);
+
+	} else {
+		PX4_INFO_RAW("%-16s\n", get_name());
+	}
+
 	unsigned i = 0;
 
 	for (WorkItem *item : _work_items) {
@@ -206,6 +410,12 @@ void WorkQueue::print_status(bool last)
 		}
 
 		item->print_run_status();
+
+		if (perf_active) {
+			PX4_INFO_RAW(last ? "    " : "|   ");
+			PX4_INFO_RAW(i < num_items ? "|       " : "        ");
+			item->print_perf_status();
+		}
 	}
 }
 
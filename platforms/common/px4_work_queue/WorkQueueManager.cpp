@@ -61,6 +61,9 @@ static BlockingQueue<const wq_config_t *, 1> *_wq_manager_create_queue{nullptr};
 
 static px4::atomic_bool _wq_manager_should_exit{true};
 
+// perf_event profiling of the work queue threads
+static px4::atomic_bool _wq_manager_profiling{false};
+
 
 static WorkQueue *
 FindWorkQueueByName(const char *name)
@@ -401,6 +404,36 @@ WorkQueueManagerStop()
 	return PX4_OK;
 }
 
+int
+WorkQueueManagerProfile(bool enable)
+{
+#if defined(__PX4_LINUX)
+	_wq_manager_profiling.store(enable);
+	return PX4_OK;
+#else
+	PX4_ERR("profiling not supported on this platform");
+	return PX4_ERROR;
+#endif
+}
+
+bool
+WorkQueueManagerProfiling()
+{
+	return _wq_manager_profiling.load();
+}
+
+void
+WorkQueueManagerForEachPerfSample(wq_perf_sample_cb_t cb, void *arg)
+{
+	if (!_wq_manager_should_exit.load() && (_wq_manager_wqs_list != nullptr)) {
+		LockGuard lg{_wq_manager_wqs_list->mutex()};
+
+		for (WorkQueue *wq : *_wq_manager_wqs_list) {
+			wq->for_each_perf_sample(cb, arg);
+		}
+	}
+}
+
 int
 WorkQueueManagerStatus()
 {
@@ -36,6 +36,8 @@
 
 #include <stdint.h>
 
+#include "uORB.h"
+
 
 namespace uORBCommunicator
 {
@@ -91,7 +93,8 @@ public:
 	 * 	This represents the uORB message name; This message name should be
 	 * 	globally unique.
 	 * @param msgRate
-	 * 	The max rate at which the subscriber can accept the messages.
+	 * 	The max rate at which the subscriber can accept the messages,
+	 * 	0 if the subscriber wants every published message.
 	 * @return
 	 * 	0 = success; This means the messages is successfully sent to the receiver
 	 * 		Note: This does not mean that the receiver as received it.
@@ -144,6 +147,29 @@ public:
 
 	virtual int16_t send_message(const char *messageName, int32_t length, uint8_t *data) = 0;
 
+	/**
+	 * @brief Sends the data message of a topic instance over the communication link.
+	 * This is called on every publication, channels that identify topics by their
+	 * ORB_ID override it to avoid looking up the message name.
+	 * @param meta
+	 * 	The uORB topic metadata.
+	 * @param instance
+	 * 	The topic instance that was published.
+	 * @param length
+	 * 	The length of the data buffer to be sent.
+	 * @param data
+	 * 	The actual data to be sent.
+	 * @return
+	 *  0 = success; This means the messages is successfully sent to the receiver
+	 * 		Note: This does not mean that the receiver as received it.
+	 *  otherwise = failure.
+	 */
+
+	virtual int16_t send_topic_data(const orb_metadata *meta, uint8_t instance, int32_t length, uint8_t *data)
+	{
+		return send_message(meta->o_name, length, data);
+	}
+
 };
 
 /**
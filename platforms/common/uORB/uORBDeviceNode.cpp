@@ -348,7 +348,7 @@ uORB::DeviceNode::publish(const orb_metadata *meta, orb_advert_t handle, const v
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
 	if (ch != nullptr) {
-		if (ch->send_message(meta->o_name, meta->o_size, (uint8_t *)data) != 0) {
+		if (ch->send_topic_data(meta, devnode->get_instance(), meta->o_size, (uint8_t *)data) != 0) {
 			PX4_ERR("Error Sending [%s] topic data over comm_channel", meta->o_name);
 			return PX4_ERROR;
 		}
@@ -455,7 +455,7 @@ void uORB::DeviceNode::add_internal_subscriber()
 
 	if (ch != nullptr && _subscriber_count > 0) {
 		unlock(); //make sure we cannot deadlock if add_subscription calls back into DeviceNode
-		ch->add_subscription(_meta->o_name, 1);
+		ch->add_subscription(_meta->o_name, 0);
 
 	} else
 #endif /* ORB_COMMUNICATOR */
@@ -493,7 +493,7 @@ int16_t uORB::DeviceNode::process_add_subscription(int32_t rateInHz)
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
 	if (_data != nullptr && ch != nullptr) { // _data will not be null if there is a publisher.
-		ch->send_message(_meta->o_name, _meta->o_size, _data);
+		ch->send_topic_data(_meta, get_instance(), _meta->o_size, _data);
 	}
 
 	return PX4_OK;
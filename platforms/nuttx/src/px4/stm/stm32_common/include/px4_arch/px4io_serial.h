@@ -58,6 +58,17 @@ public:
 	virtual int	read(unsigned offset, void *data, unsigned count = 1);
 	virtual int	write(unsigned address, void *data, unsigned count = 1);
 
+	/**
+	 * Write registers and read the registers of PX4IO_PAGE_CYCLE in one transaction.
+	 * @param address Page and offset to write to.
+	 * @param data Values to write.
+	 * @param count Number of values to write.
+	 * @param reply Buffer for the cycle registers.
+	 * @param reply_count Number of cycle registers expected.
+	 * @return The number of registers read, or a negative error.
+	 */
+	int		cycle(unsigned address, const void *data, unsigned count, void *reply, unsigned reply_count);
+
 protected:
 	/**
 	 * Does the PX4IO_serial instance initialization.
@@ -21,6 +21,7 @@ set(tests
 	matrix
 	microbench_atomic
 	microbench_hrt
+	microbench_kalman
 	microbench_math
 	microbench_matrix
 	microbench_uorb
@@ -48,20 +48,43 @@
 #include <time.h>
 #include <string.h>
 #include <errno.h>
-#include "hrt_work.h"
 
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
 #include <lockstep_scheduler/lockstep_scheduler.h>
 #endif
 
-// Intervals in usec
-static constexpr unsigned HRT_INTERVAL_MIN = 50;
-static constexpr unsigned HRT_INTERVAL_MAX = 50000000;
+// Maximum time in usec the HRT thread sleeps
+static constexpr hrt_abstime HRT_INTERVAL_MAX = 50000000;
 
 /*
- * Queue of callout entries.
+ * Hierarchical timer wheel of callout entries.
+ *
+ * Level l has HRT_WHEEL_SLOTS slots, each covering 2^(HRT_WHEEL_TICK_SHIFT + l * HRT_WHEEL_LEVEL_BITS) usec.
+ * An entry is put into the lowest level where its deadline is less than HRT_WHEEL_SLOTS slots ahead.
+ * Slots of the higher levels are emptied once the time reaches them, and their entries are
+ * re-inserted into a lower level, such that every entry is re-inserted at most once per level.
+ * Entries that are due are moved to the expired list.
+ *
+ * Each slot is a circular list with the slot head as sentinel, so an entry can be removed in
+ * constant time without knowing its slot.
  */
-static struct sq_queue_s	callout_queue;
+static constexpr int HRT_WHEEL_TICK_SHIFT = 5; // 32 usec
+static constexpr int HRT_WHEEL_LEVEL_BITS = 6;
+static constexpr int HRT_WHEEL_LEVELS = 5; // covers ~9.5 hours, later deadlines are clamped to the top level
+static constexpr unsigned HRT_WHEEL_SLOTS = 1u << HRT_WHEEL_LEVEL_BITS;
+static constexpr unsigned HRT_WHEEL_SLOT_MASK = HRT_WHEEL_SLOTS - 1;
+
+static struct dq_entry_s	wheel_slots[HRT_WHEEL_LEVELS][HRT_WHEEL_SLOTS];
+static uint64_t			wheel_slots_pending[HRT_WHEEL_LEVELS]; // bit set if the slot might be non-empty
+static struct dq_entry_s	wheel_expired;
+static hrt_abstime		wheel_time; // time up to which the wheel has been advanced
+
+/* entry that is currently being invoked, and whether it was re-scheduled or cancelled meanwhile */
+static struct hrt_call		*invoking_call;
+static bool			invoking_call_changed;
+
+/* next wakeup time of the HRT thread */
+static hrt_abstime		next_wakeup;
 
 /* latency baseline (last compare value applied) */
 static uint64_t			latency_baseline;
@@ -75,7 +98,7 @@ const uint16_t latency_buckets[LATENCY_BUCKET_COUNT] = { 1, 2, 5, 10, 20, 50, 10
 __EXPORT uint32_t latency_counters[LATENCY_BUCKET_COUNT + 1];
 
 static px4_sem_t 	_hrt_lock;
-static struct work_s	_hrt_work;
+static px4_sem_t	_hrt_wakeup;
 
 static hrt_abstime px4_timestart_monotonic = 0;
 
@@ -85,8 +108,10 @@ static LockstepScheduler *lockstep_scheduler = new LockstepScheduler();
 
 static void hrt_latency_update();
 
-static void hrt_call_reschedule();
+static void hrt_call_enter(struct hrt_call *entry);
+static void hrt_call_remove(struct hrt_call *entry);
 static void hrt_call_invoke();
+static int hrt_thread_main(int argc, char *argv[]);
 
 hrt_abstime hrt_absolute_time_offset()
 {
@@ -198,9 +223,13 @@ bool	hrt_called(struct hrt_call *entry)
 void	hrt_cancel(struct hrt_call *entry)
 {
 	hrt_lock();
-	sq_rem(&entry->link, &callout_queue);
+	hrt_call_remove(entry);
 	entry->deadline = 0;
 
+	if (entry == invoking_call) {
+		invoking_call_changed = true;
+	}
+
 	/* if this is a periodic call being removed by the callout, prevent it from
 	 * being re-entered when the callout returns.
 	 */
@@ -246,12 +275,83 @@ void	hrt_call_delay(struct hrt_call *entry, hrt_abstime delay)
 	entry->deadline = hrt_absolute_time() + delay;
 }
 
+static void wheel_list_init(struct dq_entry_s *head)
+{
+	head->flink = head;
+	head->blink = head;
+}
+
+static bool wheel_list_empty(const struct dq_entry_s *head)
+{
+	return head->flink == head;
+}
+
+static void wheel_list_add(struct dq_entry_s *head, struct dq_entry_s *node)
+{
+	node->flink = head;
+	node->blink = head->blink;
+	head->blink->flink = node;
+	head->blink = node;
+}
+
+static void wheel_list_remove(struct dq_entry_s *node)
+{
+	// a zero-initialised entry has never been in the wheel
+	if (node->flink != nullptr && node->blink != nullptr) {
+		node->blink->flink = node->flink;
+		node->flink->blink = node->blink;
+	}
+
+	// point to itself, so a repeated removal does nothing
+	wheel_list_init(node);
+}
+
+/* move all nodes of list 'from' to the end of list 'to' */
+static void wheel_list_splice(struct dq_entry_s *from, struct dq_entry_s *to)
+{
+	if (!wheel_list_empty(from)) {
+		from->flink->blink = to->blink;
+		to->blink->flink = from->flink;
+		from->blink->flink = to;
+		to->blink = from->blink;
+		wheel_list_init(from);
+	}
+}
+
+static inline int wheel_level_shift(int level)
+{
+	return HRT_WHEEL_TICK_SHIFT + level * HRT_WHEEL_LEVEL_BITS;
+}
+
+/* offset of the first pending slot, starting from slot 'current' (HRT_WHEEL_SLOTS if there is none) */
+static unsigned wheel_first_pending(int level, unsigned current)
+{
+	const uint64_t pending = wheel_slots_pending[level];
+
+	if (pending == 0) {
+		return HRT_WHEEL_SLOTS;
+	}
+
+	const uint64_t rotated = current == 0 ? pending : (pending >> current) | (pending << (HRT_WHEEL_SLOTS - current));
+	return __builtin_ctzll(rotated);
+}
+
 /*
  * Initialise the HRT.
  */
 void	hrt_init()
 {
-	sq_init(&callout_queue);
+	for (int level = 0; level < HRT_WHEEL_LEVELS; level++) {
+		for (unsigned slot = 0; slot < HRT_WHEEL_SLOTS; slot++) {
+			wheel_list_init(&wheel_slots[level][slot]);
+		}
+
+		wheel_slots_pending[level] = 0;
+	}
+
+	wheel_list_init(&wheel_expired);
+	wheel_time = hrt_absolute_time();
+	next_wakeup = wheel_time + HRT_INTERVAL_MAX;
 
 	int sem_ret = px4_sem_init(&_hrt_lock, 0, 1);
 
@@ -259,108 +359,213 @@ void	hrt_init()
 		PX4_ERR("SEM INIT FAIL: %s", strerror(errno));
 	}
 
-	memset(&_hrt_work, 0, sizeof(_hrt_work));
+	px4_sem_init(&_hrt_wakeup, 0, 0);
+	px4_sem_setprotocol(&_hrt_wakeup, SEM_PRIO_NONE);
+
+	// There is no timer interrupt, so a high priority thread waits for the next deadline instead
+	int task_id = px4_task_spawn_cmd("hrt",
+					 SCHED_DEFAULT,
+					 SCHED_PRIORITY_MAX,
+					 PX4_STACK_ADJUSTED(2000),
+					 hrt_thread_main,
+					 nullptr);
+
+	if (task_id < 0) {
+		PX4_ERR("failed to start HRT thread");
+	}
 }
 
+/*
+ * Put an entry into the wheel. Must be called with the lock held.
+ */
 static void
 hrt_call_enter(struct hrt_call *entry)
 {
-	struct hrt_call	*call, *next;
-
-	call = (struct hrt_call *)sq_peek(&callout_queue);
-
-	if ((call == nullptr) || (entry->deadline < call->deadline)) {
-		sq_addfirst(&entry->link, &callout_queue);
-		//if (call != nullptr) PX4_INFO("call enter at head, reschedule (%lu %lu)", entry->deadline, call->deadline);
-		/* we changed the next deadline, reschedule the timer event */
-		hrt_call_reschedule();
+	if (entry->deadline <= wheel_time) {
+		wheel_list_add(&wheel_expired, &entry->link);
 
 	} else {
-		do {
-			next = (struct hrt_call *)sq_next(&call->link);
+		int level = 0;
+		uint64_t slot = 0;
 
-			if ((next == nullptr) || (entry->deadline < next->deadline)) {
-				//lldbg("call enter after head\n");
-				sq_addafter(&call->link, &entry->link, &callout_queue);
+		for (; level < HRT_WHEEL_LEVELS; level++) {
+			const int shift = wheel_level_shift(level);
+			slot = entry->deadline >> shift;
+
+			if (slot - (wheel_time >> shift) < HRT_WHEEL_SLOTS) {
 				break;
 			}
-		} while ((call = next) != nullptr);
+		}
+
+		if (level == HRT_WHEEL_LEVELS) {
+			// too far in the future: use the last slot of the top level, it gets re-inserted from there
+			level = HRT_WHEEL_LEVELS - 1;
+			slot = (wheel_time >> wheel_level_shift(level)) + HRT_WHEEL_SLOTS - 1;
+		}
+
+		slot &= HRT_WHEEL_SLOT_MASK;
+		wheel_list_add(&wheel_slots[level][slot], &entry->link);
+		wheel_slots_pending[level] |= 1ull << slot;
+	}
+
+	// wake up the HRT thread if the entry is due before its next wakeup
+	if (entry->deadline < next_wakeup) {
+		next_wakeup = entry->deadline;
+		px4_sem_post(&_hrt_wakeup);
 	}
 }
 
-/**
- * Timer interrupt handler
- *
- * This routine simulates a timer interrupt handler
+/*
+ * Remove an entry from the wheel (if it is in). Must be called with the lock held.
  */
 static void
-hrt_tim_isr(void *p)
+hrt_call_remove(struct hrt_call *entry)
 {
-	/* grab the timer for latency tracking purposes */
-	latency_actual = hrt_absolute_time();
+	wheel_list_remove(&entry->link);
+}
 
-	/* do latency calculations */
-	hrt_latency_update();
+/*
+ * Advance the wheel to 'now' and move all due entries to the expired list.
+ * Must be called with the lock held.
+ */
+static void
+hrt_wheel_advance(hrt_abstime now)
+{
+	if (now < wheel_time) {
+		return;
+	}
 
-	/* run any callouts that have met their deadline */
-	hrt_call_invoke();
+	struct dq_entry_s reinsert;
+	wheel_list_init(&reinsert);
 
-	hrt_lock();
+	for (int level = 0; level < HRT_WHEEL_LEVELS; level++) {
+		const int shift = wheel_level_shift(level);
+		const uint64_t from = wheel_time >> shift;
+		const uint64_t to = now >> shift;
 
-	/* and schedule the next interrupt */
-	hrt_call_reschedule();
+		if (wheel_slots_pending[level] == 0) {
+			continue;
+		}
 
-	hrt_unlock();
+		// collect all slots that the time reached (including the current one)
+		const uint64_t count = (to - from >= HRT_WHEEL_SLOTS) ? HRT_WHEEL_SLOTS : to - from + 1;
+
+		for (uint64_t i = 0; i < count; i++) {
+			const unsigned slot = (from + i) & HRT_WHEEL_SLOT_MASK;
+
+			if (wheel_slots_pending[level] & (1ull << slot)) {
+				wheel_list_splice(&wheel_slots[level][slot], &reinsert);
+				wheel_slots_pending[level] &= ~(1ull << slot);
+			}
+		}
+	}
+
+	wheel_time = now;
+
+	// re-insert relative to the new time: due entries end up in the expired list
+	while (!wheel_list_empty(&reinsert)) {
+		struct hrt_call *call = (struct hrt_call *)reinsert.flink;
+		wheel_list_remove(&call->link);
+		hrt_call_enter(call);
+	}
 }
 
-/**
- * Reschedule the next timer interrupt.
- *
- * This routine must be called with interrupts disabled.
+/*
+ * Get the next deadline of the wheel. Must be called with the lock held.
  */
-static void
-hrt_call_reschedule()
-{
-	hrt_abstime	now = hrt_absolute_time();
-	hrt_abstime	delay = HRT_INTERVAL_MAX;
-	struct hrt_call	*next = (struct hrt_call *)sq_peek(&callout_queue);
-	hrt_abstime	deadline = now + HRT_INTERVAL_MAX;
-
-	/*
-	 * Determine what the next deadline will be.
-	 *
-	 * Note that we ensure that this will be within the counter
-	 * period, so that when we truncate all but the low 16 bits
-	 * the next time the compare matches it will be the deadline
-	 * we want.
-	 *
-	 * It is important for accurate timekeeping that the compare
-	 * interrupt fires sufficiently often that the base_time update in
-	 * hrt_absolute_time runs at least once per timer period.
-	 */
-	if (next != nullptr) {
-		//lldbg("entry in queue\n");
-		if (next->deadline <= (now + HRT_INTERVAL_MIN)) {
-			//lldbg("pre-expired\n");
-			/* set a minimal deadline so that we call ASAP */
-			delay = HRT_INTERVAL_MIN;
-
-		} else if (next->deadline < deadline) {
-			//lldbg("due soon\n");
-			delay = next->deadline - now;
+static hrt_abstime
+hrt_wheel_next_deadline()
+{
+	if (!wheel_list_empty(&wheel_expired)) {
+		return wheel_time;
+	}
+
+	hrt_abstime deadline = wheel_time + HRT_INTERVAL_MAX;
+
+	for (int level = 0; level < HRT_WHEEL_LEVELS; level++) {
+		const int shift = wheel_level_shift(level);
+		const uint64_t current = wheel_time >> shift;
+
+		while (true) {
+			const unsigned offset = wheel_first_pending(level, current & HRT_WHEEL_SLOT_MASK);
+
+			if (offset >= HRT_WHEEL_SLOTS) {
+				break;
+			}
+
+			const unsigned slot = (current + offset) & HRT_WHEEL_SLOT_MASK;
+			struct dq_entry_s *head = &wheel_slots[level][slot];
+
+			if (wheel_list_empty(head)) {
+				// entries got removed meanwhile
+				wheel_slots_pending[level] &= ~(1ull << slot);
+				continue;
+			}
+
+			hrt_abstime slot_deadline;
+
+			if (level == 0) {
+				// the first slot contains the earliest entries of the level, find the exact deadline
+				slot_deadline = UINT64_MAX;
+
+				for (struct dq_entry_s *node = head->flink; node != head; node = node->flink) {
+					const hrt_abstime entry_deadline = ((struct hrt_call *)node)->deadline;
+
+					if (entry_deadline < slot_deadline) {
+						slot_deadline = entry_deadline;
+					}
+				}
+
+			} else {
+				// the slot gets emptied into the lower levels when the time reaches it
+				slot_deadline = (current + offset) << shift;
+			}
+
+			if (slot_deadline < deadline) {
+				deadline = slot_deadline;
+			}
+
+			break;
 		}
 	}
 
-	/* set the new compare value and remember it for latency tracking */
-	latency_baseline = now + delay;
+	return deadline;
+}
+
+/**
+ * HRT thread
+ *
+ * This simulates the timer interrupt: it waits until the next deadline (as absolute time)
+ * or until an earlier entry is added, and runs the callouts.
+ */
+static int
+hrt_thread_main(int argc, char *argv[])
+{
+	while (true) {
+		/* run any callouts that have met their deadline */
+		hrt_call_invoke();
+
+		hrt_lock();
+		const hrt_abstime deadline = hrt_wheel_next_deadline();
+		next_wakeup = deadline;
+
+		/* remember the deadline for latency tracking */
+		latency_baseline = deadline;
+		hrt_unlock();
 
-	// There is no timer ISR, so simulate one by putting an event on the
-	// high priority work queue
+		struct timespec ts;
+		abstime_to_ts(&ts, deadline);
 
-	// Remove the existing expiry and update with the new expiry
-	hrt_work_cancel(&_hrt_work);
+		if (px4_sem_timedwait(&_hrt_wakeup, &ts) != 0 && errno == ETIMEDOUT) {
+			/* grab the timer for latency tracking purposes */
+			latency_actual = hrt_absolute_time();
 
-	hrt_work_queue(&_hrt_work, (worker_t)&hrt_tim_isr, nullptr, delay);
+			/* do latency calculations */
+			hrt_latency_update();
+		}
+	}
+
+	return 0;
 }
 
 static void
@@ -369,28 +574,13 @@ hrt_call_internal(struct hrt_call *entry, hrt_abstime deadline, hrt_abstime inte
 	PX4_DEBUG("hrt_call_internal deadline=%lu interval = %lu", deadline, interval);
 	hrt_lock();
 
-	//PX4_INFO("hrt_call_internal after lock");
 	/* if the entry is currently queued, remove it */
-	/* note that we are using a potentially uninitialised
-	   entry->link here, but it is safe as sq_rem() doesn't
-	   dereference the passed node unless it is found in the
-	   list. So we potentially waste a bit of time searching the
-	   queue for the uninitialised entry->link but we don't do
-	   anything actually unsafe.
-	*/
-	if (entry->deadline != 0) {
-		sq_rem(&entry->link, &callout_queue);
-	}
-
-#if 1
+	hrt_call_remove(entry);
 
-	// Use this to debug busy CPU that keeps rescheduling with 0 period time
-	/*if (interval < HRT_INTERVAL_MIN) {*/
-	/*PX4_ERR("hrt_call_internal interval too short: %" PRIu64, interval);*/
-	/*abort();*/
-	/*}*/
+	if (entry == invoking_call) {
+		invoking_call_changed = true;
+	}
 
-#endif
 	entry->deadline = deadline;
 	entry->period = interval;
 	entry->callout = callout;
@@ -447,22 +637,21 @@ hrt_call_invoke()
 
 	hrt_lock();
 
+	/* the thread is awake, so there is no need to wake it up for new entries */
+	next_wakeup = 0;
+
 	while (true) {
 		/* get the current time */
 		hrt_abstime now = hrt_absolute_time();
 
-		call = (struct hrt_call *)sq_peek(&callout_queue);
+		hrt_wheel_advance(now);
 
-		if (call == nullptr) {
+		if (wheel_list_empty(&wheel_expired)) {
 			break;
 		}
 
-		if (call->deadline > now) {
-			break;
-		}
-
-		sq_rem(&call->link, &callout_queue);
-		//PX4_INFO("call pop");
+		call = (struct hrt_call *)wheel_expired.flink;
+		hrt_call_remove(call);
 
 		/* save the intended deadline for periodic calls */
 		deadline = call->deadline;
@@ -470,17 +659,26 @@ hrt_call_invoke()
 		/* zero the deadline, as the call has occurred */
 		call->deadline = 0;
 
+		invoking_call = call;
+		invoking_call_changed = false;
+
 		/* invoke the callout (if there is one) */
 		if (call->callout) {
 			// Unlock so we don't deadlock in callback
 			hrt_unlock();
 
-			//PX4_INFO("call %p: %p(%p)", call, call->callout, call->arg);
 			call->callout(call->arg);
 
 			hrt_lock();
 		}
 
+		invoking_call = nullptr;
+
+		/* the callout re-scheduled or cancelled the entry itself */
+		if (invoking_call_changed) {
+			continue;
+		}
+
 		/* if the callout has a non-zero period, it has to be re-entered */
 		if (call->period != 0) {
 			// re-check call->deadline to allow for
@@ -488,10 +686,12 @@ hrt_call_invoke()
 			// using hrt_call_delay()
 			if (call->deadline <= now) {
 				call->deadline = deadline + call->period;
-				//PX4_INFO("call deadline set to %lu now=%lu", call->deadline,  now);
 			}
 
 			hrt_call_enter(call);
+
+		} else {
+			call->deadline = 0;
 		}
 	}
 
@@ -175,6 +175,12 @@ int main(int argc, char **argv)
 		argv[0] += path_length + strlen(prefix);
 
 		px4_daemon::Client client(instance);
+
+		if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+			/* run all commands of the file over a single connection */
+			return client.process_batch(argv[2]);
+		}
+
 		return client.process_args(argc, (const char **)argv);
 
 	} else {
@@ -576,6 +582,8 @@ void print_usage()
 	printf("\n");
 	printf("    px4-MODULE [--instance <instance>] command using symlink.\n");
 	printf("        e.g.: px4-commander status\n");
+	printf("    px4-MODULE [--instance <instance>] --batch <file> runs the commands in <file> (one per line, '-' for stdin)\n");
+	printf("        over a single connection, e.g.: px4-commander --batch commands.txt\n");
 }
 
 bool is_server_running(int instance, bool server)
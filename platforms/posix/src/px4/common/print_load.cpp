@@ -49,6 +49,12 @@
 #include <px4_platform_common/printload.h>
 #include <drivers/drv_hrt.h>
 
+#if defined(__PX4_LINUX)
+#include <dirent.h>
+#include <stdlib.h>
+#include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
+#endif
+
 #ifdef __PX4_DARWIN
 #include <mach/mach.h>
 #endif
@@ -62,6 +68,103 @@ extern struct system_load_s system_load;
 
 #define CL "\033[K" // clear line
 
+#if defined(__PX4_LINUX)
+
+struct wq_thread_perf_s {
+	int tid;
+	px4::thread_perf_sample_t sample;
+	uint32_t run_count;
+};
+
+struct wq_thread_perf_list_s {
+	wq_thread_perf_s threads[CONFIG_MAX_TASKS];
+	int count;
+};
+
+static void collect_wq_thread_perf(const char *wq_name, int tid, const char *item_name,
+				   const px4::thread_perf_sample_t &sample, uint32_t run_count, void *arg)
+{
+	wq_thread_perf_list_s *list = (wq_thread_perf_list_s *)arg;
+
+	if (item_name == nullptr && list->count < CONFIG_MAX_TASKS) {
+		list->threads[list->count++] = wq_thread_perf_s{tid, sample, run_count};
+	}
+}
+
+/**
+ * Read name, state and CPU time (user + system, in clock ticks) of a thread from /proc/self/task/<tid>/stat
+ */
+static bool read_thread_stat(int tid, char *name, size_t name_len, char *state, uint64_t *cpu_ticks)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+	FILE *f = fopen(path, "r");
+
+	if (f == nullptr) {
+		return false;
+	}
+
+	char buf[512];
+	const size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[n] = '\0';
+
+	// format: pid (comm) state ppid ... (comm can contain spaces and parentheses)
+	char *name_start = strchr(buf, '(');
+	char *name_end = strrchr(buf, ')');
+
+	if (name_start == nullptr || name_end == nullptr || name_end < name_start) {
+		return false;
+	}
+
+	size_t len = name_end - name_start - 1;
+
+	if (len > name_len - 1) {
+		len = name_len - 1;
+	}
+
+	memcpy(name, name_start + 1, len);
+	name[len] = '\0';
+
+	unsigned long utime = 0;
+	unsigned long stime = 0;
+
+	// fields after comm: state(3) ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime(14) stime(15)
+	if (sscanf(name_end + 2, "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", state, &utime, &stime) != 3) {
+		return false;
+	}
+
+	*cpu_ticks = utime + stime;
+	return true;
+}
+
+/**
+ * Get the thread ids of the process
+ * @return number of threads
+ */
+static int list_threads(int tids[CONFIG_MAX_TASKS])
+{
+	DIR *dir = opendir("/proc/self/task");
+
+	if (dir == nullptr) {
+		return 0;
+	}
+
+	int num_threads = 0;
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != nullptr && num_threads < CONFIG_MAX_TASKS) {
+		if (entry->d_name[0] != '.') {
+			tids[num_threads++] = atoi(entry->d_name);
+		}
+	}
+
+	closedir(dir);
+	return num_threads;
+}
+
+#endif // __PX4_LINUX
+
 void init_print_load(struct print_load_s *s)
 {
 	s->total_user_time = 0;
@@ -74,11 +177,31 @@ void init_print_load(struct print_load_s *s)
 
 	for (int i = 0; i < CONFIG_MAX_TASKS; i++) {
 		s->last_times[i] = 0;
+#if defined(__PX4_LINUX)
+		s->last_tids[i] = 0;
+#endif
 	}
 
 	s->interval_time_us = 0.f;
+
+#if defined(__PX4_LINUX)
+	// initial CPU times, so that the first print shows the load since now
+	int tids[CONFIG_MAX_TASKS];
+	const int num_threads = list_threads(tids);
+
+	for (int i = 0; i < num_threads; i++) {
+		char name[32];
+		char state;
+
+		if (read_thread_stat(tids[i], name, sizeof(name), &state, &s->last_times[i])) {
+			s->last_tids[i] = tids[i];
+		}
+	}
+
+#endif
 }
 
+
 void print_load(int fd, struct print_load_s *print_state)
 {
 	char clear_line[] = CL;
@@ -91,8 +214,84 @@ void print_load(int fd, struct print_load_s *print_state)
 		memset(clear_line, 0, sizeof(clear_line));
 	}
 
-#if defined(__PX4_LINUX) || defined(__PX4_CYGWIN) || defined(__PX4_QURT)
-	dprintf(fd, "%sTOP NOT IMPLEMENTED ON LINUX, QURT, WINDOWS (ONLY ON NUTTX, APPLE)\n", clear_line);
+#if defined(__PX4_LINUX)
+	const hrt_abstime now = hrt_absolute_time();
+	const float interval_s = (now - print_state->new_time) / 1e6f;
+	print_state->interval_time_us = now - print_state->new_time;
+	print_state->new_time = now;
+
+	const long ticks_per_sec = sysconf(_SC_CLK_TCK);
+
+	// perf_event counters of the work queue threads (if profiling is enabled)
+	static wq_thread_perf_list_s wq_perf;
+	wq_perf.count = 0;
+	px4::WorkQueueManagerForEachPerfSample(collect_wq_thread_perf, &wq_perf);
+
+	int tids[CONFIG_MAX_TASKS];
+	const int num_threads = list_threads(tids);
+
+	uint64_t new_times[CONFIG_MAX_TASKS] {};
+	float total_load = 0.f;
+
+	dprintf(fd, "%sThreads: %d total\n", clear_line, num_threads);
+	dprintf(fd, "%s\n", clear_line);
+
+	if (wq_perf.count > 0) {
+		dprintf(fd, "%s TID COMMAND          CPU(%%) STATE    RUNS   MCYCLES   IPC  MPKI  CTX SW\n", clear_line);
+
+	} else {
+		dprintf(fd, "%s TID COMMAND          CPU(%%) STATE\n", clear_line);
+	}
+
+	for (int i = 0; i < num_threads; i++) {
+		char name[32];
+		char state = '?';
+
+		if (!read_thread_stat(tids[i], name, sizeof(name), &state, &new_times[i])) {
+			continue;
+		}
+
+		// find the CPU time of the last print (threads can come and go)
+		float load = 0.f;
+
+		for (int j = 0; j < CONFIG_MAX_TASKS; j++) {
+			if (print_state->last_tids[j] == tids[i] && print_state->last_times[j] <= new_times[i]) {
+				load = (new_times[i] - print_state->last_times[j]) / (interval_s * ticks_per_sec);
+				break;
+			}
+		}
+
+		total_load += load;
+
+		dprintf(fd, "%s%4d %-16s %6.2f %c", clear_line, tids[i], name, (double)(load * 100.f), state);
+
+		for (int j = 0; j < wq_perf.count; j++) {
+			const wq_thread_perf_s &wq = wq_perf.threads[j];
+
+			if (wq.tid == tids[i]) {
+				const double ipc = wq.sample.cycles > 0 ? (double)wq.sample.instructions / (double)wq.sample.cycles : 0.0;
+				const double mpki = wq.sample.instructions > 0 ?
+						    1000.0 * (double)wq.sample.cache_misses / (double)wq.sample.instructions : 0.0;
+				dprintf(fd, "     %8u %9.1f %5.2f %5.2f %7llu", (unsigned)wq.run_count, (double)wq.sample.cycles / 1e6, ipc, mpki,
+					(unsigned long long)wq.sample.context_switches);
+				break;
+			}
+		}
+
+		dprintf(fd, "\n");
+	}
+
+	for (int i = 0; i < CONFIG_MAX_TASKS; i++) {
+		print_state->last_tids[i] = i < num_threads ? tids[i] : 0;
+		print_state->last_times[i] = new_times[i];
+	}
+
+	dprintf(fd, "%s\n", clear_line);
+	dprintf(fd, "%sProcesses: %.2f%% CPU (of one core)%s\n", clear_line, (double)(total_load * 100.f),
+		wq_perf.count > 0 ? ", work queue counters since 'work_queue profile start'" : "");
+
+#elif defined(__PX4_CYGWIN) || defined(__PX4_QURT)
+	dprintf(fd, "%sTOP NOT IMPLEMENTED ON QURT, WINDOWS (ONLY ON NUTTX, APPLE, LINUX)\n", clear_line);
 
 #elif defined(__PX4_DARWIN)
 	pid_t pid = getpid();   //-- this is the process id you need info for
@@ -40,6 +40,7 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <string.h>
 #include <sys/types.h>
@@ -62,7 +63,7 @@ Client::Client(int instance_id) :
 {}
 
 int
-Client::process_args(const int argc, const char **argv)
+Client::_connect()
 {
 	std::string sock_path = get_socket_path(_instance_id);
 
@@ -82,19 +83,16 @@ Client::process_args(const int argc, const char **argv)
 		return -1;
 	}
 
-	int ret = _send_cmds(argc, argv);
-
-	if (ret != 0) {
-		PX4_ERR("Could not send commands");
-		return -3;
-	}
-
-	return _listen();
+	return 0;
 }
 
 int
-Client::_send_cmds(const int argc, const char **argv)
+Client::process_args(const int argc, const char **argv)
 {
+	if (_connect() != 0) {
+		return -1;
+	}
+
 	std::string cmd_buf;
 
 	for (int i = 0; i < argc; ++i) {
@@ -107,8 +105,90 @@ Client::_send_cmds(const int argc, const char **argv)
 		}
 	}
 
-	// Last byte is 'isatty'.
-	cmd_buf.push_back(isatty(STDOUT_FILENO));
+	int ret = _send_cmd(cmd_buf, 0);
+
+	if (ret != 0) {
+		PX4_ERR("Could not send commands");
+		return -3;
+	}
+
+	return _listen();
+}
+
+int
+Client::process_batch(const char *file)
+{
+	FILE *input = stdin;
+
+	if (strcmp(file, "-") != 0) {
+		input = fopen(file, "r");
+
+		if (input == nullptr) {
+			PX4_ERR("failed to open %s: %s", file, strerror(errno));
+			return -1;
+		}
+	}
+
+	int ret = 0;
+	bool connected = _connect() == 0;
+
+	if (!connected) {
+		ret = -1;
+	}
+
+	char *line = nullptr;
+	size_t line_size = 0;
+	ssize_t line_len;
+
+	while (connected && (line_len = getline(&line, &line_size, input)) >= 0) {
+		std::string cmd(line, line_len);
+
+		// Strip whitespace, skip empty lines and comments.
+		const size_t first = cmd.find_first_not_of(" \t\r\n");
+
+		if (first == std::string::npos || cmd[first] == '#') {
+			continue;
+		}
+
+		cmd = cmd.substr(first, cmd.find_last_not_of(" \t\r\n") - first + 1);
+
+		// All commands are sent over the same connection, one after the other.
+		if (_send_cmd(cmd, CMD_FLAG_SESSION) != 0) {
+			PX4_ERR("Could not send command");
+			ret = -3;
+			break;
+		}
+
+		int retval = _listen(true);
+
+		if (retval != 0) {
+			PX4_ERR("'%s' failed (%i)", cmd.c_str(), retval);
+
+			// Keep going, but report the first failure.
+			if (ret == 0) {
+				ret = retval;
+			}
+		}
+	}
+
+	free(line);
+
+	if (input != stdin) {
+		fclose(input);
+	}
+
+	return ret;
+}
+
+int
+Client::_send_cmd(std::string cmd_buf, char flags)
+{
+	if (isatty(STDOUT_FILENO)) {
+		flags |= CMD_FLAG_ISATTY;
+	}
+
+	// Last byte are the flags.
+	cmd_buf.push_back(flags);
 
 	size_t n = cmd_buf.size();
 	const char *buf = cmd_buf.data();
@@ -129,7 +209,7 @@ Client::_send_cmds(const int argc, const char **argv)
 }
 
 int
-Client::_listen()
+Client::_listen(bool session)
 {
 	char buffer[1024];
 	int n_buffer_used = 0;
@@ -156,7 +236,14 @@ Client::_listen()
 		} else {
 			n_read += n_buffer_used;
 
-			if (n_read >= 2 && buffer[n_read - 2] == 0) {
+			if (session && n_read >= 2 && buffer[n_read - 2] == 0) {
+				// The server keeps the connection open, so the response ends with {0, retval}.
+				// The server only sends it after the command finished.
+				fwrite(buffer, n_read - 2, 1, stdout);
+				fflush(stdout);
+				return buffer[n_read - 1];
+
+			} else if (n_read >= 2 && buffer[n_read - 2] == 0) {
 				// If the buffer ends in {0, retval}, keep it.
 				fwrite(buffer, n_read - 2, 1, stdout);
 				buffer[0] = 0;
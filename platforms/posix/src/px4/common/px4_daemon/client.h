@@ -36,6 +36,8 @@
  * The client can connect and write a command to the socket that is supplied by
  * the server. It will then close its half of the connection, and read back the
  * stdout stream of the process that it started, followed by its return value.
+ * In batch mode, multiple commands are sent one after the other over the same
+ * connection (a session).
  *
  * It the client dies, the connection gets closed automatically and the corresponding
  * thread in the server gets cancelled.
@@ -47,6 +49,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 
 #include "sock_protocol.h"
 
@@ -76,9 +79,25 @@ public:
 	 */
 	int process_args(const int argc, const char **argv);
 
+	/**
+	 * Run the commands from a file (one per line) in a single session with the server.
+	 * Empty lines and lines starting with '#' are ignored.
+	 *
+	 * @param file: file name, or "-" for stdin
+	 * @return 0 if all commands succeeded, otherwise the first nonzero return value
+	 */
+	int process_batch(const char *file);
+
 private:
-	int _send_cmds(const int argc, const char **argv);
-	int _listen();
+	int _connect();
+	int _send_cmd(std::string cmd_buf, char flags);
+
+	/**
+	 * Forward the response of the server to stdout.
+	 * @param session: if true, return after the first response instead of waiting for the server to close the connection
+	 * @return return value of the command
+	 */
+	int _listen(bool session = false);
 
 	int _fd;
 	int _instance_id; ///< instance ID for running multiple instances of the px4 server
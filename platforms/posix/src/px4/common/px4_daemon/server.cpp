@@ -64,6 +64,7 @@ Server *Server::_instance = nullptr;
 
 Server::Server(int instance_id)
 	: _mutex(PTHREAD_MUTEX_INITIALIZER),
+	  _cond(PTHREAD_COND_INITIALIZER),
 	  _instance_id(instance_id)
 {
 	_instance = this;
@@ -103,6 +104,14 @@ Server::start()
 		return -1;
 	}
 
+	if (pipe(_wakeup_pipe) < 0) {
+		PX4_ERR("error creating wakeup pipe: %s", strerror(errno));
+		return -1;
+	}
+
+	fcntl(_wakeup_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(_wakeup_pipe[1], F_SETFL, O_NONBLOCK);
+
 	if (0 != pthread_create(&_server_main_pthread,
 				nullptr,
 				_server_main_trampoline,
@@ -142,14 +151,23 @@ Server::_server_main()
 	// Watch the listening socket for incoming connections.
 	poll_fds.push_back(pollfd {_fd, POLLIN, 0});
 
+	// Watch the wakeup pipe for connections closed by a worker.
+	poll_fds.push_back(pollfd {_wakeup_pipe[0], POLLIN, 0});
+
+	static constexpr size_t num_fixed_fds = 2;
+
 	// The list of FILE pointers that we'll need to fclose().
-	// stdouts[i] corresponds to poll_fds[i+1].
+	// stdouts[i] corresponds to poll_fds[i + num_fixed_fds].
 	std::vector<FILE *> stdouts;
 
 	while (true) {
 		int n_ready = poll(poll_fds.data(), poll_fds.size(), -1);
 
 		if (n_ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
 			PX4_ERR("poll() failed: %s", strerror(errno));
 			return;
 		}
@@ -177,19 +195,10 @@ Server::_server_main()
 				// Set stream to line buffered.
 				setvbuf(thread_stdout, nullptr, _IOLBF, BUFSIZ);
 
-				// Start a new thread to handle the client.
-				pthread_t *thread = &_fd_to_thread[client];
-				ret = pthread_create(thread, nullptr, Server::_handle_client, thread_stdout);
-
-				if (ret != 0) {
-					PX4_ERR("could not start pthread (%i)", ret);
-					_fd_to_thread.erase(client);
+				if (_dispatch(thread_stdout) != 0) {
 					fclose(thread_stdout);
 
 				} else {
-					// We won't join the thread, so detach to automatically release resources at its end
-					pthread_detach(*thread);
-
 					// Start listening for the client hanging up.
 					poll_fds.push_back(pollfd {client, POLLHUP, 0});
 
@@ -199,21 +208,49 @@ Server::_server_main()
 			}
 		}
 
+		if (poll_fds[1].revents & POLLIN) {
+			--n_ready;
+			char buf[16];
+
+			while (read(_wakeup_pipe[0], buf, sizeof(buf)) > 0) {}
+		}
+
 		// Handle any closed connections.
-		for (size_t i = 1; n_ready > 0 && i < poll_fds.size();) {
-			if (poll_fds[i].revents) {
+		for (size_t i = num_fixed_fds; i < poll_fds.size();) {
+			FILE *client_stdout = stdouts[i - num_fixed_fds];
+			const int client = fileno(client_stdout);
+			bool close_client = false;
+
+			if (poll_fds[i].fd < 0) {
+				// Hang-up was deferred until the worker is done with the connection.
+				close_client = _fd_to_thread.find(client) == _fd_to_thread.end();
+
+			} else if (n_ready > 0 && poll_fds[i].revents) {
 				--n_ready;
-				auto thread = _fd_to_thread.find(poll_fds[i].fd);
+				auto thread = _fd_to_thread.find(client);
 
-				if (thread != _fd_to_thread.end()) {
-					// Thread is still running, so we cancel it.
+				if (thread == _fd_to_thread.end()) {
+					// The worker already finished with this connection.
+					close_client = true;
+
+				} else if (thread->second.running) {
+					// Command is still running, so we cancel it.
 					// TODO: use a more graceful exit method to avoid resource leaks
-					pthread_cancel(thread->second);
+					pthread_cancel(thread->second.thread);
 					_fd_to_thread.erase(thread);
+					close_client = true;
+
+				} else {
+					// The worker is waiting for the next command (or did not pick up
+					// the connection yet) and will notice the hang-up by itself.
+					// Stop polling the fd (it keeps signalling POLLHUP) until then.
+					poll_fds[i].fd = -1;
 				}
+			}
 
-				fclose(stdouts[i - 1]);
-				stdouts.erase(stdouts.begin() + i - 1);
+			if (close_client) {
+				fclose(client_stdout);
+				stdouts.erase(stdouts.begin() + (i - num_fixed_fds));
 				poll_fds.erase(poll_fds.begin() + i);
 
 			} else {
@@ -227,84 +264,233 @@ Server::_server_main()
 	close(_fd);
 }
 
+int
+Server::_dispatch(FILE *client_stdout)
+{
+	const int client = fileno(client_stdout);
+
+	// Start a new worker if there is no idle one left to pick up the connection.
+	if (_num_idle_workers <= (int)_pending_clients.size()) {
+		pthread_t thread;
+		int ret = pthread_create(&thread, nullptr, Server::_worker_trampoline, this);
+
+		if (ret != 0) {
+			PX4_ERR("could not start pthread (%i)", ret);
+
+			if (_num_workers == 0) {
+				return -1;
+			}
+
+			// Fall through and queue the client for one of the existing workers.
+
+		} else {
+			// We won't join the thread, so detach to automatically release resources at its end
+			pthread_detach(thread);
+			++_num_workers;
+		}
+	}
+
+	_fd_to_thread[client] = ClientState{pthread_t{}, false};
+	_pending_clients.push_back(client_stdout);
+	pthread_cond_signal(&_cond);
+	return 0;
+}
+
+void *
+Server::_worker_trampoline(void *self)
+{
+	((Server *)self)->_worker();
+	return nullptr;
+}
+
+void
+Server::_worker_cancelled(void *arg)
+{
+	Server *self = (Server *)arg;
+	self->_lock();
+	--self->_num_workers;
+	self->_unlock();
+}
+
 void
-*Server::_handle_client(void *arg)
+Server::_worker()
 {
-	FILE *out = (FILE *)arg;
-	int fd = fileno(out);
+	// Cancellation is only allowed while a command is running.
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, nullptr);
 
-	// Read until the end of the incoming stream.
-	std::string cmd;
+	// We register thread specific data. This is used for PX4_INFO (etc.) log calls.
+	// It is deleted by _pthread_key_destructor when the worker exits.
+	CmdThreadSpecificData *thread_data = new CmdThreadSpecificData;
+	thread_data->thread_stdout = nullptr;
+	thread_data->is_atty = false;
+	(void)pthread_setspecific(_key, (void *)thread_data);
+
+	pthread_cleanup_push(_worker_cancelled, this);
+
+	_lock();
 
 	while (true) {
-		size_t n = cmd.size();
-		cmd.resize(n + 1024);
-		ssize_t n_read = read(fd, &cmd[n], cmd.size() - n);
+		while (_pending_clients.empty()) {
+			++_num_idle_workers;
+			pthread_cond_wait(&_cond, &_mutex);
+			--_num_idle_workers;
+		}
 
-		if (n_read <= 0) {
-			_cleanup(fd);
-			return nullptr;
+		FILE *out = _pending_clients.front();
+		_pending_clients.pop_front();
+
+		auto client = _fd_to_thread.find(fileno(out));
+
+		if (client != _fd_to_thread.end()) {
+			client->second.thread = pthread_self();
 		}
 
-		cmd.resize(n + n_read);
+		_unlock();
+
+		_serve_client(out, thread_data);
 
-		// Command ends in 0x00 (no tty) or 0x01 (tty).
-		if (!cmd.empty() && cmd.back() < 2) {
+		_lock();
+
+		// Keep a limited number of workers around for the next clients.
+		if (_pending_clients.empty() && _num_idle_workers >= MAX_IDLE_WORKERS) {
 			break;
 		}
 	}
 
-	if (cmd.size() < 2) {
-		_cleanup(fd);
-		return nullptr;
-	}
+	--_num_workers;
+	_unlock();
 
-	// Last byte is 'isatty'.
-	uint8_t isatty = cmd.back();
-	cmd.pop_back();
+	pthread_cleanup_pop(0);
+}
 
-	// We register thread specific data. This is used for PX4_INFO (etc.) log calls.
-	CmdThreadSpecificData *thread_data_ptr;
+void
+Server::_serve_client(FILE *out, CmdThreadSpecificData *thread_data)
+{
+	const int fd = fileno(out);
+	std::string buffer;
+	std::string cmd;
+	char flags = 0;
 
-	if ((thread_data_ptr = (CmdThreadSpecificData *)pthread_getspecific(_instance->_key)) == nullptr) {
-		thread_data_ptr = new CmdThreadSpecificData;
-		thread_data_ptr->thread_stdout = out;
-		thread_data_ptr->is_atty = isatty;
+	thread_data->thread_stdout = out;
 
-		(void)pthread_setspecific(_instance->_key, (void *)thread_data_ptr);
-	}
+	while (_read_cmd(fd, buffer, cmd, flags)) {
+		thread_data->is_atty = flags & CMD_FLAG_ISATTY;
+
+		_lock();
+		auto client = _fd_to_thread.find(fd);
+
+		if (client == _fd_to_thread.end()) {
+			// Connection was already torn down by the main thread.
+			_unlock();
+			break;
+		}
+
+		client->second.running = true;
+		_unlock();
+
+		// Run the actual command. The main thread cancels us if the client hangs up meanwhile.
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, nullptr);
+		int retval = Pxh::process_line(cmd, true);
 
-	// Run the actual command.
-	int retval = Pxh::process_line(cmd, true);
+		_lock();
+		// The entry is gone if the main thread cancelled us in the meantime.
+		client = _fd_to_thread.find(fd);
+
+		if (client != _fd_to_thread.end()) {
+			client->second.running = false;
+		}
+
+		_unlock();
+
+		// Act on a cancellation request that arrived after the command already returned,
+		// so that it does not hit the next client served by this worker.
+		pthread_testcancel();
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, nullptr);
+
+		// Report return value.
+		char buf[2] = {0, (char)retval};
+
+		if (fwrite(buf, sizeof buf, 1, out) != 1) {
+			// Don't care it went wrong, as the client will notice.
+		}
 
-	// Report return value.
-	char buf[2] = {0, (char)retval};
+		// Flush the FILE*'s buffer, the client waits for the return value.
+		fflush(out);
 
-	if (fwrite(buf, sizeof buf, 1, out) != 1) {
-		// Don't care it went wrong, as we're cleaning up anyway.
+		if (!(flags & CMD_FLAG_SESSION)) {
+			break;
+		}
 	}
 
-	// Flush the FILE*'s buffer before we shut down the connection.
-	fflush(out);
+	thread_data->thread_stdout = nullptr;
+	thread_data->is_atty = false;
 
 	_cleanup(fd);
-	return nullptr;
+}
+
+bool
+Server::_read_cmd(int fd, std::string &buffer, std::string &cmd, char &flags)
+{
+	// Command ends in the flags byte, which is always <= CMD_FLAGS_MAX.
+	auto is_terminator = [](char c) { return (unsigned char)c <= (unsigned char)CMD_FLAGS_MAX; };
+
+	size_t n_checked = 0;
+
+	while (true) {
+		for (; n_checked < buffer.size(); ++n_checked) {
+			if (is_terminator(buffer[n_checked])) {
+				cmd.assign(buffer, 0, n_checked);
+				flags = buffer[n_checked];
+				buffer.erase(0, n_checked + 1);
+
+				if (cmd.empty()) {
+					// Empty command: nothing to run.
+					return false;
+				}
+
+				return true;
+			}
+		}
+
+		size_t n = buffer.size();
+		buffer.resize(n + 1024);
+		ssize_t n_read = read(fd, &buffer[n], buffer.size() - n);
+
+		if (n_read <= 0) {
+			return false;
+		}
+
+		buffer.resize(n + n_read);
+	}
 }
 
 void
 Server::_cleanup(int fd)
 {
-	_instance->_lock();
-	_instance->_fd_to_thread.erase(fd);
-	_instance->_unlock();
+	_lock();
+	_fd_to_thread.erase(fd);
+	_unlock();
 
 	// We can't close() the fd here, since the main thread is probably
 	// polling for it: close()ing it causes a race condition.
 	// So, we only call shutdown(), which causes the main thread to register a
 	// 'POLLHUP', such that the main thread can close() it for us.
-	// We already removed this thread from _fd_to_thread, so there is no risk
-	// of the main thread trying to cancel this thread after it already exited.
+	// We already removed this connection from _fd_to_thread, so there is no risk
+	// of the main thread trying to cancel this thread after it already finished.
 	shutdown(fd, SHUT_RDWR);
+
+	// In case the main thread stopped polling the fd after the client hung up.
+	_wakeup();
+}
+
+void
+Server::_wakeup()
+{
+	char c = 0;
+
+	if (write(_wakeup_pipe[1], &c, 1) != 1) {
+		// The pipe is full, so the main thread is woken up already.
+	}
 }
 
 } //namespace px4_daemon
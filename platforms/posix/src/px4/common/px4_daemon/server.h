@@ -37,7 +37,12 @@
  *
  * Once a client connects it will send a command and close its side of the connection.
  * The server will return the stdout of the executing command, as well as the return
- * value to the client.
+ * value to the client. A client can also open a persistent session, in which case it
+ * can send any number of commands over the same connection.
+ *
+ * Connections are handled by a pool of worker threads, which are kept alive between
+ * clients. Additional workers are only started if all of them are busy (e.g. running
+ * a blocking command).
  *
  * There should only every be one server running, therefore the static instance.
  * The Singleton implementation is not complete, but it should be obvious not
@@ -53,7 +58,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <deque>
 #include <map>
+#include <string>
 
 #include "sock_protocol.h"
 
@@ -103,13 +110,51 @@ private:
 		pthread_mutex_unlock(&_mutex);
 	}
 
-	static void *_handle_client(void *arg);
-	static void _cleanup(int fd);
+	struct ClientState {
+		pthread_t thread; ///< worker thread serving this client
+		bool running;     ///< true while a command is executing
+	};
+
+	/**
+	 * Hand a new client connection to an idle worker, or start a new worker if all are busy.
+	 * Must be called with the lock held.
+	 * @return 0 on success
+	 */
+	int _dispatch(FILE *client_stdout);
+
+	static void *_worker_trampoline(void *arg);
+	void _worker();
+	static void _worker_cancelled(void *arg);
+
+	/**
+	 * Serve one client connection until the client closes it (or after a single
+	 * command if no session was requested).
+	 */
+	void _serve_client(FILE *out, CmdThreadSpecificData *thread_data);
+
+	/**
+	 * Read the next command from the client.
+	 * @param buffer receive buffer, which can contain the start of further commands
+	 * @return false if the client closed the connection
+	 */
+	static bool _read_cmd(int fd, std::string &buffer, std::string &cmd, char &flags);
+
+	void _cleanup(int fd);
+
+	void _wakeup();
 
 	pthread_t _server_main_pthread;
 
-	std::map<int, pthread_t> _fd_to_thread;
-	pthread_mutex_t _mutex; ///< Protects _fd_to_thread.
+	std::map<int, ClientState> _fd_to_thread;
+	std::deque<FILE *> _pending_clients; ///< accepted clients waiting for a worker
+	pthread_mutex_t _mutex; ///< Protects _fd_to_thread, _pending_clients and the worker counters.
+	pthread_cond_t _cond; ///< Signals new pending clients to idle workers
+
+	static constexpr int MAX_IDLE_WORKERS = 4; ///< number of workers kept alive between clients
+	int _num_workers{0};
+	int _num_idle_workers{0};
+
+	int _wakeup_pipe[2] {-1, -1}; ///< wakes up the main thread when a worker closed a connection
 
 	pthread_key_t _key;
 
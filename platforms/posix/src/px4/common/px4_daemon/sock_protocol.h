@@ -44,5 +44,13 @@ namespace px4_daemon
 
 std::string get_socket_path(int instance_id);
 
+/*
+ * A command is terminated by a flags byte, which cannot be part of the command itself.
+ * The response is the command output, followed by {0, return value}.
+ */
+static constexpr char CMD_FLAG_ISATTY = 0x01;  ///< stdout of the client is a terminal
+static constexpr char CMD_FLAG_SESSION = 0x02; ///< persistent session: keep the connection open for more commands
+static constexpr char CMD_FLAGS_MAX = CMD_FLAG_ISATTY | CMD_FLAG_SESSION;
+
 } // namespace px4_daemon
 
@@ -68,9 +68,15 @@ typedef void	(* hrt_callout)(void *arg);
 
 /**
  * Callout record.
+ *
+ * Must be zero-initialised (or initialised with hrt_call_init()) before it is used.
  */
 typedef struct hrt_call {
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+	struct dq_entry_s	link; // timer wheel slot list (circular, removal without knowing the slot)
+#else
 	struct sq_entry_s	link;
+#endif
 
 	hrt_abstime		deadline;
 	hrt_abstime		period;
@@ -129,7 +129,7 @@ public:
 	 *
 	 * Initialize all class variables.
 	 */
-	PX4IO(device::Device *interface);
+	PX4IO(PX4IO_serial *interface);
 
 	/**
 	 * Destructor.
@@ -205,7 +205,7 @@ public:
 	inline uint16_t		system_status() const {return _status;}
 
 private:
-	device::Device		*_interface;
+	PX4IO_serial		*_interface;
 
 	unsigned		_hardware;		///< Hardware revision
 	unsigned		_max_actuators;		///< Maximum # of actuators supported by PX4IO
@@ -234,6 +234,8 @@ private:
 	uint16_t		_last_written_arming_s{0};	///< the last written arming state reg
 	uint16_t		_last_written_arming_c{0};	///< the last written arming state reg
 
+	uint16_t		_cycle_regs[PX4IO_P_CYCLE_COUNT] {};	///< registers of the last cycle transaction
+
 	/* subscribed topics */
 	int			_t_actuator_controls_0;	///< actuator controls group 0 topic
 
@@ -299,10 +301,34 @@ private:
 	 */
 	int			io_set_control_state(unsigned group);
 
+	/**
+	 * Get the controls of one group in register format
+	 *
+	 * @param group		Control group.
+	 * @param regs		Registers to fill, PX4IO_PROTOCOL_MAX_CONTROL_COUNT wide.
+	 * @param num_regs	Number of registers to send, 0 if the controls must not be sent.
+	 * @return		OK if there are new controls.
+	 */
+	int			io_get_control_state(unsigned group, uint16_t *regs, unsigned &num_regs);
+
 	/**
 	 * Send all controls to IO
+	 *
+	 * @param cycle		Send group 0 with the cycle transaction.
+	 * @return		The result of the cycle transaction if cycle is set, else of the group 0 write.
+	 */
+	int			io_set_control_groups(bool cycle);
+
+	/**
+	 * Exchange the registers polled every cycle
+	 *
+	 * Writes the controls of group 0, if any, and reads PX4IO_PAGE_CYCLE in the same transaction.
+	 *
+	 * @param controls	Control group 0 registers.
+	 * @param num_controls	The number of control registers, 0 to only read.
+	 * @return		OK if the cycle registers were read.
 	 */
-	int			io_set_control_groups();
+	int			io_cycle(const uint16_t *controls, unsigned num_controls);
 
 	/**
 	 * Update IO's arming-related state
@@ -315,9 +341,9 @@ private:
 	int			io_set_rc_config();
 
 	/**
-	 * Fetch status and alarms from IO
+	 * Handle status and alarms of the last cycle transaction
 	 *
-	 * Also publishes battery voltage/current.
+	 * Also publishes the px4io_status.
 	 */
 	int			io_get_status();
 
@@ -327,7 +353,7 @@ private:
 	int			io_disable_rc_handling();
 
 	/**
-	 * Fetch RC inputs from IO.
+	 * Fetch RC inputs from the last cycle transaction and IO.
 	 *
 	 * @param input_rc	Input structure to populate.
 	 * @return		OK if data was returned.
@@ -340,7 +366,7 @@ private:
 	int			io_publish_raw_rc();
 
 	/**
-	 * Fetch and publish the PWM servo outputs.
+	 * Publish the PWM servo outputs of the last cycle transaction.
 	 */
 	int			io_publish_pwm_outputs();
 
@@ -444,7 +470,7 @@ PX4IO	*g_dev = nullptr;
 
 #define PX4IO_DEVICE_PATH	"/dev/px4io"
 
-PX4IO::PX4IO(device::Device *interface) :
+PX4IO::PX4IO(PX4IO_serial *interface) :
 	CDev(PX4IO_DEVICE_PATH),
 	_interface(interface),
 	_hardware(0),
@@ -607,7 +633,7 @@ PX4IO::init()
 	_max_transfer  = io_reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_MAX_TRANSFER) - 2;
 	_max_rc_input  = io_reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_RC_INPUT_COUNT);
 
-	if ((_max_actuators < 1) || (_max_actuators > 16) ||
+	if ((_max_actuators < 1) || (_max_actuators > PX4IO_P_CYCLE_SERVO_COUNT) ||
 	    (_max_relays > 32)   ||
 	    (_max_transfer < 16) || (_max_transfer > 255)  ||
 	    (_max_rc_input < 1)  || (_max_rc_input > 255)) {
@@ -661,7 +687,9 @@ PX4IO::init()
 	    (reg & PX4IO_P_SETUP_ARMING_FMU_ARMED)) {
 
 		/* get a status update from IO */
-		io_get_status();
+		if (io_cycle(nullptr, 0) == OK) {
+			io_get_status();
+		}
 
 		mavlink_log_emergency(&_mavlink_log_pub, "RECOVERING FROM FMU IN-AIR RESTART");
 
@@ -918,12 +946,19 @@ PX4IO::task_main()
 		perf_begin(_perf_update);
 		hrt_abstime now = hrt_absolute_time();
 
+		/* poll IO at 50-250Hz, new controls go out in the same transaction */
+		const bool poll_due = (now >= poll_last + IO_POLL_INTERVAL);
+		int cycle_ret = PX4_ERROR;
+
 		/* if we have new control data from the ORB, handle it */
 		if (fds[0].revents & POLLIN) {
 
 			/* we're not nice to the lower-priority control groups and only check them
 			   when the primary group updated (which is now). */
-			(void)io_set_control_groups();
+			cycle_ret = io_set_control_groups(poll_due);
+
+		} else if (poll_due) {
+			cycle_ret = io_cycle(nullptr, 0);
 		}
 
 		if (!_armed && !_lockdown_override) {
@@ -933,18 +968,19 @@ PX4IO::task_main()
 			_motor_test.in_test_mode = false;
 		}
 
-		if (now >= poll_last + IO_POLL_INTERVAL) {
-			/* run at 50-250Hz */
+		if (poll_due) {
 			poll_last = now;
 
-			/* pull status and alarms from IO */
-			io_get_status();
+			if (cycle_ret == OK) {
+				/* status and alarms */
+				io_get_status();
 
-			/* get raw R/C input from IO */
-			io_publish_raw_rc();
+				/* raw R/C input */
+				io_publish_raw_rc();
 
-			/* fetch PWM outputs from IO */
-			io_publish_pwm_outputs();
+				/* PWM outputs */
+				io_publish_pwm_outputs();
+			}
 
 			/* check updates on uORB topics and handle it */
 			bool updated = false;
@@ -1357,9 +1393,27 @@ void PX4IO::update_params()
 }
 
 int
-PX4IO::io_set_control_groups()
+PX4IO::io_set_control_groups(bool cycle)
 {
-	int ret = io_set_control_state(0);
+	int ret;
+
+	perf_begin(_perf_write);
+
+	if (cycle) {
+		uint16_t regs[PX4IO_PROTOCOL_MAX_CONTROL_COUNT];
+		unsigned num_regs = 0;
+
+		if (io_get_control_state(0, regs, num_regs) != OK) {
+			num_regs = 0;
+		}
+
+		ret = io_cycle(regs, num_regs);
+
+	} else {
+		ret = io_set_control_state(0);
+	}
+
+	perf_end(_perf_write);
 
 	/* send auxiliary control groups */
 	(void)io_set_control_state(1);
@@ -1371,6 +1425,22 @@ PX4IO::io_set_control_groups()
 
 int
 PX4IO::io_set_control_state(unsigned group)
+{
+	uint16_t regs[PX4IO_PROTOCOL_MAX_CONTROL_COUNT];
+	unsigned num_regs = 0;
+
+	int ret = io_get_control_state(group, regs, num_regs);
+
+	if ((ret != OK) || (num_regs == 0)) {
+		return ret;
+	}
+
+	/* copy values to registers in IO */
+	return io_reg_set(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, num_regs);
+}
+
+int
+PX4IO::io_get_control_state(unsigned group, uint16_t *regs, unsigned &num_regs)
 {
 	actuator_controls_s	controls{};	///< actuator outputs
 
@@ -1413,9 +1483,16 @@ PX4IO::io_set_control_state(unsigned group)
 		controls.control[3] = 1.0f;
 	}
 
-	uint16_t regs[sizeof(controls.control) / sizeof(controls.control[0])] = {};
+	static_assert(sizeof(controls.control) / sizeof(controls.control[0]) == PX4IO_PROTOCOL_MAX_CONTROL_COUNT,
+		      "controls must match the IO control group size");
+
+	num_regs = 0;
+
+	for (unsigned i = 0; i < PX4IO_PROTOCOL_MAX_CONTROL_COUNT; i++) {
+		regs[i] = 0;
+	}
 
-	for (unsigned i = 0; (i < _max_controls) && (i < sizeof(controls.control) / sizeof(controls.control[0])); i++) {
+	for (unsigned i = 0; (i < _max_controls) && (i < PX4IO_PROTOCOL_MAX_CONTROL_COUNT); i++) {
 		/* ensure FLOAT_TO_REG does not produce an integer overflow */
 		const float ctrl = math::constrain(controls.control[i], -1.0f, 1.0f);
 
@@ -1429,13 +1506,28 @@ PX4IO::io_set_control_state(unsigned group)
 	}
 
 	if (!_test_fmu_fail && !_motor_test.in_test_mode) {
-		/* copy values to registers in IO */
-		return io_reg_set(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, math::min(_max_controls,
-				  sizeof(controls.control) / sizeof(controls.control[0])));
+		num_regs = math::min(_max_controls, (unsigned)PX4IO_PROTOCOL_MAX_CONTROL_COUNT);
+	}
 
-	} else {
-		return OK;
+	return OK;
+}
+
+int
+PX4IO::io_cycle(const uint16_t *controls, unsigned num_controls)
+{
+	if (num_controls == 0) {
+		return io_reg_get(PX4IO_PAGE_CYCLE, 0, _cycle_regs, PX4IO_P_CYCLE_COUNT);
 	}
+
+	int ret = _interface->cycle((PX4IO_PAGE_CONTROLS << 8) | PX4IO_P_CONTROLS_GROUP_0, controls, num_controls,
+				    _cycle_regs, PX4IO_P_CYCLE_COUNT);
+
+	if (ret != PX4IO_P_CYCLE_COUNT) {
+		PX4_DEBUG("io_cycle(%u): error %d", num_controls, ret);
+		return -1;
+	}
+
+	return OK;
 }
 
 void
@@ -1892,21 +1984,11 @@ PX4IO::dsm_bind_ioctl(int dsmMode)
 int
 PX4IO::io_get_status()
 {
-	/* get
-	 * STATUS_FLAGS, STATUS_ALARMS, STATUS_VBATT, STATUS_IBATT,
-	 * STATUS_VSERVO, STATUS_VRSSI
-	 * in that order */
-	uint16_t regs[6] {};
-	int ret = io_reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS, &regs[0], sizeof(regs) / sizeof(regs[0]));
-
-	if (ret != OK) {
-		return ret;
-	}
-
-	const uint16_t STATUS_FLAGS  = regs[0];
-	const uint16_t STATUS_ALARMS = regs[1];
-	const uint16_t STATUS_VSERVO = regs[4];
-	const uint16_t STATUS_VRSSI  = regs[5];
+	const uint16_t STATUS_FLAGS  = _cycle_regs[PX4IO_P_CYCLE_STATUS_FLAGS];
+	const uint16_t STATUS_ALARMS = _cycle_regs[PX4IO_P_CYCLE_STATUS_ALARMS];
+	const uint16_t STATUS_VSERVO = _cycle_regs[PX4IO_P_CYCLE_STATUS_VSERVO];
+	const uint16_t STATUS_VRSSI  = _cycle_regs[PX4IO_P_CYCLE_STATUS_VRSSI];
+	const uint16_t SETUP_ARMING  = _cycle_regs[PX4IO_P_CYCLE_SETUP_ARMING];
 
 	io_handle_status(STATUS_FLAGS);
 
@@ -1922,8 +2004,6 @@ PX4IO::io_get_status()
 		_analog_rc_rssi_stable = true;
 	}
 
-	const uint16_t SETUP_ARMING = io_reg_get(PX4IO_PAGE_SETUP, PX4IO_P_SETUP_ARMING);
-
 	if ((hrt_elapsed_time(&_last_status_publish) >= 1_s)
 	    || (_status != STATUS_FLAGS)
 	    || (_alarms != STATUS_ALARMS)
@@ -1979,16 +2059,23 @@ PX4IO::io_get_status()
 		status.arming_termination_failsafe = SETUP_ARMING & PX4IO_P_SETUP_ARMING_TERMINATION_FAILSAFE;
 		status.arming_override_immediate   = SETUP_ARMING & PX4IO_P_SETUP_ARMING_OVERRIDE_IMMEDIATE;
 
+		uint16_t actuators[PX4IO_P_CYCLE_SERVO_COUNT];
+
+		if (io_reg_get(PX4IO_PAGE_ACTUATORS, 0, actuators, _max_actuators) == OK) {
+			for (unsigned i = 0; i < _max_actuators; i++) {
+				status.actuators[i] = static_cast<int16_t>(actuators[i]);
+			}
+		}
 
 		for (unsigned i = 0; i < _max_actuators; i++) {
-			status.actuators[i] = static_cast<int16_t>(io_reg_get(PX4IO_PAGE_ACTUATORS, i));
-			status.servos[i] = io_reg_get(PX4IO_PAGE_SERVOS, i);
+			status.servos[i] = _cycle_regs[PX4IO_P_CYCLE_SERVOS + i];
 		}
 
-		uint16_t raw_inputs = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT);
+		const unsigned raw_inputs = math::min((unsigned)_cycle_regs[PX4IO_P_CYCLE_RAW_RC + PX4IO_P_RAW_RC_COUNT],
+						      (unsigned)(sizeof(status.raw_inputs) / sizeof(status.raw_inputs[0])));
 
-		for (unsigned i = 0; i < raw_inputs; i++) {
-			status.raw_inputs[i] = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + i);
+		if (raw_inputs > 0) {
+			io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE, status.raw_inputs, raw_inputs);
 		}
 
 		status.timestamp = hrt_absolute_time();
@@ -2000,14 +2087,14 @@ PX4IO::io_get_status()
 	_alarms = STATUS_ALARMS;
 	_setup_arming = SETUP_ARMING;
 
-	return ret;
+	return OK;
 }
 
 int
 PX4IO::io_get_raw_rc_input(input_rc_s &input_rc)
 {
 	uint32_t channel_count;
-	int	ret;
+	int	ret = OK;
 
 	/* we don't have the status bits, so input_source has to be set elsewhere */
 	input_rc.input_source = input_rc_s::RC_INPUT_SOURCE_UNKNOWN;
@@ -2016,15 +2103,11 @@ PX4IO::io_get_raw_rc_input(input_rc_s &input_rc)
 	uint16_t regs[input_rc_s::RC_INPUT_MAX_CHANNELS + prolog];
 
 	/*
-	 * Read the channel count and the first 9 channels.
+	 * The channel count and the first 9 channels come with the cycle transaction.
 	 *
 	 * This should be the common case (9 channel R/C control being a reasonable upper bound).
 	 */
-	ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT, &regs[0], prolog + 9);
-
-	if (ret != OK) {
-		return ret;
-	}
+	memcpy(&regs[0], &_cycle_regs[PX4IO_P_CYCLE_RAW_RC], (prolog + PX4IO_P_CYCLE_RAW_RC_CHANNELS) * sizeof(regs[0]));
 
 	/*
 	 * Get the channel count any any extra channels. This is no more expensive than reading the
@@ -2076,8 +2159,9 @@ PX4IO::io_get_raw_rc_input(input_rc_s &input_rc)
 	/* FIELDS NOT SET HERE */
 	/* input_rc.input_source is set after this call XXX we might want to mirror the flags in the RC struct */
 
-	if (channel_count > 9) {
-		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + 9, &regs[prolog + 9], channel_count - 9);
+	if (channel_count > PX4IO_P_CYCLE_RAW_RC_CHANNELS) {
+		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + PX4IO_P_CYCLE_RAW_RC_CHANNELS,
+				 &regs[prolog + PX4IO_P_CYCLE_RAW_RC_CHANNELS], channel_count - PX4IO_P_CYCLE_RAW_RC_CHANNELS);
 
 		if (ret != OK) {
 			return ret;
@@ -2157,32 +2241,20 @@ PX4IO::io_publish_pwm_outputs()
 		return OK;
 	}
 
-	/* get servo values from IO */
-	uint16_t ctl[_max_actuators];
-	int ret = io_reg_get(PX4IO_PAGE_SERVOS, 0, ctl, _max_actuators);
-
-	if (ret != OK) {
-		return ret;
-	}
-
 	actuator_outputs_s outputs = {};
 	outputs.timestamp = hrt_absolute_time();
 	outputs.noutputs = _max_actuators;
 
 	/* convert from register format to float */
 	for (unsigned i = 0; i < _max_actuators; i++) {
-		outputs.output[i] = ctl[i];
+		outputs.output[i] = _cycle_regs[PX4IO_P_CYCLE_SERVOS + i];
 	}
 
 	_to_outputs.publish(outputs);
 
-	/* get mixer status flags from IO */
+	/* mixer status flags */
 	MultirotorMixer::saturation_status saturation_status;
-	ret = io_reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_MIXER, &saturation_status.value, 1);
-
-	if (ret != OK) {
-		return ret;
-	}
+	saturation_status.value = _cycle_regs[PX4IO_P_CYCLE_STATUS_MIXER];
 
 	/* publish mixer status */
 	if (saturation_status.flags.valid) {
@@ -3069,10 +3141,10 @@ extern "C" __EXPORT int px4io_main(int argc, char *argv[]);
 namespace
 {
 
-device::Device *
+PX4IO_serial *
 get_interface()
 {
-	device::Device *interface = nullptr;
+	PX4IO_serial *interface = nullptr;
 
 #ifdef PX4IO_SERIAL_BASE
 	interface = PX4IO_serial_interface();
@@ -3102,7 +3174,7 @@ start(int argc, char *argv[])
 	}
 
 	/* allocate the interface */
-	device::Device *interface = get_interface();
+	PX4IO_serial *interface = get_interface();
 
 	/* create the driver - it will set g_dev */
 	(void)new PX4IO(interface);
@@ -3145,7 +3217,7 @@ detect(int argc, char *argv[])
 	}
 
 	/* allocate the interface */
-	device::Device *interface = get_interface();
+	PX4IO_serial *interface = get_interface();
 
 	/* create the driver - it will set g_dev */
 	(void)new PX4IO(interface);
@@ -3175,7 +3247,7 @@ checkcrc(int argc, char *argv[])
 
 	if (g_dev == nullptr) {
 		/* allocate the interface */
-		device::Device *interface = get_interface();
+		PX4IO_serial *interface = get_interface();
 
 		/* create the driver - it will set g_dev */
 		(void)new PX4IO(interface);
@@ -3423,7 +3495,7 @@ px4io_main(int argc, char *argv[])
 
 			if (g_dev == nullptr) {
 				/* allocate the interface */
-				device::Device *interface = get_interface();
+				PX4IO_serial *interface = get_interface();
 
 				/* create the driver - it will set g_dev */
 				(void)new PX4IO(interface);
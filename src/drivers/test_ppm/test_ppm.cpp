@@ -78,7 +78,7 @@ public:
 protected:
 
 private:
-	struct hrt_call		_call;
+	struct hrt_call		_call{};
 	unsigned 		_call_times;
 	void			start();
 
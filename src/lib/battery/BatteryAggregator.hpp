@@ -0,0 +1,193 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file BatteryAggregator.hpp
+ *
+ * Combined state of all battery packs of the vehicle from their battery_status instances.
+ * The packs are kept as structure of arrays and reduced in a single pass.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <drivers/drv_hrt.h>
+#include <px4_platform_common/defines.h>
+#include <uORB/topics/battery_status.h>
+
+class BatteryAggregator
+{
+public:
+	static constexpr int MAX_PACKS = battery_status_s::MAX_INSTANCES;
+
+	/** Store the latest status of pack i. */
+	void update(int i, const battery_status_s &status)
+	{
+		if ((i < 0) || (i >= MAX_PACKS)) {
+			return;
+		}
+
+		_connected[i] = status.connected;
+		_timestamp[i] = status.timestamp;
+		_warning[i] = status.warning;
+		_current_a[i] = status.current_filtered_a;
+		_remaining[i] = status.remaining;
+		_capacity_mah[i] = static_cast<float>(status.capacity);
+	}
+
+	/** Pack i is not published (anymore). */
+	void clear(int i)
+	{
+		if ((i >= 0) && (i < MAX_PACKS)) {
+			_connected[i] = false;
+		}
+	}
+
+	/**
+	 * Reduce all connected packs and update the flight time estimate.
+	 * @param now current time, the oldest pack update if no pack is connected
+	 */
+	void aggregate(hrt_abstime now)
+	{
+		int connected = 0;
+		int capacity_known = 0;
+		uint8_t warning = battery_status_s::BATTERY_WARNING_NONE;
+		hrt_abstime oldest_timestamp = now;
+		float current_a = 0.f;
+		float remaining_sum = 0.f;
+		float capacity_mah = 0.f;
+		float remaining_capacity_mah = 0.f;
+
+		for (int i = 0; i < MAX_PACKS; i++) {
+			if (!_connected[i]) {
+				continue;
+			}
+
+			connected++;
+			warning = (_warning[i] > warning) ? _warning[i] : warning;
+			oldest_timestamp = (_timestamp[i] < oldest_timestamp) ? _timestamp[i] : oldest_timestamp;
+			current_a += _current_a[i];
+			remaining_sum += _remaining[i];
+
+			if (_capacity_mah[i] > 0.f) {
+				capacity_known++;
+				capacity_mah += _capacity_mah[i];
+				remaining_capacity_mah += _remaining[i] * _capacity_mah[i];
+			}
+		}
+
+		_connected_count = connected;
+		_worst_warning = warning;
+		_oldest_timestamp = oldest_timestamp;
+		_total_current_a = current_a;
+
+		if (connected == 0) {
+			_remaining_total = NAN;
+			_remaining_capacity_mah = NAN;
+
+		} else if (capacity_known == connected) {
+			// packs of different size contribute by their capacity
+			_remaining_total = remaining_capacity_mah / capacity_mah;
+			_remaining_capacity_mah = remaining_capacity_mah;
+
+		} else {
+			_remaining_total = remaining_sum / connected;
+			_remaining_capacity_mah = NAN;
+		}
+
+		// low pass of the total current over the last AVERAGE_CURRENT_TIME_CONSTANT
+		if ((_last_aggregate == 0) || !PX4_ISFINITE(_average_current_a)) {
+			_average_current_a = current_a;
+
+		} else if (now > _last_aggregate) {
+			const float dt = (now - _last_aggregate) * 1e-6f;
+			_average_current_a += (current_a - _average_current_a) * dt / (AVERAGE_CURRENT_TIME_CONSTANT + dt);
+		}
+
+		_last_aggregate = now;
+	}
+
+	int connected() const { return _connected_count; }
+
+	/** most urgent warning of all connected packs */
+	uint8_t warning() const { return _worst_warning; }
+
+	/** last update of the connected pack that updated longest ago */
+	hrt_abstime oldestTimestamp() const { return _oldest_timestamp; }
+
+	/** [A] sum of the filtered current of all connected packs */
+	float current() const { return _total_current_a; }
+
+	/** [0, 1] of all connected packs, weighted by capacity if every capacity is known, NAN without a pack */
+	float remaining() const { return _remaining_total; }
+
+	/** [mAh] NAN if the capacity of a connected pack is unknown */
+	float remainingCapacity() const { return _remaining_capacity_mah; }
+
+	/** [s] until all packs are empty at the average current, NAN if unknown */
+	float flightTimeRemaining() const
+	{
+		if (!PX4_ISFINITE(_remaining_capacity_mah) || !(_average_current_a > MIN_DISCHARGE_CURRENT)) {
+			return NAN;
+		}
+
+		// [mAh] / [A] * 3.6 = [s]
+		return _remaining_capacity_mah / _average_current_a * 3.6f;
+	}
+
+private:
+	static constexpr float AVERAGE_CURRENT_TIME_CONSTANT = 30.f;	///< [s]
+	static constexpr float MIN_DISCHARGE_CURRENT = 0.1f;		///< [A]
+
+	/* packs (structure of arrays) */
+	bool _connected[MAX_PACKS] {};
+	hrt_abstime _timestamp[MAX_PACKS] {};
+	uint8_t _warning[MAX_PACKS] {};
+	float _current_a[MAX_PACKS] {};
+	float _remaining[MAX_PACKS] {};
+	float _capacity_mah[MAX_PACKS] {};
+
+	/* result of the last aggregate() */
+	int _connected_count{0};
+	uint8_t _worst_warning{battery_status_s::BATTERY_WARNING_NONE};
+	hrt_abstime _oldest_timestamp{0};
+	float _total_current_a{0.f};
+	float _remaining_total{NAN};
+	float _remaining_capacity_mah{NAN};
+
+	float _average_current_a{0.f};
+	hrt_abstime _last_aggregate{0};
+};
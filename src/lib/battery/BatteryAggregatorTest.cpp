@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "BatteryAggregator.hpp"
+
+static battery_status_s pack(float remaining, uint16_t capacity, float current_a, uint8_t warning,
+			     hrt_abstime timestamp)
+{
+	battery_status_s status{};
+	status.timestamp = timestamp;
+	status.connected = true;
+	status.remaining = remaining;
+	status.capacity = capacity;
+	status.current_filtered_a = current_a;
+	status.warning = warning;
+	return status;
+}
+
+TEST(BatteryAggregatorTest, NoPack)
+{
+	BatteryAggregator aggregator;
+	aggregator.aggregate(1000);
+
+	EXPECT_EQ(aggregator.connected(), 0);
+	EXPECT_EQ(aggregator.oldestTimestamp(), 1000u);
+	EXPECT_EQ(aggregator.warning(), static_cast<uint8_t>(battery_status_s::BATTERY_WARNING_NONE));
+	EXPECT_FALSE(PX4_ISFINITE(aggregator.remaining()));
+	EXPECT_FALSE(PX4_ISFINITE(aggregator.flightTimeRemaining()));
+}
+
+TEST(BatteryAggregatorTest, CapacityWeighted)
+{
+	BatteryAggregator aggregator;
+	aggregator.update(0, pack(0.8f, 10000, 20.f, battery_status_s::BATTERY_WARNING_NONE, 900));
+	aggregator.update(1, pack(0.2f, 5000, 10.f, battery_status_s::BATTERY_WARNING_LOW, 800));
+	aggregator.aggregate(1000);
+
+	EXPECT_EQ(aggregator.connected(), 2);
+	EXPECT_EQ(aggregator.oldestTimestamp(), 800u);
+	EXPECT_EQ(aggregator.warning(), static_cast<uint8_t>(battery_status_s::BATTERY_WARNING_LOW));
+	EXPECT_FLOAT_EQ(aggregator.current(), 30.f);
+	EXPECT_FLOAT_EQ(aggregator.remaining(), 0.6f);
+	EXPECT_FLOAT_EQ(aggregator.remainingCapacity(), 9000.f);
+
+	// 9000 mAh at 30 A
+	EXPECT_FLOAT_EQ(aggregator.flightTimeRemaining(), 1080.f);
+}
+
+TEST(BatteryAggregatorTest, UnknownCapacity)
+{
+	BatteryAggregator aggregator;
+	aggregator.update(0, pack(0.8f, 10000, 20.f, battery_status_s::BATTERY_WARNING_NONE, 900));
+	aggregator.update(2, pack(0.2f, 0, 10.f, battery_status_s::BATTERY_WARNING_NONE, 900));
+	aggregator.aggregate(1000);
+
+	// plain average and no flight time
+	EXPECT_FLOAT_EQ(aggregator.remaining(), 0.5f);
+	EXPECT_FALSE(PX4_ISFINITE(aggregator.flightTimeRemaining()));
+
+	aggregator.clear(2);
+	aggregator.aggregate(2000);
+	EXPECT_EQ(aggregator.connected(), 1);
+	EXPECT_FLOAT_EQ(aggregator.remaining(), 0.8f);
+}
+
+TEST(BatteryAggregatorTest, AverageCurrent)
+{
+	BatteryAggregator aggregator;
+	hrt_abstime now = 1000;
+	aggregator.update(0, pack(0.5f, 10000, 10.f, battery_status_s::BATTERY_WARNING_NONE, now));
+	aggregator.aggregate(now);
+	EXPECT_FLOAT_EQ(aggregator.flightTimeRemaining(), 1800.f);
+
+	// a short current spike barely changes the flight time
+	aggregator.update(0, pack(0.5f, 10000, 40.f, battery_status_s::BATTERY_WARNING_NONE, now));
+	now += 100000;
+	aggregator.aggregate(now);
+	EXPECT_GT(aggregator.flightTimeRemaining(), 1700.f);
+
+	// the average follows a sustained current
+	for (int i = 0; i < 3000; i++) {
+		now += 100000;
+		aggregator.aggregate(now);
+	}
+
+	EXPECT_NEAR(aggregator.flightTimeRemaining(), 450.f, 1.f);
+}
@@ -47,6 +47,32 @@
 
 using namespace time_literals;
 
+namespace
+{
+
+/**
+ * State of charge of a lithium polymer / lithium ion cell at rest, sampled at equidistant cell voltages
+ * between the empty (0) and the full (1) cell voltage. The knee below the empty voltage is not part of the
+ * usable capacity.
+ */
+constexpr float OCV_STATE_OF_CHARGE[] {
+	0.000f, 0.089f, 0.177f, 0.280f, 0.382f, 0.479f, 0.571f, 0.615f, 0.660f,
+	0.709f, 0.760f, 0.803f, 0.843f, 0.882f, 0.921f, 0.961f, 1.000f
+};
+
+constexpr int OCV_SEGMENTS = sizeof(OCV_STATE_OF_CHARGE) / sizeof(OCV_STATE_OF_CHARGE[0]) - 1;
+
+float ocvStateOfCharge(float cell_voltage, float v_empty, float v_charged)
+{
+	const float position = math::gradual(cell_voltage, v_empty, v_charged, 0.f, static_cast<float>(OCV_SEGMENTS));
+	const int segment = math::min(static_cast<int>(position), OCV_SEGMENTS - 1);
+	const float fraction = position - segment;
+
+	return OCV_STATE_OF_CHARGE[segment] + fraction * (OCV_STATE_OF_CHARGE[segment + 1] - OCV_STATE_OF_CHARGE[segment]);
+}
+
+} // namespace
+
 Battery::Battery(int index, ModuleParams *parent, const int sample_interval_us) :
 	ModuleParams(parent),
 	_index(index < 1 || index > 9 ? 1 : index)
@@ -55,6 +81,7 @@ Battery::Battery(int index, ModuleParams *parent, const int sample_interval_us)
 	_voltage_filter_v.setParameters(expected_filter_dt, 1.f);
 	_current_filter_a.setParameters(expected_filter_dt, .5f);
 	_throttle_filter.setParameters(expected_filter_dt, 1.f);
+	_average_current_filter_a.setParameters(expected_filter_dt, AVERAGE_CURRENT_TIME_CONSTANT);
 
 	if (index > 9 || index < 1) {
 		PX4_ERR("Battery index must be between 1 and 9 (inclusive). Received %d. Defaulting to 1.", index);
@@ -91,6 +118,7 @@ Battery::Battery(int index, ModuleParams *parent, const int sample_interval_us)
 	_param_handles.low_thr = param_find("BAT_LOW_THR");
 	_param_handles.crit_thr = param_find("BAT_CRIT_THR");
 	_param_handles.emergen_thr = param_find("BAT_EMERGEN_THR");
+	_param_handles.ocv_curve = param_find("BAT_OCV_CURVE");
 
 	_param_handles.v_empty_old = param_find("BAT_V_EMPTY");
 	_param_handles.v_charged_old = param_find("BAT_V_CHARGED");
@@ -128,11 +156,13 @@ void Battery::updateBatteryStatus(const hrt_abstime &timestamp, float voltage_v,
 		_voltage_filter_v.reset(voltage_v);
 		_current_filter_a.reset(current_a);
 		_throttle_filter.reset(throttle_normalized);
+		_average_current_filter_a.reset(current_a);
 	}
 
 	_voltage_filter_v.update(voltage_v);
 	_current_filter_a.update(current_a);
 	_throttle_filter.update(throttle_normalized);
+	_average_current_filter_a.update(current_a);
 	sumDischarged(timestamp, current_a);
 	estimateStateOfCharge(_voltage_filter_v.getState(), _current_filter_a.getState(), _throttle_filter.getState());
 	computeScale();
@@ -148,6 +178,9 @@ void Battery::updateBatteryStatus(const hrt_abstime &timestamp, float voltage_v,
 		_battery_status.scale = _scale;
 		_battery_status.current_a = current_a;
 		_battery_status.current_filtered_a = _current_filter_a.getState();
+		_battery_status.average_current_a = _average_current_filter_a.getState();
+		_battery_status.run_time_to_empty = timeToEmpty(_battery_status.current_filtered_a);
+		_battery_status.average_time_to_empty = timeToEmpty(_battery_status.average_current_a);
 		_battery_status.discharged_mah = _discharged_mah;
 		_battery_status.warning = _warning;
 		_battery_status.remaining = _state_of_charge;
@@ -212,7 +245,14 @@ void Battery::estimateStateOfCharge(const float voltage_v, const float current_a
 		cell_voltage += throttle * _params.v_load_drop;
 	}
 
-	_state_of_charge_volt_based = math::gradual(cell_voltage, _params.v_empty, _params.v_charged, 0.f, 1.f);
+	_cell_voltage_compensated_v = cell_voltage;
+
+	if (_params.ocv_curve == 1) {
+		_state_of_charge_volt_based = ocvStateOfCharge(cell_voltage, _params.v_empty, _params.v_charged);
+
+	} else {
+		_state_of_charge_volt_based = math::gradual(cell_voltage, _params.v_empty, _params.v_charged, 0.f, 1.f);
+	}
 
 	// choose which quantity we're using for final reporting
 	if (_params.capacity > 0.f) {
@@ -260,10 +300,8 @@ void Battery::determineWarning(bool connected)
 
 void Battery::computeScale()
 {
-	const float voltage_range = (_params.v_charged - _params.v_empty);
-
-	// reusing capacity calculation to get single cell voltage before drop
-	const float bat_v = _params.v_empty + (voltage_range * _state_of_charge_volt_based);
+	// single cell voltage before drop
+	const float bat_v = math::constrain(_cell_voltage_compensated_v, _params.v_empty, _params.v_charged);
 
 	_scale = _params.v_charged / bat_v;
 
@@ -275,6 +313,19 @@ void Battery::computeScale()
 	}
 }
 
+uint16_t Battery::timeToEmpty(float current_a) const
+{
+	// remaining capacity at the given discharge current, unknown without capacity or discharge
+	if ((_params.capacity <= 0.f) || (current_a < MIN_DISCHARGE_CURRENT) || (_state_of_charge < 0.f)) {
+		return 0;
+	}
+
+	// [mAh] / ([A] * 1000) = [h]
+	const float minutes = _state_of_charge * _params.capacity / (current_a * 1e3f) * 60.f;
+
+	return static_cast<uint16_t>(math::min(minutes, static_cast<float>(UINT16_MAX)));
+}
+
 void Battery::updateParams()
 {
 	if (_index == 1) {
@@ -306,6 +357,7 @@ void Battery::updateParams()
 	param_get(_param_handles.low_thr, &_params.low_thr);
 	param_get(_param_handles.crit_thr, &_params.crit_thr);
 	param_get(_param_handles.emergen_thr, &_params.emergen_thr);
+	param_get(_param_handles.ocv_curve, &_params.ocv_curve);
 
 	ModuleParams::updateParams();
 
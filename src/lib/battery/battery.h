@@ -112,6 +112,7 @@ protected:
 		param_t low_thr;
 		param_t crit_thr;
 		param_t emergen_thr;
+		param_t ocv_curve;
 		param_t source;
 
 		// TODO: These parameters are depracated. They can be removed entirely once the
@@ -135,6 +136,7 @@ protected:
 		float low_thr;
 		float crit_thr;
 		float emergen_thr;
+		int ocv_curve;
 		int source;
 
 		// TODO: These parameters are depracated. They can be removed entirely once the
@@ -200,16 +202,27 @@ private:
 	void determineWarning(bool connected);
 	void computeScale();
 
+	/**
+	 * Remaining time until the battery is empty at a constant discharge current.
+	 * @return minutes, 0 if unknown
+	 */
+	uint16_t timeToEmpty(float current_a) const;
+
+	static constexpr float AVERAGE_CURRENT_TIME_CONSTANT = 30.f;	///< [s] of the average current
+	static constexpr float MIN_DISCHARGE_CURRENT = 0.1f;		///< [A] below which no time to empty is estimated
+
 	uORB::PublicationMulti<battery_status_s> _battery_status_pub{ORB_ID(battery_status)};
 
 	bool _battery_initialized{false};
 	AlphaFilter<float> _voltage_filter_v;
 	AlphaFilter<float> _current_filter_a;
 	AlphaFilter<float> _throttle_filter;
+	AlphaFilter<float> _average_current_filter_a;
 	float _discharged_mah{0.f};
 	float _discharged_mah_loop{0.f};
 	float _state_of_charge_volt_based{-1.f};	// [0,1]
 	float _state_of_charge{-1.f};				// [0,1]
+	float _cell_voltage_compensated_v{0.f};			// cell voltage corrected for the load drop
 	float _scale{1.f};
 	uint8_t _warning{battery_status_s::BATTERY_WARNING_NONE};
 	hrt_abstime _last_timestamp{0};
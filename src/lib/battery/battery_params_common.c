@@ -88,3 +88,20 @@ PARAM_DEFINE_FLOAT(BAT_CRIT_THR, 0.07f);
  * @reboot_required true
  */
 PARAM_DEFINE_FLOAT(BAT_EMERGEN_THR, 0.05f);
+
+/**
+ * State of charge from voltage
+ *
+ * Mapping of the load compensated cell voltage between the empty and full cell
+ * voltage of each battery (BAT1_V_EMPTY and BAT1_V_CHARGED for the first one,
+ * BAT2_V_EMPTY and BAT2_V_CHARGED for the second) to the voltage based state of
+ * charge. The lithium curve follows the flat middle part of the open circuit
+ * voltage of lithium polymer and lithium ion cells and reads a higher state of
+ * charge than the linear mapping at the same voltage.
+ *
+ * @group Battery Calibration
+ * @value 0 Linear
+ * @value 1 Lithium open circuit voltage curve
+ * @reboot_required true
+ */
+PARAM_DEFINE_INT32(BAT_OCV_CURVE, 0);
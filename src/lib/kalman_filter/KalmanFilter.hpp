@@ -0,0 +1,403 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file KalmanFilter.hpp
+ *
+ * Fixed-size linear / extended Kalman filter building blocks.
+ *
+ * The covariance is kept in packed symmetric storage. Measurements are fused one
+ * scalar at a time, which avoids any matrix inversion: a vector measurement with
+ * uncorrelated noise is processed as a sequence of scalar updates. Measurement rows
+ * with few non-zero entries can be given with their indices at compile time, in
+ * which case P * H^T costs O(N * nnz) instead of O(N^2). The covariance correction
+ * is a rank one update on the upper triangle (standard form) or a rank one plus
+ * rank two update (Joseph form), neither needs a full N x N product.
+ *
+ * Nonlinear measurement models are supported by passing the innovation
+ * (measurement - prediction) together with the Jacobian row.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "SymmetricMatrix.hpp"
+
+namespace kalman
+{
+
+enum class CovarianceUpdate {
+	Standard,	///< P = P - K * H * P, exact for the optimal gain
+	Joseph,		///< P = (I - K * H) * P * (I - K * H)^T + K * R * K^T, valid for any gain
+};
+
+template<typename Type>
+struct Innovation {
+	Type innovation{0};	///< measurement - predicted measurement
+	Type variance{0};	///< H * P * H^T + R
+	Type test_ratio{0};	///< innovation^2 / (gate^2 * variance), the measurement is rejected above 1
+	bool fused{false};
+};
+
+/**
+ * Normalized innovation squared of a vector measurement fused with fuseSequential() or
+ * fuseDirectSequential(). Equals r^T * S^-1 * r of the batch innovation when no component was gated.
+ * @return infinity if a component has no valid innovation variance
+ */
+template<typename Type, size_t M>
+Type normalizedInnovationSquared(const Innovation<Type>(&results)[M])
+{
+	Type sum = Type(0);
+
+	for (size_t m = 0; m < M; m++) {
+		if (!(results[m].variance > Type(0))) {
+			return INFINITY;
+		}
+
+		sum += results[m].innovation * results[m].innovation / results[m].variance;
+	}
+
+	return sum;
+}
+
+namespace detail
+{
+constexpr bool indices_valid(size_t) { return true; }
+
+template<typename... Rest>
+constexpr bool indices_valid(size_t n, size_t first, Rest... rest)
+{
+	return first < n && indices_valid(n, rest...);
+}
+} // namespace detail
+
+/**
+ * @tparam Type   float or double
+ * @tparam N      number of states
+ * @tparam UPDATE covariance update form. Updates always use the Joseph form while states are inhibited.
+ */
+template<typename Type, size_t N, CovarianceUpdate UPDATE = CovarianceUpdate::Standard>
+class KalmanFilter
+{
+public:
+	static_assert(N > 0 && N <= 32, "state count must fit the inhibit mask");
+
+	using Vector = matrix::Vector<Type, N>;
+	using Matrix = matrix::SquareMatrix<Type, N>;
+	using Covariance = SymmetricMatrix<Type, N>;
+	using Result = Innovation<Type>;
+
+	KalmanFilter() = default;
+	~KalmanFilter() = default;
+
+	void init(const Vector &x, const Covariance &P)
+	{
+		_x = x;
+		_P = P;
+	}
+
+	const Vector &state() const { return _x; }
+	Vector &state() { return _x; }
+
+	const Covariance &covariance() const { return _P; }
+	Covariance &covariance() { return _P; }
+
+	/**
+	 * Exclude states from the measurement corrections, e.g. while they are unobservable.
+	 * @param mask bit i set: state i is not corrected
+	 */
+	void setInhibitedStates(uint32_t mask) { _inhibit = mask; }
+	uint32_t inhibitedStates() const { return _inhibit; }
+
+	/**
+	 * Propagate state and covariance: x = F * x, P = F * P * F^T + Q.
+	 * Zero entries of F are skipped.
+	 */
+	void predict(const Matrix &F, const Covariance &Q)
+	{
+		Structure s;
+		s.update(F);
+
+		Vector x;
+
+		for (size_t i = 0; i < N; i++) {
+			Type sum = Type(0);
+
+			for (size_t k = 0; k < s.count[i]; k++) {
+				sum += F(i, s.cols[i][k]) * _x(s.cols[i][k]);
+			}
+
+			x(i) = sum;
+		}
+
+		_x = x;
+		propagateCovariance(F, s);
+		_P += Q;
+	}
+
+	/**
+	 * Propagate only the covariance, for filters that propagate the state themselves
+	 * (e.g. with a nonlinear model): P = F * P * F^T + Q. Zero entries of F are skipped.
+	 */
+	void predictCovariance(const Matrix &F, const Covariance &Q)
+	{
+		Structure s;
+		s.update(F);
+		propagateCovariance(F, s);
+		_P += Q;
+	}
+
+	/** as above with a diagonal process noise */
+	void predictCovariance(const Matrix &F, const Vector &q_diag)
+	{
+		Structure s;
+		s.update(F);
+		propagateCovariance(F, s);
+		_P.addDiagonal(q_diag);
+	}
+
+	/**
+	 * Fuse a scalar measurement with a dense measurement row.
+	 * @param H          measurement Jacobian row
+	 * @param innovation measurement - predicted measurement
+	 * @param R          measurement noise variance
+	 * @param gate       innovation gate in standard deviations, 0 to disable
+	 */
+	Result fuse(const Vector &H, Type innovation, Type R, Type gate = Type(0))
+	{
+		Vector PHt;
+		Type HPHt = Type(0);
+
+		for (size_t i = 0; i < N; i++) {
+			Type sum = Type(0);
+
+			for (size_t j = 0; j < N; j++) {
+				sum += _P(i, j) * H(j);
+			}
+
+			PHt(i) = sum;
+			HPHt += H(i) * sum;
+		}
+
+		return correct(PHt, HPHt, innovation, R, gate);
+	}
+
+	/**
+	 * Fuse a direct measurement of state I (H = e_I).
+	 */
+	template<size_t I>
+	Result fuseDirect(Type innovation, Type R, Type gate = Type(0))
+	{
+		static_assert(I < N, "state index out of range");
+		return fuseState(I, innovation, R, gate);
+	}
+
+	/**
+	 * Fuse a scalar measurement whose row has non-zero entries only at the states IDX.
+	 * @param h the non-zero entries, in the order of IDX
+	 */
+	template<size_t... IDX>
+	Result fuseSparse(const Type (&h)[sizeof...(IDX)], Type innovation, Type R, Type gate = Type(0))
+	{
+		static_assert(detail::indices_valid(N, IDX...), "state index out of range");
+		constexpr size_t idx[sizeof...(IDX)] {IDX...};
+
+		Vector PHt;
+
+		for (size_t i = 0; i < N; i++) {
+			Type sum = Type(0);
+
+			for (size_t k = 0; k < sizeof...(IDX); k++) {
+				sum += _P(i, idx[k]) * h[k];
+			}
+
+			PHt(i) = sum;
+		}
+
+		Type HPHt = Type(0);
+
+		for (size_t k = 0; k < sizeof...(IDX); k++) {
+			HPHt += h[k] * PHt(idx[k]);
+		}
+
+		return correct(PHt, HPHt, innovation, R, gate);
+	}
+
+	/**
+	 * Fuse a vector measurement with uncorrelated noise as a sequence of scalar updates.
+	 * The innovations are those of the state before the first update, they are corrected
+	 * for the state changes of the preceding updates with the linearized model.
+	 * @param results innovation and test ratio of every component
+	 */
+	template<size_t M>
+	void fuseSequential(const matrix::Matrix<Type, M, N> &H, const matrix::Vector<Type, M> &innovation,
+			    const matrix::Vector<Type, M> &R, Type gate, Result(&results)[M])
+	{
+		const Vector x_prior = _x;
+
+		for (size_t m = 0; m < M; m++) {
+			Vector H_row;
+			Type correction = Type(0);
+
+			for (size_t j = 0; j < N; j++) {
+				H_row(j) = H(m, j);
+				correction += H(m, j) * (_x(j) - x_prior(j));
+			}
+
+			results[m] = fuse(H_row, innovation(m) - correction, R(m), gate);
+		}
+	}
+
+	/**
+	 * Fuse direct measurements of the states IDX with uncorrelated noise, e.g. a position fix.
+	 */
+	template<size_t... IDX>
+	void fuseDirectSequential(const Type (&innovation)[sizeof...(IDX)], const Type (&R)[sizeof...(IDX)], Type gate,
+				  Result(&results)[sizeof...(IDX)])
+	{
+		static_assert(detail::indices_valid(N, IDX...), "state index out of range");
+		constexpr size_t idx[sizeof...(IDX)] {IDX...};
+
+		const Vector x_prior = _x;
+
+		for (size_t k = 0; k < sizeof...(IDX); k++) {
+			const Type correction = _x(idx[k]) - x_prior(idx[k]);
+			results[k] = fuseState(idx[k], innovation[k] - correction, R[k], gate);
+		}
+	}
+
+private:
+	/** column indices of the non-zero entries of every row of a transition matrix */
+	struct Structure {
+		uint8_t count[N] {};
+		uint8_t cols[N][N];
+
+		void update(const Matrix &F)
+		{
+			for (size_t i = 0; i < N; i++) {
+				count[i] = 0;
+
+				for (size_t j = 0; j < N; j++) {
+					if (std::fabs(F(i, j)) > Type(0)) {
+						cols[i][count[i]++] = static_cast<uint8_t>(j);
+					}
+				}
+			}
+		}
+	};
+
+	/** P = F * P * F^T, computing only the upper triangle */
+	void propagateCovariance(const Matrix &F, const Structure &s)
+	{
+		// F * P
+		Type FP[N][N];
+
+		for (size_t i = 0; i < N; i++) {
+			for (size_t j = 0; j < N; j++) {
+				Type sum = Type(0);
+
+				for (size_t k = 0; k < s.count[i]; k++) {
+					sum += F(i, s.cols[i][k]) * _P(s.cols[i][k], j);
+				}
+
+				FP[i][j] = sum;
+			}
+		}
+
+		// (F * P) * F^T
+		for (size_t i = 0; i < N; i++) {
+			for (size_t j = i; j < N; j++) {
+				Type sum = Type(0);
+
+				for (size_t k = 0; k < s.count[j]; k++) {
+					sum += FP[i][s.cols[j][k]] * F(j, s.cols[j][k]);
+				}
+
+				_P(i, j) = sum;
+			}
+		}
+	}
+
+	Result fuseState(size_t index, Type innovation, Type R, Type gate)
+	{
+		return correct(_P.col(index), _P(index, index), innovation, R, gate);
+	}
+
+	Result correct(const Vector &PHt, Type HPHt, Type innovation, Type R, Type gate)
+	{
+		Result result;
+		result.innovation = innovation;
+		result.variance = HPHt + R;
+
+		if (!(result.variance > Type(0)) || !PX4_ISFINITE(innovation)) {
+			result.test_ratio = INFINITY;
+			return result;
+		}
+
+		if (gate > Type(0)) {
+			result.test_ratio = innovation * innovation / (gate * gate * result.variance);
+
+			if (result.test_ratio > Type(1)) {
+				return result;
+			}
+		}
+
+		Vector K;
+
+		for (size_t i = 0; i < N; i++) {
+			K(i) = (_inhibit & (1u << i)) ? Type(0) : PHt(i) / result.variance;
+			_x(i) += K(i) * innovation;
+		}
+
+		if (UPDATE == CovarianceUpdate::Standard && _inhibit == 0) {
+			// P - P * H^T * H * P / S
+			_P.rankOneUpdate(-Type(1) / result.variance, PHt);
+
+		} else {
+			// Joseph form expanded for a scalar measurement: P - K * PHt^T - PHt * K^T + S * K * K^T
+			_P.rankTwoUpdate(-Type(1), K, PHt);
+			_P.rankOneUpdate(result.variance, K);
+		}
+
+		result.fused = true;
+		return result;
+	}
+
+	Vector _x{};
+	Covariance _P{};
+	uint32_t _inhibit{0};
+};
+
+} // namespace kalman
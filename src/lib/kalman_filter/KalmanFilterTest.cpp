@@ -0,0 +1,519 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file KalmanFilterTest.cpp
+ *
+ * Compares the packed, scalar and sparse updates of the Kalman filter toolkit against
+ * the textbook dense equations.
+ */
+
+#include <gtest/gtest.h>
+
+#include "KalmanFilter.hpp"
+
+using namespace kalman;
+
+namespace
+{
+
+static constexpr size_t N = 6;
+using Filter = KalmanFilter<float, N>;
+using JosephFilter = KalmanFilter<float, N, CovarianceUpdate::Joseph>;
+
+/** deterministic values in [-1, 1] */
+float pseudo_random()
+{
+	static uint32_t seed = 12345;
+	seed = seed * 1103515245u + 12345u;
+	return static_cast<float>((seed >> 8) & 0xffff) / 32767.5f - 1.f;
+}
+
+/** random symmetric positive definite covariance A * A^T + 0.1 * I */
+SymmetricMatrix<float, N> random_covariance()
+{
+	float A[N][N];
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++) {
+			A[i][j] = pseudo_random();
+		}
+	}
+
+	SymmetricMatrix<float, N> P;
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = i; j < N; j++) {
+			float sum = (i == j) ? 0.1f : 0.f;
+
+			for (size_t k = 0; k < N; k++) {
+				sum += A[i][k] * A[j][k];
+			}
+
+			P(i, j) = sum;
+		}
+	}
+
+	return P;
+}
+
+matrix::Vector<float, N> random_state()
+{
+	matrix::Vector<float, N> x;
+
+	for (size_t i = 0; i < N; i++) {
+		x(i) = 10.f * pseudo_random();
+	}
+
+	return x;
+}
+
+/** dense reference: x += K * innovation, P = (I - K * H) * P * (I - K * H)^T + K * R * K^T with K = P * H^T / S */
+void reference_update(double x[N], double P[N][N], const double H[N], double innovation, double R,
+		      uint32_t inhibit = 0)
+{
+	double PHt[N] {};
+	double S = R;
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++) {
+			PHt[i] += P[i][j] * H[j];
+		}
+
+		S += H[i] * PHt[i];
+	}
+
+	double K[N];
+
+	for (size_t i = 0; i < N; i++) {
+		K[i] = (inhibit & (1u << i)) ? 0. : PHt[i] / S;
+		x[i] += K[i] * innovation;
+	}
+
+	double IKH[N][N];
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++) {
+			IKH[i][j] = ((i == j) ? 1. : 0.) - K[i] * H[j];
+		}
+	}
+
+	double tmp[N][N] {};
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++) {
+			for (size_t k = 0; k < N; k++) {
+				tmp[i][j] += IKH[i][k] * P[k][j];
+			}
+		}
+	}
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++) {
+			double sum = K[i] * R * K[j];
+
+			for (size_t k = 0; k < N; k++) {
+				sum += tmp[i][k] * IKH[j][k];
+			}
+
+			P[i][j] = sum;
+		}
+	}
+}
+
+template<typename F>
+void load(const F &filter, double x[N], double P[N][N])
+{
+	for (size_t i = 0; i < N; i++) {
+		x[i] = filter.state()(i);
+
+		for (size_t j = 0; j < N; j++) {
+			P[i][j] = filter.covariance()(i, j);
+		}
+	}
+}
+
+template<typename F>
+void expect_equal(const F &filter, const double x[N], const double P[N][N], double tolerance = 1e-4)
+{
+	for (size_t i = 0; i < N; i++) {
+		EXPECT_NEAR(filter.state()(i), x[i], tolerance * (1. + fabs(x[i]))) << "state " << i;
+
+		for (size_t j = 0; j < N; j++) {
+			EXPECT_NEAR(filter.covariance()(i, j), P[i][j], tolerance * (1. + fabs(P[i][j]))) << "P " << i << ", " << j;
+		}
+	}
+}
+
+/** Cholesky decomposition succeeds */
+template<typename F>
+bool positive_definite(const F &filter)
+{
+	double L[N][N] {};
+
+	for (size_t j = 0; j < N; j++) {
+		double d = filter.covariance()(j, j);
+
+		for (size_t k = 0; k < j; k++) {
+			d -= L[j][k] * L[j][k];
+		}
+
+		if (!(d > 0.)) {
+			return false;
+		}
+
+		L[j][j] = sqrt(d);
+
+		for (size_t i = j + 1; i < N; i++) {
+			double s = filter.covariance()(i, j);
+
+			for (size_t k = 0; k < j; k++) {
+				s -= L[i][k] * L[j][k];
+			}
+
+			L[i][j] = s / L[j][j];
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+TEST(KalmanFilterTest, PackedIndex)
+{
+	using Covariance = SymmetricMatrix<float, N>;
+	bool used[Covariance::SIZE] {};
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = i; j < N; j++) {
+			const size_t k = Covariance::index(i, j);
+			ASSERT_LT(k, Covariance::SIZE);
+			EXPECT_FALSE(used[k]);
+			EXPECT_EQ(k, Covariance::index(j, i));
+			used[k] = true;
+		}
+	}
+}
+
+TEST(KalmanFilterTest, DenseUpdate)
+{
+	Filter kf;
+	kf.init(random_state(), random_covariance());
+
+	double x[N], P[N][N];
+	load(kf, x, P);
+
+	matrix::Vector<float, N> H;
+	double H_ref[N];
+
+	for (size_t i = 0; i < N; i++) {
+		H(i) = pseudo_random();
+		H_ref[i] = H(i);
+	}
+
+	const Filter::Result result = kf.fuse(H, 0.7f, 0.3f);
+	reference_update(x, P, H_ref, 0.7, 0.3);
+
+	EXPECT_TRUE(result.fused);
+	expect_equal(kf, x, P);
+}
+
+TEST(KalmanFilterTest, DirectUpdate)
+{
+	Filter direct;
+	direct.init(random_state(), random_covariance());
+	Filter dense = direct;
+
+	matrix::Vector<float, N> H{};
+	H(2) = 1.f;
+
+	direct.fuseDirect<2>(-1.5f, 0.2f);
+	dense.fuse(H, -1.5f, 0.2f);
+
+	double x[N], P[N][N];
+	load(dense, x, P);
+	expect_equal(direct, x, P, 1e-5);
+}
+
+TEST(KalmanFilterTest, SparseUpdate)
+{
+	Filter sparse;
+	sparse.init(random_state(), random_covariance());
+	Filter dense = sparse;
+
+	matrix::Vector<float, N> H{};
+	H(1) = 0.5f;
+	H(4) = -2.f;
+
+	sparse.fuseSparse<1, 4>({0.5f, -2.f}, 0.4f, 0.1f);
+	dense.fuse(H, 0.4f, 0.1f);
+
+	double x[N], P[N][N];
+	load(dense, x, P);
+	expect_equal(sparse, x, P, 1e-5);
+}
+
+TEST(KalmanFilterTest, JosephMatchesStandard)
+{
+	Filter standard;
+	standard.init(random_state(), random_covariance());
+
+	JosephFilter joseph;
+	joseph.init(standard.state(), standard.covariance());
+
+	standard.fuseSparse<0, 3, 5>({1.f, 0.2f, -0.3f}, 2.f, 0.05f);
+	joseph.fuseSparse<0, 3, 5>({1.f, 0.2f, -0.3f}, 2.f, 0.05f);
+
+	double x[N], P[N][N];
+	load(standard, x, P);
+	expect_equal(joseph, x, P);
+	EXPECT_TRUE(positive_definite(joseph));
+}
+
+TEST(KalmanFilterTest, InhibitedStates)
+{
+	Filter kf;
+	kf.init(random_state(), random_covariance());
+	kf.setInhibitedStates((1u << 1) | (1u << 3));
+
+	double x[N], P[N][N];
+	load(kf, x, P);
+	const double x1 = x[1];
+	const double x3 = x[3];
+
+	const double H_ref[N] {0.3, 1., 0., -0.5, 0., 0.};
+	matrix::Vector<float, N> H;
+
+	for (size_t i = 0; i < N; i++) {
+		H(i) = static_cast<float>(H_ref[i]);
+	}
+
+	kf.fuse(H, 1.2f, 0.5f);
+	reference_update(x, P, H_ref, 1.2, 0.5, kf.inhibitedStates());
+
+	expect_equal(kf, x, P);
+	EXPECT_FLOAT_EQ(kf.state()(1), static_cast<float>(x1));
+	EXPECT_FLOAT_EQ(kf.state()(3), static_cast<float>(x3));
+	EXPECT_TRUE(positive_definite(kf));
+}
+
+TEST(KalmanFilterTest, SequentialMatchesBatch)
+{
+	Filter kf;
+	kf.init(random_state(), random_covariance());
+
+	double x[N], P[N][N];
+	load(kf, x, P);
+
+	// two measurements: state 0 and state 1 + state 2, uncorrelated noise
+	matrix::Matrix<float, 2, N> H{};
+	H(0, 0) = 1.f;
+	H(1, 1) = 1.f;
+	H(1, 2) = 1.f;
+
+	matrix::Vector<float, 2> innovation;
+	innovation(0) = 0.8f;
+	innovation(1) = -0.6f;
+
+	matrix::Vector<float, 2> R;
+	R(0) = 0.2f;
+	R(1) = 0.4f;
+
+	Filter::Result results[2];
+	kf.fuseSequential(H, innovation, R, 0.f, results);
+
+	// batch reference: K = P * H^T * (H * P * H^T + R)^-1
+	double PHt[N][2] {};
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t m = 0; m < 2; m++) {
+			for (size_t j = 0; j < N; j++) {
+				PHt[i][m] += P[i][j] * static_cast<double>(H(m, j));
+			}
+		}
+	}
+
+	double S[2][2] {{static_cast<double>(R(0)), 0.}, {0., static_cast<double>(R(1))}};
+
+	for (size_t m = 0; m < 2; m++) {
+		for (size_t n = 0; n < 2; n++) {
+			for (size_t j = 0; j < N; j++) {
+				S[m][n] += static_cast<double>(H(m, j)) * PHt[j][n];
+			}
+		}
+	}
+
+	const double det = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+	const double S_inv[2][2] {{S[1][1] / det, -S[0][1] / det}, {-S[1][0] / det, S[0][0] / det}};
+
+	double K[N][2] {};
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t m = 0; m < 2; m++) {
+			for (size_t n = 0; n < 2; n++) {
+				K[i][m] += PHt[i][n] * S_inv[n][m];
+			}
+		}
+	}
+
+	double P_post[N][N];
+
+	for (size_t i = 0; i < N; i++) {
+		x[i] += K[i][0] * static_cast<double>(innovation(0)) + K[i][1] * static_cast<double>(innovation(1));
+
+		for (size_t j = 0; j < N; j++) {
+			P_post[i][j] = P[i][j] - K[i][0] * PHt[j][0] - K[i][1] * PHt[j][1];
+		}
+	}
+
+	// r^T * S^-1 * r of the batch innovation
+	const double r[2] {static_cast<double>(innovation(0)), static_cast<double>(innovation(1))};
+	double nis = 0.;
+
+	for (size_t m = 0; m < 2; m++) {
+		for (size_t n = 0; n < 2; n++) {
+			nis += r[m] * S_inv[m][n] * r[n];
+		}
+	}
+
+	EXPECT_TRUE(results[0].fused);
+	EXPECT_TRUE(results[1].fused);
+	EXPECT_NEAR(static_cast<double>(normalizedInnovationSquared(results)), nis, 1e-4);
+	expect_equal(kf, x, P_post, 1e-3);
+}
+
+TEST(KalmanFilterTest, DirectSequential)
+{
+	Filter sequential;
+	sequential.init(random_state(), random_covariance());
+	Filter sparse = sequential;
+
+	Filter::Result results[2];
+	sequential.fuseDirectSequential<0, 1>({0.5f, -0.25f}, {0.1f, 0.2f}, 0.f, results);
+
+	// the second innovation is corrected by the change of state 1 in the first update
+	const float x1 = sparse.state()(1);
+	sparse.fuseDirect<0>(0.5f, 0.1f);
+	sparse.fuseDirect<1>(-0.25f - (sparse.state()(1) - x1), 0.2f);
+
+	double x[N], P[N][N];
+	load(sparse, x, P);
+	expect_equal(sequential, x, P, 1e-5);
+}
+
+TEST(KalmanFilterTest, GateRejects)
+{
+	Filter kf;
+	kf.init(random_state(), random_covariance());
+	const float variance = kf.covariance()(0, 0);
+	const float x0 = kf.state()(0);
+
+	// 5 sigma innovation, 3 sigma gate
+	const float innovation = 5.f * sqrtf(variance + 1.f);
+	const Filter::Result result = kf.fuseDirect<0>(innovation, 1.f, 3.f);
+
+	EXPECT_FALSE(result.fused);
+	EXPECT_NEAR(result.test_ratio, 25.f / 9.f, 1e-4f);
+	EXPECT_FLOAT_EQ(kf.state()(0), x0);
+	EXPECT_FLOAT_EQ(kf.covariance()(0, 0), variance);
+}
+
+TEST(KalmanFilterTest, Predict)
+{
+	Filter kf;
+	kf.init(random_state(), random_covariance());
+
+	double x[N], P[N][N];
+	load(kf, x, P);
+
+	// constant velocity model for three axes: states are position and velocity pairs
+	const float dt = 0.01f;
+	matrix::SquareMatrix<float, N> F{};
+
+	for (size_t i = 0; i < N; i++) {
+		F(i, i) = 1.f;
+	}
+
+	F(0, 1) = F(2, 3) = F(4, 5) = dt;
+
+	SymmetricMatrix<float, N> Q;
+	Q.setDiagonal(0.01f);
+
+	kf.predict(F, Q);
+
+	double x_ref[N] {};
+	double FP[N][N] {};
+	double P_ref[N][N] {};
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t k = 0; k < N; k++) {
+			x_ref[i] += static_cast<double>(F(i, k)) * x[k];
+
+			for (size_t j = 0; j < N; j++) {
+				FP[i][j] += static_cast<double>(F(i, k)) * P[k][j];
+			}
+		}
+	}
+
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = 0; j < N; j++) {
+			P_ref[i][j] = (i == j) ? 0.01 : 0.;
+
+			for (size_t k = 0; k < N; k++) {
+				P_ref[i][j] += FP[i][k] * static_cast<double>(F(j, k));
+			}
+		}
+	}
+
+	expect_equal(kf, x_ref, P_ref, 1e-5);
+}
+
+TEST(KalmanFilterTest, ConstrainVariances)
+{
+	SymmetricMatrix<float, N> P = random_covariance();
+	P(2, 2) = -1.f;
+	P(4, 4) = 1000.f;
+
+	P.constrainVariances(0.01f, 100.f);
+
+	EXPECT_FLOAT_EQ(P(2, 2), 0.01f);
+	EXPECT_FLOAT_EQ(P(4, 4), 100.f);
+
+	for (size_t j = 0; j < N; j++) {
+		if (j != 2) {
+			EXPECT_FLOAT_EQ(P(2, j), 0.f);
+		}
+	}
+}
@@ -0,0 +1,256 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file SymmetricMatrix.hpp
+ *
+ * Symmetric square matrix in packed storage, used for Kalman filter covariances.
+ * Only the upper triangle is stored, so the matrix is symmetric by construction
+ * and updates only touch N * (N + 1) / 2 elements.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <stddef.h>
+
+#include <matrix/math.hpp>
+#include <px4_platform_common/defines.h>
+
+namespace kalman
+{
+
+template<typename Type, size_t N>
+class SymmetricMatrix
+{
+public:
+	static constexpr size_t SIZE = N * (N + 1) / 2;
+
+	SymmetricMatrix() = default;
+
+	/** copy the symmetric part (P + P^T) / 2 of a full matrix */
+	explicit SymmetricMatrix(const matrix::SquareMatrix<Type, N> &P)
+	{
+		for (size_t i = 0; i < N; i++) {
+			for (size_t j = i; j < N; j++) {
+				_data[index(i, j)] = (P(i, j) + P(j, i)) / Type(2);
+			}
+		}
+	}
+
+	/** position of element (i, j) in the packed upper triangle, rows first */
+	static constexpr size_t index(size_t i, size_t j)
+	{
+		return (i <= j) ? i * N - (i * (i + 1)) / 2 + j : index(j, i);
+	}
+
+	Type &operator()(size_t i, size_t j) { return _data[index(i, j)]; }
+	const Type &operator()(size_t i, size_t j) const { return _data[index(i, j)]; }
+
+	Type *data() { return _data; }
+	const Type *data() const { return _data; }
+
+	void setZero()
+	{
+		for (size_t k = 0; k < SIZE; k++) {
+			_data[k] = Type(0);
+		}
+	}
+
+	void setIdentity() { setDiagonal(Type(1)); }
+
+	/** zero the matrix and set every diagonal element to value */
+	void setDiagonal(Type value)
+	{
+		setZero();
+
+		for (size_t i = 0; i < N; i++) {
+			_data[index(i, i)] = value;
+		}
+	}
+
+	void setDiagonal(const matrix::Vector<Type, N> &diag)
+	{
+		setZero();
+
+		for (size_t i = 0; i < N; i++) {
+			_data[index(i, i)] = diag(i);
+		}
+	}
+
+	matrix::Vector<Type, N> diag() const
+	{
+		matrix::Vector<Type, N> d;
+
+		for (size_t i = 0; i < N; i++) {
+			d(i) = _data[index(i, i)];
+		}
+
+		return d;
+	}
+
+	/** column (equal to the row) j */
+	matrix::Vector<Type, N> col(size_t j) const
+	{
+		matrix::Vector<Type, N> c;
+
+		for (size_t i = 0; i < N; i++) {
+			c(i) = (*this)(i, j);
+		}
+
+		return c;
+	}
+
+	matrix::SquareMatrix<Type, N> full() const
+	{
+		matrix::SquareMatrix<Type, N> P;
+
+		for (size_t i = 0; i < N; i++) {
+			for (size_t j = i; j < N; j++) {
+				P(i, j) = P(j, i) = _data[index(i, j)];
+			}
+		}
+
+		return P;
+	}
+
+	SymmetricMatrix &operator+=(const SymmetricMatrix &other)
+	{
+		for (size_t k = 0; k < SIZE; k++) {
+			_data[k] += other._data[k];
+		}
+
+		return *this;
+	}
+
+	void addDiagonal(const matrix::Vector<Type, N> &diag)
+	{
+		for (size_t i = 0; i < N; i++) {
+			_data[index(i, i)] += diag(i);
+		}
+	}
+
+	/** this += alpha * v * v^T */
+	void rankOneUpdate(Type alpha, const matrix::Vector<Type, N> &v)
+	{
+		Type *p = _data;
+
+		for (size_t i = 0; i < N; i++) {
+			const Type av_i = alpha * v(i);
+
+			for (size_t j = i; j < N; j++) {
+				*p++ += av_i * v(j);
+			}
+		}
+	}
+
+	/** this += alpha * (a * b^T + b * a^T) */
+	void rankTwoUpdate(Type alpha, const matrix::Vector<Type, N> &a, const matrix::Vector<Type, N> &b)
+	{
+		Type *p = _data;
+
+		for (size_t i = 0; i < N; i++) {
+			const Type aa_i = alpha * a(i);
+			const Type ab_i = alpha * b(i);
+
+			for (size_t j = i; j < N; j++) {
+				*p++ += aa_i * b(j) + ab_i * a(j);
+			}
+		}
+	}
+
+	/** v^T * this * v */
+	Type quadraticForm(const matrix::Vector<Type, N> &v) const
+	{
+		Type sum = Type(0);
+
+		for (size_t i = 0; i < N; i++) {
+			sum += v(i) * v(i) * _data[index(i, i)];
+
+			for (size_t j = i + 1; j < N; j++) {
+				sum += Type(2) * v(i) * v(j) * _data[index(i, j)];
+			}
+		}
+
+		return sum;
+	}
+
+	/**
+	 * Clip the variances to [min_var, max_var]. A variance raised to min_var has its
+	 * covariances zeroed, a variance lowered to max_var has its covariances scaled down,
+	 * which keeps the matrix positive semi-definite.
+	 */
+	void constrainVariances(Type min_var, Type max_var)
+	{
+		for (size_t i = 0; i < N; i++) {
+			Type &var = _data[index(i, i)];
+
+			if (!(var >= min_var)) {
+				for (size_t j = 0; j < N; j++) {
+					(*this)(i, j) = Type(0);
+				}
+
+				var = min_var;
+
+			} else if (var > max_var) {
+				const Type scale = std::sqrt(max_var / var);
+
+				for (size_t j = 0; j < N; j++) {
+					(*this)(i, j) *= scale;
+				}
+
+				var = max_var;
+			}
+		}
+	}
+
+	bool isFinite() const
+	{
+		for (size_t k = 0; k < SIZE; k++) {
+			if (!PX4_ISFINITE(_data[k])) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	Type _data[SIZE] {};
+};
+
+template<typename Type, size_t N>
+constexpr size_t SymmetricMatrix<Type, N>::SIZE;
+
+} // namespace kalman
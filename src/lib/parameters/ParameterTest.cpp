@@ -106,3 +106,61 @@ TEST_F(ParameterTest, testUorbSendReceive)
 	// AND: all the bytes should be equal
 	EXPECT_EQ(0, memcmp(&message, &obstacle_distance, sizeof(message)));
 }
+
+
+TEST_F(ParameterTest, testParamChangedSince)
+{
+	// GIVEN: two parameter handles and the current generation
+	param_t param = param_handle(px4::params::CP_DIST);
+	param_t other_param = param_handle(px4::params::CP_DELAY);
+	const uint16_t generation = param_generation();
+
+	// THEN: none of them should be reported as changed
+	EXPECT_FALSE(param_changed_since(param, generation));
+	EXPECT_FALSE(param_changed_since(other_param, generation));
+
+	// WHEN: we set one parameter to a new value
+	float value = 42.f;
+	EXPECT_EQ(0, param_set(param, &value));
+
+	// THEN: only that one should be reported as changed
+	EXPECT_TRUE(param_changed_since(param, generation));
+	EXPECT_FALSE(param_changed_since(other_param, generation));
+
+	// WHEN: we set the same value again
+	const uint16_t generation2 = param_generation();
+	EXPECT_EQ(0, param_set(param, &value));
+
+	// THEN: it should not be reported as changed
+	EXPECT_FALSE(param_changed_since(param, generation2));
+
+	// WHEN: we reset the parameter
+	EXPECT_EQ(0, param_reset(param));
+
+	// THEN: it should be reported as changed again
+	EXPECT_TRUE(param_changed_since(param, generation2));
+	EXPECT_FALSE(param_changed_since(other_param, generation2));
+}
+
+
+TEST_F(ParameterTest, testParamUsedSince)
+{
+	// GIVEN: a parameter that is not used yet and the current generation
+	param_t param = param_handle(px4::params::CP_GUIDE_ANG);
+	ASSERT_FALSE(param_used(param));
+	const uint16_t generation = param_generation();
+
+	// WHEN: the parameter becomes used
+	param_set_used(param);
+
+	// THEN: it should be reported as changed, so that a delta sync includes it
+	EXPECT_TRUE(param_used(param));
+	EXPECT_TRUE(param_changed_since(param, generation));
+
+	// WHEN: it is marked used again
+	const uint16_t generation2 = param_generation();
+	param_set_used(param);
+
+	// THEN: it should not be reported as changed
+	EXPECT_FALSE(param_changed_since(param, generation2));
+}
@@ -273,6 +273,24 @@ __EXPORT int		param_set_no_notification(param_t param, const void *val);
  */
 __EXPORT void		param_notify_changes(void);
 
+/**
+ * Get the current parameter change generation. It is incremented whenever a parameter value
+ * changes (set, reset or a change of the default value) and wraps around.
+ *
+ * @return		The current generation.
+ */
+__EXPORT uint16_t	param_generation(void);
+
+/**
+ * Check if a parameter changed after a given generation. This does not take the parameter lock
+ * and can be used to cheaply skip parameter updates.
+ *
+ * @param param		A handle returned by param_find or passed by param_foreach.
+ * @param generation	A generation previously returned by param_generation().
+ * @return		True if the parameter value changed, or the parameter became used, after the given generation.
+ */
+__EXPORT bool		param_changed_since(param_t param, uint16_t generation);
+
 /**
  * Reset a parameter to its default value.
  *
@@ -388,7 +406,8 @@ __EXPORT const char	*param_get_default_file(void);
  * Save parameters to the default file.
  * Note: this method requires a large amount of stack size!
  *
- * This function saves all parameters with non-default values.
+ * This function saves all parameters with non-default values and clears the journal
+ * of the default file (compaction).
  *
  * @return		Zero on success.
  */
@@ -401,6 +420,15 @@ __EXPORT int 		param_save_default(void);
  */
 __EXPORT int 		param_load_default(void);
 
+/**
+ * Replay the journal of the default parameter file. Autosave appends changes to the journal
+ * instead of rewriting the default file, so this needs to be called after the default file
+ * has been imported or loaded.
+ *
+ * @return		Zero on success (including if there is no journal).
+ */
+__EXPORT int 		param_import_journal(void);
+
 /**
  * Generate the hash of all parameters and their values
  *
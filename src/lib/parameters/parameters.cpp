@@ -80,6 +80,7 @@ static const char *param_default_file = PX4_ROOTFSDIR"/eeprom/parameters";
 #endif
 
 static char *param_user_file = nullptr;
+static char *param_journal_file = nullptr;
 
 #ifdef __PX4_QURT
 #define PARAM_OPEN	px4_open
@@ -100,6 +101,16 @@ static constexpr uint16_t param_info_count = sizeof(px4::parameters) / sizeof(pa
 static px4::AtomicBitset<param_info_count> params_active;  // params found
 static px4::AtomicBitset<param_info_count> params_changed; // params non-default
 static px4::Bitset<param_info_count> params_custom_default; // params with runtime default value
+static px4::Bitset<param_info_count> params_reset_unsaved; // params reset to default, not yet saved
+
+// change generation tracking (see param_generation() and param_changed_since())
+static px4::atomic<uint16_t> param_generation_counter{0};
+static uint16_t params_generation[param_info_count] {}; // generation at which each param last changed
+
+// cached result of param_hash_check(), valid as long as no value and the set of used params did not change
+static px4::atomic<bool> param_hash_valid{false};
+static uint32_t param_hash_cached{0};
+static uint16_t param_hash_generation{0};
 
 // Storage for modified parameters.
 struct param_wbuf_s {
@@ -135,6 +146,32 @@ static px4_sem_t param_sem_save; ///< this protects against concurrent param sav
 ///< a param_set could still be blocked by a param save, because it
 ///< needs to take the reader lock
 
+static px4_sem_t param_sem_journal; ///< serializes journal appends and compaction (full saves to the default file)
+
+/*
+ * Parameter journal
+ *
+ * Between full saves to the default file (the snapshot), changes are appended as small
+ * checksummed records to a journal file next to it (<default file>.journal). On boot the
+ * snapshot is imported and then the journal is replayed. Once the journal grows beyond
+ * param_journal_max_records, the autosave worker compacts it by writing a new snapshot.
+ */
+struct __attribute__((packed)) param_journal_record_s {
+	uint8_t  magic;
+	uint8_t  type;     ///< param_type_t, or param_journal_type_reset
+	char     name[16]; ///< not null-terminated if 16 characters long
+	int32_t  value;
+	uint32_t crc;      ///< crc32 over all preceding fields
+};
+
+static constexpr uint8_t param_journal_magic = 0x9a;
+static constexpr uint8_t param_journal_type_reset = 0xff;
+static constexpr int param_journal_max_records = 256;
+
+static int param_journal_records = 0;              ///< number of records in the journal file
+static bool param_journal_compact_required = true; ///< journal state unknown or invalid, a full save is required
+static bool param_journal_unavailable = false;     ///< journal file cannot be created (e.g. raw MTD device)
+
 /** lock the parameter store for read access */
 static void
 param_lock_reader()
@@ -193,6 +230,7 @@ param_init()
 {
 	px4_sem_init(&param_sem, 0, 1);
 	px4_sem_init(&param_sem_save, 0, 1);
+	px4_sem_init(&param_sem_journal, 0, 1);
 	px4_sem_init(&reader_lock_holders_lock, 0, 1);
 
 	param_export_perf = perf_alloc(PC_ELAPSED, "param: export");
@@ -252,11 +290,55 @@ param_find_changed(param_t param)
 	return nullptr;
 }
 
+/**
+ * Record a change of a parameter value, or of its used state, by assigning it a new generation.
+ *
+ * This needs to be called with the writer lock held.
+ */
+static void
+param_mark_generation(param_t param)
+{
+	params_generation[param] = param_generation_counter.fetch_add(1) + 1;
+}
+
+/**
+ * Assign a new generation to all parameters (e.g. after a reset of all values).
+ *
+ * This needs to be called with the writer lock held.
+ */
+static void
+param_mark_generation_all()
+{
+	const uint16_t generation = param_generation_counter.fetch_add(1) + 1;
+
+	for (param_t param = 0; handle_in_range(param); param++) {
+		params_generation[param] = generation;
+	}
+}
+
+uint16_t
+param_generation()
+{
+	return param_generation_counter.load();
+}
+
+bool
+param_changed_since(param_t param, uint16_t generation)
+{
+	if (!handle_in_range(param)) {
+		return false;
+	}
+
+	// serial number arithmetic to handle wrap-around of the 16 bit generation counter
+	return (int16_t)(params_generation[param] - generation) > 0;
+}
+
 void
 param_notify_changes()
 {
 	parameter_update_s pup{};
 	pup.instance = param_instance++;
+	pup.generation = param_generation_counter.load();
 	pup.get_count = perf_event_count(param_get_perf);
 	pup.set_count = perf_event_count(param_set_perf);
 	pup.find_count = perf_event_count(param_find_perf);
@@ -643,6 +725,174 @@ param_get_system_default_value(param_t param, void *default_val)
 	return ret;
 }
 
+/**
+ * Get the journal file belonging to the default parameter file.
+ *
+ * @return the journal file name, or nullptr if parameters are not stored to a file
+ */
+static const char *
+param_get_journal_file()
+{
+	const char *filename = param_get_default_file();
+
+	if (filename == nullptr || param_journal_unavailable) {
+		return nullptr;
+	}
+
+	if (param_journal_file == nullptr) {
+		static constexpr char suffix[] = ".journal";
+		const size_t len = strlen(filename) + sizeof(suffix);
+		param_journal_file = (char *)malloc(len);
+
+		if (param_journal_file != nullptr) {
+			snprintf(param_journal_file, len, "%s%s", filename, suffix);
+		}
+	}
+
+	return param_journal_file;
+}
+
+/**
+ * Write a single journal record.
+ *
+ * @return true on success
+ */
+static bool
+param_journal_write_record(int fd, param_t param, uint8_t type, int32_t value)
+{
+	param_journal_record_s record{};
+	record.magic = param_journal_magic;
+	record.type = type;
+
+	const char *name = param_name(param);
+	const size_t name_len = strlen(name);
+	memcpy(record.name, name, (name_len < sizeof(record.name)) ? name_len : sizeof(record.name));
+
+	record.value = value;
+	record.crc = crc32part((const uint8_t *)&record, offsetof(param_journal_record_s, crc), 0);
+
+	return ::write(fd, &record, sizeof(record)) == (ssize_t)sizeof(record);
+}
+
+/**
+ * Append all unsaved parameter changes (including resets) to the journal.
+ *
+ * This needs to be called with param_sem_journal held.
+ *
+ * @param force		append even if the journal reached its maximum size
+ * @return		PX4_OK on success, PX4_ERROR if a full save is required instead
+ */
+static int
+param_journal_append(bool force)
+{
+	const char *filename = param_get_journal_file();
+
+	if (filename == nullptr) {
+		return PX4_ERROR;
+	}
+
+	if (param_journal_compact_required || (!force && param_journal_records >= param_journal_max_records)) {
+		return PX4_ERROR;
+	}
+
+	int shutdown_lock_ret = px4_shutdown_lock();
+
+	if (shutdown_lock_ret) {
+		PX4_ERR("px4_shutdown_lock() failed (%i)", shutdown_lock_ret);
+	}
+
+	do {} while (px4_sem_wait(&param_sem_save) != 0);
+
+	param_lock_reader();
+
+	int result = PX4_ERROR;
+	int fd = PARAM_OPEN(filename, O_WRONLY | O_CREAT | O_APPEND, PX4_O_MODE_666);
+
+	if (fd < 0) {
+		PX4_DEBUG("journal %s not available (%i)", filename, errno);
+		param_journal_unavailable = true;
+		goto out;
+	}
+
+	// resets first: a param might have been set again after the reset
+	for (param_t param = 0; handle_in_range(param); param++) {
+		if (params_reset_unsaved[param]) {
+			if (!param_journal_write_record(fd, param, param_journal_type_reset, 0)) {
+				goto out_close;
+			}
+
+			params_reset_unsaved.set(param, false);
+			param_journal_records++;
+		}
+	}
+
+	if (param_values != nullptr) {
+		param_wbuf_s *s = nullptr;
+
+		while ((s = (param_wbuf_s *)utarray_next(param_values, s)) != nullptr) {
+			if (!s->unsaved) {
+				continue;
+			}
+
+			if (!param_journal_write_record(fd, s->param, param_type(s->param), s->val.i)) {
+				goto out_close;
+			}
+
+			s->unsaved = false;
+			param_journal_records++;
+		}
+	}
+
+	fsync(fd); // make sure the data is flushed before releasing the shutdown lock
+	result = PX4_OK;
+
+out_close:
+	PARAM_CLOSE(fd);
+
+	if (result != PX4_OK) {
+		PX4_ERR("journal write to %s failed", filename);
+		param_journal_compact_required = true;
+	}
+
+out:
+	param_unlock_reader();
+
+	px4_sem_post(&param_sem_save);
+
+	if (shutdown_lock_ret == 0) {
+		px4_shutdown_unlock();
+	}
+
+	return result;
+}
+
+/**
+ * Remove the journal, after its content became part of the snapshot.
+ *
+ * This needs to be called with param_sem_journal held.
+ */
+static void
+param_journal_remove()
+{
+	const char *filename = param_get_journal_file();
+
+	if (filename != nullptr) {
+#ifndef __PX4_QURT
+		(void)unlink(filename);
+#endif
+	}
+
+	param_lock_writer();
+	param_journal_records = 0;
+	param_journal_compact_required = false;
+
+	for (int i = 0; i < params_reset_unsaved.size(); i++) {
+		params_reset_unsaved.set(i, false);
+	}
+
+	param_unlock_writer();
+}
+
 /**
  * worker callback method to save the parameters
  * @param arg unused
@@ -674,7 +924,17 @@ autosave_worker(void *arg)
 	}
 
 	PX4_DEBUG("Autosaving params");
-	int ret = param_save_default();
+
+	do {} while (px4_sem_wait(&param_sem_journal) != 0);
+
+	int ret = param_journal_append(false);
+
+	px4_sem_post(&param_sem_journal);
+
+	if (ret != PX4_OK) {
+		// journal unavailable or full: compact by writing a full snapshot
+		ret = param_save_default();
+	}
 
 	if (ret != 0) {
 		PX4_ERR("param auto save failed (%i)", ret);
@@ -801,6 +1061,10 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 			}
 		}
 
+		if ((result == PX4_OK) && param_changed) {
+			param_mark_generation(param);
+		}
+
 		if ((result == PX4_OK) && !mark_saved) { // this is false when importing parameters
 			param_autosave();
 		}
@@ -855,7 +1119,13 @@ bool param_used(param_t param)
 void param_set_used(param_t param)
 {
 	if (handle_in_range(param)) {
-		params_active.set(param, true);
+		if (!params_active[param]) {
+			params_active.set(param, true);
+			// a param becoming used is new to clients that synced before (delta sync), record it like
+			// a change. Lock free like the rest of param_find(), the generation counter is atomic.
+			param_mark_generation(param);
+			param_hash_valid.store(false);
+		}
 	}
 }
 
@@ -958,6 +1228,11 @@ int param_set_default_value(param_t param, const void *val)
 		}
 	}
 
+	if (result == PX4_OK) {
+		// the effective value changes if the param is currently at its default
+		param_mark_generation(param);
+	}
+
 	param_unlock_writer();
 
 	if ((result == PX4_OK) && param_used(param)) {
@@ -968,7 +1243,7 @@ int param_set_default_value(param_t param, const void *val)
 	return result;
 }
 
-static int param_reset_internal(param_t param, bool notify = true)
+static int param_reset_internal(param_t param, bool notify = true, bool autosave = true)
 {
 	param_wbuf_s *s = nullptr;
 	bool param_found = false;
@@ -983,6 +1258,11 @@ static int param_reset_internal(param_t param, bool notify = true)
 		if (s != nullptr) {
 			int pos = utarray_eltidx(param_values, s);
 			utarray_erase(param_values, pos, 1);
+			param_mark_generation(param);
+
+			if (autosave) {
+				params_reset_unsaved.set(param, true);
+			}
 		}
 
 		params_changed.set(param, false);
@@ -990,7 +1270,9 @@ static int param_reset_internal(param_t param, bool notify = true)
 		param_found = true;
 	}
 
-	param_autosave();
+	if (autosave) {
+		param_autosave();
+	}
 
 	param_unlock_writer();
 
@@ -1019,6 +1301,10 @@ param_reset_all_internal(bool auto_save)
 
 	/* mark as reset / deleted */
 	param_values = nullptr;
+	param_mark_generation_all();
+
+	// resets are not journaled individually
+	param_journal_compact_required = true;
 
 	if (auto_save) {
 		param_autosave();
@@ -1103,6 +1389,15 @@ param_set_default_file(const char *filename)
 		param_user_file = strdup(filename);
 	}
 
+	if (param_journal_file != nullptr) {
+		free(param_journal_file);
+		param_journal_file = nullptr;
+	}
+
+	// the journal of the newly selected file is only valid after it has been replayed
+	param_journal_compact_required = true;
+	param_journal_unavailable = false;
+
 #endif /* FLASH_BASED_PARAMS */
 
 	return 0;
@@ -1129,6 +1424,14 @@ int param_save_default()
 		return res;
 	}
 
+	do {} while (px4_sem_wait(&param_sem_journal) != 0);
+
+	// flush pending changes to the journal first, so that replaying it on top of either the old
+	// or the new snapshot gives the current state should we fail before the journal is removed.
+	// If that fails the journal is kept as it is: it may hold changes that are not in the old
+	// snapshot, and it is only removed once the new snapshot has been written and synced.
+	(void)param_journal_append(true);
+
 	int attempts = 5;
 
 	while (res != OK && attempts > 0) {
@@ -1137,6 +1440,11 @@ int param_save_default()
 
 		if (fd > -1) {
 			res = param_export(fd, false, nullptr);
+
+			if (res == PX4_OK && fsync(fd) != 0) {
+				res = PX4_ERROR;
+			}
+
 			PARAM_CLOSE(fd);
 
 			if (res != PX4_OK) {
@@ -1152,8 +1460,14 @@ int param_save_default()
 
 	if (res != OK) {
 		PX4_ERR("failed to write parameters to file: %s", filename);
+
+	} else {
+		// the snapshot is on disk and contains all changes now
+		param_journal_remove();
 	}
 
+	px4_sem_post(&param_sem_journal);
+
 	return res;
 }
 
@@ -1190,9 +1504,93 @@ param_load_default()
 		return -2;
 	}
 
+	param_import_journal();
+
 	return res;
 }
 
+int
+param_import_journal()
+{
+	const char *filename = param_get_journal_file();
+
+	if (filename == nullptr) {
+		return 0;
+	}
+
+	do {} while (px4_sem_wait(&param_sem_journal) != 0);
+
+	int fd = PARAM_OPEN(filename, O_RDONLY);
+
+	if (fd < 0) {
+		// no journal means the snapshot is up to date
+		const bool no_journal = (errno == ENOENT);
+		param_journal_records = 0;
+		param_journal_compact_required = !no_journal;
+		px4_sem_post(&param_sem_journal);
+		return no_journal ? 0 : -1;
+	}
+
+	int records = 0;
+	bool corrupt = false;
+	param_journal_record_s record;
+	ssize_t nread;
+
+	while ((nread = ::read(fd, &record, sizeof(record))) == (ssize_t)sizeof(record)) {
+		const uint32_t crc = crc32part((const uint8_t *)&record, offsetof(param_journal_record_s, crc), 0);
+
+		if (record.magic != param_journal_magic || record.crc != crc) {
+			// most likely an interrupted write: the remainder is unusable
+			PX4_ERR("journal record %d corrupt, ignoring remainder", records);
+			corrupt = true;
+			break;
+		}
+
+		records++;
+
+		char name[sizeof(record.name) + 1] {};
+		memcpy(name, record.name, sizeof(record.name));
+		const param_t param = param_find_no_notification(name);
+
+		if (param == PARAM_INVALID) {
+			PX4_ERR("ignoring unrecognised parameter '%s'", name);
+			continue;
+		}
+
+		if (record.type == param_journal_type_reset) {
+			param_reset_internal(param, false, false);
+
+		} else if (record.type == param_type(param)) {
+			const int32_t value = record.value;
+			param_set_internal(param, &value, true, false);
+
+		} else {
+			PX4_WARN("unexpected type for %s", name);
+		}
+	}
+
+	if (nread != 0 && !corrupt) {
+		PX4_ERR("journal truncated after %d records", records);
+		corrupt = true;
+	}
+
+	PARAM_CLOSE(fd);
+
+	param_journal_records = records;
+	// appending after a corrupt record would make the new records unreachable
+	param_journal_compact_required = corrupt;
+
+	px4_sem_post(&param_sem_journal);
+
+	PX4_INFO("replayed %d journal records", records);
+
+	if (records > 0) {
+		param_notify_changes();
+	}
+
+	return corrupt ? -1 : 0;
+}
+
 int
 param_export(int fd, bool only_unsaved, param_filter_func filter)
 {
@@ -1490,23 +1888,36 @@ param_foreach(void (*func)(void *arg, param_t param), void *arg, bool only_chang
 
 uint32_t param_hash_check()
 {
-	uint32_t param_hash = 0;
+	// the writer lock protects the cache, the hash is only recomputed after a change
+	param_lock_writer();
 
-	param_lock_reader();
+	const uint16_t generation = param_generation_counter.load();
 
-	/* compute the CRC32 over all string param names and 4 byte values */
-	for (param_t param = 0; handle_in_range(param); param++) {
-		if (!param_used(param) || param_is_volatile(param)) {
-			continue;
+	if (!param_hash_valid.load() || (generation != param_hash_generation)) {
+		// mark valid before computing, so that a param becoming used meanwhile invalidates the result
+		param_hash_valid.store(true);
+
+		uint32_t param_hash = 0;
+
+		/* compute the CRC32 over all string param names and 4 byte values */
+		for (param_t param = 0; handle_in_range(param); param++) {
+			if (!param_used(param) || param_is_volatile(param)) {
+				continue;
+			}
+
+			const char *name = param_name(param);
+			const void *val = param_get_value_ptr(param);
+			param_hash = crc32part((const uint8_t *)name, strlen(name), param_hash);
+			param_hash = crc32part((const uint8_t *)val, param_size(param), param_hash);
 		}
 
-		const char *name = param_name(param);
-		const void *val = param_get_value_ptr(param);
-		param_hash = crc32part((const uint8_t *)name, strlen(name), param_hash);
-		param_hash = crc32part((const uint8_t *)val, param_size(param), param_hash);
+		param_hash_cached = param_hash;
+		param_hash_generation = generation;
 	}
 
-	param_unlock_reader();
+	const uint32_t param_hash = param_hash_cached;
+
+	param_unlock_writer();
 
 	return param_hash;
 }
@@ -1537,6 +1948,11 @@ void param_print_status()
 
 	PX4_INFO("auto save: %s", autosave_disabled ? "off" : "on");
 
+	if (param_journal_file != nullptr && !param_journal_unavailable) {
+		PX4_INFO("journal: %s (%d records%s)", param_journal_file, param_journal_records,
+			 param_journal_compact_required ? ", compaction pending" : "");
+	}
+
 	if (!autosave_disabled && (last_autosave_timestamp > 0)) {
 		PX4_INFO("last auto save: %.3f seconds ago", hrt_elapsed_time(&last_autosave_timestamp) * 1e-6);
 	}
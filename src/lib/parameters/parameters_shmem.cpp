@@ -317,12 +317,37 @@ param_find_changed(param_t param)
 	return s;
 }
 
+/*
+ * Change generation. Per-parameter generations are not tracked with shared memory,
+ * so any change is reported as a change of all parameters.
+ */
+static volatile uint16_t param_generation_counter = 0;
+
+uint16_t
+param_generation()
+{
+	return param_generation_counter;
+}
+
+bool
+param_changed_since(param_t param, uint16_t generation)
+{
+	/*
+	 * Changes made by the other processor are only applied (and counted) when the
+	 * parameter is read with param_get(), so a parameter is always reported as
+	 * possibly changed to make sure it is read again.
+	 */
+	(void)generation;
+	return handle_in_range(param);
+}
+
 static void
 _param_notify_changes()
 {
 	parameter_update_s pup = {};
 	pup.timestamp = hrt_absolute_time();
 	pup.instance = param_instance++;
+	pup.generation = param_generation_counter;
 
 	/*
 	 * If we don't have a handle to our topic, create one now; otherwise
@@ -765,6 +790,10 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 		s->unsaved = !mark_saved;
 		result = 0;
 
+		if (params_changed) {
+			param_generation_counter++;
+		}
+
 		if (!mark_saved) { // this is false when importing parameters
 			param_autosave();
 		}
@@ -883,6 +912,7 @@ param_reset(param_t param)
 		if (s != nullptr) {
 			int pos = utarray_eltidx(param_values, s);
 			utarray_erase(param_values, pos, 1);
+			param_generation_counter++;
 		}
 
 		param_found = true;
@@ -909,6 +939,7 @@ param_reset_all_internal(bool auto_save)
 
 	/* mark as reset / deleted */
 	param_values = nullptr;
+	param_generation_counter++;
 
 	if (auto_save) {
 		param_autosave();
@@ -1016,6 +1047,13 @@ do_exit:
 	return res;
 }
 
+int
+param_import_journal()
+{
+	// the parameter journal is not supported with shared memory parameters
+	return 0;
+}
+
 /**
  * @return 0 on success, 1 if all params have not yet been stored, -1 if device open failed, -2 if writing parameters failed
  */
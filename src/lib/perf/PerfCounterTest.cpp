@@ -0,0 +1,225 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file PerfCounterTest.cpp
+ * Tests the counter registry, perf_alloc_once() and the latency histograms.
+ */
+
+#include <gtest/gtest.h>
+
+#include <perf/perf_counter.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct NameMatch {
+	const char *name;
+	int count;
+};
+
+static void count_named(perf_counter_t handle, void *user)
+{
+	NameMatch *match = (NameMatch *)user;
+	char buffer[128];
+	perf_print_counter_buffer(buffer, sizeof(buffer), handle);
+
+	const size_t length = strlen(match->name);
+
+	if (strncmp(buffer, match->name, length) == 0 && buffer[length] == ':') {
+		match->count++;
+	}
+}
+
+/** number of registered counters with the given name */
+static int registered(const char *name)
+{
+	NameMatch match{name, 0};
+	perf_iterate_all(count_named, &match);
+	return match.count;
+}
+
+TEST(PerfCounterTest, allocFree)
+{
+	perf_counter_t count = perf_alloc(PC_COUNT, "test_count");
+	perf_counter_t elapsed = perf_alloc(PC_ELAPSED, "test_elapsed");
+	ASSERT_NE(count, nullptr);
+	ASSERT_NE(elapsed, nullptr);
+
+	EXPECT_EQ(registered("test_count"), 1);
+	EXPECT_EQ(registered("test_elapsed"), 1);
+
+	perf_free(count);
+	EXPECT_EQ(registered("test_count"), 0);
+	EXPECT_EQ(registered("test_elapsed"), 1);
+
+	perf_free(elapsed);
+	EXPECT_EQ(registered("test_elapsed"), 0);
+}
+
+TEST(PerfCounterTest, freedSlotsAreReused)
+{
+	// more counters than fit into the arena if freed slots were lost
+	for (int i = 0; i < 10000; i++) {
+		perf_counter_t interval = perf_alloc(PC_INTERVAL, "test_interval");
+		ASSERT_NE(interval, nullptr);
+		perf_counter_t count = perf_alloc(PC_COUNT, "test_count");
+		ASSERT_NE(count, nullptr);
+
+		// a recycled slot starts from zero
+		EXPECT_EQ(perf_event_count(interval), 0u);
+		EXPECT_EQ(perf_event_count(count), 0u);
+		perf_count_interval(interval, 1000 + i);
+		perf_count(count);
+
+		perf_free(interval);
+		perf_free(count);
+	}
+
+	perf_counter_t first = perf_alloc(PC_ELAPSED, "test_elapsed");
+	perf_free(first);
+	perf_counter_t second = perf_alloc(PC_ELAPSED, "test_elapsed");
+	EXPECT_EQ(first, second);
+	perf_free(second);
+}
+
+TEST(PerfCounterTest, allocOnce)
+{
+	perf_counter_t handle = perf_alloc_once(PC_COUNT, "test_once");
+	ASSERT_NE(handle, nullptr);
+
+	EXPECT_EQ(perf_alloc_once(PC_COUNT, "test_once"), handle);
+	EXPECT_EQ(perf_alloc_once(PC_ELAPSED, "test_once"), nullptr);
+	EXPECT_EQ(registered("test_once"), 1);
+
+	perf_free(handle);
+	EXPECT_EQ(registered("test_once"), 0);
+}
+
+TEST(PerfCounterTest, concurrentAllocAndCount)
+{
+	static constexpr int THREADS = 8;
+	static constexpr int COUNTERS = 20;
+	static constexpr int EVENTS = 10000;
+
+	perf_counter_t shared = perf_alloc(PC_COUNT, "test_shared");
+	perf_counter_t once[THREADS] {};
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < THREADS; t++) {
+		threads.emplace_back([&, t]() {
+			perf_counter_t own[COUNTERS];
+
+			for (int i = 0; i < COUNTERS; i++) {
+				own[i] = perf_alloc(PC_COUNT, "test_concurrent");
+			}
+
+			once[t] = perf_alloc_once(PC_COUNT, "test_concurrent_once");
+
+			for (int i = 0; i < EVENTS; i++) {
+				perf_count(shared);
+				perf_count(own[i % COUNTERS]);
+			}
+
+			for (int i = 0; i < COUNTERS; i++) {
+				EXPECT_EQ(perf_event_count(own[i]), (uint64_t)(EVENTS / COUNTERS));
+				perf_free(own[i]);
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	EXPECT_EQ(perf_event_count(shared), (uint64_t)(THREADS * EVENTS));
+	EXPECT_EQ(registered("test_concurrent"), 0);
+	EXPECT_EQ(registered("test_concurrent_once"), 1);
+
+	for (int t = 1; t < THREADS; t++) {
+		EXPECT_EQ(once[t], once[0]);
+	}
+
+	perf_free(once[0]);
+	perf_free(shared);
+}
+
+TEST(PerfCounterTest, histogram)
+{
+	perf_counter_t elapsed = perf_alloc(PC_ELAPSED, "test_histogram");
+
+	perf_set_elapsed(elapsed, 0);		// bucket 0: [0, 2) us
+	perf_set_elapsed(elapsed, 1);
+	perf_set_elapsed(elapsed, 2);		// bucket 1: [2, 4) us
+	perf_set_elapsed(elapsed, 1000);	// bucket 9: [512, 1024) us
+	perf_set_elapsed(elapsed, 1024);	// bucket 10
+	perf_set_elapsed(elapsed, 100000000);	// last bucket
+	perf_set_elapsed(elapsed, -1);		// ignored
+
+	uint32_t buckets[PERF_HISTOGRAM_BUCKETS + 2] {};
+	ASSERT_EQ(perf_histogram(elapsed, buckets, PERF_HISTOGRAM_BUCKETS + 2), PERF_HISTOGRAM_BUCKETS);
+
+	EXPECT_EQ(buckets[0], 2u);
+	EXPECT_EQ(buckets[1], 1u);
+	EXPECT_EQ(buckets[9], 1u);
+	EXPECT_EQ(buckets[10], 1u);
+	EXPECT_EQ(buckets[PERF_HISTOGRAM_BUCKETS - 1], 1u);
+	EXPECT_EQ(perf_event_count(elapsed), 6u);
+
+	perf_reset(elapsed);
+	ASSERT_EQ(perf_histogram(elapsed, buckets, PERF_HISTOGRAM_BUCKETS), PERF_HISTOGRAM_BUCKETS);
+
+	for (int i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+		EXPECT_EQ(buckets[i], 0u);
+	}
+
+	// intervals: the first event only sets the start
+	perf_counter_t interval = perf_alloc(PC_INTERVAL, "test_histogram_interval");
+	perf_count_interval(interval, 1000);
+	perf_count_interval(interval, 1100);
+	perf_count_interval(interval, 1200);
+	perf_count_interval(interval, 5200);
+
+	ASSERT_EQ(perf_histogram(interval, buckets, PERF_HISTOGRAM_BUCKETS), PERF_HISTOGRAM_BUCKETS);
+	EXPECT_EQ(buckets[6], 2u);	// [64, 128) us
+	EXPECT_EQ(buckets[11], 1u);	// [2048, 4096) us
+
+	perf_counter_t count = perf_alloc(PC_COUNT, "test_histogram_count");
+	EXPECT_EQ(perf_histogram(count, buckets, PERF_HISTOGRAM_BUCKETS), 0);
+
+	perf_free(elapsed);
+	perf_free(interval);
+	perf_free(count);
+}
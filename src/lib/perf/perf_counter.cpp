@@ -40,14 +40,31 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/queue.h>
 #include <drivers/drv_hrt.h>
 #include <math.h>
+#include <new>
 #include <pthread.h>
+#include <px4_platform_common/atomic.h>
 #include <systemlib/err.h>
 
 #include "perf_counter.h"
 
+#ifndef PERF_COUNTER_SHARDS
+#  if defined(__PX4_LINUX)
+#    define PERF_COUNTER_SHARDS 8	///< PC_COUNT shards, each thread is assigned one round-robin
+#  else
+#    define PERF_COUNTER_SHARDS 1
+#  endif
+#endif
+
+#ifndef PERF_COUNTER_ARENA_SIZE
+#  if defined(__PX4_NUTTX)
+#    define PERF_COUNTER_ARENA_SIZE 4096	///< bytes of static counter storage
+#  else
+#    define PERF_COUNTER_ARENA_SIZE (64 * 1024)
+#  endif
+#endif
+
 #ifdef __PX4_QURT
 // There is presumably no dprintf on QURT. Therefore use the usual output to mini-dm.
 #define dprintf(_fd, _text, ...) ((_fd) == 1 ? PX4_INFO((_text), ##__VA_ARGS__) : (void)(_fd))
@@ -57,18 +74,26 @@
  * Header common to all counters.
  */
 struct perf_ctr_header {
-	sq_entry_t		link;	/**< list linkage */
+	perf_ctr_header		*next{nullptr};	/**< list linkage */
 	enum perf_counter_type	type;	/**< counter type */
 	const char		*name;	/**< counter name */
 };
 
 /**
- * PC_EVENT counter.
+ * One shard of a PC_COUNT counter, padded to a cache line so that threads
+ * counting on different shards do not contend on the same line.
  */
-struct perf_ctr_count : public perf_ctr_header {
+struct alignas(PERF_COUNTER_SHARDS > 1 ? 64 : 8) perf_ctr_count_shard {
 	uint64_t		event_count{0};
 };
 
+/**
+ * PC_COUNT counter.
+ */
+struct perf_ctr_count : public perf_ctr_header {
+	perf_ctr_count_shard	shards[PERF_COUNTER_SHARDS];
+};
+
 /**
  * PC_ELAPSED counter.
  */
@@ -80,6 +105,7 @@ struct perf_ctr_elapsed : public perf_ctr_header {
 	uint32_t		time_most{0};
 	float			mean{0.0f};
 	float			M2{0.0f};
+	uint32_t		histogram[PERF_HISTOGRAM_BUCKETS] {};
 };
 
 /**
@@ -94,41 +120,197 @@ struct perf_ctr_interval : public perf_ctr_header {
 	uint32_t		time_most{0};
 	float			mean{0.0f};
 	float			M2{0.0f};
+	uint32_t		histogram[PERF_HISTOGRAM_BUCKETS] {};
 };
 
 /**
- * List of all known counters.
+ * List of all known counters. New counters are pushed onto the head with a
+ * compare-and-swap, so registration never blocks.
  */
-static sq_queue_t	perf_counters = { nullptr, nullptr };
+static px4::atomic<perf_ctr_header *> perf_counters{nullptr};
 
 /**
- * mutex protecting access to the perf_counters linked list (which is read from & written to by different threads)
+ * mutex serializing removal from the perf_counters list with iteration over it.
+ * Adding a counter does not need it: a concurrent iteration simply starts from an
+ * older head and does not see the new counter.
  */
 pthread_mutex_t perf_counters_mutex = PTHREAD_MUTEX_INITIALIZER;
 // FIXME: the mutex does **not** protect against access to/from the perf
 // counter's data. It can still happen that a counter is updated while it is
 // printed. This can lead to inconsistent output, or completely bogus values
 // (especially the 64bit values which are in general not atomically updated).
-// The same holds for shared perf counters (perf_alloc_once), that can be updated
-// concurrently (this affects the 'ctrl_latency' counter).
+// PC_COUNT counters are the exception when sharded, they are updated atomically.
+
+/**
+ * Static arena the counters are allocated from, to keep them off the heap
+ * (most counters live for the whole runtime). Arena slots released by perf_free()
+ * are kept on a free list per counter type and reused by the next allocation of
+ * that type. Allocation falls back to the heap once the arena is exhausted.
+ */
+alignas(64) static uint8_t perf_arena[PERF_COUNTER_ARENA_SIZE];
+static px4::atomic<unsigned> perf_arena_used{0};
 
+/**
+ * Released arena slots, linked through perf_ctr_header::next. The mutex is only taken
+ * when a slot is pushed or popped, so allocating from an empty free list stays lock-free.
+ */
+static px4::atomic<perf_ctr_header *> perf_free_slots[PC_INTERVAL + 1] {};
+static pthread_mutex_t perf_free_slots_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-perf_counter_t
-perf_alloc(enum perf_counter_type type, const char *name)
+static void *perf_free_slot_pop(enum perf_counter_type type)
+{
+	if (perf_free_slots[type].load() == nullptr) {
+		return nullptr;
+	}
+
+	pthread_mutex_lock(&perf_free_slots_mutex);
+	perf_ctr_header *slot = perf_free_slots[type].load();
+
+	if (slot != nullptr) {
+		perf_free_slots[type].store(slot->next);
+	}
+
+	pthread_mutex_unlock(&perf_free_slots_mutex);
+	return slot;
+}
+
+static void perf_free_slot_push(perf_counter_t handle)
+{
+	pthread_mutex_lock(&perf_free_slots_mutex);
+	handle->next = perf_free_slots[handle->type].load();
+	perf_free_slots[handle->type].store(handle);
+	pthread_mutex_unlock(&perf_free_slots_mutex);
+}
+
+static void *perf_arena_alloc(size_t size)
+{
+	size = (size + alignof(perf_ctr_count) - 1) & ~(alignof(perf_ctr_count) - 1);
+
+	unsigned used = perf_arena_used.load();
+
+	while (used + size <= sizeof(perf_arena)) {
+		if (perf_arena_used.compare_exchange(&used, used + size)) {
+			return &perf_arena[used];
+		}
+	}
+
+	return nullptr;
+}
+
+static bool perf_in_arena(perf_counter_t handle)
+{
+	return (uint8_t *)handle >= perf_arena && (uint8_t *)handle < perf_arena + sizeof(perf_arena);
+}
+
+template<typename T>
+static T *perf_new(enum perf_counter_type type)
+{
+	void *mem = perf_free_slot_pop(type);
+
+	if (mem == nullptr) {
+		mem = perf_arena_alloc(sizeof(T));
+	}
+
+	if (mem == nullptr) {
+#if PERF_COUNTER_SHARDS > 1
+
+		// sharded counters are cache line aligned, which plain operator new does not guarantee
+		if (posix_memalign(&mem, alignof(T), sizeof(T)) != 0) {
+			mem = nullptr;
+		}
+
+#else
+		mem = malloc(sizeof(T));
+#endif
+	}
+
+	return mem != nullptr ? new (mem) T() : nullptr;
+}
+
+static void perf_register(perf_counter_t ctr)
+{
+	perf_counter_t head = perf_counters.load();
+
+	do {
+		ctr->next = head;
+	} while (!perf_counters.compare_exchange(&head, ctr));
+}
+
+/**
+ * Histogram bucket for a duration: bucket 0 holds [0, 2) us, bucket i holds
+ * [2^i, 2^(i+1)) us and the last bucket everything above.
+ */
+static inline unsigned perf_histogram_bucket(uint32_t us)
+{
+	unsigned bucket = 31 - __builtin_clz(us | 1);
+	return bucket < PERF_HISTOGRAM_BUCKETS ? bucket : PERF_HISTOGRAM_BUCKETS - 1;
+}
+
+#if PERF_COUNTER_SHARDS > 1
+/**
+ * Shard of the calling thread. Threads are assigned to the shards round-robin on their
+ * first count, so threads counting concurrently mostly update different cache lines.
+ */
+static inline unsigned perf_thread_shard()
+{
+	static px4::atomic<unsigned> next_shard{0};
+	static thread_local unsigned shard = next_shard.fetch_add(1) % PERF_COUNTER_SHARDS;
+	return shard;
+}
+#endif
+
+static inline perf_ctr_count_shard &perf_count_shard(struct perf_ctr_count *pc)
+{
+#if PERF_COUNTER_SHARDS > 1
+	return pc->shards[perf_thread_shard()];
+#else
+	return pc->shards[0];
+#endif
+}
+
+static uint64_t perf_count_sum(struct perf_ctr_count *pc)
+{
+	uint64_t sum = 0;
+
+	for (auto &shard : pc->shards) {
+#if PERF_COUNTER_SHARDS > 1
+		sum += __atomic_load_n(&shard.event_count, __ATOMIC_RELAXED);
+#else
+		sum += shard.event_count;
+#endif
+	}
+
+	return sum;
+}
+
+static void perf_count_set(struct perf_ctr_count *pc, uint64_t count)
+{
+	for (auto &shard : pc->shards) {
+#if PERF_COUNTER_SHARDS > 1
+		__atomic_store_n(&shard.event_count, count, __ATOMIC_RELAXED);
+#else
+		shard.event_count = count;
+#endif
+		count = 0;
+	}
+}
+
+static perf_counter_t
+perf_alloc_unregistered(enum perf_counter_type type, const char *name)
 {
 	perf_counter_t ctr = nullptr;
 
 	switch (type) {
 	case PC_COUNT:
-		ctr = new perf_ctr_count();
+		ctr = perf_new<perf_ctr_count>(PC_COUNT);
 		break;
 
 	case PC_ELAPSED:
-		ctr = new perf_ctr_elapsed();
+		ctr = perf_new<perf_ctr_elapsed>(PC_ELAPSED);
 		break;
 
 	case PC_INTERVAL:
-		ctr = new perf_ctr_interval();
+		ctr = perf_new<perf_ctr_interval>(PC_INTERVAL);
 		break;
 
 	default:
@@ -138,41 +320,100 @@ perf_alloc(enum perf_counter_type type, const char *name)
 	if (ctr != nullptr) {
 		ctr->type = type;
 		ctr->name = name;
-		pthread_mutex_lock(&perf_counters_mutex);
-		sq_addfirst(&ctr->link, &perf_counters);
-		pthread_mutex_unlock(&perf_counters_mutex);
 	}
 
 	return ctr;
 }
 
+static void
+perf_delete(perf_counter_t handle)
+{
+	// all counter types are trivially destructible
+	if (perf_in_arena(handle)) {
+		perf_free_slot_push(handle);
+
+	} else {
+		free(handle);
+	}
+}
+
+perf_counter_t
+perf_alloc(enum perf_counter_type type, const char *name)
+{
+	perf_counter_t ctr = perf_alloc_unregistered(type, name);
+
+	if (ctr != nullptr) {
+		perf_register(ctr);
+	}
+
+	return ctr;
+}
+
+/**
+ * Find a counter by name, starting at 'from' and stopping before 'until'.
+ */
+static perf_counter_t
+perf_find(perf_counter_t from, perf_counter_t until, const char *name)
+{
+	for (perf_counter_t handle = from; handle != until; handle = handle->next) {
+		if (!strcmp(handle->name, name)) {
+			return handle;
+		}
+	}
+
+	return nullptr;
+}
+
 perf_counter_t
 perf_alloc_once(enum perf_counter_type type, const char *name)
 {
+	// the mutex only keeps counters from being freed while we walk the list, concurrent
+	// perf_alloc() calls can still push new counters in front of the head we looked at
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t head = perf_counters.load();
+	perf_counter_t handle = perf_find(head, nullptr, name);
 
-	while (handle != nullptr) {
-		if (!strcmp(handle->name, name)) {
-			if (type == handle->type) {
-				/* they are the same counter */
-				pthread_mutex_unlock(&perf_counters_mutex);
-				return handle;
-
-			} else {
-				/* same name but different type, assuming this is an error and not intended */
-				pthread_mutex_unlock(&perf_counters_mutex);
-				return nullptr;
+	if (handle == nullptr) {
+		/* no existing counter of that name was found */
+		perf_counter_t ctr = perf_alloc_unregistered(type, name);
+
+		if (ctr == nullptr) {
+			pthread_mutex_unlock(&perf_counters_mutex);
+			return nullptr;
+		}
+
+		perf_counter_t checked = head;
+		ctr->next = head;
+
+		while (!perf_counters.compare_exchange(&head, ctr)) {
+			// the list changed: make sure nobody registered the same name in the meantime
+			handle = perf_find(head, checked, name);
+
+			if (handle != nullptr) {
+				break;
 			}
+
+			checked = head;
+			ctr->next = head;
+		}
+
+		if (handle == nullptr) {
+			pthread_mutex_unlock(&perf_counters_mutex);
+			return ctr;
 		}
 
-		handle = (perf_counter_t)sq_next(&handle->link);
+		perf_delete(ctr);
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
 
-	/* if the execution reaches here, no existing counter of that name was found */
-	return perf_alloc(type, name);
+	if (type == handle->type) {
+		/* they are the same counter */
+		return handle;
+	}
+
+	/* same name but different type, assuming this is an error and not intended */
+	return nullptr;
 }
 
 void
@@ -183,10 +424,26 @@ perf_free(perf_counter_t handle)
 	}
 
 	pthread_mutex_lock(&perf_counters_mutex);
-	sq_rem(&handle->link, &perf_counters);
+
+	perf_counter_t head = handle;
+
+	if (!perf_counters.compare_exchange(&head, handle->next)) {
+		// not (or no longer) the head: new counters only ever get pushed in front, so the
+		// predecessor is stable while we hold the mutex
+		perf_counter_t prev = head;
+
+		while (prev != nullptr && prev->next != handle) {
+			prev = prev->next;
+		}
+
+		if (prev != nullptr) {
+			prev->next = handle->next;
+		}
+	}
+
 	pthread_mutex_unlock(&perf_counters_mutex);
 
-	delete handle;
+	perf_delete(handle);
 }
 
 void
@@ -197,8 +454,13 @@ perf_count(perf_counter_t handle)
 	}
 
 	switch (handle->type) {
-	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count++;
+	case PC_COUNT: {
+#if PERF_COUNTER_SHARDS > 1
+			__atomic_fetch_add(&perf_count_shard((struct perf_ctr_count *)handle).event_count, 1, __ATOMIC_RELAXED);
+#else
+			perf_count_shard((struct perf_ctr_count *)handle).event_count++;
+#endif
+		}
 		break;
 
 	case PC_INTERVAL:
@@ -279,6 +541,8 @@ perf_set_elapsed(perf_counter_t handle, int64_t elapsed)
 				pce->mean += delta_intvl / pce->event_count;
 				pce->M2 += delta_intvl * (dt - pce->mean);
 
+				pce->histogram[perf_histogram_bucket(elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed)]++;
+
 				pce->time_start = 0;
 			}
 		}
@@ -310,6 +574,7 @@ perf_count_interval(perf_counter_t handle, hrt_abstime now)
 				pci->time_most = (uint32_t)(now - pci->time_last);
 				pci->mean = pci->time_least / 1e6f;
 				pci->M2 = 0;
+				pci->histogram[perf_histogram_bucket(pci->time_least)]++;
 				break;
 
 			default: {
@@ -329,6 +594,8 @@ perf_count_interval(perf_counter_t handle, hrt_abstime now)
 					float delta_intvl = dt - pci->mean;
 					pci->mean += delta_intvl / pci->event_count;
 					pci->M2 += delta_intvl * (dt - pci->mean);
+
+					pci->histogram[perf_histogram_bucket((uint32_t)interval)]++;
 					break;
 				}
 			}
@@ -351,9 +618,8 @@ perf_set_count(perf_counter_t handle, uint64_t count)
 	}
 
 	switch (handle->type) {
-	case PC_COUNT: {
-			((struct perf_ctr_count *)handle)->event_count = count;
-		}
+	case PC_COUNT:
+		perf_count_set((struct perf_ctr_count *)handle, count);
 		break;
 
 	default:
@@ -391,7 +657,7 @@ perf_reset(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count = 0;
+		perf_count_set((struct perf_ctr_count *)handle, 0);
 		break;
 
 	case PC_ELAPSED: {
@@ -401,6 +667,7 @@ perf_reset(perf_counter_t handle)
 			pce->time_total = 0;
 			pce->time_least = 0;
 			pce->time_most = 0;
+			memset(pce->histogram, 0, sizeof(pce->histogram));
 			break;
 		}
 
@@ -412,6 +679,7 @@ perf_reset(perf_counter_t handle)
 			pci->time_last = 0;
 			pci->time_least = 0;
 			pci->time_most = 0;
+			memset(pci->histogram, 0, sizeof(pci->histogram));
 			break;
 		}
 	}
@@ -438,7 +706,7 @@ perf_print_counter_fd(int fd, perf_counter_t handle)
 	case PC_COUNT:
 		dprintf(fd, "%s: %llu events\n",
 			handle->name,
-			(unsigned long long)((struct perf_ctr_count *)handle)->event_count);
+			(unsigned long long)perf_count_sum((struct perf_ctr_count *)handle));
 		break;
 
 	case PC_ELAPSED: {
@@ -488,7 +756,7 @@ perf_print_counter_buffer(char *buffer, int length, perf_counter_t handle)
 	case PC_COUNT:
 		num_written = snprintf(buffer, length, "%s: %llu events",
 				       handle->name,
-				       (unsigned long long)((struct perf_ctr_count *)handle)->event_count);
+				       (unsigned long long)perf_count_sum((struct perf_ctr_count *)handle));
 		break;
 
 	case PC_ELAPSED: {
@@ -536,7 +804,7 @@ perf_event_count(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_COUNT:
-		return ((struct perf_ctr_count *)handle)->event_count;
+		return perf_count_sum((struct perf_ctr_count *)handle);
 
 	case PC_ELAPSED: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
@@ -580,15 +848,107 @@ perf_mean(perf_counter_t handle)
 	return 0.0f;
 }
 
+int
+perf_histogram(perf_counter_t handle, uint32_t *buckets, int count)
+{
+	if (handle == nullptr) {
+		return 0;
+	}
+
+	const uint32_t *histogram = nullptr;
+
+	switch (handle->type) {
+	case PC_ELAPSED:
+		histogram = ((struct perf_ctr_elapsed *)handle)->histogram;
+		break;
+
+	case PC_INTERVAL:
+		histogram = ((struct perf_ctr_interval *)handle)->histogram;
+		break;
+
+	default:
+		return 0;
+	}
+
+	if (count > PERF_HISTOGRAM_BUCKETS) {
+		count = PERF_HISTOGRAM_BUCKETS;
+	}
+
+	for (int i = 0; i < count; i++) {
+		buckets[i] = histogram[i];
+	}
+
+	return count;
+}
+
+void
+perf_print_histogram_fd(int fd, perf_counter_t handle)
+{
+	uint32_t buckets[PERF_HISTOGRAM_BUCKETS];
+
+	if (perf_histogram(handle, buckets, PERF_HISTOGRAM_BUCKETS) == 0) {
+		return;
+	}
+
+	uint64_t total = 0;
+
+	for (uint32_t bucket : buckets) {
+		total += bucket;
+	}
+
+	if (total == 0) {
+		return;
+	}
+
+	dprintf(fd, "%s:\n", handle->name);
+
+	// percentiles are reported as the upper bound of the bucket they fall into
+	const uint64_t p50 = (total + 1) / 2;
+	const uint64_t p99 = total - total / 100;
+	uint64_t sum = 0;
+
+	for (int i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+		if (buckets[i] == 0) {
+			sum += buckets[i];
+			continue;
+		}
+
+		const bool contains_p50 = sum < p50 && sum + buckets[i] >= p50;
+		const bool contains_p99 = sum < p99 && sum + buckets[i] >= p99;
+		sum += buckets[i];
+
+		if (i == PERF_HISTOGRAM_BUCKETS - 1) {
+			dprintf(fd, "  >=%7uus : %lu%s%s\n", 1u << i, (unsigned long)buckets[i],
+				contains_p50 ? " (p50)" : "", contains_p99 ? " (p99)" : "");
+
+		} else {
+			dprintf(fd, "  < %7uus : %lu%s%s\n", 2u << i, (unsigned long)buckets[i],
+				contains_p50 ? " (p50)" : "", contains_p99 ? " (p99)" : "");
+		}
+	}
+}
+
+void
+perf_print_all_histograms(int fd)
+{
+	pthread_mutex_lock(&perf_counters_mutex);
+
+	for (perf_counter_t handle = perf_counters.load(); handle != nullptr; handle = handle->next) {
+		perf_print_histogram_fd(fd, handle);
+	}
+
+	pthread_mutex_unlock(&perf_counters_mutex);
+}
+
 void
 perf_iterate_all(perf_callback cb, void *user)
 {
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters.load();
 
 	while (handle != nullptr) {
 		cb(handle, user);
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
@@ -598,11 +958,11 @@ void
 perf_print_all(int fd)
 {
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters.load();
 
 	while (handle != nullptr) {
 		perf_print_counter_fd(fd, handle);
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
@@ -625,11 +985,11 @@ void
 perf_reset_all(void)
 {
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters.load();
 
 	while (handle != nullptr) {
 		perf_reset(handle);
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
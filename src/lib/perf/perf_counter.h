@@ -51,6 +51,13 @@ enum perf_counter_type {
 	PC_INTERVAL		/**< measure the interval between instances of an event */
 };
 
+/**
+ * Number of latency histogram buckets of PC_ELAPSED and PC_INTERVAL counters.
+ * Bucket 0 counts durations below 2us, bucket i durations in [2^i, 2^(i+1)) us,
+ * and the last bucket everything from 2^(PERF_HISTOGRAM_BUCKETS-1) us upwards.
+ */
+#define PERF_HISTOGRAM_BUCKETS 16
+
 struct perf_ctr_header;
 typedef struct perf_ctr_header	*perf_counter_t;
 
@@ -89,6 +96,10 @@ __EXPORT extern void		perf_free(perf_counter_t handle);
  * Count a performance event.
  *
  * This call only affects counters that take single events; PC_COUNT, PC_INTERVAL etc.
+ * On Linux PC_COUNT counters are sharded per thread: each thread is assigned one of
+ * a fixed number of shards round-robin on its first count, so that concurrent counting
+ * threads usually do not contend on a shared cache line. With more threads than shards
+ * several threads share a shard, which stays correct but contends again.
  *
  * @param handle		The handle returned from perf_alloc.
  */
@@ -192,6 +203,22 @@ __EXPORT extern void		perf_print_counter_fd(int fd, perf_counter_t handle);
  */
 __EXPORT extern int		perf_print_counter_buffer(char *buffer, int length, perf_counter_t handle);
 
+/**
+ * Print the latency histogram of one PC_ELAPSED or PC_INTERVAL counter.
+ * Nothing is printed for other counter types or counters without events.
+ *
+ * @param fd			File descriptor to print to - e.g. 0 for stdout
+ * @param handle		The counter to print.
+ */
+__EXPORT extern void		perf_print_histogram_fd(int fd, perf_counter_t handle);
+
+/**
+ * Print the latency histograms of all counters that have one.
+ *
+ * @param fd			File descriptor to print to - e.g. 0 for stdout
+ */
+__EXPORT extern void		perf_print_all_histograms(int fd);
+
 /**
  * Print all of the performance counters.
  *
@@ -205,9 +232,9 @@ typedef void (*perf_callback)(perf_counter_t handle, void *user);
 /**
  * Iterate over all performance counters using a callback.
  *
- * Caution: This will aquire the mutex, so do not call any other perf_* method
- * that aquire the mutex as well from the callback (If this is needed, configure
- * the mutex to be reentrant).
+ * Caution: This will aquire the mutex, so do not call perf_free() or
+ * perf_alloc_once() from the callback (perf_alloc() is fine, it does not need
+ * the mutex).
  *
  * @param cb callback method
  * @param user custom argument for the callback
@@ -242,6 +269,16 @@ __EXPORT extern uint64_t	perf_event_count(perf_counter_t handle);
  */
 __EXPORT extern float		perf_mean(perf_counter_t handle);
 
+/**
+ * Copy the latency histogram of a PC_ELAPSED or PC_INTERVAL counter.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param buckets		Output array (see PERF_HISTOGRAM_BUCKETS for the bucket bounds)
+ * @param count			Size of buckets
+ * @return			number of buckets written, 0 if the counter has no histogram
+ */
+__EXPORT extern int		perf_histogram(perf_counter_t handle, uint32_t *buckets, int count);
+
 __END_DECLS
 
 #endif
@@ -80,7 +80,7 @@ public:
 	// rotate corrected measurements from sensor to body frame
 	inline matrix::Vector3f Correct(const matrix::Vector3f &data) const
 	{
-		return _rotation * matrix::Vector3f{(data - _thermal_offset - _offset).emult(_scale)};
+		return _rotation * matrix::Vector3f{(data - _total_offset).emult(_scale)};
 	}
 
 	bool ParametersSave();
@@ -99,6 +99,7 @@ private:
 	matrix::Vector3f _offset;
 	matrix::Vector3f _scale;
 	matrix::Vector3f _thermal_offset;
+	matrix::Vector3f _total_offset;	///< _thermal_offset + _offset, applied to every sample
 
 	int8_t _calibration_index{-1};
 	uint32_t _device_id{0};
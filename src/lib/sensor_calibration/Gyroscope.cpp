@@ -96,6 +96,9 @@ void Gyroscope::SensorCorrectionsUpdate(bool force)
 
 		sensor_correction_s corrections;
 
+		// zero thermal offset if not found
+		_thermal_offset.zero();
+
 		if (_sensor_correction_sub.copy(&corrections)) {
 			// find sensor_corrections index
 			for (int i = 0; i < MAX_SENSOR_COUNT; i++) {
@@ -103,23 +106,27 @@ void Gyroscope::SensorCorrectionsUpdate(bool force)
 					switch (i) {
 					case 0:
 						_thermal_offset = Vector3f{corrections.gyro_offset_0};
-						return;
+						break;
+
 					case 1:
 						_thermal_offset = Vector3f{corrections.gyro_offset_1};
-						return;
+						break;
+
 					case 2:
 						_thermal_offset = Vector3f{corrections.gyro_offset_2};
-						return;
+						break;
+
 					case 3:
 						_thermal_offset = Vector3f{corrections.gyro_offset_3};
-						return;
+						break;
 					}
+
+					break;
 				}
 			}
 		}
 
-		// zero thermal offset if not found
-		_thermal_offset.zero();
+		_total_offset = _thermal_offset + _offset;
 	}
 }
 
@@ -128,6 +135,7 @@ bool Gyroscope::set_offset(const Vector3f &offset)
 	if (Vector3f(_offset - offset).longerThan(0.01f)) {
 		if (PX4_ISFINITE(offset(0)) && PX4_ISFINITE(offset(1)) && PX4_ISFINITE(offset(2))) {
 			_offset = offset;
+			_total_offset = _thermal_offset + _offset;
 			_calibration_count++;
 			return true;
 		}
@@ -216,6 +224,7 @@ void Gyroscope::Reset()
 
 	_offset.zero();
 	_thermal_offset.zero();
+	_total_offset.zero();
 
 	_priority = _external ? DEFAULT_EXTERNAL_PRIORITY : DEFAULT_PRIORITY;
 
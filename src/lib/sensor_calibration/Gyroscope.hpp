@@ -79,12 +79,12 @@ public:
 	// rotate corrected measurements from sensor to body frame
 	inline matrix::Vector3f Correct(const matrix::Vector3f &data) const
 	{
-		return _rotation * matrix::Vector3f{data - _thermal_offset - _offset};
+		return _rotation * matrix::Vector3f{data - _total_offset};
 	}
 
 	inline matrix::Vector3f Uncorrect(const matrix::Vector3f &corrected_data) const
 	{
-		return (_rotation.I() * corrected_data) + _thermal_offset + _offset;
+		return (_rotation.I() * corrected_data) + _total_offset;
 	}
 
 	bool ParametersSave();
@@ -102,6 +102,7 @@ private:
 	matrix::Dcmf _rotation;
 	matrix::Vector3f _offset;
 	matrix::Vector3f _thermal_offset;
+	matrix::Vector3f _total_offset;	///< _thermal_offset + _offset, applied to every sample
 
 	int8_t _calibration_index{-1};
 	uint32_t _device_id{0};
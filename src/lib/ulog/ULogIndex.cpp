@@ -0,0 +1,322 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "ULogIndex.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <logger/messages.h>
+
+namespace ulog
+{
+
+static constexpr char INDEX_FILE_MAGIC[8] = {'U', 'L', 'o', 'g', 'I', 'd', 'x', 0x01};
+
+void ULogIndex::clear()
+{
+	_messages.clear();
+	_non_data_messages.clear();
+	_data_start = 0;
+	_data_end = 0;
+	_valid = false;
+}
+
+bool ULogIndex::build(std::istream &file, uint64_t data_start, uint64_t data_end)
+{
+	clear();
+	file.clear();
+	file.seekg(data_start);
+
+	uint64_t offset = data_start;
+	ulog_message_header_s message_header;
+
+	while (offset + ULOG_MSG_HEADER_LEN <= data_end) {
+		if (!file.read((char *)&message_header, ULOG_MSG_HEADER_LEN)) {
+			break;
+		}
+
+		const uint64_t next_offset = offset + ULOG_MSG_HEADER_LEN + message_header.msg_size;
+
+		if (next_offset > data_end) {
+			break; // truncated message
+		}
+
+		if (message_header.msg_type == (uint8_t)ULogMessageType::DATA) {
+			uint16_t msg_id;
+			uint64_t timestamp = 0;
+
+			if (message_header.msg_size < sizeof(msg_id) + sizeof(timestamp)) {
+				// cannot be a valid topic: skip it
+				offset = next_offset;
+				file.seekg(offset);
+				continue;
+			}
+
+			if (!file.read((char *)&msg_id, sizeof(msg_id)) || !file.read((char *)&timestamp, sizeof(timestamp))) {
+				break;
+			}
+
+			if (msg_id >= _messages.size()) {
+				_messages.resize(msg_id + 1);
+			}
+
+			MessageIndex &index = _messages[msg_id];
+
+			if (index.deltas.size() % SEEK_POINT_INTERVAL == 0) {
+				index.seek_points.push_back(SeekPoint{offset, timestamp});
+				index.deltas.push_back(0);
+
+			} else {
+				const uint64_t delta = offset - index.last_offset;
+
+				if (delta > std::numeric_limits<uint32_t>::max()) {
+					// gap too large for the index format
+					clear();
+					return false;
+				}
+
+				index.deltas.push_back((uint32_t)delta);
+			}
+
+			index.last_offset = offset;
+
+		} else if (message_header.msg_type != (uint8_t)ULogMessageType::SYNC) {
+			// sync messages are not needed by readers
+			_non_data_messages.push_back(offset);
+		}
+
+		offset = next_offset;
+		file.seekg(offset);
+	}
+
+	file.clear();
+
+	_data_start = data_start;
+	_data_end = offset;
+	_valid = true;
+	return true;
+}
+
+uint64_t ULogIndex::messageOffset(uint16_t msg_id, size_t index) const
+{
+	const MessageIndex &message_index = _messages[msg_id];
+	const size_t seek_point = index / SEEK_POINT_INTERVAL;
+	uint64_t offset = message_index.seek_points[seek_point].offset;
+
+	for (size_t i = seek_point * SEEK_POINT_INTERVAL + 1; i <= index; ++i) {
+		offset += message_index.deltas[i];
+	}
+
+	return offset;
+}
+
+bool ULogIndex::readTimestamp(std::istream &file, uint64_t offset, uint64_t &timestamp)
+{
+	file.seekg(offset + ULOG_MSG_HEADER_LEN + sizeof(uint16_t));
+	return (bool)file.read((char *)&timestamp, sizeof(timestamp));
+}
+
+size_t ULogIndex::findTimestamp(std::istream &file, uint16_t msg_id, uint64_t timestamp) const
+{
+	const size_t count = messageCount(msg_id);
+
+	if (count == 0) {
+		return 0;
+	}
+
+	const std::vector<SeekPoint> &seek_points = _messages[msg_id].seek_points;
+
+	// last seek point before the timestamp
+	auto it = std::lower_bound(seek_points.begin(), seek_points.end(), timestamp,
+	[](const SeekPoint & seek_point, uint64_t t) { return seek_point.timestamp < t; });
+
+	if (it == seek_points.begin()) {
+		return 0;
+	}
+
+	const size_t seek_point = (it - seek_points.begin()) - 1;
+	const size_t end = std::min(count, (seek_point + 1) * SEEK_POINT_INTERVAL);
+	uint64_t offset = seek_points[seek_point].offset;
+
+	file.clear();
+
+	for (size_t i = seek_point * SEEK_POINT_INTERVAL; i < end; ++i) {
+		if (i > seek_point * SEEK_POINT_INTERVAL) {
+			offset += _messages[msg_id].deltas[i];
+		}
+
+		uint64_t message_timestamp;
+
+		if (!readTimestamp(file, offset, message_timestamp)) {
+			file.clear();
+			return count;
+		}
+
+		if (message_timestamp >= timestamp) {
+			return i;
+		}
+	}
+
+	// the next seek point (if any) is the first one >= timestamp
+	return end;
+}
+
+bool ULogIndex::loadOrBuild(const std::string &log_file_name, std::istream &file, uint64_t data_start,
+			    uint64_t data_end)
+{
+	// identify the log by its size and start timestamp
+	ulog_file_header_s file_header{};
+	file.clear();
+	file.seekg(0, std::ios::end);
+	const uint64_t file_size = file.tellg();
+	file.seekg(0);
+	file.read((char *)&file_header, sizeof(file_header));
+	file.clear();
+
+	const std::string index_file_name = log_file_name + ".idx";
+
+	if (load(index_file_name, file_size, file_header.timestamp)
+	    && _data_start == data_start && _data_end <= data_end) {
+		return true;
+	}
+
+	if (!build(file, data_start, data_end)) {
+		return false;
+	}
+
+	// failing to write is not fatal, e.g. the log might be on a read-only file system
+	save(index_file_name, file_size, file_header.timestamp);
+	return true;
+}
+
+template<typename T>
+static bool read_vector(std::istream &in, std::vector<T> &v)
+{
+	uint64_t size;
+
+	if (!in.read((char *)&size, sizeof(size)) || size > (1ULL << 32)) {
+		return false;
+	}
+
+	v.resize(size);
+	return (bool)in.read((char *)v.data(), size * sizeof(T));
+}
+
+template<typename T>
+static void write_vector(std::ostream &out, const std::vector<T> &v)
+{
+	const uint64_t size = v.size();
+	out.write((const char *)&size, sizeof(size));
+	out.write((const char *)v.data(), size * sizeof(T));
+}
+
+bool ULogIndex::load(const std::string &index_file_name, uint64_t file_size, uint64_t file_timestamp)
+{
+	clear();
+
+	std::ifstream in(index_file_name, std::ios::in | std::ios::binary);
+
+	if (!in) {
+		return false;
+	}
+
+	char magic[sizeof(INDEX_FILE_MAGIC)];
+	uint64_t header[4]; // file size, file timestamp, data start, data end
+	uint32_t num_msg_ids;
+
+	if (!in.read(magic, sizeof(magic)) || memcmp(magic, INDEX_FILE_MAGIC, sizeof(magic)) != 0
+	    || !in.read((char *)header, sizeof(header)) || header[0] != file_size || header[1] != file_timestamp
+	    || !in.read((char *)&num_msg_ids, sizeof(num_msg_ids)) || num_msg_ids > UINT16_MAX + 1) {
+		return false;
+	}
+
+	_messages.resize(num_msg_ids);
+
+	for (MessageIndex &index : _messages) {
+		if (!read_vector(in, index.seek_points) || !read_vector(in, index.deltas)
+		    || index.seek_points.size() != (index.deltas.size() + SEEK_POINT_INTERVAL - 1) / SEEK_POINT_INTERVAL) {
+			clear();
+			return false;
+		}
+	}
+
+	if (!read_vector(in, _non_data_messages)) {
+		clear();
+		return false;
+	}
+
+	_data_start = header[2];
+	_data_end = header[3];
+	_valid = true;
+	return true;
+}
+
+bool ULogIndex::save(const std::string &index_file_name, uint64_t file_size, uint64_t file_timestamp) const
+{
+	// write to a temporary file first, so that a reader never sees a partial index
+	const std::string tmp_file_name = index_file_name + ".tmp";
+	std::ofstream out(tmp_file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!out) {
+		return false;
+	}
+
+	const uint64_t header[4] {file_size, file_timestamp, _data_start, _data_end};
+	const uint32_t num_msg_ids = _messages.size();
+
+	out.write(INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+	out.write((const char *)header, sizeof(header));
+	out.write((const char *)&num_msg_ids, sizeof(num_msg_ids));
+
+	for (const MessageIndex &index : _messages) {
+		write_vector(out, index.seek_points);
+		write_vector(out, index.deltas);
+	}
+
+	write_vector(out, _non_data_messages);
+	out.close();
+
+	if (!out) {
+		remove(tmp_file_name.c_str());
+		return false;
+	}
+
+	return rename(tmp_file_name.c_str(), index_file_name.c_str()) == 0;
+}
+
+} // namespace ulog
@@ -0,0 +1,145 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogIndex.hpp
+ *
+ * Index of the data section of an ULog file, for random access to the messages of a topic.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace ulog
+{
+
+/**
+ * @class ULogIndex
+ * Stores the file offset of each data message per msg_id, and every SEEK_POINT_INTERVAL-th message
+ * of a msg_id as a seek point together with its timestamp. Offsets between seek points are stored
+ * as 32 bit deltas to keep the index small (4 bytes per message).
+ * All other messages in the data section (subscriptions, parameter changes, dropouts, ...) are
+ * stored as a list of file offsets.
+ *
+ * The timestamp of a data message is expected to be the first field (which is the case for all
+ * topics logged by PX4).
+ *
+ * The index can be cached in a sidecar file next to the log (<log>.idx), which is rebuilt if it
+ * does not match the log anymore.
+ */
+class ULogIndex
+{
+public:
+	static constexpr size_t SEEK_POINT_INTERVAL = 64; ///< messages of a msg_id per seek point
+
+	ULogIndex() = default;
+	~ULogIndex() = default;
+
+	/**
+	 * Build the index by reading through the data section.
+	 * @param file log file
+	 * @param data_start file offset of the first message of the data section
+	 * @param data_end file offset where the data section ends (end of file or start of appended data)
+	 * @return true on success. The stream state is cleared and the position is arbitrary afterwards.
+	 */
+	bool build(std::istream &file, uint64_t data_start, uint64_t data_end);
+
+	/**
+	 * Load the index from the sidecar file of the log if it exists and matches, otherwise build it
+	 * and try to write the sidecar file.
+	 * @param log_file_name path of the log file (the sidecar is log_file_name + ".idx")
+	 * @see build()
+	 */
+	bool loadOrBuild(const std::string &log_file_name, std::istream &file, uint64_t data_start, uint64_t data_end);
+
+	bool valid() const { return _valid; }
+
+	void clear();
+
+	/** @return number of data messages with this msg_id */
+	size_t messageCount(uint16_t msg_id) const
+	{
+		return msg_id < _messages.size() ? _messages[msg_id].deltas.size() : 0;
+	}
+
+	/**
+	 * @return file offset of a data message (pointing to its message header)
+	 * @param index 0 <= index < messageCount(msg_id)
+	 */
+	uint64_t messageOffset(uint16_t msg_id, size_t index) const;
+
+	/**
+	 * Find the first data message of msg_id with a timestamp >= timestamp. The seek points are
+	 * binary searched, then at most SEEK_POINT_INTERVAL timestamps are read from the file.
+	 * @return message index, messageCount(msg_id) if there is none
+	 */
+	size_t findTimestamp(std::istream &file, uint16_t msg_id, uint64_t timestamp) const;
+
+	/** @return file offsets of all messages in the data section other than data messages, in file order */
+	const std::vector<uint64_t> &nonDataMessages() const { return _non_data_messages; }
+
+	uint64_t dataStart() const { return _data_start; }
+	uint64_t dataEnd() const { return _data_end; }
+
+private:
+	struct SeekPoint {
+		uint64_t offset;
+		uint64_t timestamp;
+	};
+
+	struct MessageIndex {
+		std::vector<SeekPoint> seek_points; ///< every SEEK_POINT_INTERVAL-th message
+		std::vector<uint32_t> deltas; ///< offset to the previous message of this msg_id (0 for seek points)
+		uint64_t last_offset{0};
+	};
+
+	bool load(const std::string &index_file_name, uint64_t file_size, uint64_t file_timestamp);
+	bool save(const std::string &index_file_name, uint64_t file_size, uint64_t file_timestamp) const;
+
+	static bool readTimestamp(std::istream &file, uint64_t offset, uint64_t &timestamp);
+
+	std::vector<MessageIndex> _messages; ///< by msg_id
+	std::vector<uint64_t> _non_data_messages;
+
+	uint64_t _data_start{0};
+	uint64_t _data_end{0};
+	bool _valid{false};
+};
+
+} // namespace ulog
@@ -0,0 +1,184 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the ULog index
+ * Run this test only using make tests TESTFILTER=ULogIndex
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+
+#include <logger/messages.h>
+
+#include "ULogIndex.hpp"
+
+using namespace ulog;
+
+class ULogIndexTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		ulog_file_header_s header{};
+		memcpy(header.magic, "ULog\x01\x12\x35\x01", sizeof(header.magic));
+		header.timestamp = 1234;
+		_log.write((const char *)&header, sizeof(header));
+		_data_start = _log.tellp();
+
+		addMessage(ULogMessageType::ADD_LOGGED_MSG, "\x00\x00\x00topic_a", 10);
+		addMessage(ULogMessageType::ADD_LOGGED_MSG, "\x00\x01\x00topic_b", 10);
+
+		// topic_a at 1 kHz, topic_b at 10 Hz, with a parameter change in between
+		for (uint64_t t = 1000; t <= 1000000; t += 1000) {
+			addData(0, t);
+
+			if (t % 100000 == 0) {
+				addData(1, t);
+			}
+
+			if (t == 500000) {
+				addMessage(ULogMessageType::PARAMETER, "parameter", 9);
+			}
+		}
+
+		_data_end = _log.tellp();
+	}
+
+	void addMessage(ULogMessageType type, const char *payload, uint16_t size)
+	{
+		ulog_message_header_s header{size, (uint8_t)type};
+		_log.write((const char *)&header, ULOG_MSG_HEADER_LEN);
+		_log.write(payload, size);
+	}
+
+	void addData(uint16_t msg_id, uint64_t timestamp)
+	{
+		_offsets[msg_id].push_back(_log.tellp());
+		ulog_message_header_s header{sizeof(msg_id) + sizeof(timestamp) + 4, (uint8_t)ULogMessageType::DATA};
+		const uint32_t value = 0;
+		_log.write((const char *)&header, ULOG_MSG_HEADER_LEN);
+		_log.write((const char *)&msg_id, sizeof(msg_id));
+		_log.write((const char *)&timestamp, sizeof(timestamp));
+		_log.write((const char *)&value, sizeof(value));
+	}
+
+	std::stringstream _log{std::ios::in | std::ios::out | std::ios::binary};
+	std::vector<uint64_t> _offsets[2];
+	uint64_t _data_start{0};
+	uint64_t _data_end{0};
+};
+
+TEST_F(ULogIndexTest, build)
+{
+	ULogIndex index;
+	ASSERT_TRUE(index.build(_log, _data_start, _data_end));
+	EXPECT_TRUE(index.valid());
+	EXPECT_EQ(index.dataEnd(), _data_end);
+
+	ASSERT_EQ(index.messageCount(0), 1000u);
+	ASSERT_EQ(index.messageCount(1), 10u);
+	EXPECT_EQ(index.messageCount(2), 0u);
+
+	for (uint16_t msg_id = 0; msg_id < 2; ++msg_id) {
+		for (size_t i = 0; i < _offsets[msg_id].size(); ++i) {
+			EXPECT_EQ(index.messageOffset(msg_id, i), _offsets[msg_id][i]);
+		}
+	}
+
+	// 2 subscriptions and 1 parameter
+	ASSERT_EQ(index.nonDataMessages().size(), 3u);
+	EXPECT_EQ(index.nonDataMessages()[0], _data_start);
+}
+
+TEST_F(ULogIndexTest, findTimestamp)
+{
+	ULogIndex index;
+	ASSERT_TRUE(index.build(_log, _data_start, _data_end));
+
+	EXPECT_EQ(index.findTimestamp(_log, 0, 0), 0u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 1000), 0u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 1001), 1u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 400000), 399u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 64000), 63u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 65000), 64u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 1000000), 999u);
+	EXPECT_EQ(index.findTimestamp(_log, 0, 1000001), 1000u);
+	EXPECT_EQ(index.findTimestamp(_log, 1, 250000), 2u);
+	EXPECT_EQ(index.findTimestamp(_log, 5, 250000), 0u);
+}
+
+TEST_F(ULogIndexTest, truncated)
+{
+	// the last message is incomplete
+	ULogIndex index;
+	ASSERT_TRUE(index.build(_log, _data_start, _data_end - 1));
+	EXPECT_EQ(index.messageCount(0), 1000u);
+	EXPECT_EQ(index.messageCount(1), 9u);
+	EXPECT_EQ(index.dataEnd(), _offsets[1].back());
+}
+
+TEST_F(ULogIndexTest, sidecar)
+{
+	char log_file_name[] = "/tmp/ULogIndexTestXXXXXX";
+	const int fd = mkstemp(log_file_name);
+	ASSERT_GE(fd, 0);
+	close(fd);
+
+	const std::string index_file_name = std::string(log_file_name) + ".idx";
+
+	ULogIndex built;
+	ASSERT_TRUE(built.loadOrBuild(log_file_name, _log, _data_start, _data_end));
+	EXPECT_EQ(access(index_file_name.c_str(), F_OK), 0);
+
+	ULogIndex loaded;
+	ASSERT_TRUE(loaded.loadOrBuild(log_file_name, _log, _data_start, _data_end));
+	ASSERT_EQ(loaded.messageCount(0), built.messageCount(0));
+	EXPECT_EQ(loaded.messageOffset(0, 777), built.messageOffset(0, 777));
+	EXPECT_EQ(loaded.nonDataMessages(), built.nonDataMessages());
+
+	// a different log must not use the cached index
+	_log.seekp(0, std::ios::end);
+	addData(1, 2000000);
+	ULogIndex rebuilt;
+	ASSERT_TRUE(rebuilt.loadOrBuild(log_file_name, _log, _data_start, _log.tellp()));
+	EXPECT_EQ(rebuilt.messageCount(1), 11u);
+
+	remove(index_file_name.c_str());
+	remove(log_file_name);
+}
@@ -0,0 +1,276 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "ULogStreamBuffer.hpp"
+
+#include <string.h>
+#include <time.h>
+
+#include <px4_platform_common/time.h>
+
+namespace ulog
+{
+
+ULogStreamBuffer *ULogStreamBuffer::instance()
+{
+	static pthread_mutex_t create_mutex = PTHREAD_MUTEX_INITIALIZER;
+	static ULogStreamBuffer *buffer = nullptr;
+
+	pthread_mutex_lock(&create_mutex);
+
+	if (!buffer) {
+		buffer = new ULogStreamBuffer();
+	}
+
+	pthread_mutex_unlock(&create_mutex);
+	return buffer;
+}
+
+ULogStreamBuffer::ULogStreamBuffer()
+{
+	pthread_mutex_init(&_mutex, nullptr);
+	px4_sem_init(&_space_available, 0, 0);
+	/* _space_available use case is a signal */
+	px4_sem_setprotocol(&_space_available, SEM_PRIO_NONE);
+}
+
+void ULogStreamBuffer::reset()
+{
+	lock();
+	_tail = _send = _head = 0;
+	_in_flight = 0;
+	_next_sequence = 0;
+	_filling = false;
+	_drop_pending = false;
+	_dropped = 0;
+
+	if (_producer_waiting) {
+		px4_sem_post(&_space_available);
+	}
+
+	unlock();
+}
+
+int ULogStreamBuffer::write(const void *ptr, size_t size, bool message_start, bool need_ack, hrt_abstime timeout_us)
+{
+	const uint8_t *data = (const uint8_t *)ptr;
+	const hrt_abstime wait_start = hrt_absolute_time();
+	int ret = 0;
+
+	lock();
+
+	while (size > 0) {
+		if (!_filling) {
+			if (_head - _tail >= NUM_SLOTS) {
+				if (!need_ack) {
+					++_dropped;
+					_drop_pending = true;
+					break;
+				}
+
+				if (hrt_elapsed_time(&wait_start) > timeout_us) {
+					ret = -1;
+					break;
+				}
+
+				// wait for the sender to free up slots (acks or timeout)
+				_producer_waiting = true;
+				unlock();
+
+				struct timespec abstime;
+				px4_clock_gettime(CLOCK_REALTIME, &abstime);
+				abstime.tv_nsec += 10 * 1000 * 1000;
+
+				if (abstime.tv_nsec >= 1000 * 1000 * 1000) {
+					abstime.tv_sec++;
+					abstime.tv_nsec -= 1000 * 1000 * 1000;
+				}
+
+				px4_sem_timedwait(&_space_available, &abstime);
+
+				lock();
+				_producer_waiting = false;
+				continue;
+			}
+
+			Slot &s = slot(_head);
+			s.length = 0;
+			s.first_message_offset = 255;
+			s.need_ack = need_ack;
+			_filling = true;
+		}
+
+		Slot &s = slot(_head);
+
+		if (message_start && s.first_message_offset == 255) {
+			s.first_message_offset = s.length;
+		}
+
+		message_start = false;
+
+		// reliable data must not be sent without ack
+		s.need_ack = s.need_ack || need_ack;
+
+		const size_t len = (size < (size_t)(DATA_LEN - s.length)) ? size : DATA_LEN - s.length;
+		memcpy(s.data + s.length, data, len);
+		s.length += len;
+		data += len;
+		size -= len;
+
+		if (s.length == DATA_LEN) {
+			commit();
+		}
+	}
+
+	unlock();
+	return ret;
+}
+
+void ULogStreamBuffer::flush()
+{
+	lock();
+
+	if (_filling && slot(_head).length > 0) {
+		commit();
+	}
+
+	unlock();
+}
+
+void ULogStreamBuffer::commit()
+{
+	if (_drop_pending) {
+		++_next_sequence;
+		_drop_pending = false;
+	}
+
+	Slot &s = slot(_head);
+	s.sequence = _next_sequence++;
+	s.sent_time = 0;
+	s.tries = 0;
+	s.acked = false;
+	++_head;
+	_filling = false;
+}
+
+ULogStreamBuffer::Slot *ULogStreamBuffer::retransmit_candidate(hrt_abstime now, hrt_abstime timeout_us)
+{
+	for (uint32_t i = _tail; i != _send; ++i) {
+		Slot &s = slot(i);
+
+		if (s.need_ack && !s.acked && now > s.sent_time + timeout_us) {
+			return &s;
+		}
+	}
+
+	return nullptr;
+}
+
+ULogStreamBuffer::Slot *ULogStreamBuffer::next_unsent(unsigned window)
+{
+	if (_send != _head) {
+		Slot &s = slot(_send);
+
+		if (!s.need_ack || _in_flight < window) {
+			return &s;
+		}
+	}
+
+	return nullptr;
+}
+
+void ULogStreamBuffer::mark_sent(Slot *s, hrt_abstime now)
+{
+	if (s == &slot(_send) && _send != _head) {
+		++_send;
+
+		if (s->need_ack) {
+			++_in_flight;
+		}
+	}
+
+	s->sent_time = now;
+
+	if (s->tries < UINT8_MAX) {
+		++s->tries;
+	}
+
+	release();
+}
+
+bool ULogStreamBuffer::ack(uint16_t sequence)
+{
+	bool found = false;
+	lock();
+
+	for (uint32_t i = _tail; i != _send; ++i) {
+		Slot &s = slot(i);
+
+		if (s.sequence == sequence) {
+			if (s.need_ack && !s.acked) {
+				s.acked = true;
+				--_in_flight;
+				found = true;
+			}
+
+			break;
+		}
+	}
+
+	release();
+	unlock();
+	return found;
+}
+
+void ULogStreamBuffer::release()
+{
+	const uint32_t tail = _tail;
+
+	while (_tail != _send) {
+		const Slot &s = slot(_tail);
+
+		// keep unacked slots
+		if (s.need_ack && !s.acked) {
+			break;
+		}
+
+		++_tail;
+	}
+
+	if (_tail != tail && _producer_waiting) {
+		px4_sem_post(&_space_available);
+	}
+}
+
+} // namespace ulog
@@ -0,0 +1,175 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogStreamBuffer.hpp
+ *
+ * Ring buffer between the logger and the MAVLink ULog streaming.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <drivers/drv_hrt.h>
+#include <px4_platform_common/sem.h>
+
+namespace ulog
+{
+
+/**
+ * @class ULogStreamBuffer
+ * The logger writes ULog data directly into slots of the size of a LOGGING_DATA(_ACKED) payload, and
+ * the MAVLink stream sends them from there (no intermediate uORB copies).
+ *
+ * Slots that need an ack stay in the buffer until they are acked, and a sliding window of them can be
+ * in flight (the window size is chosen by the sender). Unacked slots are retransmitted individually.
+ * Slots without ack are released as soon as they are sent.
+ *
+ * If the buffer is full, the logger waits for slots that need an ack (up to the ack timeout), and drops
+ * data otherwise. Dropped data shows up as a gap in the sequence numbers.
+ *
+ * There is a single instance, created on first use and kept for the runtime.
+ */
+class ULogStreamBuffer
+{
+public:
+	static constexpr int DATA_LEN = 249; ///< LOGGING_DATA payload
+
+#if defined(__PX4_NUTTX)
+	static constexpr uint32_t NUM_SLOTS = 24;
+#else
+	static constexpr uint32_t NUM_SLOTS = 128;
+#endif
+
+	struct Slot {
+		hrt_abstime sent_time; ///< last time the slot was sent, 0 if not sent yet
+		uint16_t sequence;
+		uint8_t length;
+		uint8_t first_message_offset; ///< 255 if no message starts in this slot
+		uint8_t tries; ///< number of times sent
+		bool need_ack;
+		bool acked;
+		uint8_t data[DATA_LEN];
+	};
+
+	static ULogStreamBuffer *instance();
+
+	// Producer (logger) interface
+
+	/**
+	 * Drop all data and restart the sequence numbers (start or stop of a log)
+	 */
+	void reset();
+
+	/**
+	 * Append a ULog message (or a part of it).
+	 * @param message_start true if ptr points to the start of a ULog message
+	 * @param need_ack the data must be acked by the receiver
+	 * @param timeout_us how long to wait for free slots if need_ack is set
+	 * @return 0 on success, -1 if waiting for free slots timed out
+	 */
+	int write(const void *ptr, size_t size, bool message_start, bool need_ack, hrt_abstime timeout_us);
+
+	/**
+	 * Make a partially filled slot available for sending
+	 */
+	void flush();
+
+	// Consumer (MAVLink) interface. Only a single consumer is supported.
+	// The consumer holds the lock from selecting a slot until it is marked as sent, so that neither
+	// reset() nor the producer can reuse the slot in between.
+
+	void lock() { pthread_mutex_lock(&_mutex); }
+	void unlock() { pthread_mutex_unlock(&_mutex); }
+
+	/**
+	 * @return the oldest slot that needs an ack and was sent more than timeout_us ago, or nullptr (lock must be held)
+	 */
+	Slot *retransmit_candidate(hrt_abstime now, hrt_abstime timeout_us);
+
+	/**
+	 * @return the next slot that was not sent yet, or nullptr. Slots that need an ack are only returned if
+	 * less than window of them are in flight (lock must be held).
+	 */
+	Slot *next_unsent(unsigned window);
+
+	/**
+	 * Mark a slot returned by retransmit_candidate() or next_unsent() as sent (lock must be held, and not
+	 * released since the slot was returned). The slot must not be accessed afterwards.
+	 */
+	void mark_sent(Slot *slot, hrt_abstime now);
+
+	/**
+	 * Handle an ack from the receiver (thread-safe).
+	 * @return true if the sequence was in flight
+	 */
+	bool ack(uint16_t sequence);
+
+	/** @return number of slots dropped since the last reset() */
+	uint32_t dropped() const { return _dropped; }
+
+private:
+	ULogStreamBuffer();
+	~ULogStreamBuffer() = default;
+
+	Slot &slot(uint32_t index) { return _slots[index % NUM_SLOTS]; }
+
+	/** commit the slot being filled (lock must be held) */
+	void commit();
+
+	/** release sent & acked slots at the tail (lock must be held) */
+	void release();
+
+	Slot _slots[NUM_SLOTS];
+
+	// slot indices (monotonic, wrapping): [_tail, _send) sent, [_send, _head) committed, _head being filled
+	uint32_t _tail{0};
+	uint32_t _send{0};
+	uint32_t _head{0};
+	unsigned _in_flight{0}; ///< sent slots waiting for an ack
+
+	uint16_t _next_sequence{0};
+	bool _filling{false};
+	bool _drop_pending{false}; ///< data was dropped, skip a sequence number to signal it
+	uint32_t _dropped{0};
+
+	bool _producer_waiting{false};
+	px4_sem_t _space_available;
+	pthread_mutex_t _mutex;
+};
+
+} // namespace ulog
@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file GyroFifoIntegrator.hpp
+ *
+ * Integration of raw gyro FIFO blocks for the attitude estimator: one coning
+ * corrected delta angle per block and a closed-form quaternion update with it.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include <matrix/math.hpp>
+#include <uORB/topics/sensor_gyro_fifo.h>
+
+namespace attitude_estimator_q
+{
+
+/**
+ * Rotate q by a delta angle in the body frame: q = q * [cos(|a| / 2), a / |a| * sin(|a| / 2)].
+ * Below 0.1 rad, which covers a FIFO block at any realistic rate, the series
+ * expansion is used and no trigonometric function is evaluated.
+ */
+inline void rotate(matrix::Quatf &q, const matrix::Vector3f &delta_angle)
+{
+	const float angle_sq = delta_angle.norm_squared();
+	float c; // cos(|a| / 2)
+	float s; // sin(|a| / 2) / |a|
+
+	if (angle_sq < 0.01f) {
+		c = 1.f - angle_sq * (1.f / 8.f) + angle_sq * angle_sq * (1.f / 384.f);
+		s = 0.5f - angle_sq * (1.f / 48.f) + angle_sq * angle_sq * (1.f / 3840.f);
+
+	} else {
+		const float angle = sqrtf(angle_sq);
+		c = cosf(0.5f * angle);
+		s = sinf(0.5f * angle) / angle;
+	}
+
+	const float w = q(0);
+	const float x = q(1);
+	const float y = q(2);
+	const float z = q(3);
+	const float dx = s * delta_angle(0);
+	const float dy = s * delta_angle(1);
+	const float dz = s * delta_angle(2);
+
+	q(0) = w * c - x * dx - y * dy - z * dz;
+	q(1) = w * dx + x * c + y * dz - z * dy;
+	q(2) = w * dy - x * dz + y * c + z * dx;
+	q(3) = w * dz + x * dy - y * dx + z * c;
+}
+
+class GyroFifoIntegrator
+{
+public:
+	static constexpr int FIFO_SIZE_MAX = sizeof(sensor_gyro_fifo_s::x) / sizeof(sensor_gyro_fifo_s::x[0]);
+
+	void reset() { _last_delta_angle.zero(); }
+
+	/**
+	 * Delta angle of one FIFO block in the sensor frame, with coning correction.
+	 * @param fifo raw gyro samples
+	 * @param delta_angle [rad] rotation vector over the block
+	 * @return block duration [s], 0 if the block is invalid
+	 */
+	float integrate(const sensor_gyro_fifo_s &fifo, matrix::Vector3f &delta_angle)
+	{
+		const int samples = fifo.samples;
+
+		if ((samples <= 0) || (samples > FIFO_SIZE_MAX) || !(fifo.dt > 0.f) || !(fifo.scale > 0.f)) {
+			return 0.f;
+		}
+
+		const float dt = fifo.dt * 1e-6f;
+		const float raw_to_angle = fifo.scale * dt;
+
+		matrix::Vector3f alpha{0.f, 0.f, 0.f};	// integrated angle
+		matrix::Vector3f beta{0.f, 0.f, 0.f};	// coning correction
+
+		for (int n = 0; n < samples; n++) {
+			const matrix::Vector3f d{fifo.x[n] * raw_to_angle, fifo.y[n] * raw_to_angle, fifo.z[n] * raw_to_angle};
+
+			// beta += 1/2 * (alpha + 1/6 * previous delta) x delta
+			beta += (alpha + _last_delta_angle * (1.f / 6.f)) % d * 0.5f;
+			alpha += d;
+			_last_delta_angle = d;
+		}
+
+		delta_angle = alpha + beta;
+		return samples * dt;
+	}
+
+private:
+	matrix::Vector3f _last_delta_angle{0.f, 0.f, 0.f};	///< delta angle of the previous sample, also across blocks
+};
+
+} // namespace attitude_estimator_q
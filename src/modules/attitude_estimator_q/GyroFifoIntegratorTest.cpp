@@ -0,0 +1,166 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the gyro FIFO integration of the attitude estimator
+ * Run this test only using make tests TESTFILTER=GyroFifoIntegrator
+ */
+
+#include <gtest/gtest.h>
+#include <matrix/math.hpp>
+
+#include "GyroFifoIntegrator.hpp"
+
+using namespace matrix;
+using attitude_estimator_q::GyroFifoIntegrator;
+
+// angle between two attitudes [rad]
+static float angleBetween(const Quatf &a, const Quatf &b)
+{
+	const Quatf q_err = a.inversed() * b;
+	return 2.f * asinf(fminf(Vector3f(q_err(1), q_err(2), q_err(3)).norm(), 1.f));
+}
+
+static sensor_gyro_fifo_s makeFifo(int samples, float dt_us, float scale)
+{
+	sensor_gyro_fifo_s fifo{};
+	fifo.samples = samples;
+	fifo.dt = dt_us;
+	fifo.scale = scale;
+	return fifo;
+}
+
+TEST(GyroFifoIntegratorTest, rotateMatchesAxisAngle)
+{
+	const Vector3f axis = Vector3f(0.3f, -0.5f, 0.8f).normalized();
+	const Quatf q0 = Quatf(AxisAnglef(Vector3f(0.1f, 0.2f, -0.3f)));
+
+	for (float angle : {1e-4f, 0.01f, 0.09f, 0.11f, 0.5f, 2.f}) {
+		Quatf q = q0;
+		attitude_estimator_q::rotate(q, axis * angle);
+
+		const Quatf q_ref = q0 * Quatf(AxisAnglef(axis * angle));
+
+		for (int i = 0; i < 4; i++) {
+			EXPECT_NEAR(q(i), q_ref(i), 1e-6f) << "angle " << angle;
+		}
+	}
+}
+
+TEST(GyroFifoIntegratorTest, invalidBlock)
+{
+	GyroFifoIntegrator integrator;
+	Vector3f delta_angle;
+
+	EXPECT_EQ(integrator.integrate(makeFifo(0, 125.f, 1e-3f), delta_angle), 0.f);
+	EXPECT_EQ(integrator.integrate(makeFifo(GyroFifoIntegrator::FIFO_SIZE_MAX + 1, 125.f, 1e-3f), delta_angle), 0.f);
+	EXPECT_EQ(integrator.integrate(makeFifo(8, 0.f, 1e-3f), delta_angle), 0.f);
+}
+
+TEST(GyroFifoIntegratorTest, constantRate)
+{
+	// 8 kHz gyro, 8 samples per block, 1 s
+	GyroFifoIntegrator integrator;
+	const float scale = 1e-3f;
+	const Vector3f rate{1.f, -0.5f, 2.f};
+
+	sensor_gyro_fifo_s fifo = makeFifo(8, 125.f, scale);
+
+	for (int n = 0; n < 8; n++) {
+		fifo.x[n] = roundf(rate(0) / scale);
+		fifo.y[n] = roundf(rate(1) / scale);
+		fifo.z[n] = roundf(rate(2) / scale);
+	}
+
+	Quatf q;
+
+	for (int block = 0; block < 1000; block++) {
+		Vector3f delta_angle;
+		EXPECT_FLOAT_EQ(integrator.integrate(fifo, delta_angle), 8 * 125e-6f);
+		attitude_estimator_q::rotate(q, delta_angle);
+		q.normalize();
+	}
+
+	EXPECT_LT(angleBetween(q, Quatf(AxisAnglef(rate))), 1e-4f);
+}
+
+TEST(GyroFifoIntegratorTest, coningMotion)
+{
+	// rate vector rotating around the z axis, the attitude is integrated
+	// much finer as reference and compared with and without coning correction
+	const float dt = 1e-3f;		// 1 kHz gyro
+	const int samples = 10;		// 100 Hz blocks
+	const float scale = 1e-4f;
+	const float amplitude = 2.f;	// [rad/s]
+	const float frequency = 10.f;	// [rad/s] of the rotating rate vector
+
+	GyroFifoIntegrator integrator;
+	Quatf q;
+	Quatf q_no_coning;
+	Quatf q_ref;
+
+	auto rate = [&](float t) { return Vector3f(amplitude * cosf(frequency * t), amplitude * sinf(frequency * t), 0.f); };
+
+	for (int block = 0; block < 100; block++) {
+		sensor_gyro_fifo_s fifo = makeFifo(samples, dt * 1e6f, scale);
+		Vector3f alpha{0.f, 0.f, 0.f};
+
+		for (int n = 0; n < samples; n++) {
+			const float t = (block * samples + n) * dt;
+
+			// reference: 100 steps per sample with the average rate of the step
+			for (int k = 0; k < 100; k++) {
+				attitude_estimator_q::rotate(q_ref, rate(t + (k + 0.5f) * dt / 100.f) * (dt / 100.f));
+			}
+
+			// the gyro reports the average rate over the sample interval
+			const Vector3f average = rate(t + 0.5f * dt);
+			fifo.x[n] = roundf(average(0) / scale);
+			fifo.y[n] = roundf(average(1) / scale);
+			fifo.z[n] = roundf(average(2) / scale);
+			alpha += Vector3f(fifo.x[n], fifo.y[n], fifo.z[n]) * (scale * dt);
+		}
+
+		Vector3f delta_angle;
+		integrator.integrate(fifo, delta_angle);
+		attitude_estimator_q::rotate(q, delta_angle);
+		attitude_estimator_q::rotate(q_no_coning, alpha);
+	}
+
+	const float error = angleBetween(q, q_ref);
+	const float error_no_coning = angleBetween(q_no_coning, q_ref);
+
+	EXPECT_LT(error, 2e-3f);
+	EXPECT_LT(error, 0.2f * error_no_coning);
+}
@@ -41,11 +41,14 @@
 
 #include <float.h>
 
+#include "GyroFifoIntegrator.hpp"
+
 #include <drivers/drv_hrt.h>
 #include <lib/ecl/geo/geo.h>
 #include <lib/ecl/geo_lookup/geo_mag_declination.h>
 #include <lib/mathlib/mathlib.h>
 #include <lib/parameters/param.h>
+#include <lib/sensor_calibration/Gyroscope.hpp>
 #include <matrix/math.hpp>
 #include <px4_platform_common/defines.h>
 #include <px4_platform_common/module.h>
@@ -56,6 +59,8 @@
 #include <uORB/SubscriptionCallback.hpp>
 #include <uORB/topics/parameter_update.h>
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_gyro_fifo.h>
+#include <uORB/topics/sensor_selection.h>
 #include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/vehicle_gps_position.h>
 #include <uORB/topics/vehicle_local_position.h>
@@ -98,6 +103,14 @@ private:
 
 	bool update(float dt);
 
+	// Select the gyro FIFO of the voted gyro if ATT_GYRO_FIFO is enabled
+	void update_gyro_fifo_selection();
+
+	// Integrate all pending gyro FIFO blocks and publish the attitude after each
+	void update_gyro_fifo();
+
+	void publish_attitude(hrt_abstime timestamp_sample);
+
 	// Update magnetic declination (in rads) immediately changing yaw rotation
 	void update_mag_declination(float new_declination);
 
@@ -107,6 +120,8 @@ private:
 	const float _dt_max = 0.02f;
 
 	uORB::SubscriptionCallbackWorkItem _sensors_sub{this, ORB_ID(sensor_combined)};
+	uORB::SubscriptionCallbackWorkItem _sensor_gyro_fifo_sub{this, ORB_ID(sensor_gyro_fifo)};
+	uORB::Subscription _sensor_selection_sub{ORB_ID(sensor_selection)};
 
 	uORB::SubscriptionInterval	_parameter_update_sub{ORB_ID(parameter_update), 1_s};
 	uORB::Subscription		_gps_sub{ORB_ID(vehicle_gps_position)};
@@ -142,6 +157,12 @@ private:
 	bool		_data_good{false};
 	bool		_ext_hdg_good{false};
 
+	// gyro FIFO mode: the gyro is integrated per FIFO block, corrections run at the sensor_combined rate
+	attitude_estimator_q::GyroFifoIntegrator _gyro_fifo_integrator;
+	calibration::Gyroscope	_gyro_calibration{};
+	uint32_t	_selected_gyro_device_id{0};
+	bool		_gyro_fifo{false};
+
 	DEFINE_PARAMETERS(
 		(ParamFloat<px4::params::ATT_W_ACC>) _param_att_w_acc,
 		(ParamFloat<px4::params::ATT_W_MAG>) _param_att_w_mag,
@@ -152,7 +173,8 @@ private:
 		(ParamInt<px4::params::ATT_EXT_HDG_M>) _param_att_ext_hdg_m,
 		(ParamInt<px4::params::ATT_ACC_COMP>) _param_att_acc_comp,
 		(ParamFloat<px4::params::ATT_BIAS_MAX>) _param_att_bias_mas,
-		(ParamInt<px4::params::SYS_HAS_MAG>) _param_sys_has_mag
+		(ParamInt<px4::params::SYS_HAS_MAG>) _param_sys_has_mag,
+		(ParamInt<px4::params::ATT_GYRO_FIFO>) _param_att_gyro_fifo
 	)
 };
 
@@ -193,10 +215,17 @@ AttitudeEstimatorQ::Run()
 {
 	if (should_exit()) {
 		_sensors_sub.unregisterCallback();
+		_sensor_gyro_fifo_sub.unregisterCallback();
 		exit_and_cleanup();
 		return;
 	}
 
+	update_gyro_fifo_selection();
+
+	if (_gyro_fifo) {
+		update_gyro_fifo();
+	}
+
 	sensor_combined_s sensors;
 
 	if (_sensors_sub.update(&sensors)) {
@@ -347,16 +376,102 @@ AttitudeEstimatorQ::Run()
 		const float dt = math::constrain((now - _last_time) / 1e6f, _dt_min, _dt_max);
 		_last_time = now;
 
-		if (update(dt)) {
-			vehicle_attitude_s att = {};
-			att.timestamp_sample = sensors.timestamp;
-			_q.copyTo(att.q);
+		// in gyro FIFO mode the attitude is published for every FIFO block
+		if (update(dt) && !_gyro_fifo) {
+			publish_attitude(sensors.timestamp);
+		}
+	}
+}
+
+void
+AttitudeEstimatorQ::publish_attitude(hrt_abstime timestamp_sample)
+{
+	vehicle_attitude_s att = {};
+	att.timestamp_sample = timestamp_sample;
+	_q.copyTo(att.q);
+
+	/* the instance count is not used here */
+	att.timestamp = hrt_absolute_time();
+	_att_pub.publish(att);
+}
+
+void
+AttitudeEstimatorQ::update_gyro_fifo_selection()
+{
+	if (_param_att_gyro_fifo.get() == 0) {
+		if (_gyro_fifo) {
+			_sensor_gyro_fifo_sub.unregisterCallback();
+			_gyro_fifo = false;
+		}
+
+		_selected_gyro_device_id = 0;
+		return;
+	}
+
+	if (!_sensor_selection_sub.updated() && (_selected_gyro_device_id != 0)) {
+		return;
+	}
+
+	sensor_selection_s sensor_selection{};
+	_sensor_selection_sub.copy(&sensor_selection);
+
+	if (sensor_selection.gyro_device_id == _selected_gyro_device_id) {
+		return;
+	}
+
+	_selected_gyro_device_id = sensor_selection.gyro_device_id;
+	_sensor_gyro_fifo_sub.unregisterCallback();
+	_gyro_fifo = false;
+
+	// see if the selected gyro publishes sensor_gyro_fifo, otherwise fall back to sensor_combined
+	for (uint8_t i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
+		uORB::SubscriptionData<sensor_gyro_fifo_s> sensor_gyro_fifo_sub{ORB_ID(sensor_gyro_fifo), i};
+
+		if ((sensor_gyro_fifo_sub.get().device_id != 0)
+		    && (sensor_gyro_fifo_sub.get().device_id == _selected_gyro_device_id)) {
+
+			if (_sensor_gyro_fifo_sub.ChangeInstance(i) && _sensor_gyro_fifo_sub.registerCallback()) {
+				_gyro_calibration.set_device_id(_selected_gyro_device_id);
+				_gyro_fifo_integrator.reset();
+				_gyro_fifo = true;
+
+				PX4_DEBUG("integrating gyro FIFO %d %d", i, _selected_gyro_device_id);
+			}
+
+			break;
+		}
+	}
+}
+
+void
+AttitudeEstimatorQ::update_gyro_fifo()
+{
+	_gyro_calibration.SensorCorrectionsUpdate();
 
-			/* the instance count is not used here */
-			att.timestamp = hrt_absolute_time();
-			_att_pub.publish(att);
+	sensor_gyro_fifo_s sensor_gyro_fifo;
 
+	while (_sensor_gyro_fifo_sub.update(&sensor_gyro_fifo)) {
+		Vector3f delta_angle;
+		const float block_dt = _gyro_fifo_integrator.integrate(sensor_gyro_fifo, delta_angle);
+
+		if (!_inited || !(block_dt > 0.f)) {
+			continue;
 		}
+
+		// calibration (offsets are rates) and rotation to the body frame, then the estimated bias
+		delta_angle = _gyro_calibration.Correct(delta_angle / block_dt) * block_dt + _gyro_bias * block_dt;
+
+		const Quatf q_last = _q;
+		attitude_estimator_q::rotate(_q, delta_angle);
+		_q.normalize();
+
+		if (!(PX4_ISFINITE(_q(0)) && PX4_ISFINITE(_q(1)) &&
+		      PX4_ISFINITE(_q(2)) && PX4_ISFINITE(_q(3)))) {
+			_q = q_last;
+			continue;
+		}
+
+		publish_attitude(sensor_gyro_fifo.timestamp_sample);
 	}
 }
 
@@ -372,6 +487,10 @@ AttitudeEstimatorQ::update_parameters(bool force)
 		// update parameters from storage
 		updateParams();
 
+		// reload the gyro calibration and select the gyro FIFO again
+		_gyro_calibration.ParametersUpdate();
+		_selected_gyro_device_id = 0;
+
 		// disable mag fusion if the system does not have a mag
 		if (_param_sys_has_mag.get() == 0) {
 			_param_att_w_mag.set(0.0f);
@@ -521,8 +640,10 @@ AttitudeEstimatorQ::update(float dt)
 
 	_rates = _gyro + _gyro_bias;
 
-	// Feed forward gyro
-	corr += _rates;
+	// Feed forward gyro, in gyro FIFO mode the gyro is integrated per FIFO block instead
+	if (!_gyro_fifo) {
+		corr += _rates;
+	}
 
 	// Apply correction to state
 	_q += _q.derivative1(corr) * dt;
@@ -600,6 +721,10 @@ AttitudeEstimatorQ::print_usage(const char *reason)
 ### Description
 Attitude estimator q.
 
+With ATT_GYRO_FIFO enabled the raw FIFO of the selected gyro is integrated at its full rate and the attitude
+is published for every FIFO block, while the accelerometer, magnetometer and external heading corrections
+run at the sensor_combined rate.
+
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("AttitudeEstimatorQ", "estimator");
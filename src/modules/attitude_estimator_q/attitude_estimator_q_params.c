@@ -134,3 +134,16 @@ PARAM_DEFINE_INT32(ATT_ACC_COMP, 1);
  * @decimal 3
  */
 PARAM_DEFINE_FLOAT(ATT_BIAS_MAX, 0.05f);
+
+/**
+ * Integrate the gyro FIFO
+ *
+ * Integrate the raw FIFO of the selected gyro at its full sample rate and
+ * publish the attitude for every FIFO block. The accelerometer, magnetometer
+ * and external heading corrections keep running at the sensor_combined rate.
+ * Falls back to sensor_combined if the selected gyro does not publish a FIFO.
+ *
+ * @group Attitude Q estimator
+ * @boolean
+ */
+PARAM_DEFINE_INT32(ATT_GYRO_FIFO, 0);
@@ -36,14 +36,16 @@
  */
 
 #include "PreFlightCheck.hpp"
+#include "PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <HealthFlags.h>
-#include <lib/parameters/param.h>
+#include <string.h>
 #include <systemlib/mavlink_log.h>
 #include <uORB/Subscription.hpp>
 
 using namespace time_literals;
+using Check = PreFlightCheckContext::Check;
 
 static constexpr unsigned max_mandatory_gyro_count = 1;
 static constexpr unsigned max_optional_gyro_count = 4;
@@ -54,6 +56,88 @@ static constexpr unsigned max_optional_mag_count = 4;
 static constexpr unsigned max_mandatory_baro_count = 1;
 static constexpr unsigned max_optional_baro_count = 4;
 
+static_assert(max_optional_mag_count <= PreFlightCheckContext::MAX_SENSOR_COUNT, "not enough mag subscriptions");
+static_assert(max_optional_accel_count <= PreFlightCheckContext::MAX_SENSOR_COUNT, "not enough accel subscriptions");
+static_assert(max_optional_gyro_count <= PreFlightCheckContext::MAX_SENSOR_COUNT, "not enough gyro subscriptions");
+static_assert(max_optional_baro_count <= PreFlightCheckContext::MAX_SENSOR_COUNT, "not enough baro subscriptions");
+
+// checks that depend on the age of their data are re-evaluated at least at this interval
+static constexpr hrt_abstime timeout_check_interval = 500_ms;
+
+// health flags written by the cached checks
+static constexpr uint32_t mag_health_flags = subsystem_info_s::SUBSYSTEM_TYPE_MAG | subsystem_info_s::SUBSYSTEM_TYPE_MAG2;
+static constexpr uint32_t imu_health_flags = subsystem_info_s::SUBSYSTEM_TYPE_ACC | subsystem_info_s::SUBSYSTEM_TYPE_ACC2
+		| subsystem_info_s::SUBSYSTEM_TYPE_GYRO | subsystem_info_s::SUBSYSTEM_TYPE_GYRO2;
+
+static void get_health_flags(const vehicle_status_s &status, uint32_t mask, uint32_t flags[3])
+{
+	flags[0] = status.onboard_control_sensors_present & mask;
+	flags[1] = status.onboard_control_sensors_enabled & mask;
+	flags[2] = status.onboard_control_sensors_health & mask;
+}
+
+static void restore_health_flags(vehicle_status_s &status, uint32_t mask, const uint32_t flags[3])
+{
+	status.onboard_control_sensors_present = (status.onboard_control_sensors_present & ~mask) | flags[0];
+	status.onboard_control_sensors_enabled = (status.onboard_control_sensors_enabled & ~mask) | flags[1];
+	status.onboard_control_sensors_health = (status.onboard_control_sensors_health & ~mask) | flags[2];
+}
+
+/**
+ * Run a check, or return its cached result (and restore the health flags it set) if none of its inputs changed.
+ *
+ * @param topics_updated true if any of the topics the check reads was updated
+ * @param context inputs of the check that are not topics or parameters
+ * @param health_mask health flags written by the check, and the ones set by earlier checks it builds upon
+ * @param max_age re-evaluate after this time even without updates (0: never)
+ * @param verbose the check also reports warnings on success, re-evaluate it whenever reporting
+ */
+template<typename CheckFunction>
+static bool evaluate(Check check, vehicle_status_s &status, const bool topics_updated, const uint32_t context,
+		     const uint32_t health_mask, const hrt_abstime max_age, const bool report, const bool verbose,
+		     CheckFunction check_function)
+{
+	PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	PreFlightCheckContext::CheckCache &cache = ctx.cache(check);
+	const hrt_abstime now = hrt_absolute_time();
+
+	uint32_t health_in[3];
+	get_health_flags(status, health_mask, health_in);
+
+	bool changed = (cache.evaluated == 0) || topics_updated
+		       || (cache.param_generation != ctx.paramGeneration())
+		       || (cache.context != context)
+		       || (memcmp(health_in, cache.health_in, sizeof(health_in)) != 0)
+		       || ((max_age != 0) && (now > cache.evaluated + max_age));
+
+	// failures are always reported in full, and a failure found while reporting is checked again
+	// when not reporting, as some checks change the health flags when reporting
+	if (report && (verbose || (cache.result == 0))) {
+		changed = true;
+	}
+
+	if (!report && cache.reported && (cache.result == 0)) {
+		changed = true;
+	}
+
+	if (!changed) {
+		restore_health_flags(status, health_mask, cache.health_out);
+		return cache.result != 0;
+	}
+
+	const bool pass = check_function();
+
+	cache.evaluated = now;
+	cache.param_generation = ctx.paramGeneration();
+	cache.context = context;
+	memcpy(cache.health_in, health_in, sizeof(health_in));
+	get_health_flags(status, health_mask, cache.health_out);
+	cache.result = pass;
+	cache.reported = report;
+
+	return pass;
+}
+
 bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status,
 				    vehicle_status_flags_s &status_flags, bool report_failures, const bool prearm,
 				    const hrt_abstime &time_since_boot)
@@ -61,6 +145,9 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 	report_failures = (report_failures && status_flags.condition_system_hotplug_timeout
 			   && !status_flags.condition_calibration_enabled);
 
+	PreFlightCheckContext &ctx = PreFlightCheckContext::acquire();
+	const PreFlightCheckContext::Parameters &params = ctx.params;
+
 	bool failed = false;
 
 	failed = failed || !airframeCheck(mavlink_log_pub, status);
@@ -68,14 +155,21 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 
 	/* ---- MAG ---- */
 	{
-		int32_t sys_has_mag = 1;
-		param_get(param_find("SYS_HAS_MAG"), &sys_has_mag);
+		if (params.sys_has_mag == 1) {
 
-		if (sys_has_mag == 1) {
+			// magnetometer faults reported by the estimator instances
+			for (uint8_t i = 0; i < ctx.estimator_status_subs.size(); i++) {
+				estimator_status_s estimator_status;
+
+				if (ctx.estimator_status_subs[i].update(&estimator_status)) {
+					ctx.estimator_mag_status[i].mag_device_id = estimator_status.mag_device_id;
+					ctx.estimator_mag_status[i].mag_fault = estimator_status.control_mode_flags & (1 << estimator_status_s::CS_MAG_FAULT);
+				}
+			}
 
 			/* check all sensors individually, but fail only for mandatory ones */
 			for (unsigned i = 0; i < max_optional_mag_count; i++) {
-				const bool required = (i < max_mandatory_mag_count) && (sys_has_mag == 1);
+				const bool required = (i < max_mandatory_mag_count) && (params.sys_has_mag == 1);
 				bool report_fail = report_failures;
 
 				int32_t device_id = -1;
@@ -92,7 +186,12 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 			// TODO: highest priority mag
 
 			/* mag consistency checks (need to be performed after the individual checks) */
-			if (!magConsistencyCheck(mavlink_log_pub, status, report_failures)) {
+			const bool updated = ctx.sensor_preflight_mag_sub.update();
+
+			const bool mag_consistent = evaluate(Check::MagConsistency, status, updated, 0, mag_health_flags, 0,
+							     report_failures, false, [&]() { return magConsistencyCheck(mavlink_log_pub, status, report_failures); });
+
+			if (!mag_consistent) {
 				failed = true;
 			}
 		}
@@ -142,14 +241,11 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 
 	/* ---- BARO ---- */
 	{
-		int32_t sys_has_baro = 1;
-		param_get(param_find("SYS_HAS_BARO"), &sys_has_baro);
-
 		bool baro_fail_reported = false;
 
 		/* check all sensors, but fail only for mandatory ones */
 		for (unsigned i = 0; i < max_optional_baro_count; i++) {
-			const bool required = (i < max_mandatory_baro_count) && (sys_has_baro == 1);
+			const bool required = (i < max_mandatory_baro_count) && (params.sys_has_baro == 1);
 			bool report_fail = (required && report_failures && !baro_fail_reported);
 
 			int32_t device_id = -1;
@@ -167,7 +263,12 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 	/* ---- IMU CONSISTENCY ---- */
 	// To be performed after the individual sensor checks have completed
 	{
-		if (!imuConsistencyCheck(mavlink_log_pub, status, report_failures)) {
+		const bool updated = ctx.sensors_status_imu_sub.update();
+
+		const bool imu_consistent = evaluate(Check::ImuConsistency, status, updated, 0, imu_health_flags, 0,
+						     report_failures, true, [&]() { return imuConsistencyCheck(mavlink_log_pub, status, report_failures); });
+
+		if (!imu_consistent) {
 			failed = true;
 		}
 	}
@@ -177,28 +278,30 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 	if (!status_flags.circuit_breaker_engaged_airspd_check &&
 	    (status.vehicle_type == vehicle_status_s::VEHICLE_TYPE_FIXED_WING || status.is_vtol)) {
 
-		int32_t airspeed_mode = 0;
-		param_get(param_find("FW_ARSP_MODE"), &airspeed_mode);
-		const bool optional = (airspeed_mode == 1);
+		const bool optional = (params.fw_arsp_mode == 1);
+		const bool max_airspeed_check_en = (params.com_arm_arsp_en != 0);
+		const float arming_max_airspeed_allowed = params.fw_airspd_trim / 2.0f; // set to half of trim airspeed
 
-		int32_t max_airspeed_check_en = 0;
-		param_get(param_find("COM_ARM_ARSP_EN"), &max_airspeed_check_en);
+		const bool updated = ctx.airspeed_validated_sub.update();
 
-		float airspeed_trim = 10.0f;
-		param_get(param_find("FW_AIRSPD_TRIM"), &airspeed_trim);
+		const bool airspeed_ok = evaluate(Check::Airspeed, status, updated, prearm,
+						  subsystem_info_s::SUBSYSTEM_TYPE_DIFFPRESSURE, timeout_check_interval, report_failures, false, [&]() {
+			return airspeedCheck(mavlink_log_pub, status, optional, report_failures, prearm, max_airspeed_check_en,
+					     arming_max_airspeed_allowed);
+		});
 
-		const float arming_max_airspeed_allowed = airspeed_trim / 2.0f; // set to half of trim airspeed
-
-		if (!airspeedCheck(mavlink_log_pub, status, optional, report_failures, prearm, (bool)max_airspeed_check_en,
-				   arming_max_airspeed_allowed)
-		    && !(bool)optional) {
+		if (!airspeed_ok && !optional) {
 			failed = true;
 		}
 	}
 
 	/* ---- RC CALIBRATION ---- */
 	if (status.rc_input_mode == vehicle_status_s::RC_IN_MODE_DEFAULT) {
-		if (rcCalibrationCheck(mavlink_log_pub, report_failures, status.is_vtol) != OK) {
+		// only depends on parameters
+		const bool rc_calibration_valid = evaluate(Check::RcCalibration, status, false, status.is_vtol, 0, 0,
+						  report_failures, false, [&]() { return rcCalibrationCheck(mavlink_log_pub, report_failures, status.is_vtol) == OK; });
+
+		if (!rc_calibration_valid) {
 			if (report_failures) {
 				mavlink_log_critical(mavlink_log_pub, "RC calibration check failed");
 			}
@@ -218,7 +321,14 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 
 	/* ---- SYSTEM POWER ---- */
 	if (status_flags.condition_power_input_valid && !status_flags.circuit_breaker_engaged_power_check) {
-		if (!powerCheck(mavlink_log_pub, status, report_failures, prearm)) {
+		const bool updated = ctx.system_power_sub.update();
+		const uint32_t context = prearm | ((status.hil_state == vehicle_status_s::HIL_STATE_ON) << 1);
+
+		const bool power_ok = evaluate(Check::Power, status, updated, context, 0, 0, report_failures, true, [&]() {
+			return powerCheck(mavlink_log_pub, status, report_failures, prearm);
+		});
+
+		if (!power_ok) {
 			failed = true;
 		}
 	}
@@ -228,7 +338,7 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 	int32_t estimator_type = -1;
 
 	if (status.vehicle_type == vehicle_status_s::VEHICLE_TYPE_ROTARY_WING && !status.is_vtol) {
-		param_get(param_find("SYS_MC_EST_GROUP"), &estimator_type);
+		estimator_type = params.sys_mc_est_group;
 
 	} else {
 		// EKF2 is currently the only supported option for FW & VTOL
@@ -237,8 +347,34 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 
 	if (estimator_type == 2) {
 
-		const bool ekf_healthy = ekf2Check(mavlink_log_pub, status, false, report_failures) &&
-					 ekf2CheckSensorBias(mavlink_log_pub, report_failures);
+		bool selector_updated = ctx.estimator_selector_status_sub.update();
+		const uint8_t primary_instance = ctx.estimator_selector_status_sub.get().primary_instance;
+
+		if (ctx.estimator_status_sub.get_instance() != primary_instance) {
+			ctx.estimator_status_sub.ChangeInstance(primary_instance);
+			ctx.estimator_sensor_bias_sub.ChangeInstance(primary_instance);
+			selector_updated = true;
+		}
+
+		const bool status_updated = ctx.estimator_status_sub.update();
+		const bool bias_updated = ctx.estimator_sensor_bias_sub.update();
+
+		// warnings are reported on success if arming without GPS is allowed
+		const bool ekf_status_ok = evaluate(Check::Ekf2, status, selector_updated || status_updated, 0,
+						    subsystem_info_s::SUBSYSTEM_TYPE_GPS, 0, report_failures, params.com_arm_wo_gps != 0, [&]() {
+			return ekf2Check(mavlink_log_pub, status, false, report_failures);
+		});
+
+		bool ekf_healthy = false;
+
+		if (ekf_status_ok) {
+			ekf_healthy = evaluate(Check::Ekf2SensorBias, status, selector_updated || bias_updated, 0, 0, timeout_check_interval,
+					       report_failures, false, [&]() { return ekf2CheckSensorBias(mavlink_log_pub, report_failures); });
+
+		} else {
+			// the bias update was consumed without running the check, evaluate it again once the status passes
+			ctx.cache(Check::Ekf2SensorBias).evaluated = 0;
+		}
 
 		// For the first 10 seconds the ekf2 can be unhealthy, and we just mark it
 		// as not present.
@@ -259,8 +395,27 @@ bool PreFlightCheck::preflightCheck(orb_advert_t *mavlink_log_pub, vehicle_statu
 		failed = true;
 	}
 
-	failed = failed || !manualControlCheck(mavlink_log_pub, report_failures);
-	failed = failed || !cpuResourceCheck(mavlink_log_pub, report_failures);
+	{
+		const bool updated = ctx.manual_control_switches_sub.update();
+
+		// always evaluated, the switches are only published on change and the update is consumed here
+		const bool manual_control_ok = evaluate(Check::ManualControl, status, updated, 0, 0, 0, report_failures, false, [&]() {
+			return manualControlCheck(mavlink_log_pub, report_failures);
+		});
+
+		failed = failed || !manual_control_ok;
+	}
+
+	{
+		const bool updated = ctx.cpuload_sub.update();
+
+		const bool cpu_resource_ok = evaluate(Check::CpuResource, status, updated, 0, 0, timeout_check_interval,
+						      report_failures, false, [&]() { return cpuResourceCheck(mavlink_log_pub, report_failures); });
+
+		failed = failed || !cpu_resource_ok;
+	}
+
+	PreFlightCheckContext::release();
 
 	/* Report status */
 	return !failed;
@@ -58,6 +58,9 @@ public:
 	* The function won't fail the test if optional sensors are not found, however,
 	* it will fail the test if optional sensors are found but not in working condition.
 	*
+	* Subscriptions and parameters are kept between calls, and a check whose inputs (topics,
+	* parameters, vehicle state) did not change since its last evaluation returns its cached result.
+	*
 	* @param mavlink_log_pub
 	*   Mavlink output orb handle reference for feedback when a sensor fails
 	* @param checkMag
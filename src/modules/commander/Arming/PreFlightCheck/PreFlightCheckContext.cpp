@@ -0,0 +1,138 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file PreFlightCheckContext.cpp
+ */
+
+#include "PreFlightCheckContext.hpp"
+
+#include <lib/sensor_calibration/Utilities.hpp>
+
+PreFlightCheckContext *PreFlightCheckContext::_instance = nullptr;
+pthread_mutex_t PreFlightCheckContext::_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+PreFlightCheckContext &PreFlightCheckContext::acquire()
+{
+	// the checks run from the commander thread and from the 'commander check' command
+	pthread_mutex_lock(&_mutex);
+
+	if (_instance == nullptr) {
+		_instance = new PreFlightCheckContext();
+	}
+
+	_instance->updateParams();
+
+	return *_instance;
+}
+
+void PreFlightCheckContext::release()
+{
+	pthread_mutex_unlock(&_mutex);
+}
+
+void PreFlightCheckContext::updateParams()
+{
+	if (_param_generation != 0) {
+		if (!_parameter_update_sub.updated()) {
+			return;
+		}
+
+		parameter_update_s param_update;
+		_parameter_update_sub.copy(&param_update);
+
+	} else {
+		_param_handles.sys_has_mag = param_find("SYS_HAS_MAG");
+		_param_handles.sys_has_baro = param_find("SYS_HAS_BARO");
+		_param_handles.sys_mc_est_group = param_find("SYS_MC_EST_GROUP");
+		_param_handles.fw_arsp_mode = param_find("FW_ARSP_MODE");
+		_param_handles.fw_airspd_trim = param_find("FW_AIRSPD_TRIM");
+		_param_handles.com_arm_arsp_en = param_find("COM_ARM_ARSP_EN");
+		_param_handles.com_arm_mag_str = param_find("COM_ARM_MAG_STR");
+		_param_handles.com_arm_ekf_hgt = param_find("COM_ARM_EKF_HGT");
+		_param_handles.com_arm_ekf_vel = param_find("COM_ARM_EKF_VEL");
+		_param_handles.com_arm_ekf_pos = param_find("COM_ARM_EKF_POS");
+		_param_handles.com_arm_ekf_yaw = param_find("COM_ARM_EKF_YAW");
+		_param_handles.com_arm_wo_gps = param_find("COM_ARM_WO_GPS");
+		_param_handles.com_arm_imu_acc = param_find("COM_ARM_IMU_ACC");
+		_param_handles.com_arm_imu_gyr = param_find("COM_ARM_IMU_GYR");
+		_param_handles.com_arm_mag_ang = param_find("COM_ARM_MAG_ANG");
+		_param_handles.com_cpu_max = param_find("COM_CPU_MAX");
+		_param_handles.com_power_count = param_find("COM_POWER_COUNT");
+		_param_handles.com_arm_sdcard = param_find("COM_ARM_SDCARD");
+	}
+
+	param_get(_param_handles.sys_has_mag, &params.sys_has_mag);
+	param_get(_param_handles.sys_has_baro, &params.sys_has_baro);
+	param_get(_param_handles.sys_mc_est_group, &params.sys_mc_est_group);
+	param_get(_param_handles.fw_arsp_mode, &params.fw_arsp_mode);
+	param_get(_param_handles.fw_airspd_trim, &params.fw_airspd_trim);
+	param_get(_param_handles.com_arm_arsp_en, &params.com_arm_arsp_en);
+	param_get(_param_handles.com_arm_mag_str, &params.com_arm_mag_str);
+	param_get(_param_handles.com_arm_ekf_hgt, &params.com_arm_ekf_hgt);
+	param_get(_param_handles.com_arm_ekf_vel, &params.com_arm_ekf_vel);
+	param_get(_param_handles.com_arm_ekf_pos, &params.com_arm_ekf_pos);
+	param_get(_param_handles.com_arm_ekf_yaw, &params.com_arm_ekf_yaw);
+	param_get(_param_handles.com_arm_wo_gps, &params.com_arm_wo_gps);
+	param_get(_param_handles.com_arm_imu_acc, &params.com_arm_imu_acc);
+	param_get(_param_handles.com_arm_imu_gyr, &params.com_arm_imu_gyr);
+	param_get(_param_handles.com_arm_mag_ang, &params.com_arm_mag_ang);
+	param_get(_param_handles.com_cpu_max, &params.com_cpu_max);
+	param_get(_param_handles.com_power_count, &params.com_power_count);
+	param_get(_param_handles.com_arm_sdcard, &params.com_arm_sdcard);
+
+	// never 0, which marks the parameters as not loaded yet
+	if (++_param_generation == 0) {
+		_param_generation = 1;
+	}
+}
+
+bool PreFlightCheckContext::calibrationValid(SensorType type, uint8_t instance, uint32_t device_id)
+{
+	static constexpr const char *sensor_type_names[SENSOR_TYPE_COUNT] {"ACC", "GYRO", "MAG"};
+
+	if (instance >= MAX_SENSOR_COUNT) {
+		return calibration::FindCalibrationIndex(sensor_type_names[type], device_id) >= 0;
+	}
+
+	CalibrationCache &cache = _calibration[type][instance];
+
+	if ((cache.param_generation != _param_generation) || (cache.device_id != device_id)) {
+		cache.valid = (calibration::FindCalibrationIndex(sensor_type_names[type], device_id) >= 0);
+		cache.device_id = device_id;
+		cache.param_generation = _param_generation;
+	}
+
+	return cache.valid;
+}
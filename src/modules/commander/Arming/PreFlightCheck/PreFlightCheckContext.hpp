@@ -0,0 +1,217 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file PreFlightCheckContext.hpp
+ *
+ * State kept by PreFlightCheck between calls: subscriptions, parameter values
+ * and the last result of every check, so that a check only has to be
+ * re-evaluated when one of its inputs changed.
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+#include <lib/parameters/param.h>
+#include <pthread.h>
+#include <uORB/Subscription.hpp>
+#include <uORB/SubscriptionMultiArray.hpp>
+#include <uORB/topics/airspeed_validated.h>
+#include <uORB/topics/cpuload.h>
+#include <uORB/topics/estimator_selector_status.h>
+#include <uORB/topics/estimator_sensor_bias.h>
+#include <uORB/topics/estimator_status.h>
+#include <uORB/topics/manual_control_switches.h>
+#include <uORB/topics/parameter_update.h>
+#include <uORB/topics/sensor_accel.h>
+#include <uORB/topics/sensor_baro.h>
+#include <uORB/topics/sensor_gyro.h>
+#include <uORB/topics/sensor_mag.h>
+#include <uORB/topics/sensor_preflight_mag.h>
+#include <uORB/topics/sensors_status_imu.h>
+#include <uORB/topics/system_power.h>
+#include <uORB/topics/vehicle_status.h>
+
+class PreFlightCheckContext
+{
+public:
+	static constexpr uint8_t MAX_SENSOR_COUNT = 4;
+
+	/**
+	 * Lock the context (creating it on first use) and update the parameters.
+	 * Must be paired with release(); the checks access the context through get() in between.
+	 */
+	static PreFlightCheckContext &acquire();
+	static void release();
+
+	static PreFlightCheckContext &get() { return *_instance; }
+
+	/**
+	 * Result of a check from its last evaluation, together with everything it depended on.
+	 */
+	struct CheckCache {
+		hrt_abstime evaluated{0};	///< time of the last evaluation (0: never evaluated)
+		uint32_t param_generation{0};
+		uint32_t context{0};		///< inputs that are not topics, e.g. prearm or vehicle type
+		uint32_t health_in[3] {};	///< health flags owned by the check, before the last evaluation
+		uint32_t health_out[3] {};	///< health flags owned by the check, after the last evaluation
+		int result{0};
+		bool reported{false};		///< last evaluation reported its failures
+	};
+
+	enum class Check : uint8_t {
+		MagConsistency,
+		ImuConsistency,
+		Airspeed,
+		RcCalibration,
+		Power,
+		Ekf2,
+		Ekf2SensorBias,
+		ManualControl,
+		CpuResource,
+		Count
+	};
+
+	CheckCache &cache(Check check) { return _cache[static_cast<uint8_t>(check)]; }
+
+	/** incremented on every parameter change, cached check results are invalidated by it */
+	uint32_t paramGeneration() const { return _param_generation; }
+
+	enum SensorType : uint8_t {
+		SENSOR_ACCEL,
+		SENSOR_GYRO,
+		SENSOR_MAG,
+		SENSOR_TYPE_COUNT
+	};
+
+	/**
+	 * Returns true if a calibration for the sensor exists. The lookup goes through all
+	 * calibration parameters, so the result is cached per instance until parameters change.
+	 */
+	bool calibrationValid(SensorType type, uint8_t instance, uint32_t device_id);
+
+	struct Parameters {
+		int32_t sys_has_mag{1};
+		int32_t sys_has_baro{1};
+		int32_t sys_mc_est_group{-1};
+		int32_t fw_arsp_mode{0};
+		float fw_airspd_trim{10.f};
+		int32_t com_arm_arsp_en{0};
+		int32_t com_arm_mag_str{1};
+		float com_arm_ekf_hgt{1.f};
+		float com_arm_ekf_vel{1.f};
+		float com_arm_ekf_pos{1.f};
+		float com_arm_ekf_yaw{1.f};
+		int32_t com_arm_wo_gps{0};
+		float com_arm_imu_acc{1.f};
+		float com_arm_imu_gyr{1.f};
+		int32_t com_arm_mag_ang{90};
+		float com_cpu_max{90.f};
+		int32_t com_power_count{0};
+		int32_t com_arm_sdcard{0};
+	} params;
+
+	uORB::SubscriptionData<sensor_accel_s> sensor_accel[MAX_SENSOR_COUNT] {
+		{ORB_ID(sensor_accel), 0}, {ORB_ID(sensor_accel), 1}, {ORB_ID(sensor_accel), 2}, {ORB_ID(sensor_accel), 3}
+	};
+	uORB::SubscriptionData<sensor_gyro_s> sensor_gyro[MAX_SENSOR_COUNT] {
+		{ORB_ID(sensor_gyro), 0}, {ORB_ID(sensor_gyro), 1}, {ORB_ID(sensor_gyro), 2}, {ORB_ID(sensor_gyro), 3}
+	};
+	uORB::SubscriptionData<sensor_mag_s> sensor_mag[MAX_SENSOR_COUNT] {
+		{ORB_ID(sensor_mag), 0}, {ORB_ID(sensor_mag), 1}, {ORB_ID(sensor_mag), 2}, {ORB_ID(sensor_mag), 3}
+	};
+	uORB::SubscriptionData<sensor_baro_s> sensor_baro[MAX_SENSOR_COUNT] {
+		{ORB_ID(sensor_baro), 0}, {ORB_ID(sensor_baro), 1}, {ORB_ID(sensor_baro), 2}, {ORB_ID(sensor_baro), 3}
+	};
+
+	uORB::SubscriptionMultiArray<estimator_status_s> estimator_status_subs{ORB_ID::estimator_status};
+
+	/** magnetometer fault flags reported by every estimator instance */
+	struct EstimatorMagStatus {
+		uint32_t mag_device_id{0};
+		bool mag_fault{false};
+	} estimator_mag_status[ORB_MULTI_MAX_INSTANCES] {};
+
+	uORB::SubscriptionData<estimator_selector_status_s> estimator_selector_status_sub{ORB_ID(estimator_selector_status)};
+	uORB::SubscriptionData<estimator_status_s> estimator_status_sub{ORB_ID(estimator_status)};
+	uORB::SubscriptionData<estimator_sensor_bias_s> estimator_sensor_bias_sub{ORB_ID(estimator_sensor_bias)};
+
+	uORB::SubscriptionData<airspeed_validated_s> airspeed_validated_sub{ORB_ID(airspeed_validated)};
+	uORB::SubscriptionData<cpuload_s> cpuload_sub{ORB_ID(cpuload)};
+	uORB::SubscriptionData<manual_control_switches_s> manual_control_switches_sub{ORB_ID(manual_control_switches)};
+	uORB::SubscriptionData<sensor_preflight_mag_s> sensor_preflight_mag_sub{ORB_ID(sensor_preflight_mag)};
+	uORB::SubscriptionData<sensors_status_imu_s> sensors_status_imu_sub{ORB_ID(sensors_status_imu)};
+	uORB::SubscriptionData<system_power_s> system_power_sub{ORB_ID(system_power)};
+
+private:
+	PreFlightCheckContext() = default;
+	~PreFlightCheckContext() = default;
+
+	void updateParams();
+
+	static PreFlightCheckContext *_instance;
+	static pthread_mutex_t _mutex;
+
+	uORB::Subscription _parameter_update_sub{ORB_ID(parameter_update)};
+
+	struct ParamHandles {
+		param_t sys_has_mag{PARAM_INVALID};
+		param_t sys_has_baro{PARAM_INVALID};
+		param_t sys_mc_est_group{PARAM_INVALID};
+		param_t fw_arsp_mode{PARAM_INVALID};
+		param_t fw_airspd_trim{PARAM_INVALID};
+		param_t com_arm_arsp_en{PARAM_INVALID};
+		param_t com_arm_mag_str{PARAM_INVALID};
+		param_t com_arm_ekf_hgt{PARAM_INVALID};
+		param_t com_arm_ekf_vel{PARAM_INVALID};
+		param_t com_arm_ekf_pos{PARAM_INVALID};
+		param_t com_arm_ekf_yaw{PARAM_INVALID};
+		param_t com_arm_wo_gps{PARAM_INVALID};
+		param_t com_arm_imu_acc{PARAM_INVALID};
+		param_t com_arm_imu_gyr{PARAM_INVALID};
+		param_t com_arm_mag_ang{PARAM_INVALID};
+		param_t com_cpu_max{PARAM_INVALID};
+		param_t com_power_count{PARAM_INVALID};
+		param_t com_arm_sdcard{PARAM_INVALID};
+	} _param_handles;
+
+	uint32_t _param_generation{0};
+
+	struct CalibrationCache {
+		uint32_t device_id{0};
+		uint32_t param_generation{0};
+		bool valid{false};
+	} _calibration[SENSOR_TYPE_COUNT][MAX_SENSOR_COUNT] {};
+
+	CheckCache _cache[static_cast<uint8_t>(Check::Count)] {};
+};
@@ -32,12 +32,12 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <HealthFlags.h>
 #include <math.h>
 #include <px4_defines.h>
-#include <lib/sensor_calibration/Utilities.hpp>
 #include <lib/systemlib/mavlink_log.h>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/sensor_accel.h>
@@ -47,13 +47,16 @@ using namespace time_literals;
 bool PreFlightCheck::accelerometerCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status, const uint8_t instance,
 					const bool optional, int32_t &device_id, const bool report_fail)
 {
-	const bool exists = (orb_exists(ORB_ID(sensor_accel), instance) == PX4_OK);
+	PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	uORB::SubscriptionData<sensor_accel_s> &accel = ctx.sensor_accel[instance];
+
+	const bool exists = accel.advertised();
 	bool calibration_valid = false;
 	bool valid = true;
 
 	if (exists) {
 
-		uORB::SubscriptionData<sensor_accel_s> accel{ORB_ID(sensor_accel), instance};
+		accel.update();
 
 		valid = (accel.get().device_id != 0) && (accel.get().timestamp != 0);
 
@@ -69,7 +72,7 @@ bool PreFlightCheck::accelerometerCheck(orb_advert_t *mavlink_log_pub, vehicle_s
 			calibration_valid = true;
 
 		} else {
-			calibration_valid = (calibration::FindCalibrationIndex("ACC", device_id) >= 0);
+			calibration_valid = (ctx.calibrationValid(PreFlightCheckContext::SENSOR_ACCEL, instance, device_id));
 		}
 
 		if (!calibration_valid) {
@@ -32,13 +32,12 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <HealthFlags.h>
 #include <drivers/drv_hrt.h>
 #include <math.h>
 #include <systemlib/mavlink_log.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/airspeed_validated.h>
 
 using namespace time_literals;
 
@@ -48,9 +47,7 @@ bool PreFlightCheck::airspeedCheck(orb_advert_t *mavlink_log_pub, vehicle_status
 	bool present = true;
 	bool success = true;
 
-	uORB::SubscriptionData<airspeed_validated_s> airspeed_validated_sub{ORB_ID(airspeed_validated)};
-	airspeed_validated_sub.update();
-	const airspeed_validated_s &airspeed_validated = airspeed_validated_sub.get();
+	const airspeed_validated_s &airspeed_validated = PreFlightCheckContext::get().airspeed_validated_sub.get();
 
 	/*
 	 * Check if Airspeed Selector is up and running.
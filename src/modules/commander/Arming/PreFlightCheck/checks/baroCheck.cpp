@@ -32,6 +32,7 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <HealthFlags.h>
@@ -45,11 +46,13 @@ using namespace time_literals;
 bool PreFlightCheck::baroCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status, const uint8_t instance,
 			       const bool optional, int32_t &device_id, const bool report_fail)
 {
-	const bool exists = (orb_exists(ORB_ID(sensor_baro), instance) == PX4_OK);
+	uORB::SubscriptionData<sensor_baro_s> &baro = PreFlightCheckContext::get().sensor_baro[instance];
+
+	const bool exists = baro.advertised();
 	bool valid = false;
 
 	if (exists) {
-		uORB::SubscriptionData<sensor_baro_s> baro{ORB_ID(sensor_baro), instance};
+		baro.update();
 
 		valid = (baro.get().device_id != 0) && (baro.get().timestamp != 0);
 
@@ -32,12 +32,10 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <systemlib/mavlink_log.h>
-#include <lib/parameters/param.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/cpuload.h>
 
 using namespace time_literals;
 
@@ -45,15 +43,14 @@ bool PreFlightCheck::cpuResourceCheck(orb_advert_t *mavlink_log_pub, const bool
 {
 	bool success = true;
 
-	uORB::SubscriptionData<cpuload_s> cpuload_sub{ORB_ID(cpuload)};
-	cpuload_sub.update();
+	const PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	const cpuload_s &cpuload = ctx.cpuload_sub.get();
 
-	float cpuload_percent_max;
-	param_get(param_find("COM_CPU_MAX"), &cpuload_percent_max);
+	const float cpuload_percent_max = ctx.params.com_cpu_max;
 
 	if (cpuload_percent_max > 0.f) {
 
-		if (hrt_elapsed_time(&cpuload_sub.get().timestamp) > 2_s) {
+		if (hrt_elapsed_time(&cpuload.timestamp) > 2_s) {
 			success = false;
 
 			if (report_fail) {
@@ -61,7 +58,7 @@ bool PreFlightCheck::cpuResourceCheck(orb_advert_t *mavlink_log_pub, const bool
 			}
 		}
 
-		const float cpuload_percent = cpuload_sub.get().load * 100.f;
+		const float cpuload_percent = cpuload.load * 100.f;
 
 		if (cpuload_percent > cpuload_percent_max) {
 			success = false;
@@ -32,15 +32,11 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <HealthFlags.h>
 #include <math.h>
-#include <lib/parameters/param.h>
 #include <systemlib/mavlink_log.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/estimator_selector_status.h>
-#include <uORB/topics/estimator_sensor_bias.h>
-#include <uORB/topics/estimator_status.h>
 
 using namespace time_literals;
 
@@ -49,31 +45,20 @@ bool PreFlightCheck::ekf2Check(orb_advert_t *mavlink_log_pub, vehicle_status_s &
 {
 	bool success = true; // start with a pass and change to a fail if any test fails
 
-	int32_t mag_strength_check_enabled = 1;
-	param_get(param_find("COM_ARM_MAG_STR"), &mag_strength_check_enabled);
+	const PreFlightCheckContext &ctx = PreFlightCheckContext::get();
 
-	float hgt_test_ratio_limit = 1.f;
-	param_get(param_find("COM_ARM_EKF_HGT"), &hgt_test_ratio_limit);
-
-	float vel_test_ratio_limit = 1.f;
-	param_get(param_find("COM_ARM_EKF_VEL"), &vel_test_ratio_limit);
-
-	float pos_test_ratio_limit = 1.f;
-	param_get(param_find("COM_ARM_EKF_POS"), &pos_test_ratio_limit);
-
-	float mag_test_ratio_limit = 1.f;
-	param_get(param_find("COM_ARM_EKF_YAW"), &mag_test_ratio_limit);
-
-	int32_t arm_without_gps = 0;
-	param_get(param_find("COM_ARM_WO_GPS"), &arm_without_gps);
+	const int32_t mag_strength_check_enabled = ctx.params.com_arm_mag_str;
+	const float hgt_test_ratio_limit = ctx.params.com_arm_ekf_hgt;
+	const float vel_test_ratio_limit = ctx.params.com_arm_ekf_vel;
+	const float pos_test_ratio_limit = ctx.params.com_arm_ekf_pos;
+	const float mag_test_ratio_limit = ctx.params.com_arm_ekf_yaw;
+	const int32_t arm_without_gps = ctx.params.com_arm_wo_gps;
 
 	bool gps_success = true;
 	bool gps_present = true;
 
-	// Get estimator status data if available and exit with a fail recorded if not
-	uORB::SubscriptionData<estimator_selector_status_s> estimator_selector_status_sub{ORB_ID(estimator_selector_status)};
-	uORB::SubscriptionData<estimator_status_s> status_sub{ORB_ID(estimator_status), estimator_selector_status_sub.get().primary_instance};
-	const estimator_status_s &status = status_sub.get();
+	// Get estimator status data (of the primary instance) if available and exit with a fail recorded if not
+	const estimator_status_s &status = ctx.estimator_status_sub.get();
 
 	if (status.timestamp == 0) {
 		success = false;
@@ -233,10 +218,8 @@ out:
 
 bool PreFlightCheck::ekf2CheckSensorBias(orb_advert_t *mavlink_log_pub, const bool report_fail)
 {
-	// Get estimator states data if available and exit with a fail recorded if not
-	uORB::SubscriptionData<estimator_selector_status_s> estimator_selector_status_sub{ORB_ID(estimator_selector_status)};
-	uORB::SubscriptionData<estimator_sensor_bias_s> estimator_sensor_bias_sub{ORB_ID(estimator_sensor_bias), estimator_selector_status_sub.get().primary_instance};
-	const estimator_sensor_bias_s &bias = estimator_sensor_bias_sub.get();
+	// Get estimator states data (of the primary instance) if available and exit with a fail recorded if not
+	const estimator_sensor_bias_s &bias = PreFlightCheckContext::get().estimator_sensor_bias_sub.get();
 
 	if (hrt_elapsed_time(&bias.timestamp) < 30_s) {
 
@@ -32,11 +32,11 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <HealthFlags.h>
 #include <px4_defines.h>
-#include <lib/sensor_calibration/Utilities.hpp>
 #include <lib/systemlib/mavlink_log.h>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/sensor_gyro.h>
@@ -46,13 +46,16 @@ using namespace time_literals;
 bool PreFlightCheck::gyroCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status, const uint8_t instance,
 			       const bool optional, int32_t &device_id, const bool report_fail)
 {
-	const bool exists = (orb_exists(ORB_ID(sensor_gyro), instance) == PX4_OK);
+	PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	uORB::SubscriptionData<sensor_gyro_s> &gyro = ctx.sensor_gyro[instance];
+
+	const bool exists = gyro.advertised();
 	bool calibration_valid = false;
 	bool valid = false;
 
 	if (exists) {
 
-		uORB::SubscriptionData<sensor_gyro_s> gyro{ORB_ID(sensor_gyro), instance};
+		gyro.update();
 
 		valid = (gyro.get().device_id != 0) && (gyro.get().timestamp != 0);
 
@@ -68,7 +71,7 @@ bool PreFlightCheck::gyroCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &
 			calibration_valid = true;
 
 		} else {
-			calibration_valid = (calibration::FindCalibrationIndex("GYRO", device_id) >= 0);
+			calibration_valid = (ctx.calibrationValid(PreFlightCheckContext::SENSOR_GYRO, instance, device_id));
 		}
 
 		if (!calibration_valid) {
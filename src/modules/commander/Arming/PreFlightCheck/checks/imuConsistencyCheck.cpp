@@ -32,26 +32,22 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <HealthFlags.h>
 
-#include <lib/parameters/param.h>
 #include <systemlib/mavlink_log.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/sensors_status_imu.h>
 
 bool PreFlightCheck::imuConsistencyCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status,
 		const bool report_status)
 {
-	float accel_test_limit = 1.f;
-	param_get(param_find("COM_ARM_IMU_ACC"), &accel_test_limit);
+	const PreFlightCheckContext &ctx = PreFlightCheckContext::get();
 
-	float gyro_test_limit = 1.f;
-	param_get(param_find("COM_ARM_IMU_GYR"), &gyro_test_limit);
+	const float accel_test_limit = ctx.params.com_arm_imu_acc;
+	const float gyro_test_limit = ctx.params.com_arm_imu_gyr;
 
 	// Get sensor_preflight data if available and exit with a fail recorded if not
-	uORB::SubscriptionData<sensors_status_imu_s> sensors_status_imu_sub{ORB_ID(sensors_status_imu)};
-	const sensors_status_imu_s &imu = sensors_status_imu_sub.get();
+	const sensors_status_imu_s &imu = ctx.sensors_status_imu_sub.get();
 
 	// Use the difference between IMU's to detect a bad calibration.
 	// If a single IMU is fitted, the value being checked will be zero so this check will always pass.
@@ -32,14 +32,12 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <HealthFlags.h>
 
-#include <lib/parameters/param.h>
 #include <mathlib/mathlib.h>
 #include <systemlib/mavlink_log.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/sensor_preflight_mag.h>
 
 // return false if the magnetomer measurements are inconsistent
 bool PreFlightCheck::magConsistencyCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status,
@@ -48,9 +46,8 @@ bool PreFlightCheck::magConsistencyCheck(orb_advert_t *mavlink_log_pub, vehicle_
 	bool pass = false; // flag for result of checks
 
 	// get the sensor preflight data
-	uORB::SubscriptionData<sensor_preflight_mag_s> sensors_sub{ORB_ID(sensor_preflight_mag)};
-	sensors_sub.update();
-	const sensor_preflight_mag_s &sensors = sensors_sub.get();
+	const PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	const sensor_preflight_mag_s &sensors = ctx.sensor_preflight_mag_sub.get();
 
 	if (sensors.timestamp == 0) {
 		// can happen if not advertised (yet)
@@ -59,8 +56,7 @@ bool PreFlightCheck::magConsistencyCheck(orb_advert_t *mavlink_log_pub, vehicle_
 
 	// Use the difference between sensors to detect a bad calibration, orientation or magnetic interference.
 	// If a single sensor is fitted, the value being checked will be zero so this check will always pass.
-	int32_t angle_difference_limit_deg = 90;
-	param_get(param_find("COM_ARM_MAG_ANG"), &angle_difference_limit_deg);
+	const int32_t angle_difference_limit_deg = ctx.params.com_arm_mag_ang;
 
 	pass = pass || angle_difference_limit_deg < 0; // disabled, pass check
 	pass = pass || sensors.mag_inconsistency_angle < math::radians<float>(angle_difference_limit_deg);
@@ -32,14 +32,13 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <HealthFlags.h>
 #include <px4_defines.h>
-#include <lib/sensor_calibration/Utilities.hpp>
 #include <lib/systemlib/mavlink_log.h>
 #include <uORB/Subscription.hpp>
-#include <uORB/topics/estimator_status.h>
 #include <uORB/topics/sensor_mag.h>
 
 using namespace time_literals;
@@ -47,14 +46,17 @@ using namespace time_literals;
 bool PreFlightCheck::magnetometerCheck(orb_advert_t *mavlink_log_pub, vehicle_status_s &status, const uint8_t instance,
 				       const bool optional, int32_t &device_id, const bool report_fail)
 {
-	const bool exists = (orb_exists(ORB_ID(sensor_mag), instance) == PX4_OK);
+	PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	uORB::SubscriptionData<sensor_mag_s> &magnetometer = ctx.sensor_mag[instance];
+
+	const bool exists = magnetometer.advertised();
 	bool calibration_valid = false;
 	bool valid = false;
 	bool is_mag_fault = false;
 
 	if (exists) {
 
-		uORB::SubscriptionData<sensor_mag_s> magnetometer{ORB_ID(sensor_mag), instance};
+		magnetometer.update();
 
 		valid = (magnetometer.get().device_id != 0) && (magnetometer.get().timestamp != 0);
 
@@ -70,7 +72,7 @@ bool PreFlightCheck::magnetometerCheck(orb_advert_t *mavlink_log_pub, vehicle_st
 			calibration_valid = true;
 
 		} else {
-			calibration_valid = (calibration::FindCalibrationIndex("MAG", device_id) >= 0);
+			calibration_valid = (ctx.calibrationValid(PreFlightCheckContext::SENSOR_MAG, instance, device_id));
 		}
 
 		if (!calibration_valid) {
@@ -79,11 +81,9 @@ bool PreFlightCheck::magnetometerCheck(orb_advert_t *mavlink_log_pub, vehicle_st
 			}
 		}
 
-		for (uint8_t i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
-			uORB::SubscriptionData<estimator_status_s> estimator_status_sub{ORB_ID(estimator_status), i};
-
-			if (estimator_status_sub.get().mag_device_id == static_cast<uint32_t>(device_id)) {
-				if (estimator_status_sub.get().control_mode_flags & (1 << estimator_status_s::CS_MAG_FAULT)) {
+		for (const auto &estimator_mag_status : ctx.estimator_mag_status) {
+			if (estimator_mag_status.mag_device_id == static_cast<uint32_t>(device_id)) {
+				if (estimator_mag_status.mag_fault) {
 					is_mag_fault = true;
 					break;
 				}
@@ -32,10 +32,9 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <systemlib/mavlink_log.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/manual_control_switches.h>
 
 using namespace time_literals;
 
@@ -43,8 +42,8 @@ bool PreFlightCheck::manualControlCheck(orb_advert_t *mavlink_log_pub, const boo
 {
 	bool success = true;
 
-	uORB::SubscriptionData<manual_control_switches_s> manual_control_switches_sub{ORB_ID(manual_control_switches)};
-	const manual_control_switches_s &manual_control_switches = manual_control_switches_sub.get();
+	const manual_control_switches_s &manual_control_switches =
+		PreFlightCheckContext::get().manual_control_switches_sub.get();
 
 	if (manual_control_switches.timestamp != 0) {
 
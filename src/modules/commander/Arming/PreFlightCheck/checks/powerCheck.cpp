@@ -32,12 +32,10 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
+#include "../PreFlightCheckContext.hpp"
 
 #include <drivers/drv_hrt.h>
 #include <systemlib/mavlink_log.h>
-#include <lib/parameters/param.h>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/system_power.h>
 
 using namespace time_literals;
 
@@ -68,13 +66,11 @@ bool PreFlightCheck::powerCheck(orb_advert_t *mavlink_log_pub, const vehicle_sta
 		return true;
 	}
 
-	uORB::SubscriptionData<system_power_s> system_power_sub{ORB_ID(system_power)};
-	system_power_sub.update();
-	const system_power_s &system_power = system_power_sub.get();
+	const PreFlightCheckContext &ctx = PreFlightCheckContext::get();
+	const system_power_s &system_power = ctx.system_power_sub.get();
 
 	if (system_power.timestamp != 0) {
-		int32_t required_power_module_count = 0;
-		param_get(param_find("COM_POWER_COUNT"), &required_power_module_count);
+		const int32_t required_power_module_count = ctx.params.com_power_count;
 
 		// Check avionics rail voltages (if USB isn't connected)
 		if (!system_power.usb_connected) {
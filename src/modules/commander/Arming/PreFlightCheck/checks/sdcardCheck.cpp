@@ -32,7 +32,7 @@
  ****************************************************************************/
 
 #include "../PreFlightCheck.hpp"
-#include <lib/parameters/param.h>
+#include "../PreFlightCheckContext.hpp"
 #include <systemlib/mavlink_log.h>
 
 #ifdef __PX4_DARWIN
@@ -47,8 +47,7 @@ bool PreFlightCheck::sdcardCheck(orb_advert_t *mavlink_log_pub, bool &sd_card_de
 {
 	bool success = true;
 
-	int32_t param_com_arm_sdcard{0};
-	param_get(param_find("COM_ARM_SDCARD"), &param_com_arm_sdcard);
+	const int32_t param_com_arm_sdcard = PreFlightCheckContext::get().params.com_arm_sdcard;
 
 	if (param_com_arm_sdcard > 0) {
 		struct statfs statfs_buf;
@@ -414,6 +414,13 @@ int Commander::print_status()
 {
 	PX4_INFO("arming: %s", arming_state_names[_status.arming_state]);
 	PX4_INFO("navigation: %s", nav_state_names[_status.nav_state]);
+
+	if (_battery_aggregator.connected() > 0) {
+		PX4_INFO("batteries: %d connected, %.2f remaining, %.1f A, %.0f s flight time left",
+			 _battery_aggregator.connected(), (double)_battery_aggregator.remaining(),
+			 (double)_battery_aggregator.current(), (double)_battery_aggregator.flightTimeRemaining());
+	}
+
 	return 0;
 }
 
@@ -3631,47 +3638,36 @@ void Commander::battery_status_check()
 		return;
 	}
 
-	battery_status_s batteries[_battery_status_subs.size()];
-	size_t num_connected_batteries = 0;
+	int instance = 0;
 
 	for (auto &battery_sub : _battery_status_subs) {
-		if (battery_sub.copy(&batteries[num_connected_batteries])) {
-			if (batteries[num_connected_batteries].connected) {
-				num_connected_batteries++;
-			}
+		battery_status_s battery;
+
+		if (battery_sub.copy(&battery)) {
+			_battery_aggregator.update(instance, battery);
+
+		} else {
+			_battery_aggregator.clear(instance);
 		}
+
+		instance++;
 	}
 
 	// There are possibly multiple batteries, and we can't know which ones serve which purpose. So the safest
 	// option is to check if ANY of them have a warning, and specifically find which one has the most
-	// urgent warning.
-	uint8_t worst_warning = battery_status_s::BATTERY_WARNING_NONE;
-	// To make sure that all connected batteries are being regularly reported, we check which one has the
-	// oldest timestamp.
-	hrt_abstime oldest_update = hrt_absolute_time();
+	// urgent warning. To make sure that all connected batteries are being regularly reported, we check which
+	// one has the oldest timestamp. Disconnected batteries are not expected to publish regularly.
+	_battery_aggregator.aggregate(hrt_absolute_time());
 
-	_battery_current = 0.0f;
-	float battery_level = 0.0f;
+	const size_t num_connected_batteries = _battery_aggregator.connected();
+	const hrt_abstime oldest_update = _battery_aggregator.oldestTimestamp();
+	uint8_t worst_warning = _battery_aggregator.warning();
 
+	// Sum up current from all batteries.
+	_battery_current = _battery_aggregator.current();
 
-	// Only iterate over connected batteries. We don't care if a disconnected battery is not regularly publishing.
-	for (size_t i = 0; i < num_connected_batteries; i++) {
-		if (batteries[i].warning > worst_warning) {
-			worst_warning = batteries[i].warning;
-		}
-
-		if (hrt_elapsed_time(&batteries[i].timestamp) > hrt_elapsed_time(&oldest_update)) {
-			oldest_update = batteries[i].timestamp;
-		}
-
-		// Sum up current from all batteries.
-		_battery_current += batteries[i].current_filtered_a;
-
-		// average levels from all batteries
-		battery_level += batteries[i].remaining;
-	}
-
-	battery_level /= num_connected_batteries;
+	// level of all batteries, weighted by their capacity if known
+	const float battery_level = _battery_aggregator.remaining();
 
 	_rtl_flight_time_sub.update();
 	float battery_usage_to_home = 0;
@@ -0,0 +1,588 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file FwBatchEval.cpp
+ */
+
+#include "FwBatchEval.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <drivers/drv_hrt.h>
+#include <lib/ecl/geo/geo.h>
+#include <px4_platform_common/defines.h>
+
+/*
+ * TECS takes its time steps from hrt_absolute_time(). The evaluator is not linked against
+ * the platform layer and provides the clock itself: every worker thread steps its
+ * instances in lockstep and advances its own simulated time.
+ */
+static thread_local hrt_abstime sim_time{0};
+
+hrt_abstime hrt_absolute_time()
+{
+	return sim_time;
+}
+
+namespace fw_batch_eval
+{
+
+using namespace time_literals;
+using math::constrain;
+using math::radians;
+using matrix::Vector2d;
+using matrix::Vector2f;
+
+namespace
+{
+
+struct ParameterName {
+	const char *name;
+	float ControllerParameters::*member;
+};
+
+constexpr ParameterName parameter_names[] {
+	{"FW_AIRSPD_MIN", &ControllerParameters::fw_airspd_min},
+	{"FW_AIRSPD_MAX", &ControllerParameters::fw_airspd_max},
+	{"FW_AIRSPD_TRIM", &ControllerParameters::fw_airspd_trim},
+	{"FW_L1_PERIOD", &ControllerParameters::fw_l1_period},
+	{"FW_L1_DAMPING", &ControllerParameters::fw_l1_damping},
+	{"FW_L1_R_SLEW_MAX", &ControllerParameters::fw_l1_r_slew_max},
+	{"FW_R_LIM", &ControllerParameters::fw_r_lim},
+	{"FW_P_LIM_MIN", &ControllerParameters::fw_p_lim_min},
+	{"FW_P_LIM_MAX", &ControllerParameters::fw_p_lim_max},
+	{"FW_THR_MIN", &ControllerParameters::fw_thr_min},
+	{"FW_THR_MAX", &ControllerParameters::fw_thr_max},
+	{"FW_THR_CRUISE", &ControllerParameters::fw_thr_cruise},
+	{"FW_THR_SLEW_MAX", &ControllerParameters::fw_thr_slew_max},
+	{"FW_T_CLMB_MAX", &ControllerParameters::fw_t_clmb_max},
+	{"FW_T_SINK_MIN", &ControllerParameters::fw_t_sink_min},
+	{"FW_T_SINK_MAX", &ControllerParameters::fw_t_sink_max},
+	{"FW_T_THR_DAMP", &ControllerParameters::fw_t_thr_damp},
+	{"FW_T_I_GAIN_THR", &ControllerParameters::fw_t_i_gain_thr},
+	{"FW_T_I_GAIN_PIT", &ControllerParameters::fw_t_i_gain_pit},
+	{"FW_T_VERT_ACC", &ControllerParameters::fw_t_vert_acc},
+	{"FW_T_SPD_OMEGA", &ControllerParameters::fw_t_spd_omega},
+	{"FW_T_RLL2THR", &ControllerParameters::fw_t_rll2thr},
+	{"FW_T_SPDWEIGHT", &ControllerParameters::fw_t_spdweight},
+	{"FW_T_PTCH_DAMP", &ControllerParameters::fw_t_ptch_damp},
+	{"FW_T_ALT_TC", &ControllerParameters::fw_t_alt_tc},
+	{"FW_T_HRATE_FF", &ControllerParameters::fw_t_hrate_ff},
+	{"FW_T_TAS_TC", &ControllerParameters::fw_t_tas_tc},
+	{"FW_T_STE_R_TC", &ControllerParameters::fw_t_ste_r_tc},
+	{"FW_T_TAS_R_TC", &ControllerParameters::fw_t_tas_r_tc},
+	{"FW_T_SEB_R_FF", &ControllerParameters::fw_t_seb_r_ff},
+};
+
+constexpr size_t parameter_count = sizeof(parameter_names) / sizeof(parameter_names[0]);
+
+constexpr float MAX_ROLL = radians(80.f);
+constexpr float MIN_AIRSPEED = 1.f;	///< [m/s] lower bound of the plant airspeed, keeps the turn rate finite
+
+// all scenarios are flown around the SITL default home position
+constexpr double REFERENCE_LAT = 47.397742;
+constexpr double REFERENCE_LON = 8.545594;
+
+const map_projection_reference_s &reference()
+{
+	static const map_projection_reference_s ref = [] {
+		map_projection_reference_s r{};
+		map_projection_init(&r, REFERENCE_LAT, REFERENCE_LON);
+		return r;
+	}();
+
+	return ref;
+}
+
+TraceSample sample(float time, float altitude_sp, float airspeed_sp, float prev_north, float prev_east,
+		   float curr_north, float curr_east, float wind_north = 0.f, float wind_east = 0.f)
+{
+	TraceSample s{};
+	s.time = time;
+	s.altitude_sp = altitude_sp;
+	s.airspeed_sp = airspeed_sp;
+	s.prev_wp[0] = prev_north;
+	s.prev_wp[1] = prev_east;
+	s.curr_wp[0] = curr_north;
+	s.curr_wp[1] = curr_east;
+	s.wind[0] = wind_north;
+	s.wind[1] = wind_east;
+	return s;
+}
+
+} // namespace
+
+bool ControllerParameters::set(const char *name, float value)
+{
+	for (const ParameterName &p : parameter_names) {
+		if (strcmp(p.name, name) == 0) {
+			this->*p.member = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const char *ControllerParameters::name(size_t i)
+{
+	return (i < parameter_count) ? parameter_names[i].name : nullptr;
+}
+
+float ControllerParameters::get(size_t i) const
+{
+	return (i < parameter_count) ? this->*parameter_names[i].member : NAN;
+}
+
+void Scenario::finalize()
+{
+	std::stable_sort(trace.begin(), trace.end(), [](const TraceSample & a, const TraceSample & b) {
+		return a.time < b.time;
+	});
+
+	if (!trace.empty()) {
+		duration = std::max(duration, trace.back().time);
+	}
+
+	prev_wp_global.resize(2 * trace.size());
+	curr_wp_global.resize(2 * trace.size());
+
+	for (size_t k = 0; k < trace.size(); k++) {
+		map_projection_reproject(&reference(), trace[k].prev_wp[0], trace[k].prev_wp[1],
+					 &prev_wp_global[2 * k], &prev_wp_global[2 * k + 1]);
+		map_projection_reproject(&reference(), trace[k].curr_wp[0], trace[k].curr_wp[1],
+					 &curr_wp_global[2 * k], &curr_wp_global[2 * k + 1]);
+	}
+}
+
+bool Scenario::loadCsv(const char *file_name)
+{
+	FILE *f = fopen(file_name, "r");
+
+	if (f == nullptr) {
+		return false;
+	}
+
+	const char *base_name = strrchr(file_name, '/');
+	name = base_name ? base_name + 1 : file_name;
+	trace.clear();
+
+	char line[512];
+	bool ok = true;
+
+	while (fgets(line, sizeof(line), f)) {
+		// skip the header, comments and empty lines
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || isalpha(static_cast<unsigned char>(line[0]))) {
+			continue;
+		}
+
+		TraceSample s{};
+		const int n = sscanf(line, "%f,%f,%f,%f,%f,%f,%f,%f,%f", &s.time, &s.altitude_sp, &s.airspeed_sp,
+				     &s.prev_wp[0], &s.prev_wp[1], &s.curr_wp[0], &s.curr_wp[1], &s.wind[0], &s.wind[1]);
+
+		if (n != 7 && n != 9) {
+			ok = false;
+			break;
+		}
+
+		trace.push_back(s);
+	}
+
+	fclose(f);
+
+	if (!ok || trace.empty()) {
+		return false;
+	}
+
+	finalize();
+	return true;
+}
+
+std::vector<Scenario> Scenario::synthetic(const ControllerParameters &defaults)
+{
+	const float alt = 100.f;
+	const float trim = defaults.fw_airspd_trim;
+	std::vector<Scenario> scenarios;
+
+	// straight leg with altitude steps up and down
+	Scenario s;
+	s.name = "altitude_step";
+	s.duration = 100.f;
+	s.trace = {
+		sample(0.f, alt, trim, 0.f, 0.f, 5000.f, 0.f),
+		sample(20.f, alt + 30.f, trim, 0.f, 0.f, 5000.f, 0.f),
+		sample(60.f, alt - 10.f, trim, 0.f, 0.f, 5000.f, 0.f),
+	};
+	scenarios.push_back(s);
+
+	// straight leg with airspeed steps towards both limits
+	s.name = "airspeed_step";
+	s.duration = 110.f;
+	s.trace = {
+		sample(0.f, alt, trim, 0.f, 0.f, 5000.f, 0.f),
+		sample(20.f, alt, defaults.fw_airspd_max - 2.f, 0.f, 0.f, 5000.f, 0.f),
+		sample(50.f, alt, defaults.fw_airspd_min + 2.f, 0.f, 0.f, 5000.f, 0.f),
+		sample(80.f, alt, trim, 0.f, 0.f, 5000.f, 0.f),
+	};
+	scenarios.push_back(s);
+
+	// straight leg in crosswind, followed by a wind shift
+	s.name = "crosswind";
+	s.duration = 90.f;
+	s.trace = {
+		sample(0.f, alt, trim, 0.f, 0.f, 0.f, 5000.f, 8.f, 0.f),
+		sample(40.f, alt, trim, 0.f, 0.f, 0.f, 5000.f, -6.f, 3.f),
+	};
+	scenarios.push_back(s);
+
+	// box pattern in light wind with a climb on the third leg, legs are switched on time
+	const float side = 800.f;
+	const float leg_time = side / trim;
+	const float corners[5][2] {{0.f, 0.f}, {side, 0.f}, {side, side}, {0.f, side}, {0.f, 0.f}};
+
+	s.name = "box";
+	s.duration = 4.f * leg_time;
+	s.trace.clear();
+
+	for (int leg = 0; leg < 4; leg++) {
+		s.trace.push_back(sample(leg * leg_time, (leg >= 2) ? alt + 20.f : alt, trim,
+					 corners[leg][0], corners[leg][1], corners[leg + 1][0], corners[leg + 1][1], 0.f, 3.f));
+	}
+
+	scenarios.push_back(s);
+
+	for (Scenario &scenario : scenarios) {
+		scenario.finalize();
+	}
+
+	return scenarios;
+}
+
+void BatchEvaluator::States::resize(size_t n)
+{
+	for (std::vector<float> *v : {&north, &east, &altitude, &airspeed, &airspeed_rate, &heading, &flight_path_angle,
+				      &pitch, &roll, &wind_north, &wind_east, &pitch_sp, &roll_sp, &throttle
+				     }) {
+		v->assign(n, 0.f);
+	}
+
+	trace_index.assign(n, 0);
+}
+
+void BatchEvaluator::Accumulators::resize(size_t n)
+{
+	for (std::vector<double> *v : {&altitude_sq, &airspeed_sq, &crosstrack_sq, &throttle}) {
+		v->assign(n, 0.);
+	}
+
+	for (std::vector<float> *v : {&altitude_max, &airspeed_max, &crosstrack_max}) {
+		v->assign(n, 0.f);
+	}
+
+	airspeed_min.assign(n, INFINITY);
+	samples.assign(n, 0);
+	saturated.assign(n, 0);
+	diverged.assign(n, 0);
+}
+
+BatchEvaluator::BatchEvaluator(std::vector<ControllerParameters> parameter_sets, std::vector<Scenario> scenarios,
+			       const PlantParameters &plant) :
+	_parameter_sets(std::move(parameter_sets)),
+	_scenarios(std::move(scenarios)),
+	_plant(plant)
+{
+	// drag at trim airspeed from the idle sink rate, split evenly between parasitic and induced drag
+	const float drag_trim = _plant.sink_rate_min * CONSTANTS_ONE_G / _plant.airspeed_trim;
+	_drag_parasitic = 0.5f * drag_trim;
+	_drag_induced = 0.5f * drag_trim;
+
+	// linear thrust above idle, giving level flight at trim throttle and the max climb rate at full throttle
+	const float thrust_max = (_plant.climb_rate_max + _plant.sink_rate_min) * CONSTANTS_ONE_G / _plant.airspeed_trim;
+	_throttle_idle = math::max(((_plant.climb_rate_max + _plant.sink_rate_min) * _plant.throttle_trim
+				    - _plant.sink_rate_min) / _plant.climb_rate_max, 0.f);
+	_thrust_gain = thrust_max / (1.f - _throttle_idle);
+}
+
+void BatchEvaluator::initialize(size_t i)
+{
+	const ControllerParameters &p = _parameter_sets[parameterSetOf(i)];
+	const TraceSample &start = _scenarios[scenarioOf(i)].trace.front();
+
+	// same mapping as FixedwingPositionControl::parameters_update()
+	ECL_L1_Pos_Controller &l1 = _l1[i];
+	l1.set_l1_damping(p.fw_l1_damping);
+	l1.set_l1_period(p.fw_l1_period);
+	l1.set_l1_roll_limit(radians(p.fw_r_lim));
+	l1.set_roll_slew_rate(radians(p.fw_l1_r_slew_max));
+	l1.set_dt(_dt);
+
+	TECS &tecs = _tecs[i];
+	tecs.set_max_climb_rate(p.fw_t_clmb_max);
+	tecs.set_max_sink_rate(p.fw_t_sink_max);
+	tecs.set_speed_weight(p.fw_t_spdweight);
+	tecs.set_equivalent_airspeed_cruise(p.fw_airspd_trim);
+	tecs.set_equivalent_airspeed_min(p.fw_airspd_min);
+	tecs.set_equivalent_airspeed_max(p.fw_airspd_max);
+	tecs.set_min_sink_rate(p.fw_t_sink_min);
+	tecs.set_throttle_damp(p.fw_t_thr_damp);
+	tecs.set_integrator_gain_throttle(p.fw_t_i_gain_thr);
+	tecs.set_integrator_gain_pitch(p.fw_t_i_gain_pit);
+	tecs.set_throttle_slewrate(p.fw_thr_slew_max);
+	tecs.set_vertical_accel_limit(p.fw_t_vert_acc);
+	tecs.set_speed_comp_filter_omega(p.fw_t_spd_omega);
+	tecs.set_roll_throttle_compensation(p.fw_t_rll2thr);
+	tecs.set_pitch_damping(p.fw_t_ptch_damp);
+	tecs.set_height_error_time_constant(p.fw_t_alt_tc);
+	tecs.set_heightrate_ff(p.fw_t_hrate_ff);
+	tecs.set_airspeed_error_time_constant(p.fw_t_tas_tc);
+	tecs.set_ste_rate_time_const(p.fw_t_ste_r_tc);
+	tecs.set_speed_derivative_time_constant(p.fw_t_tas_r_tc);
+	tecs.set_seb_rate_ff_gain(p.fw_t_seb_r_ff);
+	tecs.enable_airspeed(true);
+	tecs.set_detect_underspeed_enabled(true);
+
+	// start trimmed on the first leg
+	_states.north[i] = start.prev_wp[0];
+	_states.east[i] = start.prev_wp[1];
+	_states.altitude[i] = start.altitude_sp;
+	_states.airspeed[i] = start.airspeed_sp;
+	_states.airspeed_rate[i] = 0.f;
+	_states.heading[i] = atan2f(start.curr_wp[1] - start.prev_wp[1], start.curr_wp[0] - start.prev_wp[0]);
+	_states.flight_path_angle[i] = 0.f;
+	_states.pitch[i] = 0.f;
+	_states.roll[i] = 0.f;
+	_states.pitch_sp[i] = 0.f;
+	_states.roll_sp[i] = 0.f;
+	_states.throttle[i] = p.fw_thr_cruise;
+	_states.trace_index[i] = 0;
+}
+
+void BatchEvaluator::control(size_t i, float t)
+{
+	const ControllerParameters &p = _parameter_sets[parameterSetOf(i)];
+	const Scenario &scenario = _scenarios[scenarioOf(i)];
+
+	uint32_t &k = _states.trace_index[i];
+
+	while (k + 1 < scenario.trace.size() && scenario.trace[k + 1].time <= t) {
+		k++;
+	}
+
+	const TraceSample &sp = scenario.trace[k];
+	_states.wind_north[i] = sp.wind[0];
+	_states.wind_east[i] = sp.wind[1];
+
+	const float airspeed = _states.airspeed[i];
+	const float heading = _states.heading[i];
+	const float gamma = _states.flight_path_angle[i];
+	const float horizontal_speed = airspeed * cosf(gamma);
+
+	double lat = 0.;
+	double lon = 0.;
+	map_projection_reproject(&reference(), _states.north[i], _states.east[i], &lat, &lon);
+
+	// lateral guidance
+	ECL_L1_Pos_Controller &l1 = _l1[i];
+	const Vector2f ground_speed{horizontal_speed *cosf(heading) + sp.wind[0], horizontal_speed *sinf(heading) + sp.wind[1]};
+	l1.navigate_waypoints(Vector2d{scenario.prev_wp_global[2 * k], scenario.prev_wp_global[2 * k + 1]},
+			      Vector2d{scenario.curr_wp_global[2 * k], scenario.curr_wp_global[2 * k + 1]},
+			      Vector2d{lat, lon}, ground_speed);
+	_states.roll_sp[i] = l1.get_roll_setpoint();
+
+	// longitudinal control
+	TECS &tecs = _tecs[i];
+	tecs.set_load_factor(1.f / cosf(_states.roll[i]));
+	tecs.update_vehicle_state_estimates(airspeed, _states.airspeed_rate[i], true, true, _states.altitude[i],
+					    -airspeed * sinf(gamma));
+	tecs.update_pitch_throttle(_states.pitch[i], _states.altitude[i], sp.altitude_sp, sp.airspeed_sp, airspeed, 1.f,
+				   false, radians(p.fw_p_lim_min), p.fw_thr_min, p.fw_thr_max, p.fw_thr_cruise,
+				   radians(p.fw_p_lim_min), radians(p.fw_p_lim_max));
+	_states.pitch_sp[i] = tecs.get_pitch_setpoint();
+	_states.throttle[i] = tecs.get_throttle_setpoint();
+
+	if (t < _warmup) {
+		return;
+	}
+
+	const float altitude_error = fabsf(sp.altitude_sp - _states.altitude[i]);
+	const float airspeed_error = fabsf(sp.airspeed_sp - airspeed);
+	const float crosstrack_error = fabsf(l1.crosstrack_error());
+	const float throttle = _states.throttle[i];
+
+	_acc.altitude_sq[i] += static_cast<double>(altitude_error * altitude_error);
+	_acc.airspeed_sq[i] += static_cast<double>(airspeed_error * airspeed_error);
+	_acc.crosstrack_sq[i] += static_cast<double>(crosstrack_error * crosstrack_error);
+	_acc.throttle[i] += static_cast<double>(throttle);
+	_acc.altitude_max[i] = math::max(_acc.altitude_max[i], altitude_error);
+	_acc.airspeed_max[i] = math::max(_acc.airspeed_max[i], airspeed_error);
+	_acc.crosstrack_max[i] = math::max(_acc.crosstrack_max[i], crosstrack_error);
+	_acc.airspeed_min[i] = math::min(_acc.airspeed_min[i], airspeed);
+	_acc.samples[i]++;
+
+	if (throttle >= p.fw_thr_max - 0.01f || throttle <= p.fw_thr_min + 0.01f) {
+		_acc.saturated[i]++;
+	}
+}
+
+void BatchEvaluator::runRange(size_t begin, size_t end)
+{
+	float duration = 0.f;
+
+	for (size_t i = begin; i < end; i++) {
+		initialize(i);
+		duration = math::max(duration, _scenarios[scenarioOf(i)].duration);
+	}
+
+	const float dt = _dt;
+	const hrt_abstime dt_us = static_cast<hrt_abstime>(dt * 1e6f);
+
+	// first-order responses of the attitude loops, discretized
+	const float alpha_roll = dt / (_plant.roll_time_constant + dt);
+	const float alpha_pitch = dt / (_plant.pitch_time_constant + dt);
+	const float alpha_gamma = dt / (_plant.flight_path_time_constant + dt);
+	const float airspeed_trim_inv = 1.f / _plant.airspeed_trim;
+
+	// TECS treats a zero timestamp as uninitialized
+	sim_time = 1_s;
+
+	for (uint32_t step = 0; step * dt <= duration; step++) {
+		const float t = step * dt;
+		sim_time += dt_us;
+
+		for (size_t i = begin; i < end; i++) {
+			if (!_acc.diverged[i] && t <= _scenarios[scenarioOf(i)].duration) {
+				control(i, t);
+			}
+		}
+
+		// point-mass plant in coordinated flight, stepped for all instances of the range
+		for (size_t i = begin; i < end; i++) {
+			if (_acc.diverged[i] || t > _scenarios[scenarioOf(i)].duration) {
+				continue;
+			}
+
+			const float roll = _states.roll[i] + alpha_roll * (constrain(_states.roll_sp[i], -MAX_ROLL, MAX_ROLL) - _states.roll[i]);
+			const float pitch = _states.pitch[i] + alpha_pitch * (_states.pitch_sp[i] - _states.pitch[i]);
+			const float gamma = _states.flight_path_angle[i] + alpha_gamma * (pitch - _states.flight_path_angle[i]);
+			const float airspeed = math::max(_states.airspeed[i], MIN_AIRSPEED);
+
+			const float speed_ratio_sq = airspeed * airspeed * airspeed_trim_inv * airspeed_trim_inv;
+			const float load_factor_sq = 1.f / (cosf(roll) * cosf(roll));
+			const float drag = _drag_parasitic * speed_ratio_sq + _drag_induced * load_factor_sq / speed_ratio_sq;
+			const float thrust = _thrust_gain * math::max(_states.throttle[i] - _throttle_idle, 0.f);
+			const float airspeed_rate = thrust - drag - CONSTANTS_ONE_G * sinf(gamma);
+
+			const float horizontal_speed = airspeed * cosf(gamma);
+			const float heading = matrix::wrap_pi(_states.heading[i] + CONSTANTS_ONE_G * tanf(roll) / airspeed * dt);
+
+			_states.north[i] += (horizontal_speed * cosf(heading) + _states.wind_north[i]) * dt;
+			_states.east[i] += (horizontal_speed * sinf(heading) + _states.wind_east[i]) * dt;
+			_states.altitude[i] += airspeed * sinf(gamma) * dt;
+			_states.airspeed[i] = math::max(airspeed + airspeed_rate * dt, MIN_AIRSPEED);
+			_states.airspeed_rate[i] = airspeed_rate;
+			_states.heading[i] = heading;
+			_states.flight_path_angle[i] = gamma;
+			_states.pitch[i] = pitch;
+			_states.roll[i] = roll;
+
+			if (!PX4_ISFINITE(_states.north[i]) || !PX4_ISFINITE(_states.east[i]) || !PX4_ISFINITE(_states.altitude[i])
+			    || !PX4_ISFINITE(_states.airspeed[i]) || !PX4_ISFINITE(_states.pitch_sp[i]) || !PX4_ISFINITE(_states.throttle[i])) {
+				_acc.diverged[i] = 1;
+			}
+		}
+	}
+}
+
+void BatchEvaluator::run(unsigned threads)
+{
+	const size_t n = instanceCount();
+
+	_states.resize(n);
+	_acc.resize(n);
+	_tecs.reset(new TECS[n]);
+	_l1.reset(new ECL_L1_Pos_Controller[n]);
+
+	if (threads == 0) {
+		threads = math::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	threads = static_cast<unsigned>(math::min<size_t>(threads, math::max<size_t>(n, 1)));
+
+	std::vector<std::thread> workers;
+	const size_t chunk = (n + threads - 1) / threads;
+
+	for (size_t begin = 0; begin < n; begin += chunk) {
+		workers.emplace_back(&BatchEvaluator::runRange, this, begin, math::min(begin + chunk, n));
+	}
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	_steps = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		_steps += static_cast<uint64_t>(_scenarios[scenarioOf(i)].duration / _dt) + 1;
+	}
+}
+
+Metrics BatchEvaluator::metrics(size_t instance) const
+{
+	Metrics m{};
+	const uint32_t samples = _acc.samples[instance];
+
+	m.finite = !_acc.diverged[instance];
+
+	if (samples > 0) {
+		m.altitude_rms = static_cast<float>(sqrt(_acc.altitude_sq[instance] / samples));
+		m.airspeed_rms = static_cast<float>(sqrt(_acc.airspeed_sq[instance] / samples));
+		m.crosstrack_rms = static_cast<float>(sqrt(_acc.crosstrack_sq[instance] / samples));
+		m.throttle_mean = static_cast<float>(_acc.throttle[instance] / samples);
+		m.throttle_saturated = static_cast<float>(_acc.saturated[instance]) / samples;
+		m.airspeed_min = _acc.airspeed_min[instance];
+	}
+
+	m.altitude_max = _acc.altitude_max[instance];
+	m.airspeed_max = _acc.airspeed_max[instance];
+	m.crosstrack_max = _acc.crosstrack_max[instance];
+
+	return m;
+}
+
+} // namespace fw_batch_eval
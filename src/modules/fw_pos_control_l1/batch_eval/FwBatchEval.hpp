@@ -0,0 +1,254 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file FwBatchEval.hpp
+ *
+ * Offline batch evaluation of the fixed-wing TECS and L1 controllers.
+ *
+ * Every instance is one parameter set flying one scenario (a setpoint and wind
+ * trace) against a point-mass plant. The controllers are driven the same way
+ * FixedwingPositionControl drives them in auto mode. Vehicle and metric states
+ * are kept as structure of arrays, all instances of a worker thread are
+ * stepped together and the instances are split across threads.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lib/l1/ECL_L1_Pos_Controller.hpp>
+#include <lib/tecs/TECS.hpp>
+
+namespace fw_batch_eval
+{
+
+/**
+ * Controller tuning, named after the parameters of fw_pos_control_l1.
+ */
+struct ControllerParameters {
+	float fw_airspd_min{10.f};
+	float fw_airspd_max{20.f};
+	float fw_airspd_trim{15.f};
+	float fw_l1_period{20.f};
+	float fw_l1_damping{0.75f};
+	float fw_l1_r_slew_max{90.f};
+	float fw_r_lim{50.f};
+	float fw_p_lim_min{-45.f};
+	float fw_p_lim_max{45.f};
+	float fw_thr_min{0.f};
+	float fw_thr_max{1.f};
+	float fw_thr_cruise{0.6f};
+	float fw_thr_slew_max{0.f};
+	float fw_t_clmb_max{5.f};
+	float fw_t_sink_min{2.f};
+	float fw_t_sink_max{5.f};
+	float fw_t_thr_damp{0.1f};
+	float fw_t_i_gain_thr{0.3f};
+	float fw_t_i_gain_pit{0.1f};
+	float fw_t_vert_acc{7.f};
+	float fw_t_spd_omega{2.f};
+	float fw_t_rll2thr{15.f};
+	float fw_t_spdweight{1.f};
+	float fw_t_ptch_damp{0.1f};
+	float fw_t_alt_tc{5.f};
+	float fw_t_hrate_ff{0.3f};
+	float fw_t_tas_tc{5.f};
+	float fw_t_ste_r_tc{0.4f};
+	float fw_t_tas_r_tc{0.2f};
+	float fw_t_seb_r_ff{1.f};
+
+	/**
+	 * Set a parameter by its PX4 name (e.g. FW_T_ALT_TC).
+	 * @return false if the name is unknown
+	 */
+	bool set(const char *name, float value);
+
+	/** PX4 name of the i-th parameter, nullptr past the last one */
+	static const char *name(size_t i);
+
+	/** value of the i-th parameter */
+	float get(size_t i) const;
+};
+
+/**
+ * Simplified airframe the controllers fly. The defaults match the default tuning,
+ * i.e. the plant climbs at FW_T_CLMB_MAX with full throttle and sinks at FW_T_SINK_MIN
+ * with idle throttle at trim airspeed.
+ */
+struct PlantParameters {
+	float airspeed_trim{15.f};		///< [m/s]
+	float throttle_trim{0.6f};		///< throttle for level flight at trim airspeed
+	float climb_rate_max{5.f};		///< [m/s] at full throttle and trim airspeed
+	float sink_rate_min{2.f};		///< [m/s] at idle and trim airspeed
+	float pitch_time_constant{0.25f};	///< [s] attitude controller response
+	float roll_time_constant{0.4f};		///< [s]
+	float flight_path_time_constant{0.5f};	///< [s] lag of the flight path angle behind pitch
+};
+
+/**
+ * Setpoints and environment at one point in time. The trace is held constant until the next sample.
+ */
+struct TraceSample {
+	float time{0.f};		///< [s] since scenario start
+	float altitude_sp{0.f};		///< [m] AMSL
+	float airspeed_sp{0.f};		///< [m/s] equivalent airspeed
+	float prev_wp[2] {};		///< [m] north, east of the start of the current leg
+	float curr_wp[2] {};		///< [m] north, east of the end of the current leg
+	float wind[2] {};		///< [m/s] north, east
+};
+
+struct Scenario {
+	std::string name;
+	std::vector<TraceSample> trace;
+	float duration{0.f};		///< [s]
+
+	/** waypoints of every trace sample in geographic coordinates, filled by finalize() */
+	std::vector<double> prev_wp_global;	///< lat, lon pairs
+	std::vector<double> curr_wp_global;
+
+	/** sort the trace, set the duration and project the waypoints */
+	void finalize();
+
+	/**
+	 * Read a trace from a CSV file with the columns
+	 * time,altitude_sp,airspeed_sp,prev_north,prev_east,curr_north,curr_east[,wind_north,wind_east]
+	 * and an optional header line. The scenario ends at the last sample.
+	 * @return false on a parse error
+	 */
+	bool loadCsv(const char *file_name);
+
+	/** built-in scenarios: altitude and airspeed steps, crosswind line, box pattern */
+	static std::vector<Scenario> synthetic(const ControllerParameters &defaults);
+};
+
+/**
+ * Tracking metrics of one instance, accumulated after the warm-up time.
+ */
+struct Metrics {
+	float altitude_rms{0.f};	///< [m]
+	float altitude_max{0.f};	///< [m]
+	float airspeed_rms{0.f};	///< [m/s]
+	float airspeed_max{0.f};	///< [m/s]
+	float crosstrack_rms{0.f};	///< [m]
+	float crosstrack_max{0.f};	///< [m]
+	float throttle_mean{0.f};
+	float throttle_saturated{0.f};	///< fraction of time at a throttle limit
+	float airspeed_min{0.f};	///< [m/s] lowest airspeed flown
+	bool finite{true};		///< false if the simulation diverged
+};
+
+class BatchEvaluator
+{
+public:
+	BatchEvaluator(std::vector<ControllerParameters> parameter_sets, std::vector<Scenario> scenarios,
+		       const PlantParameters &plant = PlantParameters{});
+
+	void setRate(float rate_hz) { _dt = 1.f / rate_hz; }
+	void setWarmup(float warmup_s) { _warmup = warmup_s; }
+
+	size_t instanceCount() const { return _parameter_sets.size() * _scenarios.size(); }
+
+	/** an instance flies scenario instance / parameter set count with parameter set instance % parameter set count */
+	size_t parameterSetOf(size_t instance) const { return instance % _parameter_sets.size(); }
+	size_t scenarioOf(size_t instance) const { return instance / _parameter_sets.size(); }
+
+	/**
+	 * Run all instances to the end of their scenario.
+	 * @param threads number of worker threads, 0 for one per core
+	 */
+	void run(unsigned threads = 0);
+
+	Metrics metrics(size_t instance) const;
+
+	/** total number of controller steps of the last run */
+	uint64_t steps() const { return _steps; }
+
+private:
+	void runRange(size_t begin, size_t end);
+	void initialize(size_t i);
+
+	/** run the controllers of instance i, which update the commanded pitch, roll and throttle */
+	void control(size_t i, float t);
+
+	std::vector<ControllerParameters> _parameter_sets;
+	std::vector<Scenario> _scenarios;
+	PlantParameters _plant;
+
+	float _dt{0.02f};
+	float _warmup{5.f};
+
+	/* plant coefficients derived from PlantParameters */
+	float _drag_parasitic{0.f};	///< [m/s^2] parasitic drag at trim airspeed
+	float _drag_induced{0.f};	///< [m/s^2] induced drag at trim airspeed and unit load factor
+	float _thrust_gain{0.f};	///< [m/s^2] per unit throttle above idle
+	float _throttle_idle{0.f};	///< throttle below which the propeller does not produce thrust
+
+	/* vehicle states of all instances (structure of arrays) */
+	struct States {
+		std::vector<float> north, east, altitude;	///< [m]
+		std::vector<float> airspeed, airspeed_rate;	///< [m/s], [m/s^2]
+		std::vector<float> heading, flight_path_angle;	///< [rad]
+		std::vector<float> pitch, roll;			///< [rad]
+		std::vector<float> wind_north, wind_east;	///< [m/s]
+
+		/* commands of the last control step */
+		std::vector<float> pitch_sp, roll_sp, throttle;
+
+		std::vector<uint32_t> trace_index;
+
+		void resize(size_t n);
+	} _states;
+
+	/* metric accumulators of all instances (structure of arrays) */
+	struct Accumulators {
+		std::vector<double> altitude_sq, airspeed_sq, crosstrack_sq, throttle;
+		std::vector<float> altitude_max, airspeed_max, crosstrack_max, airspeed_min;
+		std::vector<uint32_t> samples, saturated;
+		std::vector<uint8_t> diverged;
+
+		void resize(size_t n);
+	} _acc;
+
+	/* the controllers are stateful objects, one per instance */
+	std::unique_ptr<TECS[]> _tecs;
+	std::unique_ptr<ECL_L1_Pos_Controller[]> _l1;
+
+	uint64_t _steps{0};
+};
+
+} // namespace fw_batch_eval
@@ -0,0 +1,342 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file fw_batch_eval_main.cpp
+ *
+ * Command line front end of the fixed-wing controller batch evaluation.
+ * Runs every parameter set against every scenario and writes one CSV line of
+ * tracking metrics per instance.
+ */
+
+#include "FwBatchEval.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace fw_batch_eval;
+
+namespace
+{
+
+// limits of the check mode (-c), exceeding one means the instance did not fly
+constexpr float CHECK_ALTITUDE_ERROR_MAX = 100.f;	///< [m]
+constexpr float CHECK_CROSSTRACK_ERROR_MAX = 250.f;	///< [m]
+constexpr float CHECK_AIRSPEED_MIN_RATIO = 0.7f;	///< of FW_AIRSPD_MIN
+
+void usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"Runs TECS and L1 for every combination of parameter set and scenario.\n\n"
+		" -p <file>         parameter sets, CSV with the parameter names as header and one set per line\n"
+		" -s <NAME=v1,v2..> sweep a parameter over the given values (grid over all sweeps and parameter sets)\n"
+		" -t <file>         add a recorded trace, CSV with the columns\n"
+		"                   time,altitude_sp,airspeed_sp,prev_north,prev_east,curr_north,curr_east[,wind_north,wind_east]\n"
+		" -n                do not add the built-in synthetic scenarios\n"
+		" -j <threads>      worker threads (default: one per core)\n"
+		" -r <rate>         controller rate in Hz (default: 50)\n"
+		" -w <seconds>      warm-up time excluded from the metrics (default: 5)\n"
+		" -o <file>         metrics output (default: stdout)\n"
+		" -c                check mode: fail if any instance diverged or lost control\n",
+		name);
+}
+
+bool load_parameter_sets(const char *file_name, std::vector<ControllerParameters> &sets)
+{
+	FILE *f = fopen(file_name, "r");
+
+	if (f == nullptr) {
+		fprintf(stderr, "failed to open %s\n", file_name);
+		return false;
+	}
+
+	char line[2048];
+	std::vector<std::string> names;
+	bool ok = true;
+
+	while (ok && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+			continue;
+		}
+
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (names.empty()) {
+			for (char *token = strtok(line, ", "); token; token = strtok(nullptr, ", ")) {
+				if (!ControllerParameters{}.set(token, 0.f)) {
+					fprintf(stderr, "%s: unknown parameter %s\n", file_name, token);
+					ok = false;
+					break;
+				}
+
+				names.push_back(token);
+			}
+
+			continue;
+		}
+
+		ControllerParameters p{};
+		size_t column = 0;
+
+		for (char *token = strtok(line, ", "); token; token = strtok(nullptr, ", ")) {
+			if (column >= names.size()) {
+				fprintf(stderr, "%s: too many values in line %zu\n", file_name, sets.size() + 2);
+				ok = false;
+				break;
+			}
+
+			p.set(names[column++].c_str(), strtof(token, nullptr));
+		}
+
+		sets.push_back(p);
+	}
+
+	fclose(f);
+	return ok;
+}
+
+bool add_sweep(const char *arg, std::vector<ControllerParameters> &sets)
+{
+	const char *separator = strchr(arg, '=');
+
+	if (separator == nullptr) {
+		return false;
+	}
+
+	const std::string name(arg, separator - arg);
+	std::vector<float> values;
+
+	for (const char *v = separator + 1; *v != '\0';) {
+		char *end = nullptr;
+		values.push_back(strtof(v, &end));
+
+		if (end == v) {
+			return false;
+		}
+
+		v = (*end == ',') ? end + 1 : end;
+	}
+
+	std::vector<ControllerParameters> grid;
+
+	for (const ControllerParameters &base : sets) {
+		for (float value : values) {
+			ControllerParameters p = base;
+
+			if (!p.set(name.c_str(), value)) {
+				fprintf(stderr, "unknown parameter %s\n", name.c_str());
+				return false;
+			}
+
+			grid.push_back(p);
+		}
+	}
+
+	sets.swap(grid);
+	return !values.empty();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	std::vector<ControllerParameters> parameter_sets;
+	std::vector<const char *> sweeps;
+	std::vector<Scenario> scenarios;
+	bool synthetic = true;
+	bool check = false;
+	unsigned threads = 0;
+	float rate = 50.f;
+	float warmup = 5.f;
+	const char *output = nullptr;
+
+	int ch;
+
+	while ((ch = getopt(argc, argv, "p:s:t:nj:r:w:o:ch")) != -1) {
+		switch (ch) {
+		case 'p':
+			if (!load_parameter_sets(optarg, parameter_sets)) {
+				return 1;
+			}
+
+			break;
+
+		case 's':
+			sweeps.push_back(optarg);
+			break;
+
+		case 't': {
+				Scenario s;
+
+				if (!s.loadCsv(optarg)) {
+					fprintf(stderr, "failed to load trace %s\n", optarg);
+					return 1;
+				}
+
+				scenarios.push_back(s);
+			}
+			break;
+
+		case 'n':
+			synthetic = false;
+			break;
+
+		case 'j':
+			threads = strtoul(optarg, nullptr, 0);
+			break;
+
+		case 'r':
+			rate = strtof(optarg, nullptr);
+			break;
+
+		case 'w':
+			warmup = strtof(optarg, nullptr);
+			break;
+
+		case 'o':
+			output = optarg;
+			break;
+
+		case 'c':
+			check = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (parameter_sets.empty()) {
+		parameter_sets.push_back(ControllerParameters{});
+	}
+
+	for (const char *sweep : sweeps) {
+		if (!add_sweep(sweep, parameter_sets)) {
+			fprintf(stderr, "invalid sweep %s\n", sweep);
+			return 1;
+		}
+	}
+
+	if (synthetic) {
+		// the synthetic setpoints are relative to the first parameter set
+		const std::vector<Scenario> s = Scenario::synthetic(parameter_sets.front());
+		scenarios.insert(scenarios.begin(), s.begin(), s.end());
+	}
+
+	if (scenarios.empty() || !(rate > 0.f)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	// only report the parameters that differ between the sets
+	std::vector<size_t> varying;
+
+	for (size_t k = 0; ControllerParameters::name(k) != nullptr; k++) {
+		for (const ControllerParameters &p : parameter_sets) {
+			if (fabsf(p.get(k) - parameter_sets.front().get(k)) > 0.f) {
+				varying.push_back(k);
+				break;
+			}
+		}
+	}
+
+	BatchEvaluator evaluator(parameter_sets, scenarios);
+	evaluator.setRate(rate);
+	evaluator.setWarmup(warmup);
+
+	const auto start = std::chrono::steady_clock::now();
+	evaluator.run(threads);
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	FILE *out = output ? fopen(output, "w") : stdout;
+
+	if (out == nullptr) {
+		fprintf(stderr, "failed to open %s\n", output);
+		return 1;
+	}
+
+	fprintf(out, "parameter_set,scenario");
+
+	for (size_t k : varying) {
+		fprintf(out, ",%s", ControllerParameters::name(k));
+	}
+
+	fprintf(out, ",altitude_rms,altitude_max,airspeed_rms,airspeed_max,crosstrack_rms,crosstrack_max,"
+		"throttle_mean,throttle_saturated,airspeed_min,finite\n");
+
+	unsigned failed = 0;
+
+	for (size_t i = 0; i < evaluator.instanceCount(); i++) {
+		const ControllerParameters &p = parameter_sets[evaluator.parameterSetOf(i)];
+		const Metrics m = evaluator.metrics(i);
+
+		fprintf(out, "%zu,%s", evaluator.parameterSetOf(i), scenarios[evaluator.scenarioOf(i)].name.c_str());
+
+		for (size_t k : varying) {
+			fprintf(out, ",%g", (double)p.get(k));
+		}
+
+		fprintf(out, ",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
+			(double)m.altitude_rms, (double)m.altitude_max, (double)m.airspeed_rms, (double)m.airspeed_max,
+			(double)m.crosstrack_rms, (double)m.crosstrack_max, (double)m.throttle_mean, (double)m.throttle_saturated,
+			(double)m.airspeed_min, m.finite ? 1 : 0);
+
+		if (!m.finite || m.altitude_max > CHECK_ALTITUDE_ERROR_MAX || m.crosstrack_max > CHECK_CROSSTRACK_ERROR_MAX
+		    || m.airspeed_min < CHECK_AIRSPEED_MIN_RATIO * p.fw_airspd_min) {
+			failed++;
+		}
+	}
+
+	if (output) {
+		fclose(out);
+	}
+
+	fprintf(stderr, "%zu instances (%zu parameter sets x %zu scenarios), %llu steps in %.2f s (%.2f Msteps/s)\n",
+		evaluator.instanceCount(), parameter_sets.size(), scenarios.size(), (unsigned long long)evaluator.steps(),
+		elapsed, (elapsed > 0.) ? evaluator.steps() / elapsed * 1e-6 : 0.);
+
+	if (check && failed > 0) {
+		fprintf(stderr, "%u instances diverged or lost control\n", failed);
+		return 1;
+	}
+
+	return 0;
+}
@@ -48,7 +48,7 @@ namespace land_detector
 class AirshipLandDetector : public LandDetector
 {
 public:
-	AirshipLandDetector() = default;
+	AirshipLandDetector();
 	~AirshipLandDetector() override = default;
 
 protected:
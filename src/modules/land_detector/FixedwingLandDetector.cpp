@@ -49,6 +49,13 @@ FixedwingLandDetector::FixedwingLandDetector()
 	// Use Trigger time when transitioning from in-air (false) to landed (true) / ground contact (true).
 	_landed_hysteresis.set_hysteresis_time_from(false, LANDED_TRIGGER_TIME_US);
 	_landed_hysteresis.set_hysteresis_time_from(true, FLYING_TRIGGER_TIME_US);
+
+	// the filters run once per local position update
+	_state_inputs.freefall = 0;
+	_state_inputs.ground_contact = 0;
+	_state_inputs.maybe_landed = 0;
+	_state_inputs.landed = INPUT_PARAMETERS | INPUT_ARMED | INPUT_LOCAL_POSITION;
+	_state_inputs.ground_effect = 0;
 }
 
 bool FixedwingLandDetector::_get_landed_state()
@@ -60,7 +67,7 @@ bool FixedwingLandDetector::_get_landed_state()
 
 	bool landDetected = false;
 
-	if (hrt_elapsed_time(&_vehicle_local_position.timestamp) < 1_s) {
+	if (_time_now_us < _vehicle_local_position.timestamp_sample + 1_s) {
 
 		// Horizontal velocity complimentary filter.
 		float val = 0.97f * _velocity_xy_filtered + 0.03f * sqrtf(_vehicle_local_position.vx * _vehicle_local_position.vx +
@@ -81,7 +88,7 @@ bool FixedwingLandDetector::_get_landed_state()
 		_airspeed_validated_sub.copy(&airspeed_validated);
 
 		// set _airspeed_filtered to 0 if airspeed data is invalid
-		if (!PX4_ISFINITE(airspeed_validated.true_airspeed_m_s) || hrt_elapsed_time(&airspeed_validated.timestamp) > 1_s) {
+		if (!PX4_ISFINITE(airspeed_validated.true_airspeed_m_s) || (_time_now_us > airspeed_validated.timestamp + 1_s)) {
 			_airspeed_filtered = 0.0f;
 
 		} else {
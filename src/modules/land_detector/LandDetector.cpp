@@ -57,14 +57,16 @@ LandDetector::~LandDetector()
 
 void LandDetector::start()
 {
-	ScheduleDelayed(50_ms);
+	ScheduleDelayed(BACKUP_SCHEDULE_INTERVAL_US);
+	_actuator_armed_sub.registerCallback();
 	_vehicle_local_position_sub.registerCallback();
+	_vehicle_status_sub.registerCallback();
 }
 
 void LandDetector::Run()
 {
 	// push backup schedule
-	ScheduleDelayed(50_ms);
+	ScheduleDelayed(BACKUP_SCHEDULE_INTERVAL_US);
 
 	perf_begin(_cycle_perf);
 
@@ -77,25 +79,41 @@ void LandDetector::Run()
 
 		_total_flight_time = static_cast<uint64_t>(_param_total_flight_time_high.get()) << 32;
 		_total_flight_time |= static_cast<uint32_t>(_param_total_flight_time_low.get());
+
+		_input_updated(INPUT_PARAMETERS, 0);
 	}
 
 	actuator_armed_s actuator_armed;
 
 	if (_actuator_armed_sub.update(&actuator_armed)) {
 		_armed = actuator_armed.armed;
+		_input_updated(INPUT_ARMED, actuator_armed.timestamp);
 	}
 
 	vehicle_acceleration_s vehicle_acceleration;
 
 	if (_vehicle_acceleration_sub.update(&vehicle_acceleration)) {
 		_acceleration = matrix::Vector3f{vehicle_acceleration.xyz};
+		_input_updated(INPUT_ACCELERATION, vehicle_acceleration.timestamp_sample);
 	}
 
-	_vehicle_local_position_sub.update(&_vehicle_local_position);
-	_vehicle_status_sub.update(&_vehicle_status);
+	if (_vehicle_local_position_sub.update(&_vehicle_local_position)) {
+		_input_updated(INPUT_LOCAL_POSITION, _vehicle_local_position.timestamp_sample);
+	}
+
+	if (_vehicle_status_sub.update(&_vehicle_status)) {
+		_input_updated(INPUT_VEHICLE_STATUS, _vehicle_status.timestamp);
+	}
 
 	_update_topics();
 
+	if (!(_inputs & INPUT_LOCAL_POSITION)) {
+		// backup schedule, arming or vehicle status change: the local position is the main input and the
+		// time dependent checks of the states rely on it, evaluate everything on the system time
+		_input_updated(0, hrt_absolute_time());
+		_evaluate_all = true;
+	}
+
 	if (!_dist_bottom_is_observable) {
 		// we consider the distance to the ground observable if the system is using a range sensor
 		_dist_bottom_is_observable = _vehicle_local_position.dist_bottom_sensor_bitfield &
@@ -110,13 +128,20 @@ void LandDetector::Run()
 		_set_hysteresis_factor(1);
 	}
 
-	const hrt_abstime now_us = hrt_absolute_time();
-
-	_freefall_hysteresis.set_state_and_update(_get_freefall_state(), now_us);
-	_ground_contact_hysteresis.set_state_and_update(_get_ground_contact_state(), now_us);
-	_maybe_landed_hysteresis.set_state_and_update(_get_maybe_landed_state(), now_us);
-	_landed_hysteresis.set_state_and_update(_get_landed_state(), now_us);
-	_ground_effect_hysteresis.set_state_and_update(_get_ground_effect_state(), now_us);
+	uint32_t outputs_changed = 0;
+	outputs_changed |= _update_state(_freefall_hysteresis, _state_inputs.freefall,
+					 &LandDetector::_get_freefall_state, INPUT_FREEFALL);
+	outputs_changed |= _update_state(_ground_contact_hysteresis, _state_inputs.ground_contact,
+					 &LandDetector::_get_ground_contact_state, INPUT_GROUND_CONTACT);
+	outputs_changed |= _update_state(_maybe_landed_hysteresis, _state_inputs.maybe_landed,
+					 &LandDetector::_get_maybe_landed_state, INPUT_MAYBE_LANDED);
+	outputs_changed |= _update_state(_landed_hysteresis, _state_inputs.landed,
+					 &LandDetector::_get_landed_state, INPUT_LANDED);
+	_update_state(_ground_effect_hysteresis, _state_inputs.ground_effect, &LandDetector::_get_ground_effect_state, 0);
+
+	// a changed output is also an input of the states evaluated before it, they see it on the next cycle
+	_inputs = outputs_changed;
+	_evaluate_all = false;
 
 	const bool freefallDetected = _freefall_hysteresis.get_state();
 	const bool ground_contactDetected = _ground_contact_hysteresis.get_state();
@@ -136,7 +161,7 @@ void LandDetector::Run()
 
 		if (!landDetected && _land_detected.landed && _takeoff_time == 0) { /* only set take off time once, until disarming */
 			// We did take off
-			_takeoff_time = now_us;
+			_takeoff_time = _time_now_us;
 		}
 
 		_land_detected.landed = landDetected;
@@ -157,7 +182,7 @@ void LandDetector::Run()
 	// set the flight time when disarming (not necessarily when landed, because all param changes should
 	// happen on the same event and it's better to set/save params while not in armed state)
 	if (_takeoff_time != 0 && !_armed && _previous_armed_state) {
-		_total_flight_time += now_us - _takeoff_time;
+		_total_flight_time += _time_now_us - _takeoff_time;
 		_takeoff_time = 0;
 
 		uint32_t flight_time = (_total_flight_time >> 32) & 0xffffffff;
@@ -181,4 +206,25 @@ void LandDetector::Run()
 	}
 }
 
+uint32_t LandDetector::_update_state(systemlib::Hysteresis &hysteresis, uint32_t state_inputs,
+				 bool (LandDetector::*get_state)(), uint32_t output)
+{
+	const bool state = hysteresis.get_state();
+
+	if (_evaluate_all || (_inputs & state_inputs)) {
+		hysteresis.set_state_and_update((this->*get_state)(), _time_now_us);
+
+	} else {
+		hysteresis.update(_time_now_us);
+	}
+
+	if (hysteresis.get_state() != state) {
+		// the states evaluated after this one see the change in this cycle
+		_inputs |= output;
+		return output;
+	}
+
+	return 0;
+}
+
 } // namespace land_detector
@@ -96,6 +96,40 @@ public:
 
 protected:
 
+	/**
+	 * Inputs of the land detector states. A state is evaluated again only once one of its
+	 * inputs was updated, in between the hysteresis keeps running on the last result.
+	 * The vehicle specific inputs start at INPUT_VEHICLE.
+	 */
+	enum Input : uint32_t {
+		INPUT_PARAMETERS     = (1 << 0),
+		INPUT_ARMED          = (1 << 1),
+		INPUT_ACCELERATION   = (1 << 2),
+		INPUT_LOCAL_POSITION = (1 << 3),
+		INPUT_VEHICLE_STATUS = (1 << 4),
+		INPUT_FREEFALL       = (1 << 5),	///< output of the freefall hysteresis changed
+		INPUT_GROUND_CONTACT = (1 << 6),	///< output of the ground contact hysteresis changed
+		INPUT_MAYBE_LANDED   = (1 << 7),	///< output of the maybe landed hysteresis changed
+		INPUT_LANDED         = (1 << 8),	///< output of the landed hysteresis changed
+		INPUT_VEHICLE        = (1 << 16),
+	};
+
+	static constexpr uint32_t INPUT_ALL = UINT32_MAX;
+
+	/**
+	 * Mark an input as updated.
+	 * @param input one or more Input bits
+	 * @param timestamp sample time of the update, 0 if it does not advance the detector time
+	 */
+	void _input_updated(uint32_t input, hrt_abstime timestamp)
+	{
+		_inputs |= input;
+
+		if (timestamp > _time_now_us) {
+			_time_now_us = timestamp;
+		}
+	}
+
 	/**
 	 * Updates parameters.
 	 */
@@ -143,6 +177,19 @@ protected:
 	virtual bool _get_close_to_ground_or_skipped_check() {  return false; }
 	virtual void _set_hysteresis_factor(const int factor) = 0;
 
+	/**
+	 * Inputs every state depends on, a state with no inputs is constant. By default a state is
+	 * evaluated on every cycle. All states are evaluated on the first cycle and whenever the
+	 * local position did not update.
+	 */
+	struct {
+		uint32_t freefall{INPUT_ALL};
+		uint32_t ground_contact{INPUT_ALL};
+		uint32_t maybe_landed{INPUT_ALL};
+		uint32_t landed{INPUT_ALL};
+		uint32_t ground_effect{INPUT_ALL};
+	} _state_inputs;
+
 	systemlib::Hysteresis _freefall_hysteresis{false};
 	systemlib::Hysteresis _landed_hysteresis{true};
 	systemlib::Hysteresis _maybe_landed_hysteresis{true};
@@ -154,6 +201,8 @@ protected:
 
 	matrix::Vector3f _acceleration{};
 
+	hrt_abstime _time_now_us{0};	///< sample time of the newest input, drives the hysteresis
+
 	bool _armed{false};
 	bool _previous_armed_state{false};	///< stores the previous actuator_armed.armed state
 	bool _dist_bottom_is_observable{false};
@@ -161,6 +210,19 @@ protected:
 private:
 	void Run() override;
 
+	/**
+	 * Evaluate a state if one of its inputs was updated and run its hysteresis.
+	 * @return output if the hysteresis output changed, 0 otherwise
+	 */
+	uint32_t _update_state(systemlib::Hysteresis &hysteresis, uint32_t state_inputs, bool (LandDetector::*get_state)(),
+			   uint32_t output);
+
+	/** Backup schedule if none of the callback topics updates. */
+	static constexpr hrt_abstime BACKUP_SCHEDULE_INTERVAL_US = 50_ms;
+
+	uint32_t _inputs{0};		///< inputs updated since the last cycle
+	bool _evaluate_all{true};	///< evaluate all states regardless of their inputs
+
 	vehicle_land_detected_s _land_detected = {
 		.timestamp = 0,
 		.alt_max = -1.0f,
@@ -179,11 +241,11 @@ private:
 
 	uORB::SubscriptionInterval _parameter_update_sub{ORB_ID(parameter_update), 1_s};
 
-	uORB::Subscription _actuator_armed_sub{ORB_ID(actuator_armed)};
 	uORB::Subscription _vehicle_acceleration_sub{ORB_ID(vehicle_acceleration)};
-	uORB::Subscription _vehicle_status_sub{ORB_ID(vehicle_status)};
 
+	uORB::SubscriptionCallbackWorkItem _actuator_armed_sub{this, ORB_ID(actuator_armed)};
 	uORB::SubscriptionCallbackWorkItem _vehicle_local_position_sub{this, ORB_ID(vehicle_local_position)};
+	uORB::SubscriptionCallbackWorkItem _vehicle_status_sub{this, ORB_ID(vehicle_status)};
 
 	DEFINE_PARAMETERS_CUSTOM_PARENT(
 		ModuleParams,
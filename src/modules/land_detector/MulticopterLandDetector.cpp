@@ -80,6 +80,16 @@ MulticopterLandDetector::MulticopterLandDetector()
 	_paramHandle.minThrottle = param_find("MPC_THR_MIN");
 	_paramHandle.useHoverThrustEstimate = param_find("MPC_USE_HTE");
 	_paramHandle.hoverThrottle = param_find("MPC_THR_HOVER");
+
+	_state_inputs.freefall = INPUT_ACCELERATION;
+	_state_inputs.ground_contact = INPUT_PARAMETERS | INPUT_ARMED | INPUT_LOCAL_POSITION | INPUT_THROTTLE | INPUT_CONTROL_MODE
+				       | INPUT_HOVER_THRUST | INPUT_TRAJECTORY_SETPOINT | INPUT_MAYBE_LANDED | INPUT_LANDED;
+	_state_inputs.maybe_landed = INPUT_PARAMETERS | INPUT_ARMED | INPUT_LOCAL_POSITION | INPUT_THROTTLE | INPUT_CONTROL_MODE
+				     | INPUT_FREEFALL | INPUT_GROUND_CONTACT;
+	_state_inputs.landed = INPUT_ARMED | INPUT_MAYBE_LANDED;
+
+	// uses the movement and descend checks of the ground contact state
+	_state_inputs.ground_effect = _state_inputs.ground_contact | INPUT_TAKEOFF_STATUS;
 }
 
 void MulticopterLandDetector::_update_topics()
@@ -88,12 +98,19 @@ void MulticopterLandDetector::_update_topics()
 
 	if (_actuator_controls_sub.update(&actuator_controls)) {
 		_actuator_controls_throttle = actuator_controls.control[actuator_controls_s::INDEX_THROTTLE];
+		_input_updated(INPUT_THROTTLE, actuator_controls.timestamp_sample);
 	}
 
 	vehicle_control_mode_s vehicle_control_mode;
 
 	if (_vehicle_control_mode_sub.update(&vehicle_control_mode)) {
 		_flag_control_climb_rate_enabled = vehicle_control_mode.flag_control_climb_rate_enabled;
+		_input_updated(INPUT_CONTROL_MODE, vehicle_control_mode.timestamp);
+	}
+
+	// consumed by the ground contact state
+	if (_trajectory_setpoint_sub.updated()) {
+		_input_updated(INPUT_TRAJECTORY_SETPOINT, 0);
 	}
 
 	if (_params.useHoverThrustEstimate) {
@@ -104,6 +121,8 @@ void MulticopterLandDetector::_update_topics()
 				_params.hoverThrottle = hte.hover_thrust;
 				_hover_thrust_estimate_last_valid = hte.timestamp;
 			}
+
+			_input_updated(INPUT_HOVER_THRUST, hte.timestamp);
 		}
 	}
 
@@ -111,6 +130,7 @@ void MulticopterLandDetector::_update_topics()
 
 	if (_takeoff_status_sub.update(&takeoff_status)) {
 		_takeoff_state = takeoff_status.takeoff_state;
+		_input_updated(INPUT_TAKEOFF_STATUS, takeoff_status.timestamp);
 	}
 }
 
@@ -152,9 +172,9 @@ bool MulticopterLandDetector::_get_freefall_state()
 
 bool MulticopterLandDetector::_get_ground_contact_state()
 {
-	const hrt_abstime time_now_us = hrt_absolute_time();
+	const hrt_abstime time_now_us = _time_now_us;
 
-	const bool lpos_available = ((time_now_us - _vehicle_local_position.timestamp) < 1_s);
+	const bool lpos_available = (time_now_us < _vehicle_local_position.timestamp_sample + 1_s);
 
 	// land speed threshold, 90% of MPC_LAND_SPEED
 	const float land_speed_threshold = 0.9f * math::max(_params.landSpeed, 0.1f);
@@ -194,7 +214,7 @@ bool MulticopterLandDetector::_get_ground_contact_state()
 		_below_gnd_effect_hgt = false;
 	}
 
-	const bool hover_thrust_estimate_valid = ((time_now_us - _hover_thrust_estimate_last_valid) < 1_s);
+	const bool hover_thrust_estimate_valid = (time_now_us < _hover_thrust_estimate_last_valid + 1_s);
 
 	if (!_in_descend || hover_thrust_estimate_valid) {
 		// continue using valid hover thrust if it became invalid during descent
@@ -250,7 +270,7 @@ bool MulticopterLandDetector::_get_maybe_landed_state()
 		return true;
 	}
 
-	const hrt_abstime time_now_us = hrt_absolute_time();
+	const hrt_abstime time_now_us = _time_now_us;
 
 	// minimal throttle: initially 10% of throttle range between min and hover
 	float sys_min_throttle = _params.minThrottle + (_params.hoverThrottle - _params.minThrottle) * 0.1f;
@@ -295,7 +315,7 @@ bool MulticopterLandDetector::_get_maybe_landed_state()
 	}
 
 	// If vertical velocity is available: ground contact, no thrust, no movement -> landed
-	if (((time_now_us - _vehicle_local_position.timestamp) < 1_s) && _vehicle_local_position.v_z_valid) {
+	if ((time_now_us < _vehicle_local_position.timestamp_sample + 1_s) && _vehicle_local_position.v_z_valid) {
 		return _ground_contact_hysteresis.get_state();
 	}
 
@@ -310,7 +330,7 @@ bool MulticopterLandDetector::_get_landed_state()
 		_landed_time = 0;
 
 	} else if (_landed_time == 0) {
-		_landed_time = hrt_absolute_time();
+		_landed_time = _time_now_us;
 	}
 
 	// When not armed, consider to be landed
@@ -84,6 +84,14 @@ private:
 	float _get_gnd_effect_altitude();
 	bool _is_close_to_ground();
 
+	enum : uint32_t {
+		INPUT_THROTTLE            = INPUT_VEHICLE << 0,
+		INPUT_CONTROL_MODE        = INPUT_VEHICLE << 1,
+		INPUT_HOVER_THRUST        = INPUT_VEHICLE << 2,
+		INPUT_TRAJECTORY_SETPOINT = INPUT_VEHICLE << 3,
+		INPUT_TAKEOFF_STATUS      = INPUT_VEHICLE << 4,
+	};
+
 	/** Time in us that freefall has to hold before triggering freefall */
 	static constexpr hrt_abstime FREEFALL_TRIGGER_TIME_US = 300_ms;
 
@@ -44,6 +44,16 @@
 namespace land_detector
 {
 
+RoverLandDetector::RoverLandDetector()
+{
+	// only the landed state is not constant
+	_state_inputs.freefall = 0;
+	_state_inputs.ground_contact = 0;
+	_state_inputs.maybe_landed = 0;
+	_state_inputs.landed = INPUT_ARMED | INPUT_VEHICLE_STATUS;
+	_state_inputs.ground_effect = 0;
+}
+
 bool RoverLandDetector::_get_ground_contact_state()
 {
 	return true;
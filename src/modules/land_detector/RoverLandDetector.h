@@ -49,7 +49,7 @@ namespace land_detector
 class RoverLandDetector : public LandDetector
 {
 public:
-	RoverLandDetector() = default;
+	RoverLandDetector();
 	~RoverLandDetector() override = default;
 
 protected:
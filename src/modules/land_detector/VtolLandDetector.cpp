@@ -47,6 +47,15 @@
 namespace land_detector
 {
 
+VtolLandDetector::VtolLandDetector()
+{
+	_state_inputs.freefall |= INPUT_VEHICLE_STATUS;
+	_state_inputs.maybe_landed |= INPUT_VEHICLE_STATUS;
+
+	// the airspeed filter runs once per local position update
+	_state_inputs.landed |= INPUT_VEHICLE_STATUS | INPUT_LOCAL_POSITION;
+}
+
 void VtolLandDetector::_update_topics()
 {
 	MulticopterLandDetector::_update_topics();
@@ -76,7 +85,7 @@ bool VtolLandDetector::_get_landed_state()
 	airspeed_validated_s airspeed_validated{};
 	_airspeed_validated_sub.copy(&airspeed_validated);
 
-	if (hrt_elapsed_time(&airspeed_validated.timestamp) < 1_s && PX4_ISFINITE(airspeed_validated.true_airspeed_m_s)) {
+	if ((_time_now_us < airspeed_validated.timestamp + 1_s) && PX4_ISFINITE(airspeed_validated.true_airspeed_m_s)) {
 
 		_airspeed_filtered = 0.95f * _airspeed_filtered + 0.05f * airspeed_validated.true_airspeed_m_s;
 
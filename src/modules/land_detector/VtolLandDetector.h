@@ -51,7 +51,7 @@ namespace land_detector
 class VtolLandDetector : public MulticopterLandDetector
 {
 public:
-	VtolLandDetector() = default;
+	VtolLandDetector();
 	~VtolLandDetector() override = default;
 
 protected:
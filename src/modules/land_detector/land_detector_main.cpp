@@ -137,7 +137,9 @@ position controller sets the thrust setpoint to zero.
 
 **landed**: it requires maybe_landed to be true for time LAND_DETECTOR_TRIGGER_TIME_US.
 
-The module runs periodically on the HP work queue.
+The module runs on the nav_and_controllers work queue whenever the local position, the arming state or the vehicle
+status updates, with a backup schedule of 50 ms. Each state only evaluates its criteria again when one of the topics it
+depends on has updated, the hysteresis runs on the sample timestamps of the inputs.
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("land_detector", "system");
@@ -50,8 +50,7 @@ KalmanFilter::KalmanFilter(matrix::Vector<float, 2> &initial, matrix::Matrix<flo
 
 void KalmanFilter::init(matrix::Vector<float, 2> &initial, matrix::Matrix<float, 2, 2> &covInit)
 {
-	_x = initial;
-	_covariance = covInit;
+	_filter.init(initial, kalman::SymmetricMatrix<float, 2>(matrix::SquareMatrix<float, 2>(covInit)));
 }
 
 void KalmanFilter::init(float initial0, float initial1, float covInit00, float covInit11)
@@ -68,80 +67,58 @@ void KalmanFilter::init(float initial0, float initial1, float covInit00, float c
 
 void KalmanFilter::predict(float dt, float acc, float acc_unc)
 {
-	_x(0) += _x(1) * dt + dt * dt / 2 * acc;
-	_x(1) += acc * dt;
+	matrix::Vector<float, 2> &x = _filter.state();
+	x(0) += x(1) * dt + dt * dt / 2 * acc;
+	x(1) += acc * dt;
 
-	matrix::Matrix<float, 2, 2> A; // propagation matrix
+	matrix::SquareMatrix<float, 2> A; // propagation matrix
 	A(0, 0) = 1;
 	A(1, 1) = 1;
 	A(0, 1) = dt;
 
-	matrix::Matrix<float, 2, 1> G; // noise model
-	G(0, 0) = dt * dt / 2;
-	G(1, 0) = dt;
+	// noise model G = [dt^2 / 2, dt]^T, process noise G * G^T * acc_unc
+	matrix::Vector<float, 2> G;
+	G(0) = dt * dt / 2;
+	G(1) = dt;
 
-	matrix::Matrix<float, 2, 2> process_noise = G * G.transpose() * acc_unc;
+	kalman::SymmetricMatrix<float, 2> process_noise;
+	process_noise.setZero();
+	process_noise.rankOneUpdate(acc_unc, G);
 
-	_covariance = A * _covariance * A.transpose() + process_noise;
+	_filter.predictCovariance(A, process_noise);
 }
 
 bool KalmanFilter::update(float meas, float measUnc)
 {
+	// H = [1, 0], reject outliers at a 5% false alarm probability (chi-squared 3.84)
+	const auto result = _filter.fuseDirect<0>(meas - _filter.state()(0), measUnc, sqrtf(3.84f));
 
-	// H = [1, 0]
-	_residual = meas - _x(0);
-
-	// H * P * H^T simply selects P(0,0)
-	_innovCov = _covariance(0, 0) + measUnc;
-
-	// outlier rejection
-	float beta = _residual / _innovCov * _residual;
-
-	// 5% false alarm probability
-	if (beta > 3.84f) {
-		return false;
-	}
-
-	matrix::Vector<float, 2> kalmanGain;
-	kalmanGain(0) = _covariance(0, 0);
-	kalmanGain(1) = _covariance(1, 0);
-	kalmanGain /= _innovCov;
-
-	_x += kalmanGain * _residual;
-
-	matrix::Matrix<float, 2, 2> identity;
-	identity.identity();
-
-	matrix::Matrix<float, 2, 2> KH; // kalmanGain * H
-	KH(0, 0) = kalmanGain(0);
-	KH(1, 0) = kalmanGain(1);
-
-	_covariance = (identity - KH) * _covariance;
-
-	return true;
+	_residual = result.innovation;
+	_innovCov = result.variance;
 
+	return result.fused;
 }
 
 void KalmanFilter::getState(matrix::Vector<float, 2> &state)
 {
-	state = _x;
+	state = _filter.state();
 }
 
 void KalmanFilter::getState(float &state0, float &state1)
 {
-	state0 = _x(0);
-	state1 = _x(1);
+	state0 = _filter.state()(0);
+	state1 = _filter.state()(1);
 }
 
 void KalmanFilter::getCovariance(matrix::Matrix<float, 2, 2> &covariance)
 {
-	covariance = _covariance;
+	covariance = _filter.covariance().full();
 }
 
 void KalmanFilter::getCovariance(float &cov00, float &cov11)
 {
-	cov00 = _covariance(0, 0);
-	cov11 = _covariance(1, 1);
+	cov00 = _filter.covariance()(0, 0);
+	cov11 = _filter.covariance()(1, 1);
 }
 
 void KalmanFilter::getInnovations(float &innov, float &innovCov)
@@ -50,6 +50,7 @@
 #include <mathlib/mathlib.h>
 #include <matrix/Matrix.hpp>
 #include <matrix/Vector.hpp>
+#include <lib/kalman_filter/KalmanFilter.hpp>
 
 #pragma once
 
@@ -139,9 +140,7 @@ public:
 	void getInnovations(float &innov, float &innovCov);
 
 private:
-	matrix::Vector<float, 2> _x; // state
-
-	matrix::Matrix<float, 2, 2> _covariance; // state covariance
+	kalman::KalmanFilter<float, 2> _filter; // state and state covariance
 
 	float _residual{0.0f}; // residual of last measurement update
 
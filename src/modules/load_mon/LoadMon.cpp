@@ -101,6 +101,14 @@ void LoadMon::Run()
 
 	cpuload();
 
+#if defined(__PX4_LINUX)
+
+	if (px4::WorkQueueManagerProfiling()) {
+		work_item_perf();
+	}
+
+#endif
+
 #if defined(__PX4_NUTTX)
 
 	if (_param_sys_stck_en.get()) {
@@ -238,6 +246,36 @@ void LoadMon::cpuload()
 #endif
 }
 
+#if defined(__PX4_LINUX)
+void LoadMon::work_item_perf()
+{
+	px4::WorkQueueManagerForEachPerfSample(&LoadMon::publish_work_item_perf, this);
+}
+
+void LoadMon::publish_work_item_perf(const char *wq_name, int tid, const char *item_name,
+				     const px4::thread_perf_sample_t &sample, uint32_t run_count, void *arg)
+{
+	LoadMon *self = static_cast<LoadMon *>(arg);
+
+	work_item_perf_s work_item_perf{};
+	strncpy(work_item_perf.wq_name, wq_name, sizeof(work_item_perf.wq_name) - 1);
+
+	if (item_name != nullptr) {
+		strncpy(work_item_perf.item_name, item_name, sizeof(work_item_perf.item_name) - 1);
+	}
+
+	work_item_perf.tid = tid;
+	work_item_perf.run_count = run_count;
+	work_item_perf.cycles = sample.cycles;
+	work_item_perf.instructions = sample.instructions;
+	work_item_perf.cache_misses = sample.cache_misses;
+	work_item_perf.context_switches = sample.context_switches;
+	work_item_perf.timestamp = hrt_absolute_time();
+
+	self->_work_item_perf_pub.publish(work_item_perf);
+}
+#endif
+
 #if defined(__PX4_NUTTX)
 void LoadMon::stack_usage()
 {
@@ -317,6 +355,8 @@ usage and publish the `cpuload` topic.
 
 On NuttX it also checks the stack usage of each process and if it falls below 300 bytes, a warning is output,
 which will also appear in the log file.
+
+On Linux it publishes the `work_item_perf` topic while work queue profiling is enabled (`work_queue profile start`).
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("load_mon", "system");
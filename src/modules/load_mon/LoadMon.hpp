@@ -47,6 +47,7 @@
 #include <uORB/Publication.hpp>
 #include <uORB/topics/cpuload.h>
 #include <uORB/topics/task_stack_info.h>
+#include <uORB/topics/work_item_perf.h>
 
 #if defined(__PX4_LINUX)
 #include <sys/times.h>
@@ -81,6 +82,16 @@ private:
 	/** Do a calculation of the CPU load and publish it. */
 	void cpuload();
 
+#if defined(__PX4_LINUX)
+	/** Publish the perf_event counters of the work queues (if profiling is enabled). */
+	void work_item_perf();
+
+	static void publish_work_item_perf(const char *wq_name, int tid, const char *item_name,
+					   const px4::thread_perf_sample_t &sample, uint32_t run_count, void *arg);
+
+	uORB::Publication<work_item_perf_s> _work_item_perf_pub{ORB_ID(work_item_perf)};
+#endif
+
 	/* Stack check only available on Nuttx */
 #if defined(__PX4_NUTTX)
 	/* Calculate stack usage */
@@ -999,6 +999,19 @@ void BlockLocalPositionEstimator::predict(const sensor_combined_s &imu)
 	_aglLowPass.update(agl());
 }
 
+BlockLocalPositionEstimator::CorrectionFilter BlockLocalPositionEstimator::correctionFilter() const
+{
+	CorrectionFilter kf;
+	kf.init(_x, CorrectionFilter::Covariance(m_P));
+	return kf;
+}
+
+void BlockLocalPositionEstimator::applyCorrection(const CorrectionFilter &kf)
+{
+	_x = kf.state();
+	m_P = kf.covariance().full();
+}
+
 int BlockLocalPositionEstimator::getDelayPeriods(float delay, uint8_t *periods)
 {
 	float t_delay = 0;
@@ -9,6 +9,8 @@
 #include <lib/mathlib/mathlib.h>
 #include <matrix/Matrix.hpp>
 
+#include <lib/kalman_filter/KalmanFilter.hpp>
+
 // uORB Subscriptions
 #include <uORB/Subscription.hpp>
 #include <uORB/SubscriptionCallback.hpp>
@@ -127,6 +129,8 @@ public:
 	bool init();
 
 private:
+	// the test needs to compare the corrections against the dense batch update
+	friend class LocalPositionEstimatorTest;
 
 	// constants
 	enum {X_x = 0, X_y, X_z, X_vx, X_vy, X_vz, X_bx, X_by, X_bz, X_tz, n_x};
@@ -169,6 +173,8 @@ private:
 		EST_TZ = 1 << 2,
 	};
 
+	using CorrectionFilter = kalman::KalmanFilter<float, n_x>;
+
 	void Run() override;
 
 	// methods
@@ -186,6 +192,11 @@ private:
 	// predict the next state
 	void predict(const sensor_combined_s &imu);
 
+	// measurement corrections are fused on a filter copy of the state,
+	// which is taken over only if the sensor passes fault detection
+	CorrectionFilter correctionFilter() const;
+	void applyCorrection(const CorrectionFilter &kf);
+
 	// lidar
 	int  lidarMeasure(Vector<float, n_y_lidar> &y);
 	void lidarCorrect();
@@ -0,0 +1,201 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file LocalPositionEstimatorTest.cpp
+ *
+ * Compares the sequential sensor corrections of the estimator (correctionFilter() / applyCorrection())
+ * against the dense batch update they replaced.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BlockLocalPositionEstimator.hpp"
+
+class LocalPositionEstimatorTest : public ::testing::Test
+{
+public:
+	using Estimator = BlockLocalPositionEstimator;
+	static constexpr size_t n_x = Estimator::n_x;
+	static constexpr size_t n_y_gps = Estimator::n_y_gps;
+	static constexpr size_t n_y_land = Estimator::n_y_land;
+
+	void SetUp() override
+	{
+		// random state and positive definite covariance A * A^T + 0.1 * I
+		Matrix<float, n_x, n_x> A;
+
+		for (size_t i = 0; i < n_x; i++) {
+			_lpe._x(i) = 10.f * pseudo_random();
+
+			for (size_t j = 0; j < n_x; j++) {
+				A(i, j) = pseudo_random();
+			}
+		}
+
+		_lpe.m_P = A * A.transpose();
+
+		for (size_t i = 0; i < n_x; i++) {
+			_lpe.m_P(i, i) += 0.1f;
+		}
+	}
+
+	/** deterministic values in [-1, 1] */
+	static float pseudo_random()
+	{
+		static uint32_t seed = 12345;
+		seed = seed * 1103515245u + 12345u;
+		return static_cast<float>((seed >> 8) & 0xffff) / 32767.5f - 1.f;
+	}
+
+	/** gps measures position and velocity directly */
+	static Matrix<float, n_y_gps, n_x> gpsMeasurementMatrix()
+	{
+		Matrix<float, n_y_gps, n_x> C;
+		C.setZero();
+		C(Estimator::Y_gps_x, Estimator::X_x) = 1;
+		C(Estimator::Y_gps_y, Estimator::X_y) = 1;
+		C(Estimator::Y_gps_z, Estimator::X_z) = 1;
+		C(Estimator::Y_gps_vx, Estimator::X_vx) = 1;
+		C(Estimator::Y_gps_vy, Estimator::X_vy) = 1;
+		C(Estimator::Y_gps_vz, Estimator::X_vz) = 1;
+		return C;
+	}
+
+	/** land measures the horizontal velocity and the altitude above ground (tz - z) */
+	static Matrix<float, n_y_land, n_x> landMeasurementMatrix()
+	{
+		Matrix<float, n_y_land, n_x> C;
+		C.setZero();
+		C(Estimator::Y_land_vx, Estimator::X_vx) = 1;
+		C(Estimator::Y_land_vy, Estimator::X_vy) = 1;
+		C(Estimator::Y_land_agl, Estimator::X_z) = -1;
+		C(Estimator::Y_land_agl, Estimator::X_tz) = 1;
+		return C;
+	}
+
+	/** the correction as implemented before: K = P * C^T * (C * P * C^T + R)^-1 */
+	template<size_t M>
+	void batchCorrect(const Matrix<float, M, n_x> &C, const Vector<float, M> &r, const Vector<float, M> &R,
+			  Vector<float, n_x> &x, Matrix<float, n_x, n_x> &P) const
+	{
+		SquareMatrix<float, M> R_dense;
+		R_dense.setZero();
+
+		for (size_t i = 0; i < M; i++) {
+			R_dense(i, i) = R(i);
+		}
+
+		const SquareMatrix<float, M> S_I = inv<float, M>(C * P * C.transpose() + R_dense);
+		const Matrix<float, n_x, M> K = P * C.transpose() * S_I;
+		x += K * r;
+		P -= K * C * P;
+	}
+
+	/** as in gpsCorrect() */
+	void gpsCorrect(const Vector<float, n_y_gps> &r, const Vector<float, n_y_gps> &R)
+	{
+		Estimator::CorrectionFilter kf = _lpe.correctionFilter();
+		Estimator::CorrectionFilter::Result innov[n_y_gps];
+		const float innovation[n_y_gps] {r(0), r(1), r(2), r(3), r(4), r(5)};
+		const float noise[n_y_gps] {R(0), R(1), R(2), R(3), R(4), R(5)};
+		kf.fuseDirectSequential<Estimator::X_x, Estimator::X_y, Estimator::X_z,
+					Estimator::X_vx, Estimator::X_vy, Estimator::X_vz>(innovation, noise, 0.f, innov);
+		_lpe.applyCorrection(kf);
+	}
+
+	/** as in landCorrect() */
+	void landCorrect(const Vector<float, n_y_land> &r, const Vector<float, n_y_land> &R)
+	{
+		Estimator::CorrectionFilter kf = _lpe.correctionFilter();
+		Estimator::CorrectionFilter::Result innov[n_y_land];
+		kf.fuseSequential(landMeasurementMatrix(), r, R, 0.f, innov);
+		_lpe.applyCorrection(kf);
+	}
+
+	const Vector<float, n_x> &state() const { return _lpe._x; }
+	const Matrix<float, n_x, n_x> &covariance() const { return _lpe.m_P; }
+
+	void expectEstimate(const Vector<float, n_x> &x, const Matrix<float, n_x, n_x> &P) const
+	{
+		for (size_t i = 0; i < n_x; i++) {
+			EXPECT_NEAR(_lpe._x(i), x(i), 1e-3f) << "state " << i;
+
+			for (size_t j = 0; j < n_x; j++) {
+				EXPECT_NEAR(_lpe.m_P(i, j), P(i, j), 1e-3f) << "covariance " << i << ", " << j;
+			}
+		}
+	}
+
+private:
+	Estimator _lpe;
+};
+
+TEST_F(LocalPositionEstimatorTest, gpsCorrectionMatchesBatch)
+{
+	Vector<float, n_y_gps> r;
+	Vector<float, n_y_gps> R;
+
+	for (size_t i = 0; i < n_y_gps; i++) {
+		r(i) = pseudo_random();
+		R(i) = 0.5f + 0.25f * pseudo_random();
+	}
+
+	Vector<float, n_x> x = state();
+	Matrix<float, n_x, n_x> P = covariance();
+	batchCorrect(gpsMeasurementMatrix(), r, R, x, P);
+
+	gpsCorrect(r, R);
+	expectEstimate(x, P);
+}
+
+TEST_F(LocalPositionEstimatorTest, landCorrectionMatchesBatch)
+{
+	Vector<float, n_y_land> R;
+	R(0) = 0.04f;
+	R(1) = 0.04f;
+	R(2) = 0.25f;
+
+	// landed: no velocity and no altitude above ground
+	Vector<float, n_y_land> y;
+	y.setZero();
+	const Vector<float, n_y_land> r = y - landMeasurementMatrix() * state();
+
+	Vector<float, n_x> x = state();
+	Matrix<float, n_x, n_x> P = covariance();
+	batchCorrect(landMeasurementMatrix(), r, R, x, P);
+
+	landCorrect(r, R);
+	expectEstimate(x, P);
+}
@@ -57,22 +57,19 @@ void BlockLocalPositionEstimator::baroCorrect()
 	// subtract baro origin alt
 	y -= _baroAltOrigin;
 
-	// baro measurement matrix
-	Matrix<float, n_y_baro, n_x> C;
-	C.setZero();
-	C(Y_baro_z, X_z) = -1;	// measured altitude, negative down dir.
+	Vector<float, n_y_baro> R;
+	R(Y_baro_z) = _param_lpe_bar_z.get() * _param_lpe_bar_z.get();
 
-	Matrix<float, n_y_baro, n_y_baro> R;
-	R.setZero();
-	R(0, 0) = _param_lpe_bar_z.get() * _param_lpe_bar_z.get();
+	// residual, measured altitude, negative down dir.
+	Vector<float, n_y_baro> r;
+	r(Y_baro_z) = y(Y_baro_z) + _x(X_z);
 
-	// residual
-	Matrix<float, n_y_baro, n_y_baro> S_I =
-		inv<float, n_y_baro>((C * m_P * C.transpose()) + R);
-	Vector<float, n_y_baro> r = y - (C * _x);
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_baro];
+	innov[Y_baro_z] = kf.fuseSparse<X_z>({-1.f}, r(Y_baro_z), R(Y_baro_z));
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_baro]) {
 		if (!(_sensorFault & SENSOR_BARO)) {
@@ -87,10 +84,7 @@ void BlockLocalPositionEstimator::baroCorrect()
 	}
 
 	// kalman filter correction always
-	Matrix<float, n_x, n_y_baro> K = m_P * C.transpose() * S_I;
-	Vector<float, n_x> dx = K * r;
-	_x += dx;
-	m_P -= K * C * m_P;
+	applyCorrection(kf);
 }
 
 void BlockLocalPositionEstimator::baroCheckTimeout()
@@ -112,14 +112,8 @@ void BlockLocalPositionEstimator::flowCorrect()
 
 	if (flowMeasure(y) != OK) { return; }
 
-	// flow measurement matrix and noise matrix
-	Matrix<float, n_y_flow, n_x> C;
-	C.setZero();
-	C(Y_flow_vx, X_vx) = 1;
-	C(Y_flow_vy, X_vy) = 1;
-
-	SquareMatrix<float, n_y_flow> R;
-	R.setZero();
+	// flow noise matrix, flow measures vx, vy
+	Vector<float, n_y_flow> R;
 
 	// polynomial noise model, found using least squares fit
 	// h, h**2, v, v*h, v*h**2
@@ -160,28 +154,30 @@ void BlockLocalPositionEstimator::flowCorrect()
 	matrix::Eulerf euler(matrix::Quatf(_sub_att.get().q));
 	float rot_sq = euler.phi() * euler.phi() + euler.theta() * euler.theta();
 
-	R(Y_flow_vx, Y_flow_vx) = flow_vxy_stddev * flow_vxy_stddev +
+	R(Y_flow_vx) = flow_vxy_stddev * flow_vxy_stddev +
 				  _param_lpe_flw_r.get() * _param_lpe_flw_r.get() * rot_sq +
 				  _param_lpe_flw_rr.get() * _param_lpe_flw_rr.get() * rotrate_sq;
-	R(Y_flow_vy, Y_flow_vy) = R(Y_flow_vx, Y_flow_vx);
+	R(Y_flow_vy) = R(Y_flow_vx);
 
 	// residual
-	Vector<float, 2> r = y - C * _x;
-
-	// residual covariance
-	Matrix<float, n_y_flow, n_y_flow> S = C * m_P * C.transpose() + R;
+	Vector<float, n_y_flow> r;
+	r(Y_flow_vx) = y(Y_flow_vx) - _x(X_vx);
+	r(Y_flow_vy) = y(Y_flow_vy) - _x(X_vy);
 
 	// publish innovations
 	_pub_innov.get().flow[0] = r(0);
 	_pub_innov.get().flow[1] = r(1);
-	_pub_innov_var.get().flow[0] = S(0, 0);
-	_pub_innov_var.get().flow[1] = S(1, 1);
+	_pub_innov_var.get().flow[0] = m_P(X_vx, X_vx) + R(Y_flow_vx);
+	_pub_innov_var.get().flow[1] = m_P(X_vy, X_vy) + R(Y_flow_vy);
 
-	// residual covariance, (inverse)
-	Matrix<float, n_y_flow, n_y_flow> S_I = inv<float, n_y_flow>(S);
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_flow];
+	const float innovation[n_y_flow] {r(Y_flow_vx), r(Y_flow_vy)};
+	const float noise[n_y_flow] {R(Y_flow_vx), R(Y_flow_vy)};
+	kf.fuseDirectSequential<X_vx, X_vy>(innovation, noise, 0.f, innov);
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_flow]) {
 		if (!(_sensorFault & SENSOR_FLOW)) {
@@ -195,11 +191,7 @@ void BlockLocalPositionEstimator::flowCorrect()
 	}
 
 	if (!(_sensorFault & SENSOR_FLOW)) {
-		Matrix<float, n_x, n_y_flow> K =
-			m_P * C.transpose() * S_I;
-		Vector<float, n_x> dx = K * r;
-		_x += dx;
-		m_P -= K * C * m_P;
+		applyCorrection(kf);
 	}
 }
 
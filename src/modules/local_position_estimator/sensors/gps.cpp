@@ -129,19 +129,8 @@ void BlockLocalPositionEstimator::gpsCorrect()
 	y(Y_gps_vy) = y_global(Y_gps_vy);
 	y(Y_gps_vz) = y_global(Y_gps_vz);
 
-	// gps measurement matrix, measures position and velocity
-	Matrix<float, n_y_gps, n_x> C;
-	C.setZero();
-	C(Y_gps_x, X_x) = 1;
-	C(Y_gps_y, X_y) = 1;
-	C(Y_gps_z, X_z) = 1;
-	C(Y_gps_vx, X_vx) = 1;
-	C(Y_gps_vy, X_vy) = 1;
-	C(Y_gps_vz, X_vz) = 1;
-
-	// gps covariance matrix
-	SquareMatrix<float, n_y_gps> R;
-	R.setZero();
+	// gps covariance matrix (diagonal)
+	Vector<float, n_y_gps> R;
 
 	// default to parameter, use gps cov if provided
 	float var_xy = _param_lpe_gps_xy.get() * _param_lpe_gps_xy.get();
@@ -168,12 +157,12 @@ void BlockLocalPositionEstimator::gpsCorrect()
 		var_vz = gps_s_stddev * gps_s_stddev;
 	}
 
-	R(0, 0) = var_xy;
-	R(1, 1) = var_xy;
-	R(2, 2) = var_z;
-	R(3, 3) = var_vxy;
-	R(4, 4) = var_vxy;
-	R(5, 5) = var_vz;
+	R(Y_gps_x) = var_xy;
+	R(Y_gps_y) = var_xy;
+	R(Y_gps_z) = var_z;
+	R(Y_gps_vx) = var_vxy;
+	R(Y_gps_vy) = var_vxy;
+	R(Y_gps_vz) = var_vz;
 
 	// get delayed x
 	uint8_t i_hist = 0;
@@ -182,11 +171,23 @@ void BlockLocalPositionEstimator::gpsCorrect()
 
 	Vector<float, n_x> x0 = _xDelay.get(i_hist);
 
-	// residual
-	Vector<float, n_y_gps> r = y - C * x0;
-
-	// residual covariance
-	Matrix<float, n_y_gps, n_y_gps> S = C * m_P * C.transpose() + R;
+	// residual, gps measures position and velocity
+	Vector<float, n_y_gps> r;
+	r(Y_gps_x) = y(Y_gps_x) - x0(X_x);
+	r(Y_gps_y) = y(Y_gps_y) - x0(X_y);
+	r(Y_gps_z) = y(Y_gps_z) - x0(X_z);
+	r(Y_gps_vx) = y(Y_gps_vx) - x0(X_vx);
+	r(Y_gps_vy) = y(Y_gps_vy) - x0(X_vy);
+	r(Y_gps_vz) = y(Y_gps_vz) - x0(X_vz);
+
+	// residual covariance (diagonal)
+	Vector<float, n_y_gps> S;
+	S(Y_gps_x) = m_P(X_x, X_x) + R(Y_gps_x);
+	S(Y_gps_y) = m_P(X_y, X_y) + R(Y_gps_y);
+	S(Y_gps_z) = m_P(X_z, X_z) + R(Y_gps_z);
+	S(Y_gps_vx) = m_P(X_vx, X_vx) + R(Y_gps_vx);
+	S(Y_gps_vy) = m_P(X_vy, X_vy) + R(Y_gps_vy);
+	S(Y_gps_vz) = m_P(X_vz, X_vz) + R(Y_gps_vz);
 
 	// publish innovations
 	_pub_innov.get().gps_hpos[0] = r(0);
@@ -197,18 +198,21 @@ void BlockLocalPositionEstimator::gpsCorrect()
 	_pub_innov.get().gps_vvel    = r(5);
 
 	// publish innovation variances
-	_pub_innov_var.get().gps_hpos[0] = S(0, 0);
-	_pub_innov_var.get().gps_hpos[1] = S(1, 1);
-	_pub_innov_var.get().gps_vpos    = S(2, 2);
-	_pub_innov_var.get().gps_hvel[0] = S(3, 3);
-	_pub_innov_var.get().gps_hvel[1] = S(4, 4);
-	_pub_innov_var.get().gps_vvel    = S(5, 5);
-
-	// residual covariance, (inverse)
-	Matrix<float, n_y_gps, n_y_gps> S_I = inv<float, n_y_gps>(S);
+	_pub_innov_var.get().gps_hpos[0] = S(0);
+	_pub_innov_var.get().gps_hpos[1] = S(1);
+	_pub_innov_var.get().gps_vpos    = S(2);
+	_pub_innov_var.get().gps_hvel[0] = S(3);
+	_pub_innov_var.get().gps_hvel[1] = S(4);
+	_pub_innov_var.get().gps_vvel    = S(5);
+
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_gps];
+	const float innovation[n_y_gps] {r(Y_gps_x), r(Y_gps_y), r(Y_gps_z), r(Y_gps_vx), r(Y_gps_vy), r(Y_gps_vz)};
+	const float noise[n_y_gps] {R(Y_gps_x), R(Y_gps_y), R(Y_gps_z), R(Y_gps_vx), R(Y_gps_vy), R(Y_gps_vz)};
+	kf.fuseDirectSequential<X_x, X_y, X_z, X_vx, X_vy, X_vz>(innovation, noise, 0.f, innov);
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	// artifically increase beta threshhold to prevent fault during landing
 	float beta_thresh = 1e2f;
@@ -216,8 +220,8 @@ void BlockLocalPositionEstimator::gpsCorrect()
 	if (beta / BETA_TABLE[n_y_gps] > beta_thresh) {
 		if (!(_sensorFault & SENSOR_GPS)) {
 			mavlink_log_critical(&mavlink_log_pub, "[lpe] gps fault %3g %3g %3g %3g %3g %3g",
-					     double(r(0) * r(0) / S_I(0, 0)),  double(r(1) * r(1) / S_I(1, 1)), double(r(2) * r(2) / S_I(2, 2)),
-					     double(r(3) * r(3) / S_I(3, 3)),  double(r(4) * r(4) / S_I(4, 4)), double(r(5) * r(5) / S_I(5, 5)));
+					     double(r(0) * r(0) / S(0)),  double(r(1) * r(1) / S(1)), double(r(2) * r(2) / S(2)),
+					     double(r(3) * r(3) / S(3)),  double(r(4) * r(4) / S(4)), double(r(5) * r(5) / S(5)));
 			_sensorFault |= SENSOR_GPS;
 		}
 
@@ -227,10 +231,7 @@ void BlockLocalPositionEstimator::gpsCorrect()
 	}
 
 	// kalman filter correction always for GPS
-	Matrix<float, n_x, n_y_gps> K = m_P * C.transpose() * S_I;
-	Vector<float, n_x> dx = K * r;
-	_x += dx;
-	m_P -= K * C * m_P;
+	applyCorrection(kf);
 }
 
 void BlockLocalPositionEstimator::gpsCheckTimeout()
@@ -51,21 +51,23 @@ void BlockLocalPositionEstimator::landCorrect()
 	C(Y_land_agl, X_z) = -1;// measured altitude, negative down dir.
 	C(Y_land_agl, X_tz) = 1;// measured altitude, negative down dir.
 
-	// use parameter covariance
-	SquareMatrix<float, n_y_land> R;
-	R.setZero();
-	R(Y_land_vx, Y_land_vx) = _param_lpe_land_vxy.get() * _param_lpe_land_vxy.get();
-	R(Y_land_vy, Y_land_vy) = _param_lpe_land_vxy.get() * _param_lpe_land_vxy.get();
-	R(Y_land_agl, Y_land_agl) = _param_lpe_land_z.get() * _param_lpe_land_z.get();
+	// use parameter covariance (diagonal)
+	Vector<float, n_y_land> R;
+	R(Y_land_vx) = _param_lpe_land_vxy.get() * _param_lpe_land_vxy.get();
+	R(Y_land_vy) = _param_lpe_land_vxy.get() * _param_lpe_land_vxy.get();
+	R(Y_land_agl) = _param_lpe_land_z.get() * _param_lpe_land_z.get();
 
 	// residual
-	Matrix<float, n_y_land, n_y_land> S_I = inv<float, n_y_land>((C * m_P * C.transpose()) + R);
 	Vector<float, n_y_land> r = y - C * _x;
 	_pub_innov.get().hagl = r(Y_land_agl);
-	_pub_innov_var.get().hagl = R(Y_land_agl, Y_land_agl);
+	_pub_innov_var.get().hagl = R(Y_land_agl);
+
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_land];
+	kf.fuseSequential(C, r, R, 0.f, innov);
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	// artifically increase beta threshhold to prevent fault during landing
 	float beta_thresh = 1e2f;
@@ -85,10 +87,7 @@ void BlockLocalPositionEstimator::landCorrect()
 	}
 
 	// kalman filter correction always for land detector
-	Matrix<float, n_x, n_y_land> K = m_P * C.transpose() * S_I;
-	Vector<float, n_x> dx = K * r;
-	_x += dx;
-	m_P -= K * C * m_P;
+	applyCorrection(kf);
 }
 
 void BlockLocalPositionEstimator::landCheckTimeout()
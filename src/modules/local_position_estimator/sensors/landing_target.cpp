@@ -64,28 +64,27 @@ void BlockLocalPositionEstimator::landingTargetCorrect()
 	}
 
 	// target measurement matrix and noise matrix
-	Matrix<float, n_y_target, n_x> C;
-	C.setZero();
 	// residual = (y + vehicle velocity)
 	// sign change because target velocitiy is -vehicle velocity
+	Matrix<float, n_y_target, n_x> C;
+	C.setZero();
 	C(Y_target_x, X_vx) = -1;
 	C(Y_target_y, X_vy) = -1;
 
-	// covariance matrix
-	SquareMatrix<float, n_y_target> R;
-	R.setZero();
-	R(0, 0) = cov_vx;
-	R(1, 1) = cov_vy;
+	// covariance matrix (diagonal)
+	Vector<float, n_y_target> R;
+	R(Y_target_x) = cov_vx;
+	R(Y_target_y) = cov_vy;
 
 	// residual
 	Vector<float, n_y_target> r = y - C * _x;
 
-	// residual covariance, (inverse)
-	Matrix<float, n_y_target, n_y_target> S_I =
-		inv<float, n_y_target>(C * m_P * C.transpose() + R);
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_target];
+	kf.fuseSequential(C, r, R, 0.f, innov);
 
 	// fault detection
-	float beta = (r.transpose()  * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_target]) {
 		if (!(_sensorFault & SENSOR_LAND_TARGET)) {
@@ -102,11 +101,7 @@ void BlockLocalPositionEstimator::landingTargetCorrect()
 	}
 
 	// kalman filter correction
-	Matrix<float, n_x, n_y_target> K =
-		m_P * C.transpose() * S_I;
-	Vector<float, n_x> dx = K * r;
-	_x += dx;
-	m_P -= K * C * m_P;
+	applyCorrection(kf);
 
 }
 
@@ -66,40 +66,33 @@ void BlockLocalPositionEstimator::lidarCorrect()
 
 	if (lidarMeasure(y) != OK) { return; }
 
-	// measurement matrix
-	Matrix<float, n_y_lidar, n_x> C;
-	C.setZero();
-	// y = -(z - tz)
-	// TODO could add trig to make this an EKF correction
-	C(Y_lidar_z, X_z) = -1;	// measured altitude, negative down dir.
-	C(Y_lidar_z, X_tz) = 1;	// measured altitude, negative down dir.
-
 	// use parameter covariance unless sensor provides reasonable value
-	SquareMatrix<float, n_y_lidar> R;
-	R.setZero();
+	Vector<float, n_y_lidar> R;
 	float cov = _sub_lidar->get().variance;
 
 	if (cov < 1.0e-3f) {
-		R(0, 0) = _param_lpe_ldr_z.get() * _param_lpe_ldr_z.get();
+		R(Y_lidar_z) = _param_lpe_ldr_z.get() * _param_lpe_ldr_z.get();
 
 	} else {
-		R(0, 0) = cov;
+		R(Y_lidar_z) = cov;
 	}
 
 	// residual
-	Vector<float, n_y_lidar> r = y - C * _x;
-	// residual covariance
-	Matrix<float, n_y_lidar, n_y_lidar> S = C * m_P * C.transpose() + R;
+	// y = -(z - tz)
+	// TODO could add trig to make this an EKF correction
+	Vector<float, n_y_lidar> r;
+	r(Y_lidar_z) = y(Y_lidar_z) + _x(X_z) - _x(X_tz);
+
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_lidar];
+	innov[Y_lidar_z] = kf.fuseSparse<X_z, X_tz>({-1.f, 1.f}, r(Y_lidar_z), R(Y_lidar_z));
 
 	// publish innovations
 	_pub_innov.get().hagl = r(0);
-	_pub_innov_var.get().hagl = S(0, 0);
-
-	// residual covariance, (inverse)
-	Matrix<float, n_y_lidar, n_y_lidar> S_I = inv<float, n_y_lidar>(S);
+	_pub_innov_var.get().hagl = innov[Y_lidar_z].variance;
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_lidar]) {
 		if (!(_sensorFault & SENSOR_LIDAR)) {
@@ -116,10 +109,7 @@ void BlockLocalPositionEstimator::lidarCorrect()
 	}
 
 	// kalman filter correction always
-	Matrix<float, n_x, n_y_lidar> K = m_P * C.transpose() * S_I;
-	Vector<float, n_x> dx = K * r;
-	_x += dx;
-	m_P -= K * C * m_P;
+	applyCorrection(kf);
 }
 
 void BlockLocalPositionEstimator::lidarCheckTimeout()
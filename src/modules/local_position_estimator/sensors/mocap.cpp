@@ -113,38 +113,31 @@ void BlockLocalPositionEstimator::mocapCorrect()
 		return;
 	}
 
-	// mocap measurement matrix, measures position
-	Matrix<float, n_y_mocap, n_x> C;
-	C.setZero();
-	C(Y_mocap_x, X_x) = 1;
-	C(Y_mocap_y, X_y) = 1;
-	C(Y_mocap_z, X_z) = 1;
-
-	// noise matrix
-	Matrix<float, n_y_mocap, n_y_mocap> R;
-	R.setZero();
+	// noise matrix (diagonal)
+	Vector<float, n_y_mocap> R;
 
 	// use std dev from mocap data if available
 	if (_mocap_eph > _param_lpe_vic_p.get()) {
-		R(Y_mocap_x, Y_mocap_x) = _mocap_eph * _mocap_eph;
-		R(Y_mocap_y, Y_mocap_y) = _mocap_eph * _mocap_eph;
+		R(Y_mocap_x) = _mocap_eph * _mocap_eph;
+		R(Y_mocap_y) = _mocap_eph * _mocap_eph;
 
 	} else {
-		R(Y_mocap_x, Y_mocap_x) = _param_lpe_vic_p.get() * _param_lpe_vic_p.get();
-		R(Y_mocap_y, Y_mocap_y) = _param_lpe_vic_p.get() * _param_lpe_vic_p.get();
+		R(Y_mocap_x) = _param_lpe_vic_p.get() * _param_lpe_vic_p.get();
+		R(Y_mocap_y) = _param_lpe_vic_p.get() * _param_lpe_vic_p.get();
 	}
 
 	if (_mocap_epv > _param_lpe_vic_p.get()) {
-		R(Y_mocap_z, Y_mocap_z) = _mocap_epv * _mocap_epv;
+		R(Y_mocap_z) = _mocap_epv * _mocap_epv;
 
 	} else {
-		R(Y_mocap_z, Y_mocap_z) = _param_lpe_vic_p.get() * _param_lpe_vic_p.get();
+		R(Y_mocap_z) = _param_lpe_vic_p.get() * _param_lpe_vic_p.get();
 	}
 
-	// residual
-	Vector<float, n_y_mocap> r = y - C * _x;
-	// residual covariance
-	Matrix<float, n_y_mocap, n_y_mocap> S = C * m_P * C.transpose() + R;
+	// residual, mocap measures position
+	Vector<float, n_y_mocap> r;
+	r(Y_mocap_x) = y(Y_mocap_x) - _x(X_x);
+	r(Y_mocap_y) = y(Y_mocap_y) - _x(X_y);
+	r(Y_mocap_z) = y(Y_mocap_z) - _x(X_z);
 
 	// publish innovations
 	_pub_innov.get().ev_hpos[0] = r(0);
@@ -155,18 +148,21 @@ void BlockLocalPositionEstimator::mocapCorrect()
 	_pub_innov.get().ev_vvel    = NAN;
 
 	// publish innovation variances
-	_pub_innov_var.get().ev_hpos[0] = S(0, 0);
-	_pub_innov_var.get().ev_hpos[1] = S(1, 1);
-	_pub_innov_var.get().ev_vpos    = S(2, 2);
+	_pub_innov_var.get().ev_hpos[0] = m_P(X_x, X_x) + R(Y_mocap_x);
+	_pub_innov_var.get().ev_hpos[1] = m_P(X_y, X_y) + R(Y_mocap_y);
+	_pub_innov_var.get().ev_vpos    = m_P(X_z, X_z) + R(Y_mocap_z);
 	_pub_innov_var.get().ev_hvel[0] = NAN;
 	_pub_innov_var.get().ev_hvel[1] = NAN;
 	_pub_innov_var.get().ev_vvel    = NAN;
 
-	// residual covariance, (inverse)
-	Matrix<float, n_y_mocap, n_y_mocap> S_I = inv<float, n_y_mocap>(S);
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_mocap];
+	const float innovation[n_y_mocap] {r(Y_mocap_x), r(Y_mocap_y), r(Y_mocap_z)};
+	const float noise[n_y_mocap] {R(Y_mocap_x), R(Y_mocap_y), R(Y_mocap_z)};
+	kf.fuseDirectSequential<X_x, X_y, X_z>(innovation, noise, 0.f, innov);
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_mocap]) {
 		if (!(_sensorFault & SENSOR_MOCAP)) {
@@ -180,10 +176,7 @@ void BlockLocalPositionEstimator::mocapCorrect()
 	}
 
 	// kalman filter correction always
-	Matrix<float, n_x, n_y_mocap> K = m_P * C.transpose() * S_I;
-	Vector<float, n_x> dx = K * r;
-	_x += dx;
-	m_P -= K * C * m_P;
+	applyCorrection(kf);
 }
 
 void BlockLocalPositionEstimator::mocapCheckTimeout()
@@ -93,33 +93,26 @@ void BlockLocalPositionEstimator::sonarCorrect()
 		cov = _param_lpe_snr_z.get() * _param_lpe_snr_z.get();
 	}
 
-	// sonar measurement matrix and noise matrix
-	Matrix<float, n_y_sonar, n_x> C;
-	C.setZero();
+	// covariance matrix (diagonal)
+	Vector<float, n_y_sonar> R;
+	R(Y_sonar_z) = cov;
+
+	// residual
 	// y = -(z - tz)
 	// TODO could add trig to make this an EKF correction
-	C(Y_sonar_z, X_z) = -1;	// measured altitude, negative down dir.
-	C(Y_sonar_z, X_tz) = 1;	// measured altitude, negative down dir.
+	Vector<float, n_y_sonar> r;
+	r(Y_sonar_z) = y(Y_sonar_z) + _x(X_z) - _x(X_tz);
 
-	// covariance matrix
-	SquareMatrix<float, n_y_sonar> R;
-	R.setZero();
-	R(0, 0) = cov;
-
-	// residual
-	Vector<float, n_y_sonar> r = y - C * _x;
-	// residual covariance
-	Matrix<float, n_y_sonar, n_y_sonar> S = C * m_P * C.transpose() + R;
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_sonar];
+	innov[Y_sonar_z] = kf.fuseSparse<X_z, X_tz>({-1.f, 1.f}, r(Y_sonar_z), R(Y_sonar_z));
 
 	// publish innovations
 	_pub_innov.get().hagl = r(0);
-	_pub_innov_var.get().hagl = S(0, 0);
-
-	// residual covariance, (inverse)
-	Matrix<float, n_y_sonar, n_y_sonar> S_I = inv<float, n_y_sonar>(S);
+	_pub_innov_var.get().hagl = innov[Y_sonar_z].variance;
 
 	// fault detection
-	float beta = (r.transpose()  * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_sonar]) {
 		if (!(_sensorFault & SENSOR_SONAR)) {
@@ -137,11 +130,7 @@ void BlockLocalPositionEstimator::sonarCorrect()
 
 	// kalman filter correction if no fault
 	if (!(_sensorFault & SENSOR_SONAR)) {
-		Matrix<float, n_x, n_y_sonar> K =
-			m_P * C.transpose() * S_I;
-		Vector<float, n_x> dx = K * r;
-		_x += dx;
-		m_P -= K * C * m_P;
+		applyCorrection(kf);
 	}
 }
 
@@ -118,32 +118,24 @@ void BlockLocalPositionEstimator::visionCorrect()
 		return;
 	}
 
-	// vision measurement matrix, measures position
-	Matrix<float, n_y_vision, n_x> C;
-	C.setZero();
-	C(Y_vision_x, X_x) = 1;
-	C(Y_vision_y, X_y) = 1;
-	C(Y_vision_z, X_z) = 1;
-
-	// noise matrix
-	Matrix<float, n_y_vision, n_y_vision> R;
-	R.setZero();
+	// noise matrix (diagonal)
+	Vector<float, n_y_vision> R;
 
 	// use std dev from vision data if available
 	if (_vision_eph > _param_lpe_vis_xy.get()) {
-		R(Y_vision_x, Y_vision_x) = _vision_eph * _vision_eph;
-		R(Y_vision_y, Y_vision_y) = _vision_eph * _vision_eph;
+		R(Y_vision_x) = _vision_eph * _vision_eph;
+		R(Y_vision_y) = _vision_eph * _vision_eph;
 
 	} else {
-		R(Y_vision_x, Y_vision_x) = _param_lpe_vis_xy.get() * _param_lpe_vis_xy.get();
-		R(Y_vision_y, Y_vision_y) = _param_lpe_vis_xy.get() * _param_lpe_vis_xy.get();
+		R(Y_vision_x) = _param_lpe_vis_xy.get() * _param_lpe_vis_xy.get();
+		R(Y_vision_y) = _param_lpe_vis_xy.get() * _param_lpe_vis_xy.get();
 	}
 
 	if (_vision_epv > _param_lpe_vis_z.get()) {
-		R(Y_vision_z, Y_vision_z) = _vision_epv * _vision_epv;
+		R(Y_vision_z) = _vision_epv * _vision_epv;
 
 	} else {
-		R(Y_vision_z, Y_vision_z) = _param_lpe_vis_z.get() * _param_lpe_vis_z.get();
+		R(Y_vision_z) = _param_lpe_vis_z.get() * _param_lpe_vis_z.get();
 	}
 
 	// vision delayed x
@@ -158,32 +150,36 @@ void BlockLocalPositionEstimator::visionCorrect()
 
 	Vector<float, n_x> x0 = _xDelay.get(i_hist);
 
-	// residual
-	Matrix<float, n_y_vision, 1> r = y - C * x0;
-	// residual covariance
-	Matrix<float, n_y_vision, n_y_vision> S = C * m_P * C.transpose() + R;
+	// residual, vision measures position
+	Vector<float, n_y_vision> r;
+	r(Y_vision_x) = y(Y_vision_x) - x0(X_x);
+	r(Y_vision_y) = y(Y_vision_y) - x0(X_y);
+	r(Y_vision_z) = y(Y_vision_z) - x0(X_z);
 
 	// publish innovations
-	_pub_innov.get().ev_hpos[0] = r(0, 0);
-	_pub_innov.get().ev_hpos[1] = r(1, 0);
-	_pub_innov.get().ev_vpos    = r(2, 0);
+	_pub_innov.get().ev_hpos[0] = r(0);
+	_pub_innov.get().ev_hpos[1] = r(1);
+	_pub_innov.get().ev_vpos    = r(2);
 	_pub_innov.get().ev_hvel[0] = NAN;
 	_pub_innov.get().ev_hvel[1] = NAN;
 	_pub_innov.get().ev_vvel    = NAN;
 
 	// publish innovation variances
-	_pub_innov_var.get().ev_hpos[0] = S(0, 0);
-	_pub_innov_var.get().ev_hpos[1] = S(1, 1);
-	_pub_innov_var.get().ev_vpos    = S(2, 2);
+	_pub_innov_var.get().ev_hpos[0] = m_P(X_x, X_x) + R(Y_vision_x);
+	_pub_innov_var.get().ev_hpos[1] = m_P(X_y, X_y) + R(Y_vision_y);
+	_pub_innov_var.get().ev_vpos    = m_P(X_z, X_z) + R(Y_vision_z);
 	_pub_innov_var.get().ev_hvel[0] = NAN;
 	_pub_innov_var.get().ev_hvel[1] = NAN;
 	_pub_innov_var.get().ev_vvel    = NAN;
 
-	// residual covariance, (inverse)
-	Matrix<float, n_y_vision, n_y_vision> S_I = inv<float, n_y_vision>(S);
+	CorrectionFilter kf = correctionFilter();
+	CorrectionFilter::Result innov[n_y_vision];
+	const float innovation[n_y_vision] {r(Y_vision_x), r(Y_vision_y), r(Y_vision_z)};
+	const float noise[n_y_vision] {R(Y_vision_x), R(Y_vision_y), R(Y_vision_z)};
+	kf.fuseDirectSequential<X_x, X_y, X_z>(innovation, noise, 0.f, innov);
 
 	// fault detection
-	float beta = (r.transpose() * (S_I * r))(0, 0);
+	float beta = kalman::normalizedInnovationSquared(innov);
 
 	if (beta > BETA_TABLE[n_y_vision]) {
 		if (!(_sensorFault & SENSOR_VISION)) {
@@ -198,10 +194,7 @@ void BlockLocalPositionEstimator::visionCorrect()
 
 	// kalman filter correction if no fault
 	if (!(_sensorFault & SENSOR_VISION)) {
-		Matrix<float, n_x, n_y_vision> K = m_P * C.transpose() * S_I;
-		Vector<float, n_x> dx = K * r;
-		_x += dx;
-		m_P -= K * C * m_P;
+		applyCorrection(kf);
 	}
 }
 
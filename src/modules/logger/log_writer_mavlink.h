@@ -34,9 +34,7 @@
 #pragma once
 
 #include <stdint.h>
-#include <uORB/Publication.hpp>
-#include <uORB/topics/ulog_stream.h>
-#include <uORB/topics/ulog_stream_ack.h>
+#include <lib/ulog/ULogStreamBuffer.hpp>
 
 namespace px4
 {
@@ -45,7 +43,7 @@ namespace logger
 
 /**
  * @class LogWriterMavlink
- * Writes logging data to uORB, and then sent via mavlink
+ * Writes logging data into the shared ULogStreamBuffer, from where it is sent via mavlink
  */
 class LogWriterMavlink
 {
@@ -71,14 +69,12 @@ public:
 		return _need_reliable_transfer;
 	}
 
-private:
+	/** time to wait for free buffer space for reliable data before the log is stopped [us] (ack timeout * max tries) */
+	static constexpr hrt_abstime RELIABLE_TIMEOUT = 50 * 50 * 1000;
 
-	/** publish message, wait for ack if needed & reset message */
-	int publish_message();
+private:
 
-	ulog_stream_s _ulog_stream_data{};
-	uORB::Publication<ulog_stream_s> _ulog_stream_pub{ORB_ID(ulog_stream)};
-	int _ulog_stream_ack_sub{-1};
+	ulog::ULogStreamBuffer *_buffer{nullptr};
 	bool _need_reliable_transfer{false};
 	bool _is_started{false};
 };
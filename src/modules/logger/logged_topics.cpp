@@ -212,6 +212,7 @@ void LoggedTopics::add_debug_topics()
 	add_topic("debug_key_value");
 	add_topic("debug_value");
 	add_topic("debug_vect");
+	add_topic("profiler_sample");
 	add_topic_multi("satellite_info", 1000, 2);
 }
 
@@ -0,0 +1,179 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mavlink_bandwidth_scheduler.h
+ * Allocation of the link bandwidth to the streams of a MAVLink instance.
+ *
+ * The streams are served by priority: the bandwidth left after the constant rate
+ * streams goes to the critical streams first, then to the high, normal and low
+ * priority ones. The first priority that does not fit is slowed down, the ones
+ * below run at the minimum rate multiplier. The budget follows the link, it backs
+ * off when messages do not fit the TX buffer and recovers slowly otherwise.
+ */
+
+#ifndef MAVLINK_BANDWIDTH_SCHEDULER_H_
+#define MAVLINK_BANDWIDTH_SCHEDULER_H_
+
+#include <math.h>
+#include <stdint.h>
+
+enum class MavlinkStreamPriority : uint8_t {
+	CRITICAL = 0,	///< vehicle state and operator feedback, throttled last
+	HIGH,		///< navigation and position
+	NORMAL,
+	LOW,		///< debug and raw sensor data, throttled first
+	COUNT
+};
+
+class MavlinkBandwidthScheduler
+{
+public:
+	static constexpr int PRIORITY_COUNT = static_cast<int>(MavlinkStreamPriority::COUNT);
+
+	/** lowest rate multiplier, so that every stream still sends something */
+	static constexpr float RATE_MULT_MIN = 0.05f;
+
+	/** TX buffer space [B] each priority level leaves to the ones above, about two messages */
+	static constexpr unsigned TX_RESERVE_STEP = 128;
+
+	/**
+	 * Start collecting the bandwidth demand of the streams.
+	 */
+	void begin()
+	{
+		_fixed = 0.f;
+
+		for (int p = 0; p < PRIORITY_COUNT; p++) {
+			_demand[p] = 0.f;
+		}
+	}
+
+	/**
+	 * Add a stream that is never scaled.
+	 * @param bytes_per_second bandwidth of the stream at its configured rate
+	 */
+	void add_fixed(float bytes_per_second) { _fixed += bytes_per_second; }
+
+	/**
+	 * Add a stream to its priority level.
+	 * @param bytes_per_second bandwidth of the stream at its configured rate
+	 */
+	void add_demand(MavlinkStreamPriority priority, float bytes_per_second) { _demand[index(priority)] += bytes_per_second; }
+
+	/**
+	 * Allocate the budget to the priority levels, highest first. A level never gets more than
+	 * its configured rate, the multipliers are between RATE_MULT_MIN and 1.
+	 * @param budget [B/s] for all streams, including the fixed ones
+	 */
+	void allocate(float budget)
+	{
+		float remaining = budget - _fixed;
+		float demand_total = 0.f;
+		float allocated = 0.f;
+
+		for (int p = 0; p < PRIORITY_COUNT; p++) {
+			float mult = 1.f;
+
+			if (_demand[p] > 0.f) {
+				mult = fminf(fmaxf(remaining / _demand[p], RATE_MULT_MIN), 1.f);
+				remaining = fmaxf(remaining - mult * _demand[p], 0.f);
+
+				demand_total += _demand[p];
+				allocated += mult * _demand[p];
+			}
+
+			_rate_mult[p] = mult;
+		}
+
+		_rate_mult_total = (demand_total > 0.f) ? (allocated / demand_total) : 1.f;
+	}
+
+	/**
+	 * Follow the link capacity, called once per measurement period.
+	 * @param tx_rate [B/s] sent during the period
+	 * @param tx_buffer_overruns messages that did not fit the TX buffer during the period
+	 * @param datarate [B/s] configured data rate
+	 */
+	void update_link(float tx_rate, unsigned tx_buffer_overruns, float datarate)
+	{
+		if ((tx_buffer_overruns > 0) && (datarate > 0.f)) {
+			// the link carries about what was sent, back off below it but at most by half
+			_link_mult = fmaxf(0.5f * _link_mult, fminf(0.8f * _link_mult, 0.9f * tx_rate / datarate));
+
+		} else {
+			_link_mult *= 1.025f;
+		}
+
+		_link_mult = fminf(fmaxf(_link_mult, RATE_MULT_MIN), 1.f);
+	}
+
+	/** rate multiplier of a priority level from the last allocation */
+	float rate_mult(MavlinkStreamPriority priority) const { return _rate_mult[index(priority)]; }
+
+	/** allocated over requested bandwidth of all scaled streams */
+	float rate_mult_total() const { return _rate_mult_total; }
+
+	/** fraction of the configured data rate the link currently carries */
+	float link_mult() const { return _link_mult; }
+
+	/** TX buffer space [B] a stream of the priority has to leave free */
+	static constexpr unsigned tx_reserve(MavlinkStreamPriority priority) { return index(priority) * TX_RESERVE_STEP; }
+
+	static const char *priority_name(MavlinkStreamPriority priority)
+	{
+		switch (priority) {
+		case MavlinkStreamPriority::CRITICAL: return "crit";
+
+		case MavlinkStreamPriority::HIGH: return "high";
+
+		case MavlinkStreamPriority::NORMAL: return "norm";
+
+		case MavlinkStreamPriority::LOW: return "low";
+
+		default: return "";
+		}
+	}
+
+private:
+	static constexpr int index(MavlinkStreamPriority priority) { return static_cast<int>(priority); }
+
+	float _fixed{0.f};
+	float _demand[PRIORITY_COUNT] {};
+	float _rate_mult[PRIORITY_COUNT] {1.f, 1.f, 1.f, 1.f};
+	float _rate_mult_total{1.f};
+	float _link_mult{1.f};
+};
+
+#endif /* MAVLINK_BANDWIDTH_SCHEDULER_H_ */
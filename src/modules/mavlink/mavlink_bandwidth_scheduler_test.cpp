@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Test the priority allocation and the link capacity estimate of the stream bandwidth scheduler.
+ * Run this test only using make tests TESTFILTER=mavlink_bandwidth_scheduler
+ */
+
+#include <gtest/gtest.h>
+
+#include "mavlink_bandwidth_scheduler.h"
+
+using P = MavlinkStreamPriority;
+
+TEST(MavlinkBandwidthSchedulerTest, budgetSufficient)
+{
+	MavlinkBandwidthScheduler scheduler;
+	scheduler.begin();
+	scheduler.add_fixed(100.f);
+	scheduler.add_demand(P::CRITICAL, 200.f);
+	scheduler.add_demand(P::NORMAL, 300.f);
+	scheduler.add_demand(P::LOW, 400.f);
+	scheduler.allocate(1000.f);
+
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::CRITICAL), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::HIGH), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::NORMAL), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::LOW), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult_total(), 1.f);
+}
+
+TEST(MavlinkBandwidthSchedulerTest, lowPriorityThrottledFirst)
+{
+	MavlinkBandwidthScheduler scheduler;
+	scheduler.begin();
+	scheduler.add_fixed(100.f);
+	scheduler.add_demand(P::CRITICAL, 200.f);
+	scheduler.add_demand(P::HIGH, 200.f);
+	scheduler.add_demand(P::NORMAL, 1000.f);
+	scheduler.add_demand(P::LOW, 1000.f);
+	scheduler.allocate(1000.f);
+
+	// 500 B/s left after fixed, critical and high go to the normal streams
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::CRITICAL), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::HIGH), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::NORMAL), 0.5f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::LOW), MavlinkBandwidthScheduler::RATE_MULT_MIN);
+	EXPECT_NEAR(scheduler.rate_mult_total(), (200.f + 200.f + 500.f + 50.f) / 2400.f, 1e-6f);
+
+	// the link gets worse, the high priority streams are throttled before the critical ones
+	scheduler.allocate(400.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::CRITICAL), 1.f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::HIGH), 0.5f);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::NORMAL), MavlinkBandwidthScheduler::RATE_MULT_MIN);
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::LOW), MavlinkBandwidthScheduler::RATE_MULT_MIN);
+}
+
+TEST(MavlinkBandwidthSchedulerTest, fixedExceedsBudget)
+{
+	MavlinkBandwidthScheduler scheduler;
+	scheduler.begin();
+	scheduler.add_fixed(2000.f);
+	scheduler.add_demand(P::CRITICAL, 100.f);
+	scheduler.allocate(1000.f);
+
+	EXPECT_FLOAT_EQ(scheduler.rate_mult(P::CRITICAL), MavlinkBandwidthScheduler::RATE_MULT_MIN);
+}
+
+TEST(MavlinkBandwidthSchedulerTest, linkBackoffAndRecovery)
+{
+	MavlinkBandwidthScheduler scheduler;
+	EXPECT_FLOAT_EQ(scheduler.link_mult(), 1.f);
+
+	// overruns while 600 B/s got through a 1000 B/s configuration: back off below the measured rate
+	scheduler.update_link(600.f, 3, 1000.f);
+	EXPECT_FLOAT_EQ(scheduler.link_mult(), 0.54f);
+
+	// never more than half per update
+	scheduler.update_link(10.f, 3, 1000.f);
+	EXPECT_FLOAT_EQ(scheduler.link_mult(), 0.27f);
+
+	// slow recovery without overruns, up to the configured rate
+	scheduler.update_link(270.f, 0, 1000.f);
+	EXPECT_NEAR(scheduler.link_mult(), 0.27f * 1.025f, 1e-6f);
+
+	for (int i = 0; i < 100; i++) {
+		scheduler.update_link(1000.f, 0, 1000.f);
+	}
+
+	EXPECT_FLOAT_EQ(scheduler.link_mult(), 1.f);
+
+	for (int i = 0; i < 100; i++) {
+		scheduler.update_link(0.f, 1, 1000.f);
+	}
+
+	EXPECT_FLOAT_EQ(scheduler.link_mult(), MavlinkBandwidthScheduler::RATE_MULT_MIN);
+}
+
+TEST(MavlinkBandwidthSchedulerTest, txReserve)
+{
+	EXPECT_EQ(MavlinkBandwidthScheduler::tx_reserve(P::CRITICAL), 0u);
+	EXPECT_LT(MavlinkBandwidthScheduler::tx_reserve(P::CRITICAL), MavlinkBandwidthScheduler::tx_reserve(P::HIGH));
+	EXPECT_LT(MavlinkBandwidthScheduler::tx_reserve(P::HIGH), MavlinkBandwidthScheduler::tx_reserve(P::NORMAL));
+	EXPECT_LT(MavlinkBandwidthScheduler::tx_reserve(P::NORMAL), MavlinkBandwidthScheduler::tx_reserve(P::LOW));
+}
@@ -706,6 +706,29 @@ Mavlink::get_free_tx_buf()
 	return buf_free;
 }
 
+bool
+Mavlink::tx_buffer_available(unsigned tx_buf_free, unsigned size, MavlinkStreamPriority priority)
+{
+#if defined(__PX4_NUTTX)
+
+	// only serial ports report the space left in the TX buffer
+	if (get_protocol() == Protocol::SERIAL) {
+		if (tx_buf_free < size + MavlinkBandwidthScheduler::tx_reserve(priority)) {
+			// lower priorities defer on purpose to keep the reserve free, only a
+			// critical stream that does not fit shows that the link is congested
+			if (priority == MavlinkStreamPriority::CRITICAL) {
+				_tx_deferred++;
+			}
+
+			return false;
+		}
+	}
+
+#endif // __PX4_NUTTX
+
+	return true;
+}
+
 void Mavlink::send_start(int length)
 {
 	pthread_mutex_lock(&_send_mutex);
@@ -1401,16 +1424,17 @@ Mavlink::close_shell()
 void
 Mavlink::update_rate_mult()
 {
-	float const_rate = 0.0f;
-	float rate = 0.0f;
+	_bandwidth_scheduler.begin();
 
-	/* scale down rates if their theoretical bandwidth is exceeding the link bandwidth */
+	/* collect the bandwidth the streams need at their configured rate */
 	for (const auto &stream : _streams) {
+		const float rate = (stream->get_interval() > 0) ? stream->get_size_avg() * 1000000.0f / stream->get_interval() : 0;
+
 		if (stream->const_rate()) {
-			const_rate += (stream->get_interval() > 0) ? stream->get_size_avg() * 1000000.0f / stream->get_interval() : 0;
+			_bandwidth_scheduler.add_fixed(rate);
 
 		} else {
-			rate += (stream->get_interval() > 0) ? stream->get_size_avg() * 1000000.0f / stream->get_interval() : 0;
+			_bandwidth_scheduler.add_demand(stream->get_priority(), rate);
 		}
 	}
 
@@ -1420,13 +1444,10 @@ Mavlink::update_rate_mult()
 		mavlink_ulog_streaming_rate_inv = 1.0f - _mavlink_ulog->current_data_rate();
 	}
 
-	/* scale up and down as the link permits */
-	float bandwidth_mult = (float)(_datarate * mavlink_ulog_streaming_rate_inv - const_rate) / rate;
-
-	/* if we do not have flow control, limit to the set data rate */
-	if (!get_flow_control_enabled()) {
-		bandwidth_mult = fminf(1.0f, bandwidth_mult);
-	}
+	/* the configured data rate, as far as the link currently carries it.
+	 * The rate multipliers never exceed 1, also with flow control: streams are not sent faster
+	 * than configured, a link with spare bandwidth is left to the unlimited rate streams. */
+	float budget = _datarate * mavlink_ulog_streaming_rate_inv * _bandwidth_scheduler.link_mult();
 
 	float hardware_mult = 1.0f;
 
@@ -1450,11 +1471,24 @@ Mavlink::update_rate_mult()
 		hardware_mult *= _radio_status_mult;
 	}
 
-	/* pick the minimum from bandwidth mult and hardware mult as limit */
-	_rate_mult = fminf(bandwidth_mult, hardware_mult);
+	/* highest priority first, the lower priorities are throttled until it fits */
+	_bandwidth_scheduler.allocate(budget * hardware_mult);
 
-	/* ensure the rate multiplier never drops below 5% so that something is always sent */
-	_rate_mult = math::constrain(_rate_mult, 0.05f, 1.0f);
+	_rate_mult = _bandwidth_scheduler.rate_mult_total();
+}
+
+void
+Mavlink::update_link_capacity(float dt)
+{
+	const uint32_t tx_buffer_overruns = _tstatus.tx_buffer_overruns - _tx_buffer_overruns_last;
+	_tx_buffer_overruns_last = _tstatus.tx_buffer_overruns;
+
+	_bandwidth_scheduler.update_link(_tstatus.tx_rate_avg, tx_buffer_overruns + _tx_deferred, _datarate);
+	_tx_deferred = 0;
+
+	for (const auto &stream : _streams) {
+		stream->update_rate_achieved(dt);
+	}
 }
 
 void
@@ -2400,9 +2434,11 @@ Mavlink::task_main(int argc, char *argv[])
 
 		check_requested_subscriptions();
 
-		/* update streams */
+		/* update streams, the free TX buffer space is read once for all of them */
+		unsigned tx_buf_free = get_free_tx_buf();
+
 		for (const auto &stream : _streams) {
-			stream->update(t);
+			stream->update(t, tx_buf_free);
 
 			if (!_first_heartbeat_sent) {
 				if (_mode == MAVLINK_MODE_IRIDIUM) {
@@ -2430,7 +2466,7 @@ Mavlink::task_main(int argc, char *argv[])
 					_mavlink_ulog->start_ack_received();
 				}
 
-				int ret = _mavlink_ulog->handle_update(get_channel());
+				int ret = _mavlink_ulog->handle_update(get_channel(), get_free_tx_buf());
 
 				if (ret < 0) { //abort the streaming on error
 					if (ret != -1) {
@@ -2503,6 +2539,8 @@ Mavlink::task_main(int argc, char *argv[])
 				_bytes_tx = 0;
 				_bytes_txerr = 0;
 				_bytes_rx = 0;
+
+				update_link_capacity(dt);
 			}
 
 			_bytes_timestamp = t;
@@ -2814,14 +2852,15 @@ Mavlink::display_status()
 	printf("\t  tx: %.1f B/s\n", (double)_tstatus.tx_rate_avg);
 	printf("\t  txerr: %.1f B/s\n", (double)_tstatus.tx_error_rate_avg);
 	printf("\t  tx rate mult: %.3f\n", (double)_rate_mult);
+	printf("\t  tx link capacity: %.0f%%\n", (double)(100.f * _bandwidth_scheduler.link_mult()));
 	printf("\t  tx rate max: %i B/s\n", _datarate);
 	printf("\t  rx: %.1f B/s\n", (double)_tstatus.rx_rate_avg);
 	printf("\t  rx loss: %.1f%%\n", (double)_tstatus.rx_message_lost_rate);
 	_receiver.print_detailed_rx_stats();
 
 	if (_mavlink_ulog) {
-		printf("\tULog rate: %.1f%% of max %.1f%%\n", (double)_mavlink_ulog->current_data_rate() * 100.,
-		       (double)_mavlink_ulog->maximum_data_rate() * 100.);
+		printf("\tULog rate: %.1f%% of max %.1f%%, window: %u\n", (double)_mavlink_ulog->current_data_rate() * 100.,
+		       (double)_mavlink_ulog->maximum_data_rate() * 100., _mavlink_ulog->window());
 	}
 
 	printf("\tFTP enabled: %s, TX enabled: %s\n",
@@ -2871,14 +2910,14 @@ Mavlink::display_status()
 void
 Mavlink::display_status_streams()
 {
-	printf("\t%-20s%-16s %s\n", "Name", "Rate Config (current) [Hz]", "Message Size (if active) [B]");
-
-	const float rate_mult = _rate_mult;
+	printf("\t%-30s%-5s%-26s%-10s %s\n", "Name", "Prio", "Rate Config (scheduled) [Hz]", "Sent [Hz]",
+	       "Message Size (if active) [B]");
 
 	for (const auto &stream : _streams) {
 		const int interval = stream->get_interval();
 		const unsigned size = stream->get_size();
-		char rate_str[20];
+		const MavlinkStreamPriority priority = stream->get_priority();
+		char rate_str[28];
 
 		if (interval < 0) {
 			strcpy(rate_str, "unlimited");
@@ -2887,11 +2926,13 @@ Mavlink::display_status_streams()
 			float rate = 1000000.0f / (float)interval;
 			// Note that the actual current rate can be lower if the associated uORB topic updates at a
 			// lower rate.
-			float rate_current = stream->const_rate() ? rate : rate * rate_mult;
-			snprintf(rate_str, sizeof(rate_str), "%6.2f (%.3f)", (double)rate, (double)rate_current);
+			float rate_scheduled = stream->const_rate() ? rate : rate * get_rate_mult(priority);
+			snprintf(rate_str, sizeof(rate_str), "%6.2f (%.3f)", (double)rate, (double)rate_scheduled);
 		}
 
-		printf("\t%-30s%-16s", stream->get_name(), rate_str);
+		printf("\t%-30s%-5s%-26s%9.2f ", stream->get_name(),
+		       stream->const_rate() ? "-" : MavlinkBandwidthScheduler::priority_name(priority),
+		       rate_str, (double)stream->get_rate_achieved());
 
 		if (size > 0) {
 			printf(" %3i\n", size);
@@ -2900,6 +2941,15 @@ Mavlink::display_status_streams()
 			printf("\n");
 		}
 	}
+
+	printf("\tlink capacity: %.0f%% of %d B/s, priority rate mult: ", (double)(100.f * _bandwidth_scheduler.link_mult()),
+	       _datarate);
+
+	for (int p = 0; p < MavlinkBandwidthScheduler::PRIORITY_COUNT; p++) {
+		const MavlinkStreamPriority priority = static_cast<MavlinkStreamPriority>(p);
+		printf("%s %.3f%s", MavlinkBandwidthScheduler::priority_name(priority), (double)get_rate_mult(priority),
+		       (p < MavlinkBandwidthScheduler::PRIORITY_COUNT - 1) ? ", " : "\n");
+	}
 }
 
 int
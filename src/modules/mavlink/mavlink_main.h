@@ -78,6 +78,7 @@
 #include <uORB/topics/vehicle_command_ack.h>
 #include <uORB/topics/vehicle_status.h>
 
+#include "mavlink_bandwidth_scheduler.h"
 #include "mavlink_command_sender.h"
 #include "mavlink_messages.h"
 #include "mavlink_receiver.h"
@@ -88,6 +89,7 @@
 #define DEFAULT_DEVICE_NAME     "/dev/ttyS1"
 
 #define HASH_PARAM              "_HASH_CHECK"
+#define GENERATION_PARAM        "_PARAM_GEN"
 
 #if defined(CONFIG_NET) || defined(__PX4_POSIX)
 # define MAVLINK_UDP
@@ -407,6 +409,22 @@ public:
 
 	float			get_rate_mult() const { return _rate_mult; }
 
+	/**
+	 * Rate multiplier the bandwidth scheduler assigned to a stream priority
+	 */
+	float			get_rate_mult(MavlinkStreamPriority priority) const { return _bandwidth_scheduler.rate_mult(priority); }
+
+	/**
+	 * Check if a message of a stream fits the TX buffer, leaving the reserve of
+	 * higher priority streams free.
+	 *
+	 * @param tx_buf_free	Free TX buffer space in bytes, from get_free_tx_buf() once per loop iteration.
+	 * @param size		Message size in bytes.
+	 * @param priority	Priority of the stream.
+	 * @return		true if the stream can send now.
+	 */
+	bool			tx_buffer_available(unsigned tx_buf_free, unsigned size, MavlinkStreamPriority priority);
+
 	float			get_baudrate() { return _baudrate; }
 
 	/* Functions for waiting to start transmission until message received. */
@@ -585,6 +603,10 @@ private:
 	int			_datarate{1000};		///< data rate for normal streams (attitude, position, etc.)
 	float			_rate_mult{1.0f};
 
+	MavlinkBandwidthScheduler	_bandwidth_scheduler{};
+	unsigned		_tx_deferred{0};		///< critical stream messages that did not fit the TX buffer since the last link update
+	uint32_t		_tx_buffer_overruns_last{0};
+
 	bool			_radio_status_available{false};
 	bool			_radio_status_critical{false};
 	float			_radio_status_mult{1.0f};
@@ -734,10 +756,17 @@ private:
 	void configure_sik_radio();
 
 	/**
-	 * Update rate mult so total bitrate will be equal to _datarate.
+	 * Allocate the bandwidth to the streams by priority so total bitrate will be equal to _datarate.
 	 */
 	void update_rate_mult();
 
+	/**
+	 * Update the link capacity of the bandwidth scheduler and the achieved stream rates.
+	 *
+	 * @param dt	Measurement period in seconds.
+	 */
+	void update_link_capacity(float dt);
+
 #if defined(MAVLINK_UDP)
 	void find_broadcast_address();
 
@@ -68,6 +68,8 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 
 			if (req_list.target_system == mavlink_system.sysid &&
 			    (req_list.target_component == mavlink_system.compid || req_list.target_component == MAV_COMP_ID_ALL)) {
+				_send_changed_only = false;
+
 				if (_send_all_index < 0) {
 					_send_all_index = PARAM_HASH;
 
@@ -116,6 +118,14 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 					return;
 				}
 
+				/* Setting the generation token requests all params changed since then */
+				if (strncmp(name, GENERATION_PARAM, sizeof(name)) == 0) {
+					uint32_t token;
+					memcpy(&token, &set.param_value, sizeof(token));
+					start_send_changed_since(token);
+					return;
+				}
+
 				/* attempt to find parameter, set and send it */
 				param_t param = param_find_no_notification(name);
 
@@ -189,6 +199,10 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 						memcpy(&param_value.param_value, &hash, sizeof(hash));
 						mavlink_msg_param_value_send_struct(_mavlink->get_channel(), &param_value);
 
+					} else if (strncmp(req_read.param_id, GENERATION_PARAM, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN) == 0) {
+						/* return the token to use for a later delta sync */
+						send_generation(generation_token(param_generation()));
+
 					} else {
 						/* local name buffer to enforce null-terminated string */
 						char name[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN + 1];
@@ -488,14 +502,22 @@ MavlinkParametersManager::send_one()
 			return true;
 		}
 
-		/* look for the first parameter which is used */
+		/* a delta sync starts with the token for the next one */
+		if (_send_generation) {
+			send_generation(_send_generation_token);
+			_send_generation = false;
+			return true;
+		}
+
+		/* look for the first parameter which is used (and changed if requested) */
 		param_t p;
 
 		do {
 			/* walk through all parameters, including unused ones */
 			p = param_for_index(_send_all_index);
 			_send_all_index++;
-		} while (p != PARAM_INVALID && !param_used(p));
+		} while (p != PARAM_INVALID && (!param_used(p)
+						|| (_send_changed_only && !param_changed_since(p, _send_changed_since))));
 
 		if (p != PARAM_INVALID) {
 			send_param(p);
@@ -503,6 +525,7 @@ MavlinkParametersManager::send_one()
 
 		if ((p == PARAM_INVALID) || (_send_all_index >= (int) param_count())) {
 			_send_all_index = -1;
+			_send_changed_only = false;
 			return false;
 
 		} else {
@@ -589,6 +612,50 @@ MavlinkParametersManager::send_param(param_t param, int component_id)
 	return 0;
 }
 
+void
+MavlinkParametersManager::send_generation(uint32_t token)
+{
+	mavlink_param_value_t msg{};
+	msg.param_count = param_count_used();
+	msg.param_index = -1;
+	strncpy(msg.param_id, GENERATION_PARAM, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+	msg.param_type = MAV_PARAM_TYPE_UINT32;
+	memcpy(&msg.param_value, &token, sizeof(token));
+	mavlink_msg_param_value_send_struct(_mavlink->get_channel(), &msg);
+}
+
+uint32_t
+MavlinkParametersManager::generation_token(uint16_t generation)
+{
+	// Generations restart on every boot, so tag them with an identifier of this boot.
+	// It only needs to differ between consecutive boots, the boot time jitter is good enough.
+	static uint16_t boot_id = 0;
+
+	while (boot_id == 0) {
+		const hrt_abstime now = hrt_absolute_time();
+		boot_id = (uint16_t)(now ^ (now >> 16));
+	}
+
+	return ((uint32_t)boot_id << 16) | generation;
+}
+
+void
+MavlinkParametersManager::start_send_changed_since(uint32_t token)
+{
+	const uint16_t generation = param_generation();
+	const uint16_t since = token & 0xffff;
+
+	_send_generation_token = generation_token(generation);
+	_send_generation = true;
+
+	// generations are only comparable within the same boot and a limited window
+	_send_changed_only = ((token >> 16) == (_send_generation_token >> 16)) && ((uint16_t)(generation - since) < 0x8000);
+	_send_changed_since = since;
+
+	// a full transfer is sent if the token is not valid (anymore)
+	_send_all_index = 0;
+}
+
 void MavlinkParametersManager::request_next_uavcan_parameter()
 {
 	// Request a parameter if we are not already waiting on a response and if the list is not empty
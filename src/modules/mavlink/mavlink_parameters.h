@@ -77,6 +77,11 @@ public:
 private:
 	int		_send_all_index{-1};
 
+	bool		_send_changed_only{false};	///< restrict the transfer to params changed since _send_changed_since
+	uint16_t	_send_changed_since{0};
+	bool		_send_generation{false};	///< send _send_generation_token before the first param
+	uint32_t	_send_generation_token{0};
+
 	/* do not allow top copying this class */
 	MavlinkParametersManager(MavlinkParametersManager &);
 	MavlinkParametersManager &operator = (const MavlinkParametersManager &);
@@ -103,6 +108,23 @@ protected:
 
 	int send_param(param_t param, int component_id = -1);
 
+	/**
+	 * Send the generation token, which identifies the current state of the parameters.
+	 * It contains a per-boot identifier in the upper and the parameter generation in the lower 16 bits.
+	 */
+	void send_generation(uint32_t token);
+
+	/**
+	 * Get the generation token for a parameter generation (@see param_generation())
+	 */
+	static uint32_t generation_token(uint16_t generation);
+
+	/**
+	 * Start sending all params changed after the generation of a token previously sent to the
+	 * ground station (delta sync). Falls back to sending all params if the token is not valid anymore.
+	 */
+	void start_send_changed_since(uint32_t token);
+
 	// Item of a single-linked list to store requested uavcan parameters
 	struct _uavcan_open_request_list_item {
 		uavcan_parameter_request_s req;
@@ -54,7 +54,7 @@ MavlinkStream::MavlinkStream(Mavlink *mavlink) :
  * Update subscriptions and send message if necessary
  */
 int
-MavlinkStream::update(const hrt_abstime &t)
+MavlinkStream::update(const hrt_abstime &t, unsigned &tx_buf_free)
 {
 	update_data();
 
@@ -66,6 +66,8 @@ MavlinkStream::update(const hrt_abstime &t)
 		// on the link scheduling
 		if (send()) {
 			_last_sent = hrt_absolute_time();
+			_send_count++;
+			tx_buf_free = (tx_buf_free > get_size()) ? tx_buf_free - get_size() : 0;
 
 			if (!_first_message_sent) {
 				_first_message_sent = true;
@@ -85,7 +87,7 @@ MavlinkStream::update(const hrt_abstime &t)
 	int interval = _interval;
 
 	if (!const_rate()) {
-		interval /= _mavlink->get_rate_mult();
+		interval /= _mavlink->get_rate_mult(get_priority());
 	}
 
 	// We don't need to send anything if the inverval is 0. send() will be called manually.
@@ -108,12 +110,19 @@ MavlinkStream::update(const hrt_abstime &t)
 	if (unlimited_rate || (dt > (interval - (_mavlink->get_main_loop_delay() / 10) * 3))) {
 		// interval expired, send message
 
+		// leave the TX buffer space to higher priority streams, try again on the next iteration
+		if (!_mavlink->tx_buffer_available(tx_buf_free, get_size(), get_priority())) {
+			return -1;
+		}
+
 		// If the interval is non-zero and dt is smaller than 1.5 times the interval
 		// do not use the actual time but increment at a fixed rate, so that processing delays do not
 		// distort the average rate. The check of the maximum interval is done to ensure that after a
 		// long time not sending anything, sending multiple messages in a short time is avoided.
 		if (send()) {
 			_last_sent = ((interval > 0) && ((int64_t)(1.5f * interval) > dt)) ? _last_sent + interval : t;
+			_send_count++;
+			tx_buf_free = (tx_buf_free > get_size()) ? tx_buf_free - get_size() : 0;
 
 			if (!_first_message_sent) {
 				_first_message_sent = true;
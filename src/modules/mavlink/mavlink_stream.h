@@ -45,6 +45,8 @@
 #include <px4_platform_common/module_params.h>
 #include <containers/List.hpp>
 
+#include "mavlink_bandwidth_scheduler.h"
+
 class Mavlink;
 
 class MavlinkStream : public ListNode<MavlinkStream *>
@@ -76,9 +78,11 @@ public:
 	int get_interval() { return _interval; }
 
 	/**
+	 * @param tx_buf_free free TX buffer space [B] read once per main loop iteration,
+	 *                    reduced by the size of the messages sent
 	 * @return 0 if updated / sent, -1 if unchanged
 	 */
-	int update(const hrt_abstime &t);
+	int update(const hrt_abstime &t, unsigned &tx_buf_free);
 	virtual const char *get_name() const = 0;
 	virtual uint16_t get_id() = 0;
 
@@ -87,6 +91,11 @@ public:
 	 */
 	virtual bool const_rate() { return false; }
 
+	/**
+	 * @return priority of the stream when the link bandwidth is short
+	 */
+	virtual MavlinkStreamPriority get_priority() const { return MavlinkStreamPriority::NORMAL; }
+
 	/**
 	 * Get maximal total messages size on update
 	 */
@@ -122,6 +131,22 @@ public:
 	 */
 	void reset_last_sent() { _last_sent = 0; }
 
+	/**
+	 * @return the rate in Hz the stream was sent at during the last measurement period
+	 */
+	float get_rate_achieved() const { return _rate_achieved; }
+
+	/**
+	 * End a measurement period of the achieved rate
+	 *
+	 * @param dt length of the period in seconds
+	 */
+	void update_rate_achieved(float dt)
+	{
+		_rate_achieved = (dt > 0.f) ? (_send_count / dt) : 0.f;
+		_send_count = 0;
+	}
+
 protected:
 	Mavlink      *const _mavlink;
 	int _interval{1000000};		///< if set to negative value = unlimited rate
@@ -139,6 +164,9 @@ protected:
 private:
 	hrt_abstime _last_sent{0};
 	bool _first_message_sent{false};
+
+	uint16_t _send_count{0};	///< messages sent in the current measurement period
+	float _rate_achieved{0.f};
 };
 
 
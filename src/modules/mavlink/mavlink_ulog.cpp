@@ -56,34 +56,41 @@ MavlinkULog::MavlinkULog(int datarate, float max_rate_factor, uint8_t target_sys
 				      (MAVLINK_MSG_ID_LOGGING_DATA_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES)))),
 	  _current_rate_factor(max_rate_factor)
 {
-	// make sure we won't read any old messages
-	while (_ulog_stream_sub.update()) {
-
-	}
-
+	_buffer = ulog::ULogStreamBuffer::instance();
 	_waiting_for_initial_ack = true;
-	_last_sent_time = hrt_absolute_time(); //(ab)use this timestamp during initialization
-	_next_rate_check = _last_sent_time + _rate_calculation_delta_t * 1.e6f;
+	_initial_ack_wait_start = hrt_absolute_time();
+	_next_rate_check = _initial_ack_wait_start + _rate_calculation_delta_t * 1.e6f;
 }
 
 void MavlinkULog::start_ack_received()
 {
 	if (_waiting_for_initial_ack) {
-		_last_sent_time = 0;
 		_waiting_for_initial_ack = false;
 		PX4_DEBUG("got logger ack");
 	}
 }
 
-int MavlinkULog::handle_update(mavlink_channel_t channel)
+void MavlinkULog::send(mavlink_channel_t channel, const ulog::ULogStreamBuffer::Slot &slot)
+{
+	if (slot.need_ack) {
+		mavlink_msg_logging_data_acked_send(channel, _target_system, _target_component, slot.sequence, slot.length,
+						    slot.first_message_offset, slot.data);
+
+	} else {
+		mavlink_msg_logging_data_send(channel, _target_system, _target_component, slot.sequence, slot.length,
+					      slot.first_message_offset, slot.data);
+	}
+}
+
+int MavlinkULog::handle_update(mavlink_channel_t channel, unsigned free_tx_buf)
 {
-	static_assert(sizeof(ulog_stream_s::data) == MAVLINK_MSG_LOGGING_DATA_FIELD_DATA_LEN,
-		      "Invalid uorb ulog_stream.data length");
-	static_assert(sizeof(ulog_stream_s::data) == MAVLINK_MSG_LOGGING_DATA_ACKED_FIELD_DATA_LEN,
-		      "Invalid uorb ulog_stream.data length");
+	static_assert(ulog::ULogStreamBuffer::DATA_LEN == MAVLINK_MSG_LOGGING_DATA_FIELD_DATA_LEN,
+		      "Invalid ULogStreamBuffer data length");
+	static_assert(ulog::ULogStreamBuffer::DATA_LEN == MAVLINK_MSG_LOGGING_DATA_ACKED_FIELD_DATA_LEN,
+		      "Invalid ULogStreamBuffer data length");
 
 	if (_waiting_for_initial_ack) {
-		if (hrt_elapsed_time(&_last_sent_time) > 3e5) {
+		if (hrt_elapsed_time(&_initial_ack_wait_start) > 3e5) {
 			PX4_WARN("no ack from logger (is it running?)");
 			return -1;
 		}
@@ -91,83 +98,65 @@ int MavlinkULog::handle_update(mavlink_channel_t channel)
 		return 0;
 	}
 
-	// check if we're waiting for an ACK
-	if (_last_sent_time) {
-		bool check_for_updates = false;
-
-		if (_ack_received) {
-			_last_sent_time = 0;
-			check_for_updates = true;
+	if (!_buffer) {
+		return -ENOMEM;
+	}
 
-		} else {
+	static constexpr unsigned message_len = MAVLINK_MSG_ID_LOGGING_DATA_ACKED_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+	hrt_abstime now = hrt_absolute_time();
 
-			if (hrt_elapsed_time(&_last_sent_time) > ulog_stream_ack_s::ACK_TIMEOUT * 1000) {
-				if (++_sent_tries > ulog_stream_ack_s::ACK_MAX_TRIES) {
-					return -ETIMEDOUT;
+	// the buffer stays locked from selecting a slot until it is marked as sent, so that a log start or
+	// stop (reset of the buffer) cannot reuse the slot in between
+	_buffer->lock();
+	bool shrink_window = false;
 
-				} else {
-					PX4_DEBUG("re-sending ulog mavlink message (try=%i)", _sent_tries);
-					_last_sent_time = hrt_absolute_time();
+	// retransmit acked messages that timed out first (only those, the rest of the window is still in flight)
+	ulog::ULogStreamBuffer::Slot *slot;
 
-					const ulog_stream_s &ulog_data = _ulog_stream_sub.get();
+	while ((_current_num_msgs < _max_num_messages) && (free_tx_buf >= message_len)
+	       && (slot = _buffer->retransmit_candidate(now, ACK_TIMEOUT))) {
 
-					mavlink_logging_data_acked_t msg;
-					msg.sequence = ulog_data.msg_sequence;
-					msg.length = ulog_data.length;
-					msg.first_message_offset = ulog_data.first_message_offset;
-					msg.target_system = _target_system;
-					msg.target_component = _target_component;
-					memcpy(msg.data, ulog_data.data, sizeof(msg.data));
-					mavlink_msg_logging_data_acked_send_struct(channel, &msg);
-				}
-			}
+		if (slot->tries >= ACK_MAX_TRIES) {
+			_buffer->mark_sent(slot, now);
+			_buffer->unlock();
+			return -ETIMEDOUT;
 		}
 
-		if (!check_for_updates) {
-			return 0;
+		PX4_DEBUG("re-sending ulog mavlink message %i (try=%i)", slot->sequence, slot->tries + 1);
+
+		// the link is congested: shrink the window (once per timeout interval)
+		if (now > _last_window_decrease + ACK_TIMEOUT) {
+			shrink_window = true;
+			_last_window_decrease = now;
 		}
+
+		send(channel, *slot);
+		_buffer->mark_sent(slot, now);
+		free_tx_buf -= message_len;
+		++_current_num_msgs;
 	}
 
-	while ((_current_num_msgs < _max_num_messages) && _ulog_stream_sub.update()) {
-		const ulog_stream_s &ulog_data = _ulog_stream_sub.get();
-
-		if (ulog_data.timestamp > 0) {
-			if (ulog_data.flags & ulog_stream_s::FLAGS_NEED_ACK) {
-				_sent_tries = 1;
-				_last_sent_time = hrt_absolute_time();
-				lock();
-				_wait_for_ack_sequence = ulog_data.msg_sequence;
-				_ack_received = false;
-				unlock();
-
-				mavlink_logging_data_acked_t msg;
-				msg.sequence = ulog_data.msg_sequence;
-				msg.length = ulog_data.length;
-				msg.first_message_offset = ulog_data.first_message_offset;
-				msg.target_system = _target_system;
-				msg.target_component = _target_component;
-				memcpy(msg.data, ulog_data.data, sizeof(msg.data));
-				mavlink_msg_logging_data_acked_send_struct(channel, &msg);
-
-			} else {
-				mavlink_logging_data_t msg;
-				msg.sequence = ulog_data.msg_sequence;
-				msg.length = ulog_data.length;
-				msg.first_message_offset = ulog_data.first_message_offset;
-				msg.target_system = _target_system;
-				msg.target_component = _target_component;
-				memcpy(msg.data, ulog_data.data, sizeof(msg.data));
-				mavlink_msg_logging_data_send_struct(channel, &msg);
-			}
-		}
+	while ((_current_num_msgs < _max_num_messages) && (free_tx_buf >= message_len)
+	       && (slot = _buffer->next_unsent(shrink_window ? math::max(_window / 2, 1u) : _window))) {
 
+		send(channel, *slot);
+		_buffer->mark_sent(slot, now);
+		free_tx_buf -= message_len;
 		++_current_num_msgs;
 	}
 
-	//need to update the rate?
-	hrt_abstime t = hrt_absolute_time();
+	_buffer->unlock();
 
-	if (t > _next_rate_check) {
+	// after releasing the buffer, handle_ack() takes the locks in the opposite order
+	if (shrink_window) {
+		lock();
+		_window = math::max(_window / 2, 1u);
+		_window_acks = 0;
+		unlock();
+	}
+
+	//need to update the rate?
+	if (now > _next_rate_check) {
 		if (_current_num_msgs < _max_num_messages) {
 			_current_rate_factor = _max_rate_factor * (float)_current_num_msgs / _max_num_messages;
 
@@ -176,9 +165,9 @@ int MavlinkULog::handle_update(mavlink_channel_t channel)
 		}
 
 		_current_num_msgs = 0;
-		_next_rate_check = t + _rate_calculation_delta_t * 1.e6f;
-		PX4_DEBUG("current rate=%.3f (max=%i msgs in %.3fs)", (double)_current_rate_factor, _max_num_messages,
-			  (double)_rate_calculation_delta_t);
+		_next_rate_check = now + _rate_calculation_delta_t * 1.e6f;
+		PX4_DEBUG("current rate=%.3f (max=%i msgs in %.3fs, window=%i)", (double)_current_rate_factor, _max_num_messages,
+			  (double)_rate_calculation_delta_t, _window);
 	}
 
 	return 0;
@@ -235,20 +224,17 @@ void MavlinkULog::handle_ack(mavlink_logging_ack_t ack)
 	lock();
 
 	if (_instance) { // make sure stop() was not called right before
-		if (_wait_for_ack_sequence == ack.sequence) {
-			_ack_received = true;
-			publish_ack(ack.sequence);
+		if (_buffer->ack(ack.sequence)) {
+			// grow the window by one message per window of acks
+			if (++_window_acks >= _window) {
+				_window_acks = 0;
+
+				if (_window < WINDOW_MAX) {
+					++_window;
+				}
+			}
 		}
 	}
 
 	unlock();
 }
-
-void MavlinkULog::publish_ack(uint16_t sequence)
-{
-	ulog_stream_ack_s ack;
-	ack.timestamp = hrt_absolute_time();
-	ack.msg_sequence = sequence;
-
-	_ulog_stream_ack_pub.publish(ack);
-}
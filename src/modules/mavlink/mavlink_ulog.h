@@ -45,17 +45,19 @@
 #include <px4_platform_common/tasks.h>
 #include <px4_platform_common/sem.h>
 #include <drivers/drv_hrt.h>
+#include <mathlib/mathlib.h>
 
-#include <uORB/Publication.hpp>
-#include <uORB/Subscription.hpp>
-#include <uORB/topics/ulog_stream.h>
-#include <uORB/topics/ulog_stream_ack.h>
+#include <lib/ulog/ULogStreamBuffer.hpp>
 
 #include "mavlink_bridge_header.h"
 
 /**
  * @class MavlinkULog
  * ULog streaming class. At most one instance (stream) can exist, assigned to a specific mavlink channel.
+ *
+ * The data is sent directly from the logger's ULogStreamBuffer. Acked messages are sent with a sliding window
+ * (the receiver may ack them in any order), and only the ones that time out are retransmitted. The window
+ * adapts to the link: it grows with each ack and is halved on a timeout.
  */
 class MavlinkULog
 {
@@ -85,9 +87,10 @@ public:
 
 	/**
 	 * periodic update method: check for ulog stream messages and handle retransmission.
+	 * @param free_tx_buf available space in the transmit buffer [bytes]
 	 * @return 0 on success, <0 otherwise
 	 */
-	int handle_update(mavlink_channel_t channel);
+	int handle_update(mavlink_channel_t channel, unsigned free_tx_buf);
 
 	/** ack from mavlink for a data message */
 	void handle_ack(mavlink_logging_ack_t ack);
@@ -97,6 +100,13 @@ public:
 
 	float current_data_rate() const { return _current_rate_factor; }
 	float maximum_data_rate() const { return _max_rate_factor; }
+	unsigned window() const { return _window; }
+
+	static constexpr hrt_abstime ACK_TIMEOUT = 50 * 1000; ///< timeout waiting for an ack until we retry to send the message [us]
+	static constexpr int ACK_MAX_TRIES = 50; ///< maximum amount of tries to (re-)send a message
+
+	static constexpr unsigned WINDOW_INITIAL = 4; ///< initial number of unacked messages in flight
+	static constexpr unsigned WINDOW_MAX = math::min(32u, ulog::ULogStreamBuffer::NUM_SLOTS / 2);
 
 private:
 
@@ -114,19 +124,19 @@ private:
 		px4_sem_post(&_lock);
 	}
 
-	void publish_ack(uint16_t sequence);
+	/** send a slot of the stream buffer (the data is read from the buffer directly) */
+	void send(mavlink_channel_t channel, const ulog::ULogStreamBuffer::Slot &slot);
 
 	static px4_sem_t _lock;
 	static bool _init;
 	static MavlinkULog *_instance;
 	static const float _rate_calculation_delta_t; ///< rate update interval
 
-	uORB::SubscriptionData<ulog_stream_s> _ulog_stream_sub{ORB_ID(ulog_stream)};
-	uORB::Publication<ulog_stream_ack_s> _ulog_stream_ack_pub{ORB_ID(ulog_stream_ack)};
-	uint16_t _wait_for_ack_sequence;
-	uint8_t _sent_tries = 0;
-	volatile bool _ack_received = false; ///< set to true if a matching ack received
-	hrt_abstime _last_sent_time = 0; ///< last time we sent a message that requires an ack
+	ulog::ULogStreamBuffer *_buffer{nullptr};
+	unsigned _window{WINDOW_INITIAL}; ///< maximum number of acked messages in flight
+	unsigned _window_acks{0}; ///< acks received since the last window increase
+	hrt_abstime _last_window_decrease{0};
+	hrt_abstime _initial_ack_wait_start{0};
 	bool _waiting_for_initial_ack = false;
 	const uint8_t _target_system;
 	const uint8_t _target_component;
@@ -47,6 +47,8 @@ public:
 	const char *get_name() const override { return get_name_static(); }
 	uint16_t get_id() override { return get_id_static(); }
 
+	MavlinkStreamPriority get_priority() const override { return MavlinkStreamPriority::CRITICAL; }
+
 	unsigned get_size() override
 	{
 		return 0; // commands stream is not regular and not predictable
@@ -49,6 +49,8 @@ public:
 	const char *get_name() const override { return get_name_static(); }
 	uint16_t get_id() override { return get_id_static(); }
 
+	MavlinkStreamPriority get_priority() const override { return MavlinkStreamPriority::CRITICAL; }
+
 	bool const_rate() override { return true; }
 
 	unsigned get_size() override
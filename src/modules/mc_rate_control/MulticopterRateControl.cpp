@@ -114,7 +114,10 @@ MulticopterRateControl::Run()
 		_parameter_update_sub.copy(&param_update);
 
 		updateParams();
-		parameters_updated();
+
+		if (paramsChanged()) {
+			parameters_updated();
+		}
 	}
 
 	/* run controller on gyro changes */
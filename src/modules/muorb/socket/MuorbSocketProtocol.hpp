@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file MuorbSocketProtocol.hpp
+ *
+ * Datagram format of the uORB socket channel.
+ *
+ * A datagram starts with a header and carries any number of frames. A frame is
+ * a control message or the data of one topic, identified by its ORB_ID. Both
+ * ends need to be built from the same message definitions, a datagram with a
+ * different topic count is dropped.
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace muorb_socket
+{
+
+static constexpr uint16_t MAGIC = 0x4d55;
+static constexpr size_t DATAGRAM_SIZE_MAX = 8192;
+
+enum class FrameType : uint8_t {
+	Advertise = 1,
+	Unadvertise = 2,
+	AddSubscription = 3,	///< payload: int32_t max rate [Hz], 0 for every message
+	RemoveSubscription = 4,
+	Data = 5,
+};
+
+struct DatagramHeader {
+	uint16_t magic;
+	uint16_t topic_count;
+	uint32_t sequence;
+};
+
+struct FrameHeader {
+	uint8_t type;
+	uint8_t reserved;
+	uint16_t orb_id;
+	uint16_t length;	///< of the payload following the header
+};
+
+struct Frame {
+	FrameType type;
+	uint16_t orb_id;
+	uint16_t length;
+	const uint8_t *payload;
+};
+
+/**
+ * Collects frames until the datagram is full or flushed.
+ */
+class DatagramWriter
+{
+public:
+	explicit DatagramWriter(uint16_t topic_count) : _topic_count(topic_count) { reset(); }
+
+	void reset() { _size = sizeof(DatagramHeader); }
+
+	/**
+	 * Append a frame.
+	 * @return false if the datagram has no room left for it
+	 */
+	bool append(FrameType type, uint16_t orb_id, const void *payload, size_t length)
+	{
+		if (_size + sizeof(FrameHeader) + length > sizeof(_buffer)) {
+			return false;
+		}
+
+		const FrameHeader header{static_cast<uint8_t>(type), 0, orb_id, static_cast<uint16_t>(length)};
+		memcpy(&_buffer[_size], &header, sizeof(header));
+		_size += sizeof(header);
+
+		if (length > 0) {
+			memcpy(&_buffer[_size], payload, length);
+			_size += length;
+		}
+
+		_frames++;
+		return true;
+	}
+
+	/** a single frame of this payload length fits into an empty datagram */
+	static constexpr bool fits(size_t length)
+	{
+		return sizeof(DatagramHeader) + sizeof(FrameHeader) + length <= DATAGRAM_SIZE_MAX;
+	}
+
+	bool empty() const { return _size == sizeof(DatagramHeader); }
+
+	/**
+	 * Write the datagram header.
+	 * @return the datagram, valid until the next append() or reset()
+	 */
+	const uint8_t *finalize(uint32_t sequence)
+	{
+		const DatagramHeader header{MAGIC, _topic_count, sequence};
+		memcpy(_buffer, &header, sizeof(header));
+		return _buffer;
+	}
+
+	size_t size() const { return _size; }
+	uint32_t frames() const { return _frames; }
+
+private:
+	uint8_t _buffer[DATAGRAM_SIZE_MAX];
+	size_t _size{0};
+	uint32_t _frames{0};	///< total number of frames appended
+	const uint16_t _topic_count;
+};
+
+/**
+ * Iterates over the frames of a received datagram.
+ */
+class DatagramReader
+{
+public:
+	DatagramReader(const uint8_t *data, size_t size, uint16_t topic_count) : _data(data), _size(size)
+	{
+		if (size >= sizeof(DatagramHeader)) {
+			memcpy(&_header, data, sizeof(_header));
+			_valid = (_header.magic == MAGIC) && (_header.topic_count == topic_count);
+			_offset = sizeof(DatagramHeader);
+		}
+	}
+
+	bool valid() const { return _valid; }
+	uint32_t sequence() const { return _header.sequence; }
+
+	/**
+	 * Get the next frame.
+	 * @return false at the end of the datagram or if the remaining data is truncated
+	 */
+	bool next(Frame &frame)
+	{
+		if (!_valid || _offset + sizeof(FrameHeader) > _size) {
+			return false;
+		}
+
+		FrameHeader header;
+		memcpy(&header, &_data[_offset], sizeof(header));
+
+		if (_offset + sizeof(FrameHeader) + header.length > _size) {
+			_valid = false;
+			return false;
+		}
+
+		frame.type = static_cast<FrameType>(header.type);
+		frame.orb_id = header.orb_id;
+		frame.length = header.length;
+		frame.payload = &_data[_offset + sizeof(FrameHeader)];
+		_offset += sizeof(FrameHeader) + header.length;
+		return true;
+	}
+
+private:
+	const uint8_t *_data;
+	const size_t _size;
+	size_t _offset{0};
+	DatagramHeader _header{};
+	bool _valid{false};
+};
+
+/**
+ * Sender side throttling of a topic to the rate requested by the remote subscriber.
+ */
+class RateLimit
+{
+public:
+	/**
+	 * @param rate_hz max rate, 0 for every message
+	 */
+	void set_rate(int32_t rate_hz)
+	{
+		const hrt_abstime interval_us = (rate_hz > 0) ? 1000000 / rate_hz : 0;
+
+		if (interval_us != _interval_us) {
+			_interval_us = interval_us;
+			_last_sent = 0;
+		}
+	}
+
+	hrt_abstime interval() const { return _interval_us; }
+
+	/**
+	 * @return true if a message published at time now is to be sent
+	 */
+	bool update(hrt_abstime now)
+	{
+		if (_interval_us == 0) {
+			return true;
+		}
+
+		if ((_last_sent == 0) || (now >= _last_sent + _interval_us)) {
+			// shift the last sent time forward, but don't let it get further behind than the interval
+			const hrt_abstime next = _last_sent + _interval_us;
+			_last_sent = (_last_sent == 0 || now > next + _interval_us) ? now : next;
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	hrt_abstime _interval_us{0};
+	hrt_abstime _last_sent{0};
+};
+
+} // namespace muorb_socket
@@ -0,0 +1,159 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test the datagram format and the sender side rate limit of the uORB socket channel.
+ * Run this test only using make tests TESTFILTER=MuorbSocketProtocol
+ */
+
+#include <gtest/gtest.h>
+
+#include "MuorbSocketProtocol.hpp"
+
+using namespace muorb_socket;
+
+static constexpr uint16_t TOPIC_COUNT = 200;
+
+TEST(MuorbSocketProtocolTest, roundTrip)
+{
+	DatagramWriter writer(TOPIC_COUNT);
+	EXPECT_TRUE(writer.empty());
+
+	const int32_t rate = 50;
+	const uint8_t data[5] {1, 2, 3, 4, 5};
+	EXPECT_TRUE(writer.append(FrameType::AddSubscription, 17, &rate, sizeof(rate)));
+	EXPECT_TRUE(writer.append(FrameType::Data, 199, data, sizeof(data)));
+	EXPECT_TRUE(writer.append(FrameType::Advertise, 0, nullptr, 0));
+	EXPECT_FALSE(writer.empty());
+	EXPECT_EQ(writer.frames(), 3u);
+
+	const uint8_t *datagram = writer.finalize(42);
+	DatagramReader reader(datagram, writer.size(), TOPIC_COUNT);
+	ASSERT_TRUE(reader.valid());
+	EXPECT_EQ(reader.sequence(), 42u);
+
+	Frame frame;
+	ASSERT_TRUE(reader.next(frame));
+	EXPECT_EQ(frame.type, FrameType::AddSubscription);
+	EXPECT_EQ(frame.orb_id, 17);
+	ASSERT_EQ(frame.length, sizeof(rate));
+	int32_t rate_received = 0;
+	memcpy(&rate_received, frame.payload, sizeof(rate_received));
+	EXPECT_EQ(rate_received, rate);
+
+	ASSERT_TRUE(reader.next(frame));
+	EXPECT_EQ(frame.type, FrameType::Data);
+	EXPECT_EQ(frame.orb_id, 199);
+	ASSERT_EQ(frame.length, sizeof(data));
+	EXPECT_EQ(memcmp(frame.payload, data, sizeof(data)), 0);
+
+	ASSERT_TRUE(reader.next(frame));
+	EXPECT_EQ(frame.type, FrameType::Advertise);
+	EXPECT_EQ(frame.length, 0);
+
+	EXPECT_FALSE(reader.next(frame));
+	EXPECT_TRUE(reader.valid());
+
+	writer.reset();
+	EXPECT_TRUE(writer.empty());
+}
+
+TEST(MuorbSocketProtocolTest, datagramFull)
+{
+	DatagramWriter writer(TOPIC_COUNT);
+	uint8_t data[1000] {};
+	int frames = 0;
+
+	while (writer.append(FrameType::Data, 1, data, sizeof(data))) {
+		frames++;
+	}
+
+	EXPECT_EQ(frames, (DATAGRAM_SIZE_MAX - sizeof(DatagramHeader)) / (sizeof(FrameHeader) + sizeof(data)));
+	EXPECT_LE(writer.size(), DATAGRAM_SIZE_MAX);
+
+	EXPECT_TRUE(DatagramWriter::fits(DATAGRAM_SIZE_MAX - sizeof(DatagramHeader) - sizeof(FrameHeader)));
+	EXPECT_FALSE(DatagramWriter::fits(DATAGRAM_SIZE_MAX));
+}
+
+TEST(MuorbSocketProtocolTest, invalidDatagram)
+{
+	DatagramWriter writer(TOPIC_COUNT);
+	const uint8_t data[8] {};
+	writer.append(FrameType::Data, 3, data, sizeof(data));
+	const uint8_t *datagram = writer.finalize(0);
+
+	// different message definitions
+	EXPECT_FALSE(DatagramReader(datagram, writer.size(), TOPIC_COUNT + 1).valid());
+
+	// too short for the header
+	EXPECT_FALSE(DatagramReader(datagram, sizeof(DatagramHeader) - 1, TOPIC_COUNT).valid());
+
+	// truncated frame
+	DatagramReader reader(datagram, writer.size() - 1, TOPIC_COUNT);
+	EXPECT_TRUE(reader.valid());
+	Frame frame;
+	EXPECT_FALSE(reader.next(frame));
+	EXPECT_FALSE(reader.valid());
+}
+
+TEST(MuorbSocketProtocolTest, rateLimit)
+{
+	RateLimit limit;
+
+	// no limit
+	for (hrt_abstime t = 1000; t < 100000; t += 1000) {
+		EXPECT_TRUE(limit.update(t));
+	}
+
+	// 30 Hz out of 250 Hz
+	limit.set_rate(30);
+	int sent = 0;
+
+	for (hrt_abstime t = 1000000; t < 11000000; t += 4000) {
+		sent += limit.update(t);
+	}
+
+	EXPECT_NEAR(sent, 300, 2);
+
+	// a gap in the publications does not cause a burst
+	EXPECT_TRUE(limit.update(20000000));
+	EXPECT_FALSE(limit.update(20004000));
+
+	// the same rate again keeps the cadence
+	limit.set_rate(30);
+	EXPECT_FALSE(limit.update(20008000));
+
+	limit.set_rate(0);
+	EXPECT_TRUE(limit.update(20008000));
+}
@@ -0,0 +1,176 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "uORBSocketChannel.hpp"
+
+#include <px4_platform_common/getopt.h>
+#include <px4_platform_common/log.h>
+#include <px4_platform_common/module.h>
+#include <uORB/uORBManager.hpp>
+
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" __EXPORT int muorb_socket_main(int argc, char *argv[]);
+
+static void usage()
+{
+	PRINT_MODULE_DESCRIPTION(
+		R"DESCR_STR(
+### Description
+uORB communicator channel over a UNIX-domain or UDP datagram socket. It connects the uORB of two
+PX4 processes, on the same host or on different hosts, so that modules can be moved to another
+process without changes.
+
+Topics are identified by their ORB_ID, both processes need to be built from the same message
+definitions. Only the data of topics with a subscriber in the other process is sent, and only
+instance 0 of multi-instance topics. Everything published within the flush interval is sent as
+one datagram. The rate of a topic can be limited with the `rate` command, the other process then
+drops the messages above that rate before sending them.
+
+The channel needs a build with ORB_COMMUNICATOR defined (e.g. px4_sitl_muorb) and is to be started
+before any other module.
+
+### Examples
+Two processes on the same host:
+$ muorb_socket start -l /tmp/px4_muorb_0 -r /tmp/px4_muorb_1
+$ muorb_socket start -l /tmp/px4_muorb_1 -r /tmp/px4_muorb_0
+
+Over UDP, receive 'vehicle_local_position' at most at 10 Hz:
+$ muorb_socket start -l :14600 -r 192.168.1.10:14600
+$ muorb_socket rate vehicle_local_position 10
+)DESCR_STR");
+
+	PRINT_MODULE_USAGE_NAME("muorb_socket", "communication");
+	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_PARAM_STRING('l', nullptr, "<path>|[host]:port", "Local address", false);
+	PRINT_MODULE_USAGE_PARAM_STRING('r', nullptr, "<path>|host:port", "Remote address", false);
+	PRINT_MODULE_USAGE_PARAM_INT('i', 1000, 0, 100000, "Flush interval in us", true);
+	PRINT_MODULE_USAGE_COMMAND_DESCR("rate", "Limit the rate of a topic received from the other process");
+	PRINT_MODULE_USAGE_ARG("<topic> <rate>", "Topic name and max rate in Hz (0: every message, -1: reset)", false);
+	PRINT_MODULE_USAGE_COMMAND("stop");
+	PRINT_MODULE_USAGE_COMMAND("status");
+}
+
+int muorb_socket_main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+
+	if (!strcmp(argv[1], "start")) {
+		const char *local = nullptr;
+		const char *remote = nullptr;
+		uint32_t flush_interval_us = 1000;
+
+		int myoptind = 1;
+		int ch;
+		const char *myoptarg = nullptr;
+
+		while ((ch = px4_getopt(argc, argv, "l:r:i:", &myoptind, &myoptarg)) != EOF) {
+			switch (ch) {
+			case 'l':
+				local = myoptarg;
+				break;
+
+			case 'r':
+				remote = myoptarg;
+				break;
+
+			case 'i':
+				flush_interval_us = strtoul(myoptarg, nullptr, 10);
+				break;
+
+			default:
+				usage();
+				return 1;
+			}
+		}
+
+		if (local == nullptr || remote == nullptr) {
+			usage();
+			return 1;
+		}
+
+		uORB::SocketChannel *channel = uORB::SocketChannel::GetInstance();
+
+		if (channel->IsRunning()) {
+			PX4_WARN("already running");
+			return 0;
+		}
+
+		if (channel->Start(local, remote, flush_interval_us) != 0) {
+			return 1;
+		}
+
+		uORB::Manager::get_instance()->set_uorb_communicator(channel);
+		return 0;
+	}
+
+	if (!uORB::SocketChannel::isInstance() || !uORB::SocketChannel::GetInstance()->IsRunning()) {
+		PX4_INFO("not running");
+		return (!strcmp(argv[1], "status")) ? 0 : 1;
+	}
+
+	uORB::SocketChannel *channel = uORB::SocketChannel::GetInstance();
+
+	if (!strcmp(argv[1], "rate")) {
+		if (argc < 4) {
+			usage();
+			return 1;
+		}
+
+		if (channel->SetSubscriptionRate(argv[2], strtol(argv[3], nullptr, 10)) != 0) {
+			PX4_ERR("unknown topic %s", argv[2]);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		uORB::Manager::get_instance()->set_uorb_communicator(nullptr);
+		channel->Stop();
+		return 0;
+	}
+
+	if (!strcmp(argv[1], "status")) {
+		channel->PrintStatus();
+		return 0;
+	}
+
+	usage();
+	return 1;
+}
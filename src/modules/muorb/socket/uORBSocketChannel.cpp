@@ -0,0 +1,634 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "uORBSocketChannel.hpp"
+
+#include <px4_platform_common/log.h>
+#include <px4_platform_common/time.h>
+#include <uORB/uORBTopics.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace muorb_socket;
+
+uORB::SocketChannel *uORB::SocketChannel::_InstancePtr = nullptr;
+
+/**
+ * Parse a socket address: a path for a UNIX-domain socket, [host]:port for UDP.
+ * An empty host is the wildcard address.
+ */
+static bool parse_address(const char *address, sockaddr_storage &addr, socklen_t &addr_len)
+{
+	memset(&addr, 0, sizeof(addr));
+
+	if (address[0] == '/') {
+		sockaddr_un *un = (sockaddr_un *)&addr;
+
+		if (strlen(address) >= sizeof(un->sun_path)) {
+			return false;
+		}
+
+		un->sun_family = AF_UNIX;
+		strncpy(un->sun_path, address, sizeof(un->sun_path) - 1);
+		addr_len = sizeof(sockaddr_un);
+		return true;
+	}
+
+	const char *separator = strrchr(address, ':');
+
+	if (separator == nullptr) {
+		return false;
+	}
+
+	char host[INET_ADDRSTRLEN] {};
+	const size_t host_len = separator - address;
+
+	if (host_len >= sizeof(host)) {
+		return false;
+	}
+
+	memcpy(host, address, host_len);
+
+	char *end = nullptr;
+	const unsigned long port = strtoul(separator + 1, &end, 10);
+
+	if (end == separator + 1 || *end != '\0' || port == 0 || port > UINT16_MAX) {
+		return false;
+	}
+
+	sockaddr_in *in = (sockaddr_in *)&addr;
+	in->sin_family = AF_INET;
+	in->sin_port = htons(port);
+	addr_len = sizeof(sockaddr_in);
+
+	if (host_len == 0) {
+		in->sin_addr.s_addr = htonl(INADDR_ANY);
+		return true;
+	}
+
+	return inet_pton(AF_INET, host, &in->sin_addr) == 1;
+}
+
+uORB::SocketChannel::SocketChannel() :
+	_topic_count(orb_topics_count()),
+	_writer(orb_topics_count())
+{
+	pthread_mutex_init(&_tx_mutex, nullptr);
+	pthread_cond_init(&_tx_cond, nullptr);
+
+	_remote_subscribed = new px4::atomic_bool[_topic_count];
+	_remote_rate = new RateLimit[_topic_count];
+	_local_subscription_rate = new int32_t[_topic_count];
+	_rate_override = new int32_t[_topic_count];
+	_local_advertised = new bool[_topic_count] {};
+	_remote_advertised = new bool[_topic_count] {};
+
+	for (uint16_t i = 0; i < _topic_count; i++) {
+		_local_subscription_rate[i] = -1;
+		_rate_override[i] = -1;
+	}
+}
+
+uORB::SocketChannel::~SocketChannel()
+{
+	Stop();
+
+	delete[] _remote_subscribed;
+	delete[] _remote_rate;
+	delete[] _local_subscription_rate;
+	delete[] _rate_override;
+	delete[] _local_advertised;
+	delete[] _remote_advertised;
+
+	perf_free(_tx_datagrams);
+	perf_free(_tx_throttled);
+	perf_free(_tx_errors);
+	perf_free(_rx_datagrams);
+	perf_free(_rx_lost);
+	perf_free(_rx_errors);
+
+	pthread_cond_destroy(&_tx_cond);
+	pthread_mutex_destroy(&_tx_mutex);
+}
+
+int uORB::SocketChannel::find_topic(const char *messageName)
+{
+	const orb_metadata *const *topics = orb_get_topics();
+
+	for (size_t i = 0; i < orb_topics_count(); i++) {
+		if (strcmp(topics[i]->o_name, messageName) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int uORB::SocketChannel::Start(const char *local, const char *remote, uint32_t flush_interval_us)
+{
+	if (_fd >= 0) {
+		PX4_WARN("already running");
+		return -1;
+	}
+
+	sockaddr_storage local_addr;
+	socklen_t local_addr_len = 0;
+
+	if (!parse_address(local, local_addr, local_addr_len) || !parse_address(remote, _remote_addr, _remote_addr_len)
+	    || local_addr.ss_family != _remote_addr.ss_family) {
+		PX4_ERR("invalid addresses %s, %s", local, remote);
+		return -1;
+	}
+
+	const int fd = socket(local_addr.ss_family, SOCK_DGRAM, 0);
+
+	if (fd < 0) {
+		PX4_ERR("socket failed (%i)", errno);
+		return -1;
+	}
+
+	if (local_addr.ss_family == AF_UNIX) {
+		// remove the socket of a previous run
+		unlink(local);
+	}
+
+	if (bind(fd, (sockaddr *)&local_addr, local_addr_len) < 0) {
+		PX4_ERR("bind %s failed (%i)", local, errno);
+		close(fd);
+		return -1;
+	}
+
+	if (local_addr.ss_family == AF_UNIX) {
+		strncpy(_local_path, local, sizeof(_local_path) - 1);
+	}
+
+	strncpy(_local_name, local, sizeof(_local_name) - 1);
+	strncpy(_remote_name, remote, sizeof(_remote_name) - 1);
+
+	_flush_interval_us = flush_interval_us;
+	_rx_sequence_expected = 0;
+	_should_exit.store(false);
+	_fd = fd;
+
+	if (pthread_create(&_rx_thread, nullptr, rx_thread_start, this) != 0) {
+		PX4_ERR("receive thread failed");
+		_should_exit.store(true);
+		Stop();
+		return -1;
+	}
+
+	if (pthread_create(&_tx_thread, nullptr, tx_thread_start, this) != 0) {
+		PX4_ERR("transmit thread failed");
+		_should_exit.store(true);
+		pthread_join(_rx_thread, nullptr);
+		Stop();
+		return -1;
+	}
+
+	return 0;
+}
+
+void uORB::SocketChannel::Stop()
+{
+	if (_fd < 0) {
+		return;
+	}
+
+	if (!_should_exit.load()) {
+		_should_exit.store(true);
+
+		pthread_mutex_lock(&_tx_mutex);
+		pthread_cond_signal(&_tx_cond);
+		pthread_mutex_unlock(&_tx_mutex);
+
+		pthread_join(_tx_thread, nullptr);
+		pthread_join(_rx_thread, nullptr);
+	}
+
+	pthread_mutex_lock(&_tx_mutex);
+
+	close(_fd);
+	_fd = -1;
+	_writer.reset();
+
+	for (uint16_t i = 0; i < _topic_count; i++) {
+		_remote_subscribed[i].store(false);
+		_remote_advertised[i] = false;
+	}
+
+	pthread_mutex_unlock(&_tx_mutex);
+
+	if (_local_path[0] != '\0') {
+		unlink(_local_path);
+		_local_path[0] = '\0';
+	}
+}
+
+void uORB::SocketChannel::PrintStatus()
+{
+	if (_fd < 0) {
+		PX4_INFO("not running");
+		return;
+	}
+
+	PX4_INFO("local %s, remote %s, flush interval %u us", _local_name, _remote_name, (unsigned)_flush_interval_us);
+	perf_print_counter(_tx_datagrams);
+	perf_print_counter(_tx_throttled);
+	perf_print_counter(_tx_errors);
+	perf_print_counter(_rx_datagrams);
+	perf_print_counter(_rx_lost);
+	perf_print_counter(_rx_errors);
+
+	PX4_INFO_RAW("remote subscriptions:\n");
+	const orb_metadata *const *topics = orb_get_topics();
+
+	pthread_mutex_lock(&_tx_mutex);
+
+	for (uint16_t i = 0; i < _topic_count; i++) {
+		if (_remote_subscribed[i].load()) {
+			const hrt_abstime interval = _remote_rate[i].interval();
+
+			if (interval > 0) {
+				PX4_INFO_RAW("  %s (%.1f Hz)\n", topics[i]->o_name, 1e6 / interval);
+
+			} else {
+				PX4_INFO_RAW("  %s\n", topics[i]->o_name);
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&_tx_mutex);
+}
+
+int uORB::SocketChannel::SetSubscriptionRate(const char *messageName, int32_t rate_hz)
+{
+	const int id = find_topic(messageName);
+
+	if (id < 0) {
+		return -1;
+	}
+
+	pthread_mutex_lock(&_tx_mutex);
+	_rate_override[id] = rate_hz;
+
+	// a reset to -1 requests the add_subscription() rate again
+	if (_local_subscription_rate[id] >= 0) {
+		const int32_t rate = subscription_rate_locked(id);
+		append_locked(FrameType::AddSubscription, id, &rate, sizeof(rate));
+	}
+
+	pthread_mutex_unlock(&_tx_mutex);
+	return 0;
+}
+
+int16_t uORB::SocketChannel::topic_advertised(const char *messageName)
+{
+	const int id = find_topic(messageName);
+
+	if (id < 0) {
+		return -1;
+	}
+
+	pthread_mutex_lock(&_tx_mutex);
+	_local_advertised[id] = true;
+	append_locked(FrameType::Advertise, id, nullptr, 0);
+	pthread_mutex_unlock(&_tx_mutex);
+	return 0;
+}
+
+int16_t uORB::SocketChannel::add_subscription(const char *messageName, int32_t msgRateInHz)
+{
+	const int id = find_topic(messageName);
+
+	if (id < 0) {
+		return -1;
+	}
+
+	pthread_mutex_lock(&_tx_mutex);
+	_local_subscription_rate[id] = msgRateInHz;
+	const int32_t rate = subscription_rate_locked(id);
+	append_locked(FrameType::AddSubscription, id, &rate, sizeof(rate));
+	pthread_mutex_unlock(&_tx_mutex);
+	return 0;
+}
+
+int16_t uORB::SocketChannel::remove_subscription(const char *messageName)
+{
+	const int id = find_topic(messageName);
+
+	if (id < 0) {
+		return -1;
+	}
+
+	pthread_mutex_lock(&_tx_mutex);
+	_local_subscription_rate[id] = -1;
+	append_locked(FrameType::RemoveSubscription, id, nullptr, 0);
+	pthread_mutex_unlock(&_tx_mutex);
+	return 0;
+}
+
+int16_t uORB::SocketChannel::register_handler(uORBCommunicator::IChannelRxHandler *handler)
+{
+	_RxHandler = handler;
+	return 0;
+}
+
+int16_t uORB::SocketChannel::send_message(const char *messageName, int32_t length, uint8_t *data)
+{
+	const int id = find_topic(messageName);
+
+	if (id < 0) {
+		return -1;
+	}
+
+	return send_topic_data(orb_get_topics()[id], 0, length, data);
+}
+
+int16_t uORB::SocketChannel::send_topic_data(const orb_metadata *meta, uint8_t instance, int32_t length,
+		uint8_t *data)
+{
+	// the remote handler identifies topics by name, which always refers to instance 0
+	if (instance != 0 || meta->o_id >= _topic_count || !_remote_subscribed[meta->o_id].load()) {
+		return 0;
+	}
+
+	if (length < 0 || !DatagramWriter::fits(length)) {
+		perf_count(_tx_errors);
+		return 0;
+	}
+
+	pthread_mutex_lock(&_tx_mutex);
+
+	if (_remote_rate[meta->o_id].update(hrt_absolute_time())) {
+		append_locked(FrameType::Data, meta->o_id, data, length);
+
+	} else {
+		perf_count(_tx_throttled);
+	}
+
+	pthread_mutex_unlock(&_tx_mutex);
+	return 0;
+}
+
+void uORB::SocketChannel::append_locked(FrameType type, uint16_t orb_id, const void *payload, size_t length)
+{
+	const bool was_empty = _writer.empty();
+
+	if (!_writer.append(type, orb_id, payload, length)) {
+		flush_locked();
+		_writer.append(type, orb_id, payload, length);
+	}
+
+	if (was_empty) {
+		pthread_cond_signal(&_tx_cond);
+	}
+}
+
+void uORB::SocketChannel::flush_locked()
+{
+	if (_writer.empty()) {
+		return;
+	}
+
+	if (_fd >= 0) {
+		const uint8_t *datagram = _writer.finalize(_tx_sequence++);
+
+		if (sendto(_fd, datagram, _writer.size(), 0, (sockaddr *)&_remote_addr, _remote_addr_len) < 0) {
+			// the peer is not running (yet)
+			perf_count(_tx_errors);
+
+		} else {
+			perf_count(_tx_datagrams);
+		}
+	}
+
+	_writer.reset();
+}
+
+void uORB::SocketChannel::announce_locked()
+{
+	for (uint16_t i = 0; i < _topic_count; i++) {
+		if (_local_advertised[i]) {
+			append_locked(FrameType::Advertise, i, nullptr, 0);
+		}
+
+		if (_local_subscription_rate[i] >= 0) {
+			const int32_t rate = subscription_rate_locked(i);
+			append_locked(FrameType::AddSubscription, i, &rate, sizeof(rate));
+		}
+	}
+}
+
+int32_t uORB::SocketChannel::subscription_rate_locked(uint16_t id) const
+{
+	return (_rate_override[id] >= 0) ? _rate_override[id] : _local_subscription_rate[id];
+}
+
+void *uORB::SocketChannel::tx_thread_start(void *arg)
+{
+	static_cast<SocketChannel *>(arg)->tx_thread();
+	return nullptr;
+}
+
+void uORB::SocketChannel::tx_thread()
+{
+	hrt_abstime announce_next = 0;
+
+	pthread_mutex_lock(&_tx_mutex);
+
+	while (!_should_exit.load()) {
+		const hrt_abstime now = hrt_absolute_time();
+
+		if (now >= announce_next) {
+			announce_locked();
+			announce_next = now + ANNOUNCE_INTERVAL_US;
+		}
+
+		if (_writer.empty()) {
+			// wait for the first frame of the next datagram
+			timespec ts;
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_nsec += 100 * 1000 * 1000;
+
+			if (ts.tv_nsec >= 1000 * 1000 * 1000) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000 * 1000 * 1000;
+			}
+
+			pthread_cond_timedwait(&_tx_cond, &_tx_mutex, &ts);
+			continue;
+		}
+
+		if (_flush_interval_us > 0) {
+			// collect everything published within the flush interval into one datagram
+			pthread_mutex_unlock(&_tx_mutex);
+			px4_usleep(_flush_interval_us);
+			pthread_mutex_lock(&_tx_mutex);
+		}
+
+		flush_locked();
+	}
+
+	flush_locked();
+	pthread_mutex_unlock(&_tx_mutex);
+}
+
+void *uORB::SocketChannel::rx_thread_start(void *arg)
+{
+	static_cast<SocketChannel *>(arg)->rx_thread();
+	return nullptr;
+}
+
+void uORB::SocketChannel::rx_thread()
+{
+	uint8_t buffer[DATAGRAM_SIZE_MAX];
+	bool topic_count_reported = false;
+
+	while (!_should_exit.load()) {
+		pollfd fds{_fd, POLLIN, 0};
+
+		if (poll(&fds, 1, 100) <= 0) {
+			continue;
+		}
+
+		const ssize_t size = recv(_fd, buffer, sizeof(buffer), 0);
+
+		if (size <= 0) {
+			continue;
+		}
+
+		DatagramReader reader(buffer, size, _topic_count);
+
+		if (!reader.valid()) {
+			if (!topic_count_reported && size >= (ssize_t)sizeof(DatagramHeader)) {
+				PX4_ERR("dropping datagrams of a peer with different message definitions");
+				topic_count_reported = true;
+			}
+
+			perf_count(_rx_errors);
+			continue;
+		}
+
+		perf_count(_rx_datagrams);
+
+		// a sequence number below the expected one is a restarted peer
+		if (reader.sequence() > _rx_sequence_expected) {
+			perf_set_count(_rx_lost, perf_event_count(_rx_lost) + reader.sequence() - _rx_sequence_expected);
+		}
+
+		_rx_sequence_expected = reader.sequence() + 1;
+
+		Frame frame;
+
+		while (reader.next(frame)) {
+			handle_frame(frame);
+		}
+
+		if (!reader.valid()) {
+			// truncated frame
+			perf_count(_rx_errors);
+		}
+	}
+}
+
+void uORB::SocketChannel::handle_frame(const Frame &frame)
+{
+	if (frame.orb_id >= _topic_count || _RxHandler == nullptr) {
+		perf_count(_rx_errors);
+		return;
+	}
+
+	const orb_metadata *meta = orb_get_topics()[frame.orb_id];
+
+	switch (frame.type) {
+	case FrameType::Data:
+		// the handler copies the data into the topic
+		_RxHandler->process_received_message(meta->o_name, frame.length, const_cast<uint8_t *>(frame.payload));
+		break;
+
+	case FrameType::Advertise:
+	case FrameType::Unadvertise: {
+			const bool advertised = (frame.type == FrameType::Advertise);
+
+			if (_remote_advertised[frame.orb_id] != advertised) {
+				_remote_advertised[frame.orb_id] = advertised;
+				_RxHandler->process_remote_topic(meta->o_name, advertised);
+			}
+		}
+		break;
+
+	case FrameType::AddSubscription: {
+			int32_t rate = 0;
+
+			if (frame.length >= sizeof(rate)) {
+				memcpy(&rate, frame.payload, sizeof(rate));
+			}
+
+			pthread_mutex_lock(&_tx_mutex);
+
+			const bool subscribed = _remote_subscribed[frame.orb_id].load();
+			_remote_rate[frame.orb_id].set_rate(rate);
+			_remote_subscribed[frame.orb_id].store(true);
+
+			pthread_mutex_unlock(&_tx_mutex);
+
+			// repeated announcements of a subscription are not forwarded, the handler sends the current data
+			if (!subscribed) {
+				_RxHandler->process_add_subscription(meta->o_name, rate);
+			}
+		}
+		break;
+
+	case FrameType::RemoveSubscription:
+		if (_remote_subscribed[frame.orb_id].load()) {
+			_remote_subscribed[frame.orb_id].store(false);
+			_RxHandler->process_remove_subscription(meta->o_name);
+		}
+
+		break;
+
+	default:
+		perf_count(_rx_errors);
+		break;
+	}
+}
@@ -0,0 +1,175 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file uORBSocketChannel.hpp
+ *
+ * uORB communicator channel over a UNIX-domain or UDP datagram socket, which
+ * connects the uORB of two PX4 processes on the same or on different hosts.
+ */
+
+#pragma once
+
+#include "MuorbSocketProtocol.hpp"
+
+#include <drivers/drv_hrt.h>
+#include <lib/perf/perf_counter.h>
+#include <px4_platform_common/atomic.h>
+#include <uORB/uORBCommunicator.hpp>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+namespace uORB
+{
+class SocketChannel;
+}
+
+class uORB::SocketChannel : public uORBCommunicator::IChannel
+{
+public:
+	/**
+	 * static method to get the IChannel Implementor.
+	 */
+	static uORB::SocketChannel *GetInstance()
+	{
+		if (_InstancePtr == nullptr) {
+			_InstancePtr = new uORB::SocketChannel();
+		}
+
+		return _InstancePtr;
+	}
+
+	/**
+	 * Static method to check if there is an instance.
+	 */
+	static bool isInstance()
+	{
+		return (_InstancePtr != nullptr);
+	}
+
+	/**
+	 * Open the socket and start the receive and transmit threads.
+	 * @param local address to bind, a path for a UNIX-domain socket or [host]:port for UDP
+	 * @param remote address of the peer, of the same kind as local
+	 * @param flush_interval_us time frames are collected before they are sent as one datagram
+	 * @return 0 on success
+	 */
+	int Start(const char *local, const char *remote, uint32_t flush_interval_us);
+	void Stop();
+	bool IsRunning() const { return _fd >= 0; }
+
+	void PrintStatus();
+
+	/**
+	 * Override the rate requested from the remote publisher of a topic.
+	 * @param rate_hz max rate, 0 for every message, -1 to use the rate of add_subscription()
+	 * @return 0 on success, -1 if the topic is unknown
+	 */
+	int SetSubscriptionRate(const char *messageName, int32_t rate_hz);
+
+	int16_t topic_advertised(const char *messageName) override;
+	int16_t add_subscription(const char *messageName, int32_t msgRateInHz) override;
+	int16_t remove_subscription(const char *messageName) override;
+	int16_t register_handler(uORBCommunicator::IChannelRxHandler *handler) override;
+	int16_t send_message(const char *messageName, int32_t length, uint8_t *data) override;
+	int16_t send_topic_data(const orb_metadata *meta, uint8_t instance, int32_t length, uint8_t *data) override;
+
+private:
+	SocketChannel();
+	~SocketChannel();
+
+	static constexpr hrt_abstime ANNOUNCE_INTERVAL_US = 1000000;	///< advertisements and subscriptions are repeated for a (re)started peer
+
+	/** @return ORB_ID of the topic, -1 if unknown */
+	static int find_topic(const char *messageName);
+
+	static void *rx_thread_start(void *arg);
+	static void *tx_thread_start(void *arg);
+	void rx_thread();
+	void tx_thread();
+
+	void handle_frame(const muorb_socket::Frame &frame);
+
+	/* the following methods need _tx_mutex to be held */
+	void append_locked(muorb_socket::FrameType type, uint16_t orb_id, const void *payload, size_t length);
+	void flush_locked();
+	void announce_locked();
+	/** rate requested from the remote publisher: the override if set, else the add_subscription() rate */
+	int32_t subscription_rate_locked(uint16_t id) const;
+
+	static uORB::SocketChannel *_InstancePtr;
+	uORBCommunicator::IChannelRxHandler *_RxHandler{nullptr};
+
+	const uint16_t _topic_count;
+
+	int _fd{-1};
+	sockaddr_storage _remote_addr{};
+	socklen_t _remote_addr_len{0};
+	char _local_path[108] {};	///< bound UNIX-domain socket, removed on stop
+	char _local_name[64] {};
+	char _remote_name[64] {};
+
+	pthread_t _rx_thread{};
+	pthread_t _tx_thread{};
+	px4::atomic_bool _should_exit{false};
+
+	pthread_mutex_t _tx_mutex;
+	pthread_cond_t _tx_cond;
+	muorb_socket::DatagramWriter _writer;
+	uint32_t _tx_sequence{0};
+	uint32_t _flush_interval_us{0};
+
+	uint32_t _rx_sequence_expected{0};
+
+	/* per ORB_ID, written by the receive thread and read on every publication */
+	px4::atomic_bool *_remote_subscribed{nullptr};
+
+	/* per ORB_ID, protected by _tx_mutex */
+	muorb_socket::RateLimit *_remote_rate{nullptr};
+	int32_t *_local_subscription_rate{nullptr};	///< rate of add_subscription(), -1 if not subscribed
+	int32_t *_rate_override{nullptr};		///< -1 if not set
+	bool *_local_advertised{nullptr};
+
+	/* per ORB_ID, only accessed by the receive thread */
+	bool *_remote_advertised{nullptr};
+
+	perf_counter_t _tx_datagrams{perf_alloc(PC_COUNT, "muorb_socket: tx datagrams")};
+	perf_counter_t _tx_throttled{perf_alloc(PC_COUNT, "muorb_socket: tx throttled")};
+	perf_counter_t _tx_errors{perf_alloc(PC_COUNT, "muorb_socket: tx errors")};
+	perf_counter_t _rx_datagrams{perf_alloc(PC_COUNT, "muorb_socket: rx datagrams")};
+	perf_counter_t _rx_lost{perf_alloc(PC_COUNT, "muorb_socket: rx lost")};
+	perf_counter_t _rx_errors{perf_alloc(PC_COUNT, "muorb_socket: rx errors")};
+};
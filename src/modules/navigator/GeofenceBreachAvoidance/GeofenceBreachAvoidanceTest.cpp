@@ -303,3 +303,90 @@ TEST_F(GeofenceBreachAvoidanceTest, maxDistToHomeViolationFixedWing)
 
 	EXPECT_LT(Vector2d(loiter_point_predicted - loiter_point_lat_lon).norm(), 1e-4);
 }
+
+TEST_F(GeofenceBreachAvoidanceTest, distanceToFence)
+{
+	GeofenceBreachAvoidance gf_avoidance(nullptr);
+	Vector2d home_global(42.1, 8.2);
+
+	// square inclusion polygon with the corners 100m north/south and east/west of home
+	dataman_mock::fence_stats.num_items = 4;
+	dataman_mock::fence_stats.update_counter = 1;
+
+	for (int i = 0; i < 4; ++i) {
+		Vector2d vertex = gf_avoidance.waypointFromBearingAndDistance(home_global, M_PI_F * (0.25f + 0.5f * i),
+				  100.0f * sqrtf(2.0f));
+		mission_fence_point_s &fence_point = dataman_mock::fence_points[i];
+		fence_point.lat = vertex(0);
+		fence_point.lon = vertex(1);
+		fence_point.vertex_count = 4;
+		fence_point.nav_cmd = NAV_CMD_FENCE_POLYGON_VERTEX_INCLUSION;
+		fence_point.frame = NAV_FRAME_GLOBAL;
+	}
+
+	Geofence geo(nullptr);
+
+	EXPECT_TRUE(geo.isInsidePolygonOrCircle(home_global(0), home_global(1), 0.0f));
+	EXPECT_NEAR(geo.signedDistanceToFence(home_global(0), home_global(1), 0.0f), 100.0f, 0.5f);
+	EXPECT_NEAR(geo.distanceToFenceAlongBearing(home_global(0), home_global(1), 0.0f, 0.0f, 500.0f), 100.0f, 0.5f);
+	EXPECT_NEAR(geo.distanceToFenceAlongBearing(home_global(0), home_global(1), 0.0f, M_PI_F * 0.25f, 500.0f),
+		    100.0f * sqrtf(2.0f), 0.5f);
+	EXPECT_FLOAT_EQ(geo.distanceToFenceAlongBearing(home_global(0), home_global(1), 0.0f, 0.0f, 50.0f), 50.0f);
+
+	Vector2d outside = gf_avoidance.waypointFromBearingAndDistance(home_global, 0.0f, 150.0f);
+	EXPECT_FALSE(geo.isInsidePolygonOrCircle(outside(0), outside(1), 0.0f));
+	EXPECT_NEAR(geo.signedDistanceToFence(outside(0), outside(1), 0.0f), -50.0f, 0.5f);
+	EXPECT_LT(geo.distanceToFenceAlongBearing(outside(0), outside(1), 0.0f, M_PI_F, 500.0f), 0.0f);
+
+	// add an exclusion circle with radius 10m, 50m north of home
+	Vector2d circle_center = gf_avoidance.waypointFromBearingAndDistance(home_global, 0.0f, 50.0f);
+	mission_fence_point_s &circle = dataman_mock::fence_points[4];
+	circle.lat = circle_center(0);
+	circle.lon = circle_center(1);
+	circle.circle_radius = 10.0f;
+	circle.nav_cmd = NAV_CMD_FENCE_CIRCLE_EXCLUSION;
+	circle.frame = NAV_FRAME_GLOBAL;
+	dataman_mock::fence_stats.num_items = 5;
+	dataman_mock::fence_stats.update_counter = 2;
+
+	EXPECT_NEAR(geo.distanceToFenceAlongBearing(home_global(0), home_global(1), 0.0f, 0.0f, 500.0f), 40.0f, 0.5f);
+	EXPECT_NEAR(geo.distanceToFenceAlongBearing(home_global(0), home_global(1), 0.0f, M_PI_F, 500.0f), 100.0f, 0.5f);
+	EXPECT_NEAR(geo.signedDistanceToFence(home_global(0), home_global(1), 0.0f), 40.0f, 0.5f);
+	EXPECT_NEAR(geo.signedDistanceToFence(circle_center(0), circle_center(1), 0.0f), -10.0f, 0.5f);
+
+	dataman_mock::fence_stats = {};
+}
+
+TEST_F(GeofenceBreachAvoidanceTest, fenceLoadFailure)
+{
+	GeofenceBreachAvoidance gf_avoidance(nullptr);
+	Vector2d home_global(42.1, 8.2);
+
+	// inclusion circle with radius 100m around home, but in an unsupported frame
+	mission_fence_point_s &circle = dataman_mock::fence_points[0];
+	circle.lat = home_global(0);
+	circle.lon = home_global(1);
+	circle.circle_radius = 100.0f;
+	circle.nav_cmd = NAV_CMD_FENCE_CIRCLE_INCLUSION;
+	circle.frame = NAV_FRAME_LOCAL_NED;
+	dataman_mock::fence_stats.num_items = 1;
+	dataman_mock::fence_stats.update_counter = 1;
+
+	Geofence geo(nullptr);
+
+	// the circle is dropped: the fence must not accept every position
+	EXPECT_FALSE(geo.isInsidePolygonOrCircle(home_global(0), home_global(1), 0.0f));
+	EXPECT_LT(geo.signedDistanceToFence(home_global(0), home_global(1), 0.0f), 0.0f);
+	EXPECT_LT(geo.distanceToFenceAlongBearing(home_global(0), home_global(1), 0.0f, 0.0f, 50.0f), 0.0f);
+
+	// the load is retried even though the update counter did not change
+	circle.frame = NAV_FRAME_GLOBAL;
+
+	Vector2d outside = gf_avoidance.waypointFromBearingAndDistance(home_global, 0.0f, 150.0f);
+	EXPECT_TRUE(geo.isInsidePolygonOrCircle(home_global(0), home_global(1), 0.0f));
+	EXPECT_FALSE(geo.isInsidePolygonOrCircle(outside(0), outside(1), 0.0f));
+	EXPECT_NEAR(geo.signedDistanceToFence(home_global(0), home_global(1), 0.0f), 100.0f, 0.5f);
+
+	dataman_mock::fence_stats = {};
+	dataman_mock::fence_points[0] = {};
+}
@@ -40,6 +40,16 @@
 #pragma once
 
 #include <dataman/dataman.h>
+#include <string.h>
+#include "../navigation.h"
+
+namespace dataman_mock
+{
+// fence items returned by dm_read (none by default)
+static mission_stats_entry_s fence_stats{};
+static mission_fence_point_s fence_points[16] {};
+}
+
 extern "C" {
 	__EXPORT ssize_t
 	dm_read(
@@ -47,7 +57,26 @@ extern "C" {
 		unsigned index,			/* The index of the item */
 		void *buffer,			/* Pointer to caller data buffer */
 		size_t buflen			/* Length in bytes of data to retrieve */
-	) {return 0;};
+	)
+	{
+		using namespace dataman_mock;
+
+		if (item != DM_KEY_FENCE_POINTS || fence_stats.num_items == 0) {
+			return 0;
+		}
+
+		if (index == 0 && buflen == sizeof(fence_stats)) {
+			memcpy(buffer, &fence_stats, buflen);
+			return buflen;
+		}
+
+		if (index >= 1 && index <= fence_stats.num_items && buflen == sizeof(mission_fence_point_s)) {
+			memcpy(buffer, &fence_points[index - 1], buflen);
+			return buflen;
+		}
+
+		return 0;
+	};
 
 	/** write to the data manager store */
 	__EXPORT ssize_t
@@ -75,6 +75,18 @@ public:
 		}
 	}
 
+	float distanceToFenceAlongBearing(double lat, double lon, float altitude, float bearing, float max_distance) override
+	{
+		switch (_probe_function_behavior) {
+		case ProbeFunction::GF_BOUNDARY_20M_AHEAD: {
+				return _distance_to_boundary_20m_north(lat, lon, bearing, max_distance);
+			}
+
+		default:
+			return isInsidePolygonOrCircle(lat, lon, altitude) ? max_distance : 0.0f;
+		}
+	}
+
 	enum class ProbeFunction {
 		ALL_POINTS_OUTSIDE = 0,
 		LEFT_INSIDE_RIGHT_OUTSIDE,
@@ -136,4 +148,24 @@ private:
 
 		return true;
 	}
+
+	float _distance_to_boundary_20m_north(double lat, double lon, float bearing, float max_distance)
+	{
+		struct map_projection_reference_s ref = {};
+		matrix::Vector2<double> home_global(42.1, 8.2);
+		map_projection_init(&ref, home_global(0), home_global(1));
+
+		float x, y;
+		map_projection_project(&ref, lat, lon, &x, &y);
+
+		if (x >= 20.0f) {
+			return 20.0f - x; // already outside
+		}
+
+		if (cosf(bearing) < FLT_EPSILON) {
+			return max_distance;
+		}
+
+		return math::min((20.0f - x) / cosf(bearing), max_distance);
+	}
 };
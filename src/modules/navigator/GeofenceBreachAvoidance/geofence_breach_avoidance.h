@@ -39,7 +39,7 @@
 
 class Geofence;
 
-#define GEOFENCE_CHECK_INTERVAL_US 200000
+#define GEOFENCE_CHECK_INTERVAL_US 50000
 
 union geofence_violation_type_u {
 	struct {
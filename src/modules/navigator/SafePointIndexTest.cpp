@@ -0,0 +1,138 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include "safe_point_index.h"
+
+#include <lib/ecl/geo/geo.h>
+#include <stdlib.h>
+
+static float closest_distance_brute_force(const mission_safe_point_s *safe_points, int num_safe_points, double lat,
+		double lon)
+{
+	float closest = INFINITY;
+
+	for (int i = 0; i < num_safe_points; ++i) {
+		closest = fminf(closest, get_distance_to_next_waypoint(lat, lon, safe_points[i].lat, safe_points[i].lon));
+	}
+
+	return closest;
+}
+
+TEST(SafePointIndexTest, empty)
+{
+	SafePointIndex index;
+	mission_safe_point_s safe_point{};
+	float distance = 0.f;
+
+	EXPECT_EQ(index.count(), 0);
+	EXPECT_EQ(index.findClosest(47.4, 8.5, safe_point, distance), -1);
+}
+
+TEST(SafePointIndexTest, single)
+{
+	SafePointIndex index;
+	mission_safe_point_s safe_points[1] {};
+	safe_points[0].lat = 47.4;
+	safe_points[0].lon = 8.5;
+	safe_points[0].alt = 10.f;
+	index.load(safe_points, 1);
+
+	mission_safe_point_s safe_point{};
+	float distance = 0.f;
+
+	EXPECT_EQ(index.findClosest(47.41, 8.5, safe_point, distance), 0);
+	EXPECT_DOUBLE_EQ(safe_point.lat, 47.4);
+	EXPECT_FLOAT_EQ(safe_point.alt, 10.f);
+	EXPECT_NEAR(distance, get_distance_to_next_waypoint(47.41, 8.5, 47.4, 8.5), 0.01f);
+}
+
+TEST(SafePointIndexTest, closestMatchesBruteForce)
+{
+	// GIVEN: a few hundred rally points scattered over a 20 km x 20 km area
+	static constexpr int num_safe_points = 300;
+	mission_safe_point_s safe_points[num_safe_points] {};
+	srand(1);
+
+	for (int i = 0; i < num_safe_points; ++i) {
+		safe_points[i].lat = 47.3 + 0.18 * rand() / RAND_MAX;
+		safe_points[i].lon = 8.4 + 0.27 * rand() / RAND_MAX;
+		safe_points[i].alt = i;
+	}
+
+	SafePointIndex index;
+	index.load(safe_points, num_safe_points);
+	EXPECT_EQ(index.count(), num_safe_points);
+
+	// WHEN: querying positions inside and around the area
+	for (int i = 0; i < 1000; ++i) {
+		const double lat = 47.2 + 0.4 * rand() / RAND_MAX;
+		const double lon = 8.3 + 0.5 * rand() / RAND_MAX;
+
+		mission_safe_point_s safe_point{};
+		float distance = 0.f;
+		const int closest = index.findClosest(lat, lon, safe_point, distance);
+
+		// THEN: the closest point is found (up to the flat-earth approximation of the local projection)
+		ASSERT_GE(closest, 0);
+		EXPECT_FLOAT_EQ(safe_point.alt, safe_points[closest].alt);
+		EXPECT_NEAR(distance, closest_distance_brute_force(safe_points, num_safe_points, lat, lon), 1.f);
+	}
+}
+
+TEST(SafePointIndexTest, reload)
+{
+	mission_safe_point_s safe_points[3] {};
+	safe_points[0].lat = 47.4;
+	safe_points[0].lon = 8.5;
+	safe_points[1].lat = 47.5;
+	safe_points[1].lon = 8.5;
+	safe_points[2].lat = 47.6;
+	safe_points[2].lon = 8.5;
+
+	SafePointIndex index;
+	index.load(safe_points, 3);
+
+	mission_safe_point_s safe_point{};
+	float distance = 0.f;
+	EXPECT_EQ(index.findClosest(47.59, 8.5, safe_point, distance), 2);
+
+	// WHEN: fewer safe points are uploaded
+	index.load(safe_points, 2);
+
+	// THEN: the removed one is not found anymore
+	EXPECT_EQ(index.count(), 2);
+	EXPECT_EQ(index.findClosest(47.59, 8.5, safe_point, distance), 1);
+}
@@ -52,6 +52,13 @@
 
 #define GEOFENCE_RANGE_WARNING_LIMIT 5000000
 
+using matrix::Vector2f;
+
+static inline float cross(const Vector2f &a, const Vector2f &b)
+{
+	return a(0) * b(1) - a(1) * b(0);
+}
+
 Geofence::Geofence(Navigator *navigator) :
 	ModuleParams(navigator),
 	_navigator(navigator),
@@ -68,6 +75,10 @@ Geofence::~Geofence()
 	if (_polygons) {
 		delete[](_polygons);
 	}
+
+	if (_vertices) {
+		delete[](_vertices);
+	}
 }
 
 void Geofence::updateFence()
@@ -101,6 +112,7 @@ void Geofence::_updateFence()
 	// iterate over all polygons and store their starting vertices
 	_num_polygons = 0;
 	int current_seq = 1;
+	bool load_failed = false;
 
 	while (current_seq <= num_fence_items) {
 		mission_fence_point_s mission_fence_point;
@@ -108,7 +120,11 @@ void Geofence::_updateFence()
 
 		if (dm_read(DM_KEY_FENCE_POINTS, current_seq, &mission_fence_point, sizeof(mission_fence_point_s)) !=
 		    sizeof(mission_fence_point_s)) {
-			PX4_ERR("dm_read failed");
+			if (!_load_failed) {
+				PX4_ERR("dm_read failed");
+			}
+
+			load_failed = true;
 			break;
 		}
 
@@ -147,6 +163,7 @@ void Geofence::_updateFence()
 
 				if (!_polygons) {
 					_num_polygons = 0;
+					_load_failed = true;
 					PX4_ERR("alloc failed");
 					return;
 				}
@@ -177,6 +194,123 @@ void Geofence::_updateFence()
 
 	}
 
+	if (!loadVertices()) {
+		load_failed = true;
+	}
+
+	// a fence with missing areas could accept positions outside of the configured fence: keep retrying the load
+	// (on every check) and report a violation until it succeeds
+	_load_failed = load_failed;
+}
+
+bool Geofence::loadVertices()
+{
+	if (_vertices) {
+		delete[](_vertices);
+		_vertices = nullptr;
+	}
+
+	_num_vertices = 0;
+	int total_num_vertices = 0;
+
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		const PolygonInfo &polygon = _polygons[polygon_idx];
+		const bool is_circle = polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION
+				       || polygon.fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION;
+		total_num_vertices += is_circle ? 1 : polygon.vertex_count;
+	}
+
+	if (total_num_vertices == 0) {
+		return true;
+	}
+
+	_vertices = new Vector2f[total_num_vertices];
+
+	if (!_vertices) {
+		_num_polygons = 0;
+		PX4_ERR("alloc failed");
+		return false;
+	}
+
+	// project everything once into a local frame, so that the checks do not need dataman reads nor projections
+	bool reference_set = false;
+	int num_valid_polygons = 0;
+
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		PolygonInfo polygon = _polygons[polygon_idx];
+		const bool is_circle = polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION
+				       || polygon.fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION;
+		const int vertex_count = is_circle ? 1 : polygon.vertex_count;
+		bool valid = true;
+
+		polygon.vertex_offset = _num_vertices;
+
+		for (int i = 0; i < vertex_count; ++i) {
+			mission_fence_point_s vertex;
+
+			if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + i, &vertex,
+				    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
+				if (!_load_failed) {
+					PX4_ERR("dm_read failed");
+				}
+
+				valid = false;
+				break;
+			}
+
+			if (vertex.frame != NAV_FRAME_GLOBAL && vertex.frame != NAV_FRAME_GLOBAL_INT
+			    && vertex.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
+			    && vertex.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+				// TODO: handle different frames
+				if (!_load_failed) {
+					PX4_ERR("Frame type %i not supported", (int)vertex.frame);
+				}
+
+				valid = false;
+				break;
+			}
+
+			if (!reference_set) {
+				map_projection_init(&_projection_reference, vertex.lat, vertex.lon);
+				reference_set = true;
+			}
+
+			float x, y;
+			map_projection_project(&_projection_reference, vertex.lat, vertex.lon, &x, &y);
+			_vertices[_num_vertices++] = Vector2f(x, y);
+		}
+
+		if (valid) {
+			_polygons[num_valid_polygons++] = polygon;
+
+		} else {
+			_num_vertices = polygon.vertex_offset;
+		}
+	}
+
+	const bool all_valid = num_valid_polygons == _num_polygons;
+	_num_polygons = num_valid_polygons;
+	return all_valid;
+}
+
+bool Geofence::checkForUpdate()
+{
+	// the following uses dm_read, so first we try to lock all items. If that fails, it (most likely) means
+	// the data is currently being updated (via a mavlink geofence transfer), and we do not check for a violation now
+	if (dm_trylock(DM_KEY_FENCE_POINTS) != 0) {
+		return false;
+	}
+
+	// we got the lock, now check if the fence data got updated
+	mission_stats_entry_s stats;
+	int ret = dm_read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
+
+	if (ret == sizeof(mission_stats_entry_s) && (_update_counter != stats.update_counter || _load_failed)) {
+		_updateFence();
+	}
+
+	dm_unlock(DM_KEY_FENCE_POINTS);
+	return true;
 }
 
 bool Geofence::checkAll(const struct vehicle_global_position_s &global_position)
@@ -305,22 +439,16 @@ bool Geofence::checkAll(double lat, double lon, float altitude)
 
 bool Geofence::isInsidePolygonOrCircle(double lat, double lon, float altitude)
 {
-	// the following uses dm_read, so first we try to lock all items. If that fails, it (most likely) means
-	// the data is currently being updated (via a mavlink geofence transfer), and we do not check for a violation now
-	if (dm_trylock(DM_KEY_FENCE_POINTS) != 0) {
+	if (!checkForUpdate()) {
 		return true;
 	}
 
-	// we got the lock, now check if the fence data got updated
-	mission_stats_entry_s stats;
-	int ret = dm_read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
-
-	if (ret == sizeof(mission_stats_entry_s) && _update_counter != stats.update_counter) {
-		_updateFence();
+	if (_load_failed) {
+		/* Incomplete fence -> fail safe */
+		return false;
 	}
 
 	if (isEmpty()) {
-		dm_unlock(DM_KEY_FENCE_POINTS);
 		/* Empty fence -> accept all points */
 		return true;
 	}
@@ -328,20 +456,168 @@ bool Geofence::isInsidePolygonOrCircle(double lat, double lon, float altitude)
 	/* Vertical check */
 	if (_altitude_max > _altitude_min) { // only enable vertical check if configured properly
 		if (altitude > _altitude_max || altitude < _altitude_min) {
-			dm_unlock(DM_KEY_FENCE_POINTS);
 			return false;
 		}
 	}
 
+	/* Horizontal check */
+	Vector2f point;
+	map_projection_project(&_projection_reference, lat, lon, &point(0), &point(1));
+
+	return insideAreas(point);
+}
+
+float Geofence::signedDistanceToFence(double lat, double lon, float altitude)
+{
+	if (!checkForUpdate()) {
+		return FLT_MAX;
+	}
+
+	if (_load_failed) {
+		return -FLT_MAX;
+	}
+
+	if (isEmpty()) {
+		return FLT_MAX;
+	}
+
+	Vector2f point;
+	map_projection_project(&_projection_reference, lat, lon, &point(0), &point(1));
+
+	return signedDistance(point, altitude);
+}
+
+float Geofence::signedDistance(const Vector2f &point, float altitude) const
+{
+	// the allowed area is the union of the inclusion areas without the union of the exclusion areas:
+	// combine the signed distances with max (union) and min (intersection)
+	float inclusion_distance = -FLT_MAX;
+	float exclusion_distance = FLT_MAX;
+	bool had_inclusion_areas = false;
+
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		const PolygonInfo &polygon = _polygons[polygon_idx];
+		const bool is_circle = polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION
+				       || polygon.fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION;
+		const bool inside = is_circle ? insideCircle(polygon, point) : insidePolygon(polygon, point);
+		const float distance = distanceToEdge(polygon, point);
+
+		if (polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION
+		    || polygon.fence_type == NAV_CMD_FENCE_POLYGON_VERTEX_INCLUSION) {
+			inclusion_distance = math::max(inclusion_distance, inside ? distance : -distance);
+			had_inclusion_areas = true;
+
+		} else {
+			exclusion_distance = math::min(exclusion_distance, inside ? -distance : distance);
+		}
+	}
+
+	float signed_distance = had_inclusion_areas ? math::min(inclusion_distance, exclusion_distance) : exclusion_distance;
 
-	/* Horizontal check: iterate all polygons & circles */
+	if (_altitude_max > _altitude_min) {
+		signed_distance = math::min(signed_distance, math::min(_altitude_max - altitude, altitude - _altitude_min));
+	}
+
+	return signed_distance;
+}
+
+float Geofence::distanceToFenceAlongBearing(double lat, double lon, float altitude, float bearing, float max_distance)
+{
+	if (!checkForUpdate()) {
+		return max_distance;
+	}
+
+	if (_load_failed) {
+		return -FLT_MAX;
+	}
+
+	if (isEmpty()) {
+		return max_distance;
+	}
+
+	Vector2f start;
+	map_projection_project(&_projection_reference, lat, lon, &start(0), &start(1));
+	const Vector2f direction(cosf(bearing), sinf(bearing));
+
+	const bool altitude_outside = (_altitude_max > _altitude_min) && (altitude > _altitude_max || altitude < _altitude_min);
+
+	if (altitude_outside || !insideAreas(start)) {
+		return math::min(signedDistance(start, altitude), 0.f);
+	}
+
+	// walk along the boundary crossings (ordered by distance) until one leads outside
+	static constexpr float crossing_margin = 0.01f; // [m]
+	float distance = 0.f;
+
+	for (int iteration = 0; iteration <= _num_vertices * 2; ++iteration) {
+		float next_crossing = FLT_MAX;
+
+		for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+			const PolygonInfo &polygon = _polygons[polygon_idx];
+
+			if (polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION
+			    || polygon.fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION) {
+				const Vector2f offset = start - _vertices[polygon.vertex_offset];
+				const float b = offset(0) * direction(0) + offset(1) * direction(1);
+				const float c = offset(0) * offset(0) + offset(1) * offset(1) - polygon.circle_radius * polygon.circle_radius;
+				const float discriminant = b * b - c;
+
+				if (discriminant >= 0.f) {
+					const float root = sqrtf(discriminant);
+
+					if (-b - root > distance) {
+						next_crossing = math::min(next_crossing, -b - root);
+
+					} else if (-b + root > distance) {
+						next_crossing = math::min(next_crossing, -b + root);
+					}
+				}
+
+			} else {
+				for (unsigned i = 0, j = polygon.vertex_count - 1; i < polygon.vertex_count; j = i++) {
+					const Vector2f &vertex_i = _vertices[polygon.vertex_offset + i];
+					const Vector2f edge = _vertices[polygon.vertex_offset + j] - vertex_i;
+					const float denominator = cross(direction, edge);
+
+					if (fabsf(denominator) < FLT_EPSILON) {
+						continue; // parallel: the crossing is detected at the adjacent edges
+					}
+
+					const Vector2f to_vertex = vertex_i - start;
+					const float ray_distance = cross(to_vertex, edge) / denominator;
+					const float edge_fraction = cross(to_vertex, direction) / denominator;
+
+					if (ray_distance > distance && edge_fraction >= 0.f && edge_fraction <= 1.f) {
+						next_crossing = math::min(next_crossing, ray_distance);
+					}
+				}
+			}
+		}
+
+		if (next_crossing >= max_distance) {
+			return max_distance;
+		}
+
+		if (!insideAreas(start + direction * (next_crossing + crossing_margin))) {
+			return next_crossing;
+		}
+
+		distance = next_crossing + crossing_margin;
+	}
+
+	return distance;
+}
+
+bool Geofence::insideAreas(const Vector2f &point) const
+{
+	/* iterate all polygons & circles */
 	bool outside_exclusion = true;
 	bool inside_inclusion = false;
 	bool had_inclusion_areas = false;
 
 	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
 		if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION) {
-			bool inside = insideCircle(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insideCircle(_polygons[polygon_idx], point);
 
 			if (inside) {
 				inside_inclusion = true;
@@ -350,14 +626,14 @@ bool Geofence::isInsidePolygonOrCircle(double lat, double lon, float altitude)
 			had_inclusion_areas = true;
 
 		} else if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION) {
-			bool inside = insideCircle(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insideCircle(_polygons[polygon_idx], point);
 
 			if (inside) {
 				outside_exclusion = false;
 			}
 
 		} else { // it's a polygon
-			bool inside = insidePolygon(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insidePolygon(_polygons[polygon_idx], point);
 
 			if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_POLYGON_VERTEX_INCLUSION) {
 				if (inside) {
@@ -374,12 +650,10 @@ bool Geofence::isInsidePolygonOrCircle(double lat, double lon, float altitude)
 		}
 	}
 
-	dm_unlock(DM_KEY_FENCE_POINTS);
-
 	return (!had_inclusion_areas || inside_inclusion) && outside_exclusion;
 }
 
-bool Geofence::insidePolygon(const PolygonInfo &polygon, double lat, double lon, float altitude)
+bool Geofence::insidePolygon(const PolygonInfo &polygon, const Vector2f &point) const
 {
 
 	/* Adaptation of algorithm originally presented as
@@ -388,32 +662,15 @@ bool Geofence::insidePolygon(const PolygonInfo &polygon, double lat, double lon,
 	 * Only supports non-complex polygons (not self intersecting)
 	 */
 
-	mission_fence_point_s temp_vertex_i;
-	mission_fence_point_s temp_vertex_j;
+	const Vector2f *vertices = _vertices + polygon.vertex_offset;
 	bool c = false;
 
 	for (unsigned i = 0, j = polygon.vertex_count - 1; i < polygon.vertex_count; j = i++) {
-		if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + i, &temp_vertex_i,
-			    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-			break;
-		}
-
-		if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + j, &temp_vertex_j,
-			    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-			break;
-		}
-
-		if (temp_vertex_i.frame != NAV_FRAME_GLOBAL && temp_vertex_i.frame != NAV_FRAME_GLOBAL_INT
-		    && temp_vertex_i.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
-		    && temp_vertex_i.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-			// TODO: handle different frames
-			PX4_ERR("Frame type %i not supported", (int)temp_vertex_i.frame);
-			break;
-		}
+		const Vector2f &vertex_i = vertices[i];
+		const Vector2f &vertex_j = vertices[j];
 
-		if (((double)temp_vertex_i.lon >= lon) != ((double)temp_vertex_j.lon >= lon) &&
-		    (lat <= (double)(temp_vertex_j.lat - temp_vertex_i.lat) * (lon - (double)temp_vertex_i.lon) /
-		     (double)(temp_vertex_j.lon - temp_vertex_i.lon) + (double)temp_vertex_i.lat)) {
+		if ((vertex_i(1) >= point(1)) != (vertex_j(1) >= point(1)) &&
+		    (point(0) <= (vertex_j(0) - vertex_i(0)) * (point(1) - vertex_i(1)) / (vertex_j(1) - vertex_i(1)) + vertex_i(0))) {
 			c = !c;
 		}
 	}
@@ -421,34 +678,37 @@ bool Geofence::insidePolygon(const PolygonInfo &polygon, double lat, double lon,
 	return c;
 }
 
-bool Geofence::insideCircle(const PolygonInfo &polygon, double lat, double lon, float altitude)
+bool Geofence::insideCircle(const PolygonInfo &polygon, const Vector2f &point) const
 {
+	const Vector2f offset = point - _vertices[polygon.vertex_offset];
+	return offset(0) * offset(0) + offset(1) * offset(1) < polygon.circle_radius * polygon.circle_radius;
+}
 
-	mission_fence_point_s circle_point;
-
-	if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index, &circle_point,
-		    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-		PX4_ERR("dm_read failed");
-		return false;
+float Geofence::distanceToEdge(const PolygonInfo &polygon, const Vector2f &point) const
+{
+	if (polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION || polygon.fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION) {
+		return fabsf(Vector2f(point - _vertices[polygon.vertex_offset]).norm() - polygon.circle_radius);
 	}
 
-	if (circle_point.frame != NAV_FRAME_GLOBAL && circle_point.frame != NAV_FRAME_GLOBAL_INT
-	    && circle_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
-	    && circle_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-		// TODO: handle different frames
-		PX4_ERR("Frame type %i not supported", (int)circle_point.frame);
-		return false;
-	}
+	const Vector2f *vertices = _vertices + polygon.vertex_offset;
+	float min_distance_squared = FLT_MAX;
+
+	for (unsigned i = 0, j = polygon.vertex_count - 1; i < polygon.vertex_count; j = i++) {
+		// closest point on the edge
+		const Vector2f edge = vertices[j] - vertices[i];
+		const Vector2f to_point = point - vertices[i];
+		const float edge_length_squared = edge(0) * edge(0) + edge(1) * edge(1);
+		float fraction = 0.f;
+
+		if (edge_length_squared > FLT_EPSILON) {
+			fraction = math::constrain((to_point(0) * edge(0) + to_point(1) * edge(1)) / edge_length_squared, 0.f, 1.f);
+		}
 
-	if (!map_projection_initialized(&_projection_reference)) {
-		map_projection_init(&_projection_reference, lat, lon);
+		const Vector2f offset = to_point - edge * fraction;
+		min_distance_squared = math::min(min_distance_squared, offset(0) * offset(0) + offset(1) * offset(1));
 	}
 
-	float x1, y1, x2, y2;
-	map_projection_project(&_projection_reference, lat, lon, &x1, &y1);
-	map_projection_project(&_projection_reference, circle_point.lat, circle_point.lon, &x2, &y2);
-	float dx = x1 - x2, dy = y1 - y2;
-	return dx * dx + dy * dy < circle_point.circle_radius * circle_point.circle_radius;
+	return sqrtf(min_distance_squared);
 }
 
 bool
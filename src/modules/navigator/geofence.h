@@ -46,6 +46,7 @@
 #include <px4_platform_common/module_params.h>
 #include <drivers/drv_hrt.h>
 #include <lib/ecl/geo/geo.h>
+#include <matrix/math.hpp>
 #include <px4_platform_common/defines.h>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/home_position.h>
@@ -105,6 +106,25 @@ public:
 
 	virtual bool isInsidePolygonOrCircle(double lat, double lon, float altitude);
 
+	/**
+	 * Signed distance to the nearest edge of the polygons & circles, or to the altitude limits if closer.
+	 * The magnitude is exact for a single area, and a conservative (smaller) estimate where areas overlap.
+	 *
+	 * @return distance [m], positive inside the allowed area, negative outside. FLT_MAX if there is no fence,
+	 *         -FLT_MAX if the fence could not be loaded completely.
+	 */
+	virtual float signedDistanceToFence(double lat, double lon, float altitude);
+
+	/**
+	 * Distance along a bearing until the polygons & circles are left (segment check up to max_distance).
+	 *
+	 * @param bearing [rad] from north
+	 * @return distance [m] to the first point outside of the fence, max_distance if the fence is not left
+	 *         within max_distance, or the (negative) signed distance if the point is already outside
+	 *         (-FLT_MAX if the fence could not be loaded completely)
+	 */
+	virtual float distanceToFenceAlongBearing(double lat, double lon, float altitude, float bearing, float max_distance);
+
 	int clearDm();
 
 	bool valid();
@@ -169,10 +189,14 @@ private:
 			uint16_t vertex_count;
 			float circle_radius;
 		};
+		uint16_t vertex_offset; ///< index of the first vertex (or circle center) in _vertices
 	};
 	PolygonInfo *_polygons{nullptr};
 	int _num_polygons{0};
 
+	matrix::Vector2f *_vertices{nullptr}; ///< all vertices and circle centers, local (north, east) [m]
+	int _num_vertices{0};
+
 	map_projection_reference_s _projection_reference = {}; ///< reference to convert (lon, lat) to local [m]
 
 	DEFINE_PARAMETERS(
@@ -188,6 +212,7 @@ private:
 
 	int _outside_counter{0};
 	uint16_t _update_counter{0}; ///< dataman update counter: if it does not match, we polygon data was updated
+	bool _load_failed{false}; ///< not all fence items could be loaded: the load is retried and the fence reports a violation
 
 	/**
 	 * implementation of updateFence(), but without locking
@@ -211,16 +236,44 @@ private:
 	bool checkAll(const vehicle_global_position_s &global_position);
 	bool checkAll(const vehicle_global_position_s &global_position, float baro_altitude_amsl);
 
+	/**
+	 * Read the vertices of all polygons & circles from dataman into _vertices
+	 * @return false if a polygon or circle had to be dropped (read failure or unsupported frame)
+	 */
+	bool loadVertices();
+
+	/**
+	 * Reload the fence if the data in dataman changed
+	 * @return false if the data is currently being updated (no check should be done)
+	 */
+	bool checkForUpdate();
+
+	/**
+	 * Check if a local point passes the polygon & circle test (without altitude)
+	 */
+	bool insideAreas(const matrix::Vector2f &point) const;
+
 	/**
 	 * Check if a single point is within a polygon
 	 * @return true if within polygon
 	 */
-	bool insidePolygon(const PolygonInfo &polygon, double lat, double lon, float altitude);
+	bool insidePolygon(const PolygonInfo &polygon, const matrix::Vector2f &point) const;
 
 	/**
 	 * Check if a single point is within a circle
 	 * @param polygon must be a circle!
 	 * @return true if within polygon the circle
 	 */
-	bool insideCircle(const PolygonInfo &polygon, double lat, double lon, float altitude);
+	bool insideCircle(const PolygonInfo &polygon, const matrix::Vector2f &point) const;
+
+	/**
+	 * @see signedDistanceToFence(), for a local point
+	 */
+	float signedDistance(const matrix::Vector2f &point, float altitude) const;
+
+	/**
+	 * Distance from a point to the edges of a polygon or circle
+	 * @return unsigned distance [m]
+	 */
+	float distanceToEdge(const PolygonInfo &polygon, const matrix::Vector2f &point) const;
 };
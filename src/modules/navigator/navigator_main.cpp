@@ -752,9 +752,9 @@ void Navigator::geofence_breach_check(bool &have_geofence_position_data)
 		gf_violation_type.flags.max_altitude_exceeded = !_geofence.isBelowMaxAltitude(_global_pos.alt +
 				vertical_test_point_distance);
 
-		gf_violation_type.flags.fence_violation = !_geofence.isInsidePolygonOrCircle(fence_violation_test_point(0),
-				fence_violation_test_point(1),
-				_global_pos.alt);
+		// check the whole segment up to the test point, not only the test point itself
+		gf_violation_type.flags.fence_violation = _geofence.distanceToFenceAlongBearing(_global_pos.lat, _global_pos.lon,
+				_global_pos.alt, test_point_bearing, test_point_distance) < math::max(test_point_distance, 0.f);
 
 		_last_geofence_check = hrt_absolute_time();
 		have_geofence_position_data = false;
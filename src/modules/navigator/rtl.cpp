@@ -96,17 +96,8 @@ void RTL::find_RTL_destination()
 	_destination.set(home_landing_position);
 
 	// get distance to home position
-	double dlat = home_landing_position.lat - global_position.lat;
-	double dlon = home_landing_position.lon - global_position.lon;
-
-	double lon_scale = cos(radians(global_position.lat));
-
-	auto coord_dist_sq = [lon_scale](double lat_diff, double lon_diff) -> double {
-		double lon_diff_scaled =  lon_scale * matrix::wrap(lon_diff, -180., 180.);
-		return lat_diff * lat_diff + lon_diff_scaled * lon_diff_scaled;
-	};
-
-	double min_dist_squared = coord_dist_sq(dlat, dlon);
+	float min_dist = get_distance_to_next_waypoint(global_position.lat, global_position.lon,
+			 home_landing_position.lat, home_landing_position.lon);
 
 	_destination.type = RTL_DESTINATION_HOME;
 
@@ -134,13 +125,12 @@ void RTL::find_RTL_destination()
 		}
 
 		// compare home position to landing position to decide which is closer
-		dlat = mission_landing_lat - global_position.lat;
-		dlon = mission_landing_lon - global_position.lon;
-		double dist_squared = coord_dist_sq(dlat, dlon);
+		const float dist = get_distance_to_next_waypoint(global_position.lat, global_position.lon, mission_landing_lat,
+				   mission_landing_lon);
 
 		// set destination to mission landing if closest or in RTL_LAND or RTL_MISSION (so not in RTL_CLOSEST)
-		if (dist_squared < min_dist_squared || rtl_type() != RTL_CLOSEST) {
-			min_dist_squared = dist_squared;
+		if (dist < min_dist || rtl_type() != RTL_CLOSEST) {
+			min_dist = dist;
 			_destination.lat = mission_landing_lat;
 			_destination.lon = mission_landing_lon;
 			_destination.alt = mission_landing_alt;
@@ -155,41 +145,16 @@ void RTL::find_RTL_destination()
 		return;
 	}
 
-	// compare to safe landing positions
-	mission_safe_point_s closest_safe_point {};
-	mission_stats_entry_s stats;
-	int ret = dm_read(DM_KEY_SAFE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
-	int num_safe_points = 0;
+	// compare to safe landing positions (the index is reloaded after an upload)
+	_safe_points.update();
 
-	if (ret == sizeof(mission_stats_entry_s)) {
-		num_safe_points = stats.num_items;
-	}
+	mission_safe_point_s closest_safe_point {};
+	float safe_point_dist = 0.f;
+	const int closest_index = _safe_points.findClosest(global_position.lat, global_position.lon, closest_safe_point,
+				  safe_point_dist);
 
 	// check if a safe point is closer than home or landing
-	int closest_index = 0;
-
-	for (int current_seq = 1; current_seq <= num_safe_points; ++current_seq) {
-		mission_safe_point_s mission_safe_point;
-
-		if (dm_read(DM_KEY_SAFE_POINTS, current_seq, &mission_safe_point, sizeof(mission_safe_point_s)) !=
-		    sizeof(mission_safe_point_s)) {
-			PX4_ERR("dm_read failed");
-			continue;
-		}
-
-		// TODO: take altitude into account for distance measurement
-		dlat = mission_safe_point.lat - global_position.lat;
-		dlon = mission_safe_point.lon - global_position.lon;
-		double dist_squared = coord_dist_sq(dlat, dlon);
-
-		if (dist_squared < min_dist_squared) {
-			closest_index = current_seq;
-			min_dist_squared = dist_squared;
-			closest_safe_point = mission_safe_point;
-		}
-	}
-
-	if (closest_index > 0) {
+	if (closest_index >= 0 && safe_point_dist < min_dist) {
 		_destination.type = RTL_DESTINATION_SAFE_POINT;
 
 		// There is a safe point closer than home/mission landing
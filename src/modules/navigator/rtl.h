@@ -45,6 +45,7 @@
 
 #include "navigator_mode.h"
 #include "mission_block.h"
+#include "safe_point_index.h"
 
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/home_position.h>
@@ -147,6 +148,8 @@ private:
 
 	hrt_abstime _destination_check_time{0};
 
+	SafePointIndex _safe_points;
+
 	float _rtl_alt{0.0f};	// AMSL altitude at which the vehicle should return to the home position
 	bool _rtl_alt_min{false};
 	float _rtl_loiter_rad{50.0f};		// radius at which a fixed wing would loiter while descending
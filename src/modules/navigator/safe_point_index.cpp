@@ -0,0 +1,231 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file safe_point_index.cpp
+ */
+
+#include "safe_point_index.h"
+
+#include <dataman/dataman.h>
+#include <math.h>
+#include <px4_platform_common/log.h>
+#include <string.h>
+
+SafePointIndex::~SafePointIndex()
+{
+	delete[] _safe_points;
+	delete[] _points;
+}
+
+void SafePointIndex::update()
+{
+	mission_stats_entry_s stats;
+	const int ret = dm_read(DM_KEY_SAFE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
+
+	if (ret != sizeof(mission_stats_entry_s)) {
+		if (!_loaded) {
+			// nothing stored yet
+			_num_points = 0;
+			_loaded = true;
+		}
+
+		return;
+	}
+
+	if (_loaded && stats.update_counter == _update_counter) {
+		return;
+	}
+
+	_loaded = true;
+	_update_counter = stats.update_counter;
+	_num_points = 0;
+
+	if (!allocate(stats.num_items)) {
+		return;
+	}
+
+	int num_safe_points = 0;
+
+	for (int seq = 1; seq <= stats.num_items; ++seq) {
+		if (dm_read(DM_KEY_SAFE_POINTS, seq, &_safe_points[num_safe_points], sizeof(mission_safe_point_s)) !=
+		    sizeof(mission_safe_point_s)) {
+			PX4_ERR("dm_read failed");
+			continue;
+		}
+
+		++num_safe_points;
+	}
+
+	index(num_safe_points);
+}
+
+void SafePointIndex::load(const mission_safe_point_s *safe_points, int num_safe_points)
+{
+	_num_points = 0;
+
+	if (!allocate(num_safe_points)) {
+		return;
+	}
+
+	memcpy(_safe_points, safe_points, num_safe_points * sizeof(mission_safe_point_s));
+	index(num_safe_points);
+}
+
+bool SafePointIndex::allocate(int num_safe_points)
+{
+	if (num_safe_points <= _capacity) {
+		return true;
+	}
+
+	delete[] _safe_points;
+	delete[] _points;
+
+	_safe_points = new mission_safe_point_s[num_safe_points];
+	_points = new Point[num_safe_points];
+
+	if (_safe_points == nullptr || _points == nullptr) {
+		PX4_ERR("alloc failed");
+		delete[] _safe_points;
+		delete[] _points;
+		_safe_points = nullptr;
+		_points = nullptr;
+		_capacity = 0;
+		return false;
+	}
+
+	_capacity = num_safe_points;
+	return true;
+}
+
+void SafePointIndex::index(int num_safe_points)
+{
+	if (num_safe_points > 0) {
+		map_projection_init(&_projection_reference, _safe_points[0].lat, _safe_points[0].lon);
+	}
+
+	for (int i = 0; i < num_safe_points; ++i) {
+		_points[i].index = i;
+		map_projection_project(&_projection_reference, _safe_points[i].lat, _safe_points[i].lon, &_points[i].x,
+				       &_points[i].y);
+	}
+
+	_num_points = num_safe_points;
+	build(0, _num_points, 0);
+}
+
+void SafePointIndex::build(int begin, int end, int axis)
+{
+	if (end - begin <= 1) {
+		return;
+	}
+
+	// sort the range along the axis (insertion sort: the tree is only built on upload and the ranges are small)
+	for (int i = begin + 1; i < end; ++i) {
+		const Point point = _points[i];
+		const float key = (axis == 0) ? point.x : point.y;
+		int j = i - 1;
+
+		while (j >= begin && ((axis == 0) ? _points[j].x : _points[j].y) > key) {
+			_points[j + 1] = _points[j];
+			--j;
+		}
+
+		_points[j + 1] = point;
+	}
+
+	const int mid = (begin + end) / 2;
+	build(begin, mid, 1 - axis);
+	build(mid + 1, end, 1 - axis);
+}
+
+void SafePointIndex::search(int begin, int end, int axis, float x, float y, int &closest,
+			    float &closest_dist_sq) const
+{
+	if (begin >= end) {
+		return;
+	}
+
+	const int mid = (begin + end) / 2;
+	const Point &point = _points[mid];
+
+	const float dx = x - point.x;
+	const float dy = y - point.y;
+	const float dist_sq = dx * dx + dy * dy;
+
+	if (dist_sq < closest_dist_sq) {
+		closest_dist_sq = dist_sq;
+		closest = mid;
+	}
+
+	// descend into the half containing the query first, the other half can only contain a closer
+	// point if the splitting line is closer than the closest point found so far
+	const float split_dist = (axis == 0) ? dx : dy;
+
+	if (split_dist < 0.f) {
+		search(begin, mid, 1 - axis, x, y, closest, closest_dist_sq);
+
+		if (split_dist * split_dist < closest_dist_sq) {
+			search(mid + 1, end, 1 - axis, x, y, closest, closest_dist_sq);
+		}
+
+	} else {
+		search(mid + 1, end, 1 - axis, x, y, closest, closest_dist_sq);
+
+		if (split_dist * split_dist < closest_dist_sq) {
+			search(begin, mid, 1 - axis, x, y, closest, closest_dist_sq);
+		}
+	}
+}
+
+int SafePointIndex::findClosest(double lat, double lon, mission_safe_point_s &safe_point, float &distance) const
+{
+	if (_num_points == 0) {
+		return -1;
+	}
+
+	float x, y;
+	map_projection_project(&_projection_reference, lat, lon, &x, &y);
+
+	int closest = -1;
+	float closest_dist_sq = INFINITY;
+	search(0, _num_points, 0, x, y, closest, closest_dist_sq);
+
+	if (closest < 0) {
+		return -1;
+	}
+
+	const int index = _points[closest].index;
+	safe_point = _safe_points[index];
+	distance = get_distance_to_next_waypoint(lat, lon, safe_point.lat, safe_point.lon);
+	return index;
+}
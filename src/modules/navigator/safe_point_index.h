@@ -0,0 +1,104 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file safe_point_index.h
+ * In-memory spatial index of the safe (rally) points for the RTL destination search
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <lib/ecl/geo/geo.h>
+
+#include "navigation.h"
+
+/**
+ * The safe points are read from dataman once (and again after every upload) and stored in a
+ * 2-d tree over their local position, so that the closest one can be found in O(log n).
+ */
+class SafePointIndex
+{
+public:
+	SafePointIndex() = default;
+	~SafePointIndex();
+
+	// no copy, assignment, move, move assignment
+	SafePointIndex(const SafePointIndex &) = delete;
+	SafePointIndex &operator=(const SafePointIndex &) = delete;
+	SafePointIndex(SafePointIndex &&) = delete;
+	SafePointIndex &operator=(SafePointIndex &&) = delete;
+
+	/**
+	 * Reload the safe points from dataman if they changed since the last call.
+	 */
+	void update();
+
+	/**
+	 * Replace the indexed safe points.
+	 */
+	void load(const mission_safe_point_s *safe_points, int num_safe_points);
+
+	int count() const { return _num_points; }
+
+	/**
+	 * Find the safe point with the smallest horizontal distance to a position.
+	 *
+	 * @param safe_point set to the closest safe point
+	 * @param distance set to its horizontal distance [m]
+	 * @return index of the safe point (dataman index - 1), -1 if there are no safe points
+	 */
+	int findClosest(double lat, double lon, mission_safe_point_s &safe_point, float &distance) const;
+
+private:
+	struct Point {
+		float x;	///< local position relative to _projection_reference [m]
+		float y;
+		uint16_t index;	///< index of the safe point in _safe_points
+	};
+
+	bool allocate(int num_safe_points);
+	void index(int num_safe_points);
+	void build(int begin, int end, int axis);
+	void search(int begin, int end, int axis, float x, float y, int &closest, float &closest_dist_sq) const;
+
+	map_projection_reference_s _projection_reference{};
+
+	mission_safe_point_s *_safe_points{nullptr};
+	Point *_points{nullptr};	///< 2-d tree: the median of a range splits it along axis (depth % 2)
+	int _num_points{0};
+	int _capacity{0};
+
+	bool _loaded{false};
+	uint16_t _update_counter{0};	///< dataman update counter of the loaded safe points
+};
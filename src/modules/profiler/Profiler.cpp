@@ -0,0 +1,547 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "Profiler.hpp"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <px4_platform_common/getopt.h>
+#include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__PX4_NUTTX)
+#include <arch/irq.h>
+#endif
+
+#if defined(__PX4_LINUX)
+#include <dirent.h>
+#include <link.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <ucontext.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+using namespace time_literals;
+
+namespace profiler
+{
+
+Profiler::sample_t Profiler::_ring[RING_SIZE];
+px4::atomic<uint32_t> Profiler::_write_index{0};
+px4::atomic<uint32_t> Profiler::_read_index{0};
+px4::atomic<uint32_t> Profiler::_dropped{0};
+
+#if defined(__PX4_LINUX)
+uintptr_t Profiler::_exe_start = 0;
+uintptr_t Profiler::_exe_end = 0;
+uintptr_t Profiler::_exe_load_address = 0;
+#endif
+
+Profiler::Profiler(int rate_hz) :
+	ScheduledWorkItem(MODULE_NAME, px4::wq_configurations::lp_default),
+	_rate_hz(rate_hz)
+{
+}
+
+Profiler::~Profiler()
+{
+	stop_sampling();
+	ScheduleClear();
+}
+
+void Profiler::take_sample(int tid, const uintptr_t *addresses, int depth)
+{
+	// reserve a slot, unless the reader is a full ring behind
+	uint32_t index = _write_index.load();
+
+	do {
+		if (index - _read_index.load() >= RING_SIZE) {
+			_dropped.fetch_add(1);
+			return;
+		}
+	} while (!_write_index.compare_exchange(&index, index + 1));
+
+	sample_t &sample = _ring[index % RING_SIZE];
+	sample.timestamp = hrt_absolute_time();
+	sample.tid = tid;
+	sample.wq_name = nullptr;
+	sample.item_name = px4::WorkQueueRunningItem(tid, &sample.wq_name);
+	sample.depth = depth;
+
+	for (int i = 0; i < depth; i++) {
+		sample.addresses[i] = addresses[i];
+	}
+
+	sample.sequence.store(index + 1);
+}
+
+#if defined(__PX4_LINUX)
+
+/**
+ * Read memory of this process that might not be mapped (the read fails instead of faulting).
+ */
+static bool read_memory(uintptr_t address, uintptr_t *data, size_t count)
+{
+	struct iovec local {data, count * sizeof(uintptr_t)};
+	struct iovec remote {(void *)address, count * sizeof(uintptr_t)};
+	return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == (ssize_t)(count * sizeof(uintptr_t));
+}
+
+int Profiler::unwind(const void *context, uintptr_t *addresses)
+{
+	const ucontext_t *uc = (const ucontext_t *)context;
+	uintptr_t pc;
+	uintptr_t fp;
+	uintptr_t sp;
+
+#if defined(__x86_64__)
+	pc = uc->uc_mcontext.gregs[REG_RIP];
+	fp = uc->uc_mcontext.gregs[REG_RBP];
+	sp = uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+	pc = uc->uc_mcontext.pc;
+	fp = uc->uc_mcontext.regs[29];
+	sp = uc->uc_mcontext.sp;
+#else
+	// only the program counter, the frame layout is not known
+	(void)uc;
+	return 0;
+#endif
+
+	int depth = 0;
+	addresses[depth++] = pc;
+
+	// a frame record is {caller frame pointer, return address}, each one further up the stack.
+	// Code built without frame pointers uses the register for other values, the walk then
+	// stops at the first record that is not plausible.
+	static constexpr uintptr_t MAX_FRAME_DISTANCE = 8 * 1024 * 1024;
+
+	while (depth < MAX_DEPTH) {
+		if (fp < sp || fp - sp > MAX_FRAME_DISTANCE || (fp % sizeof(uintptr_t)) != 0) {
+			break;
+		}
+
+		uintptr_t record[2];
+
+		if (!read_memory(fp, record, 2) || record[1] == 0) {
+			break;
+		}
+
+		addresses[depth++] = record[1];
+
+		// the next record is above this one
+		sp = fp + sizeof(record);
+		fp = record[0];
+	}
+
+	return depth;
+}
+
+void Profiler::sigprof_handler(int signo, siginfo_t *info, void *context)
+{
+	// async-signal-safe: no allocations, locks or unwinder library, only system calls
+	const int saved_errno = errno;
+
+	uintptr_t addresses[MAX_DEPTH];
+	const int depth = unwind(context, addresses);
+
+	for (int i = 0; i < depth; i++) {
+		if (addresses[i] >= _exe_start && addresses[i] < _exe_end) {
+			addresses[i] -= _exe_load_address;
+		}
+	}
+
+	take_sample(syscall(SYS_gettid), addresses, depth);
+
+	errno = saved_errno;
+}
+
+void Profiler::update_thread_timers()
+{
+	for (int i = 0; i < _thread_timer_count; i++) {
+		_thread_timers[i].alive = false;
+	}
+
+	DIR *dir = opendir("/proc/self/task");
+
+	if (dir == nullptr) {
+		return;
+	}
+
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != nullptr) {
+		const int tid = atoi(entry->d_name);
+
+		if (tid <= 0) {
+			continue;
+		}
+
+		bool found = false;
+
+		for (int i = 0; i < _thread_timer_count; i++) {
+			if (_thread_timers[i].tid == tid) {
+				_thread_timers[i].alive = true;
+				found = true;
+				break;
+			}
+		}
+
+		if (found || _thread_timer_count >= MAX_THREADS) {
+			continue;
+		}
+
+		// the CPU time clock of the thread (as pthread_getcpuclockid() computes it), the timer
+		// only runs while the thread does, so threads blocked in a system call are not interrupted
+		const clockid_t clock = (clockid_t)((~(unsigned)tid << 3) | 6);
+
+		struct sigevent event {};
+		event.sigev_notify = SIGEV_THREAD_ID;
+		event.sigev_signo = SIGPROF;
+		event.sigev_notify_thread_id = tid;
+
+		thread_timer_t &thread_timer = _thread_timers[_thread_timer_count];
+
+		if (timer_create(clock, &event, &thread_timer.timer) != 0) {
+			continue;
+		}
+
+		struct itimerspec spec {};
+		spec.it_interval.tv_sec = _interval_us / 1000000;
+		spec.it_interval.tv_nsec = (_interval_us % 1000000) * 1000;
+		spec.it_value = spec.it_interval;
+
+		if (timer_settime(thread_timer.timer, 0, &spec, nullptr) != 0) {
+			timer_delete(thread_timer.timer);
+			continue;
+		}
+
+		thread_timer.tid = tid;
+		thread_timer.alive = true;
+		_thread_timer_count++;
+	}
+
+	closedir(dir);
+
+	for (int i = 0; i < _thread_timer_count;) {
+		if (_thread_timers[i].alive) {
+			i++;
+
+		} else {
+			timer_delete(_thread_timers[i].timer);
+			_thread_timers[i] = _thread_timers[--_thread_timer_count];
+		}
+	}
+
+	_thread_scan_time = hrt_absolute_time();
+}
+
+void Profiler::delete_thread_timers()
+{
+	for (int i = 0; i < _thread_timer_count; i++) {
+		timer_delete(_thread_timers[i].timer);
+	}
+
+	_thread_timer_count = 0;
+}
+
+static int find_executable(struct dl_phdr_info *info, size_t size, void *data)
+{
+	// the first entry is the executable itself
+	uintptr_t *range = (uintptr_t *)data;
+	range[0] = UINTPTR_MAX;
+	range[1] = 0;
+	range[2] = info->dlpi_addr;
+
+	for (int i = 0; i < info->dlpi_phnum; i++) {
+		const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+
+		if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X)) {
+			const uintptr_t start = info->dlpi_addr + phdr.p_vaddr;
+
+			if (start < range[0]) {
+				range[0] = start;
+			}
+
+			if (start + phdr.p_memsz > range[1]) {
+				range[1] = start + phdr.p_memsz;
+			}
+		}
+	}
+
+	return 1;
+}
+
+#elif defined(__PX4_NUTTX)
+
+void Profiler::hrt_sample(void *arg)
+{
+	uintptr_t addresses[2];
+	int depth = 0;
+
+#if defined(CONFIG_ARCH_ARMV7M)
+	// registers of the interrupted context (there are no frame pointers to unwind further)
+	const volatile uint32_t *regs = g_current_regs;
+
+	if (regs != nullptr) {
+		addresses[depth++] = regs[REG_PC];
+		addresses[depth++] = regs[REG_LR];
+	}
+
+#endif
+
+	take_sample(getpid(), addresses, depth);
+}
+
+#endif
+
+bool Profiler::init()
+{
+#if defined(__PX4_LINUX)
+	uintptr_t range[3] {};
+	dl_iterate_phdr(find_executable, range);
+	_exe_start = range[0];
+	_exe_end = range[1];
+	_exe_load_address = range[2];
+
+	struct sigaction action {};
+	action.sa_sigaction = sigprof_handler;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+
+	if (sigaction(SIGPROF, &action, &_old_action) != 0) {
+		PX4_ERR("sigaction failed (%i)", errno);
+		return false;
+	}
+
+	// a CPU time timer per thread, threads started later are picked up in Run()
+	update_thread_timers();
+
+	if (_thread_timer_count == 0) {
+		PX4_ERR("timer_create failed (%i)", errno);
+		sigaction(SIGPROF, &_old_action, nullptr);
+		return false;
+	}
+
+#elif defined(__PX4_NUTTX)
+	hrt_call_every(&_hrt_call, _interval_us, _interval_us, hrt_sample, nullptr);
+#else
+	PX4_ERR("not supported on this platform");
+	return false;
+#endif
+
+	_sampling = true;
+
+	// the publication queue holds 16 samples
+	ScheduleOnInterval(20_ms);
+	return true;
+}
+
+void Profiler::stop_sampling()
+{
+	if (!_sampling) {
+		return;
+	}
+
+#if defined(__PX4_LINUX)
+	delete_thread_timers();
+
+	// ignore a signal that might still be pending before restoring the previous handler
+	struct sigaction ignore {};
+	ignore.sa_handler = SIG_IGN;
+	sigaction(SIGPROF, &ignore, nullptr);
+	sigaction(SIGPROF, &_old_action, nullptr);
+#elif defined(__PX4_NUTTX)
+	hrt_cancel(&_hrt_call);
+#endif
+
+	_sampling = false;
+}
+
+void Profiler::Run()
+{
+	if (should_exit()) {
+		ScheduleClear();
+		exit_and_cleanup();
+		return;
+	}
+
+#if defined(__PX4_LINUX)
+
+	if (hrt_elapsed_time(&_thread_scan_time) > 1_s) {
+		update_thread_timers();
+	}
+
+#endif
+
+	uint32_t index = _read_index.load();
+	int published = 0;
+
+	while (published < profiler_sample_s::ORB_QUEUE_LENGTH && _ring[index % RING_SIZE].sequence.load() == index + 1) {
+		const sample_t &sample = _ring[index % RING_SIZE];
+
+		profiler_sample_s report{};
+		report.timestamp_sample = sample.timestamp;
+		report.tid = sample.tid;
+
+		if (sample.wq_name) {
+			strncpy(report.wq_name, sample.wq_name, sizeof(report.wq_name) - 1);
+		}
+
+		if (sample.item_name) {
+			strncpy(report.item_name, sample.item_name, sizeof(report.item_name) - 1);
+		}
+
+		const uint32_t dropped = _dropped.load();
+		report.dropped = dropped - _dropped_reported;
+		_dropped_reported = dropped;
+
+		report.depth = sample.depth;
+
+		for (int i = 0; i < sample.depth; i++) {
+			report.addresses[i] = sample.addresses[i];
+		}
+
+		// release the slot before publishing
+		_read_index.store(++index);
+
+		report.timestamp = hrt_absolute_time();
+		_profiler_sample_pub.publish(report);
+		++published;
+		++_published;
+	}
+}
+
+int Profiler::print_status()
+{
+	PX4_INFO("sampling at %i Hz: %" PRIu32 " samples published, %" PRIu32 " dropped", _rate_hz, _published,
+		 _dropped.load());
+	return 0;
+}
+
+int Profiler::task_spawn(int argc, char *argv[])
+{
+	int rate_hz = 100;
+	int myoptind = 1;
+	int ch;
+	const char *myoptarg = nullptr;
+
+	while ((ch = px4_getopt(argc, argv, "r:", &myoptind, &myoptarg)) != EOF) {
+		switch (ch) {
+		case 'r':
+			rate_hz = atoi(myoptarg);
+			break;
+
+		default:
+			return print_usage("unrecognized flag");
+		}
+	}
+
+	if (rate_hz < 1 || rate_hz > 1000) {
+		return print_usage("rate must be between 1 and 1000 Hz");
+	}
+
+	Profiler *instance = new Profiler(rate_hz);
+
+	if (instance == nullptr) {
+		PX4_ERR("alloc failed");
+		return PX4_ERROR;
+	}
+
+	_object.store(instance);
+	_task_id = task_id_is_work_queue;
+
+	if (instance->init()) {
+		return PX4_OK;
+	}
+
+	delete instance;
+	_object.store(nullptr);
+	_task_id = -1;
+
+	return PX4_ERROR;
+}
+
+int Profiler::custom_command(int argc, char *argv[])
+{
+	return print_usage("unknown command");
+}
+
+int Profiler::print_usage(const char *reason)
+{
+	if (reason) {
+		PX4_WARN("%s\n", reason);
+	}
+
+	PRINT_MODULE_DESCRIPTION(
+		R"DESCR_STR(
+### Description
+Sampling profiler. It periodically interrupts the running thread and records the work item being run
+together with the program counter and return addresses, and publishes the samples as `profiler_sample`
+(logged with the debug logging profile, see SDLOG_PROFILE).
+
+On Linux the samples are taken by a `SIGPROF` timer per thread (based on the CPU time of the thread, so blocked
+threads are not interrupted) and contain the call stack from the frame pointer chain. Full call stacks need a
+build with frame pointers (`-fno-omit-frame-pointer`, e.g. a sanitizer build), otherwise the stack ends after
+the first frame without one. Addresses inside the px4 executable are relative to its load address.
+On NuttX the samples are taken from the HRT interrupt and contain only the program counter and link register.
+
+Use `Tools/profiler_flamegraph.py` to turn a log into a flame graph.
+
+### Examples
+Sample at 200 Hz:
+$ profiler start -r 200
+)DESCR_STR");
+
+	PRINT_MODULE_USAGE_NAME("profiler", "system");
+	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_PARAM_INT('r', 100, 1, 1000, "Sampling rate in Hz", true);
+	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
+
+	return 0;
+}
+
+} // namespace profiler
+
+extern "C" __EXPORT int profiler_main(int argc, char *argv[])
+{
+	return profiler::Profiler::main(argc, argv);
+}
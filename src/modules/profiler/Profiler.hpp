@@ -0,0 +1,152 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file Profiler.hpp
+ *
+ * Sampling profiler: periodically interrupts the running thread, records the work item it is
+ * running and its return addresses, and publishes the samples as profiler_sample for the logger.
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+#include <signal.h>
+#include <px4_platform_common/atomic.h>
+#include <px4_platform_common/module.h>
+#include <px4_platform_common/px4_work_queue/ScheduledWorkItem.hpp>
+#include <uORB/Publication.hpp>
+#include <uORB/topics/profiler_sample.h>
+
+namespace profiler
+{
+
+class Profiler : public ModuleBase<Profiler>, public px4::ScheduledWorkItem
+{
+public:
+	Profiler(int rate_hz);
+	~Profiler() override;
+
+	/** @see ModuleBase */
+	static int task_spawn(int argc, char *argv[]);
+
+	/** @see ModuleBase */
+	static int custom_command(int argc, char *argv[]);
+
+	/** @see ModuleBase */
+	static int print_usage(const char *reason = nullptr);
+
+	/** @see ModuleBase::print_status() */
+	int print_status() override;
+
+	bool init();
+
+private:
+	static constexpr int MAX_DEPTH = sizeof(profiler_sample_s::addresses) / sizeof(profiler_sample_s::addresses[0]);
+
+	/**
+	 * Sample slot, written from the signal handler (Linux) or the HRT interrupt (NuttX).
+	 * sequence is set to (index + 1) once the slot at index is complete.
+	 */
+	struct sample_t {
+		px4::atomic<uint32_t> sequence{0};
+		hrt_abstime timestamp;
+		int tid;
+		const char *wq_name;
+		const char *item_name;
+		uint8_t depth;
+		uint64_t addresses[MAX_DEPTH];
+	};
+
+	static constexpr uint32_t RING_SIZE = 64;
+
+	/** Take a sample of the interrupted context (called from signal/interrupt context). */
+	static void take_sample(int tid, const uintptr_t *addresses, int depth);
+
+	void Run() override;
+
+	void stop_sampling();
+
+#if defined(__PX4_LINUX)
+	static void sigprof_handler(int signo, siginfo_t *info, void *context);
+
+	/**
+	 * Walk the frame pointer chain of the interrupted context (async-signal-safe).
+	 * @return number of addresses, starting with the program counter
+	 */
+	static int unwind(const void *context, uintptr_t *addresses);
+
+	/** Start a timer for every new thread and delete the ones of exited threads */
+	void update_thread_timers();
+	void delete_thread_timers();
+
+	static constexpr int MAX_THREADS = 128;
+
+	struct thread_timer_t {
+		int tid;
+		timer_t timer;
+		bool alive;
+	};
+
+	thread_timer_t _thread_timers[MAX_THREADS] {};
+	int _thread_timer_count{0};
+	hrt_abstime _thread_scan_time{0};
+
+	/** Addresses inside the executable are logged relative to its load address (it may be a PIE) */
+	static uintptr_t _exe_start;
+	static uintptr_t _exe_end;
+	static uintptr_t _exe_load_address;
+
+	struct sigaction _old_action {};
+#elif defined(__PX4_NUTTX)
+	static void hrt_sample(void *arg);
+
+	struct hrt_call _hrt_call {};
+#endif
+
+	static sample_t _ring[RING_SIZE];
+	static px4::atomic<uint32_t> _write_index;
+	static px4::atomic<uint32_t> _read_index;
+	static px4::atomic<uint32_t> _dropped;
+
+	uORB::Publication<profiler_sample_s> _profiler_sample_pub{ORB_ID(profiler_sample)};
+
+	const int _rate_hz;
+	const uint32_t _interval_us{1000000u / _rate_hz};
+	uint32_t _published{0};
+	uint32_t _dropped_reported{0};
+	bool _sampling{false};
+};
+
+} // namespace profiler
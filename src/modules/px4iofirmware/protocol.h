@@ -80,7 +80,7 @@
 
 #define REG_TO_BOOL(_reg) 	((bool)(_reg))
 
-#define PX4IO_PROTOCOL_VERSION		4
+#define PX4IO_PROTOCOL_VERSION		5
 
 /* maximum allowable sizes on this protocol version */
 #define PX4IO_PROTOCOL_MAX_CONTROL_COUNT	8	/**< The protocol does not support more than set here, individual units might support less - see PX4IO_P_CONFIG_CONTROL_COUNT */
@@ -171,6 +171,24 @@
 #define PX4IO_PAGE_PWM_INFO		7
 #define PX4IO_RATE_MAP_BASE			0	/* 0..CONFIG_ACTUATOR_COUNT bitmaps of PWM rate groups */
 
+/* registers the FMU polls every cycle, read in one transfer or as reply to a PKT_CODE_CYCLE write */
+#define PX4IO_PAGE_CYCLE		8
+#define PX4IO_P_CYCLE_STATUS_FLAGS		0	/* PX4IO_P_STATUS_FLAGS */
+#define PX4IO_P_CYCLE_STATUS_ALARMS		1	/* PX4IO_P_STATUS_ALARMS */
+#define PX4IO_P_CYCLE_STATUS_VSERVO		2	/* PX4IO_P_STATUS_VSERVO */
+#define PX4IO_P_CYCLE_STATUS_VRSSI		3	/* PX4IO_P_STATUS_VRSSI */
+#define PX4IO_P_CYCLE_STATUS_MIXER		4	/* PX4IO_P_STATUS_MIXER */
+#define PX4IO_P_CYCLE_SETUP_ARMING		5	/* PX4IO_P_SETUP_ARMING */
+#define PX4IO_P_CYCLE_SERVOS			6	/* PX4IO_PAGE_SERVOS, PX4IO_P_CYCLE_SERVO_COUNT values */
+#define PX4IO_P_CYCLE_SERVO_COUNT		8
+#define PX4IO_P_CYCLE_RAW_RC			(PX4IO_P_CYCLE_SERVOS + PX4IO_P_CYCLE_SERVO_COUNT)	/* PX4IO_PAGE_RAW_RC_INPUT from PX4IO_P_RAW_RC_COUNT */
+#define PX4IO_P_CYCLE_RAW_RC_CHANNELS		9	/* channels included, the others are read from PX4IO_PAGE_RAW_RC_INPUT */
+#define PX4IO_P_CYCLE_COUNT			(PX4IO_P_CYCLE_RAW_RC + PX4IO_P_RAW_RC_BASE + PX4IO_P_CYCLE_RAW_RC_CHANNELS)
+
+#if (PX4IO_P_CYCLE_COUNT > (PX4IO_MAX_TRANSFER_LEN - 2) / 2)
+#error The cycle page must fit into one transfer
+#endif
+
 /* setup page */
 #define PX4IO_PAGE_SETUP		50
 #define PX4IO_P_SETUP_FEATURES			0
@@ -343,6 +361,7 @@ struct IOPacket {
 
 #define PKT_CODE_READ		0x00	/* FMU->IO read transaction */
 #define PKT_CODE_WRITE		0x40	/* FMU->IO write transaction */
+#define PKT_CODE_CYCLE		0x80	/* FMU->IO write transaction, replied with the registers of PX4IO_PAGE_CYCLE */
 #define PKT_CODE_SUCCESS	0x00	/* IO->FMU success reply */
 #define PKT_CODE_CORRUPT	0x40	/* IO->FMU bad packet reply */
 #define PKT_CODE_ERROR		0x80	/* IO->FMU register op error reply */
@@ -143,6 +143,17 @@ uint16_t		r_page_scratch[32];
 /**
  * PAGE 8
  *
+ * Registers polled by the FMU every cycle, constructed as-read.
+ */
+static uint16_t		r_page_cycle[PX4IO_P_CYCLE_COUNT];
+
+#if (PX4IO_P_CYCLE_SERVO_COUNT != PX4IO_SERVO_COUNT)
+#error The cycle page must hold all servos
+#endif
+
+/**
+ * PAGE 54
+ *
  * RAW PWM values
  */
 uint16_t		r_page_direct_pwm[PX4IO_SERVO_COUNT];
@@ -837,100 +848,109 @@ registers_set_one(uint8_t page, uint8_t offset, uint16_t value)
 	return 0;
 }
 
-uint8_t last_page;
-uint8_t last_offset;
-
-int
-registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_values)
+/*
+ * Update the status registers that are measured at read time.
+ */
+static void
+registers_update_status(void)
 {
-#define SELECT_PAGE(_page_name)							\
-	do {									\
-		*values = (uint16_t *)&_page_name[0];				\
-		*num_values = sizeof(_page_name) / sizeof(_page_name[0]);	\
-	} while(0)
-
-	switch (page) {
-
-	/*
-	 * Handle pages that are updated dynamically at read time.
-	 */
-	case PX4IO_PAGE_STATUS:
-		/* PX4IO_P_STATUS_FREEMEM */
+	/* PX4IO_P_STATUS_FREEMEM */
 
-		/* XXX PX4IO_P_STATUS_CPULOAD */
+	/* XXX PX4IO_P_STATUS_CPULOAD */
 
-		/* PX4IO_P_STATUS_FLAGS maintained externally */
+	/* PX4IO_P_STATUS_FLAGS maintained externally */
 
-		/* PX4IO_P_STATUS_ALARMS maintained externally */
+	/* PX4IO_P_STATUS_ALARMS maintained externally */
 
 #ifdef ADC_VBATT
-		/* PX4IO_P_STATUS_VBATT */
-		{
-			/*
-			 * Coefficients here derived by measurement of the 5-16V
-			 * range on one unit, validated on sample points of another unit
-			 *
-			 * Data in Tools/tests-host/data folder.
-			 *
-			 * measured slope = 0.004585267878277 (int: 4585)
-			 * nominal theoretic slope: 0.00459340659 (int: 4593)
-			 * intercept = 0.016646394188076 (int: 16646)
-			 * nominal theoretic intercept: 0.00 (int: 0)
-			 *
-			 */
-			unsigned counts = adc_measure(ADC_VBATT);
+	/* PX4IO_P_STATUS_VBATT */
+	{
+		/*
+		 * Coefficients here derived by measurement of the 5-16V
+		 * range on one unit, validated on sample points of another unit
+		 *
+		 * Data in Tools/tests-host/data folder.
+		 *
+		 * measured slope = 0.004585267878277 (int: 4585)
+		 * nominal theoretic slope: 0.00459340659 (int: 4593)
+		 * intercept = 0.016646394188076 (int: 16646)
+		 * nominal theoretic intercept: 0.00 (int: 0)
+		 *
+		 */
+		unsigned counts = adc_measure(ADC_VBATT);
 
-			if (counts != 0xffff) {
-				unsigned mV = (166460 + (counts * 45934)) / 10000;
-				unsigned corrected = (mV * r_page_setup[PX4IO_P_SETUP_VBATT_SCALE]) / 10000;
+		if (counts != 0xffff) {
+			unsigned mV = (166460 + (counts * 45934)) / 10000;
+			unsigned corrected = (mV * r_page_setup[PX4IO_P_SETUP_VBATT_SCALE]) / 10000;
 
-				r_page_status[PX4IO_P_STATUS_VBATT] = corrected;
-			}
+			r_page_status[PX4IO_P_STATUS_VBATT] = corrected;
 		}
+	}
 
 #endif
 #ifdef ADC_IBATT
-		/* PX4IO_P_STATUS_IBATT */
-		{
-			/*
-			  note that we have no idea what sort of
-			  current sensor is attached, so we just
-			  return the raw 12 bit ADC value and let the
-			  FMU sort it out, with user selectable
-			  configuration for their sensor
-			 */
-			unsigned counts = adc_measure(ADC_IBATT);
+	/* PX4IO_P_STATUS_IBATT */
+	{
+		/*
+		  note that we have no idea what sort of
+		  current sensor is attached, so we just
+		  return the raw 12 bit ADC value and let the
+		  FMU sort it out, with user selectable
+		  configuration for their sensor
+		 */
+		unsigned counts = adc_measure(ADC_IBATT);
 
-			if (counts != 0xffff) {
-				r_page_status[PX4IO_P_STATUS_IBATT] = counts;
-			}
+		if (counts != 0xffff) {
+			r_page_status[PX4IO_P_STATUS_IBATT] = counts;
 		}
+	}
 #endif
 #ifdef ADC_VSERVO
-		/* PX4IO_P_STATUS_VSERVO */
-		{
-			unsigned counts = adc_measure(ADC_VSERVO);
-
-			if (counts != 0xffff) {
-				// use 3:1 scaling on 3.3V ADC input
-				unsigned mV = counts * 9900 / 4096;
-				r_page_status[PX4IO_P_STATUS_VSERVO] = mV;
-			}
+	/* PX4IO_P_STATUS_VSERVO */
+	{
+		unsigned counts = adc_measure(ADC_VSERVO);
+
+		if (counts != 0xffff) {
+			// use 3:1 scaling on 3.3V ADC input
+			unsigned mV = counts * 9900 / 4096;
+			r_page_status[PX4IO_P_STATUS_VSERVO] = mV;
 		}
+	}
 #endif
 #ifdef ADC_RSSI
-		/* PX4IO_P_STATUS_VRSSI */
-		{
-			unsigned counts = adc_measure(ADC_RSSI);
-
-			if (counts != 0xffff) {
-				// use 1:1 scaling on 3.3V ADC input
-				unsigned mV = counts * 3300 / 4096;
-				r_page_status[PX4IO_P_STATUS_VRSSI] = mV;
-			}
+	/* PX4IO_P_STATUS_VRSSI */
+	{
+		unsigned counts = adc_measure(ADC_RSSI);
+
+		if (counts != 0xffff) {
+			// use 1:1 scaling on 3.3V ADC input
+			unsigned mV = counts * 3300 / 4096;
+			r_page_status[PX4IO_P_STATUS_VRSSI] = mV;
 		}
+	}
 #endif
-		/* XXX PX4IO_P_STATUS_PRSSI */
+	/* XXX PX4IO_P_STATUS_PRSSI */
+}
+
+uint8_t last_page;
+uint8_t last_offset;
+
+int
+registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_values)
+{
+#define SELECT_PAGE(_page_name)							\
+	do {									\
+		*values = (uint16_t *)&_page_name[0];				\
+		*num_values = sizeof(_page_name) / sizeof(_page_name[0]);	\
+	} while(0)
+
+	switch (page) {
+
+	/*
+	 * Handle pages that are updated dynamically at read time.
+	 */
+	case PX4IO_PAGE_STATUS:
+		registers_update_status();
 
 		SELECT_PAGE(r_page_status);
 		break;
@@ -963,6 +983,22 @@ registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_val
 		SELECT_PAGE(r_page_scratch);
 		break;
 
+	case PX4IO_PAGE_CYCLE:
+		registers_update_status();
+
+		r_page_cycle[PX4IO_P_CYCLE_STATUS_FLAGS] = r_page_status[PX4IO_P_STATUS_FLAGS];
+		r_page_cycle[PX4IO_P_CYCLE_STATUS_ALARMS] = r_page_status[PX4IO_P_STATUS_ALARMS];
+		r_page_cycle[PX4IO_P_CYCLE_STATUS_VSERVO] = r_page_status[PX4IO_P_STATUS_VSERVO];
+		r_page_cycle[PX4IO_P_CYCLE_STATUS_VRSSI] = r_page_status[PX4IO_P_STATUS_VRSSI];
+		r_page_cycle[PX4IO_P_CYCLE_STATUS_MIXER] = r_page_status[PX4IO_P_STATUS_MIXER];
+		r_page_cycle[PX4IO_P_CYCLE_SETUP_ARMING] = r_page_setup[PX4IO_P_SETUP_ARMING];
+		memcpy(&r_page_cycle[PX4IO_P_CYCLE_SERVOS], r_page_servos, PX4IO_P_CYCLE_SERVO_COUNT * sizeof(uint16_t));
+		memcpy(&r_page_cycle[PX4IO_P_CYCLE_RAW_RC], r_page_raw_rc_input,
+		       (PX4IO_P_RAW_RC_BASE + PX4IO_P_CYCLE_RAW_RC_CHANNELS) * sizeof(uint16_t));
+
+		SELECT_PAGE(r_page_cycle);
+		break;
+
 	/*
 	 * Pages that are just a straight read of the register state.
 	 */
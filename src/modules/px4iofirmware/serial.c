@@ -194,6 +194,29 @@ rx_handle_packet(void)
 		return;
 	}
 
+	if (PKT_CODE(dma_packet) == PKT_CODE_CYCLE) {
+
+		/* a write, the reply carries the cycle registers */
+		unsigned count;
+		uint16_t *registers;
+
+		if (registers_set(dma_packet.page, dma_packet.offset, &dma_packet.regs[0], PKT_COUNT(dma_packet))
+		    || (registers_get(PX4IO_PAGE_CYCLE, 0, &registers, &count) < 0)) {
+#if defined(PX4IO_PERF)
+			perf_count(pc_regerr);
+#endif
+
+			dma_packet.count_code = PKT_CODE_ERROR;
+
+		} else {
+			/* copy reply registers into DMA buffer */
+			memcpy((void *)&dma_packet.regs[0], registers, count * 2);
+			dma_packet.count_code = count | PKT_CODE_SUCCESS;
+		}
+
+		return;
+	}
+
 	if (PKT_CODE(dma_packet) == PKT_CODE_READ) {
 
 		/* it's a read - get register pointer for reply */
@@ -489,6 +489,37 @@ Replay::readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_
 {
 	ulog_message_header_s message_header;
 
+	if (_index.valid()) {
+		// jump directly to the messages of interest
+		const std::vector<uint64_t> &messages = _index.nonDataMessages();
+
+		for (; _next_non_data_message < messages.size(); ++_next_non_data_message) {
+			const std::streampos pos = (streamoff)messages[_next_non_data_message];
+
+			if (pos >= end_position) {
+				break;
+			}
+
+			file.seekg(pos);
+			file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+
+			if (!file) {
+				return false;
+			}
+
+			if (message_header.msg_type == (int)ULogMessageType::PARAMETER) {
+				if (!readAndApplyParameter(file, message_header.msg_size)) {
+					return false;
+				}
+
+			} else if (message_header.msg_type == (int)ULogMessageType::DROPOUT) {
+				readDropout(file, message_header.msg_size);
+			}
+		}
+
+		return true;
+	}
+
 	while (file.tellg() < end_position) {
 		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
 
@@ -572,6 +603,10 @@ Replay::readDropout(std::ifstream &file, uint16_t msg_size)
 bool
 Replay::nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id)
 {
+	if (_index.valid()) {
+		return nextIndexedDataMessage(file, subscription, msg_id);
+	}
+
 	ulog_message_header_s message_header;
 	file.seekg(subscription.next_read_pos);
 	//ignore the first message (it's data we already read)
@@ -654,6 +689,38 @@ Replay::nextDataMessage(std::ifstream &file, Subscription &subscription, int msg
 	return file.good();
 }
 
+bool
+Replay::nextIndexedDataMessage(std::ifstream &file, Subscription &subscription, int msg_id)
+{
+	ulog_message_header_s message_header;
+	const int64_t count = _index.messageCount(msg_id);
+
+	while (++subscription.next_index < count) {
+		const std::streampos pos = (streamoff)_index.messageOffset(msg_id, subscription.next_index);
+		file.seekg(pos);
+		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+
+		if (!file) {
+			return false;
+		}
+
+		if (message_header.msg_size == subscription.orb_meta->o_size_no_padding + 2) {
+			subscription.next_read_pos = pos;
+			file.seekg(sizeof(uint16_t) + subscription.timestamp_offset, ios::cur); // skip msg id
+			file.read((char *)&subscription.next_timestamp, sizeof(subscription.next_timestamp));
+			return file.good();
+		}
+
+		PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
+			subscription.orb_meta->o_name, message_header.msg_size,
+			subscription.orb_meta->o_size_no_padding + 2);
+	}
+
+	//no more data messages for this subscription
+	subscription.orb_meta = nullptr;
+	return true;
+}
+
 const orb_metadata *
 Replay::findTopic(const std::string &name)
 {
@@ -757,6 +824,51 @@ Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 	return true;
 }
 
+void
+Replay::indexDataSection(std::ifstream &file)
+{
+	file.seekg(0, ios::end);
+	const int64_t file_size = file.tellg();
+	const int64_t data_end = file_size < _read_until_file_position ? file_size : _read_until_file_position;
+
+	if (!_index.loadOrBuild(_replay_file, file, (streamoff)_data_section_start, data_end)) {
+		PX4_WARN("Failed to index the log, parsing it sequentially");
+	}
+
+	file.clear();
+}
+
+bool
+Replay::addSubscriptions(std::ifstream &file)
+{
+	ulog_message_header_s message_header;
+
+	if (!_index.valid()) {
+		file.seekg(_data_section_start);
+
+		//we know the next message must be an ADD_LOGGED_MSG, the others are added while parsing
+		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+		return readAndAddSubscription(file, message_header.msg_size);
+	}
+
+	// the data messages are not parsed sequentially, so add all subscriptions upfront
+	for (uint64_t offset : _index.nonDataMessages()) {
+		file.seekg((streamoff)offset);
+		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+
+		if (!file) {
+			return false;
+		}
+
+		if (message_header.msg_type == (int)ULogMessageType::ADD_LOGGED_MSG
+		    && !readAndAddSubscription(file, message_header.msg_size)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void
 Replay::run()
 {
@@ -766,6 +878,8 @@ Replay::run()
 		return;
 	}
 
+	indexDataSection(replay_file);
+
 	_speed_factor = 1.f;
 	const char *speedup = getenv("PX4_SIM_SPEED_FACTOR");
 
@@ -779,13 +893,7 @@ Replay::run()
 
 	PX4_INFO("Replay in progress...");
 
-	ulog_message_header_s message_header;
-	replay_file.seekg(_data_section_start);
-
-	//we know the next message must be an ADD_LOGGED_MSG
-	replay_file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-	if (!readAndAddSubscription(replay_file, message_header.msg_size)) {
+	if (!addSubscriptions(replay_file)) {
 		PX4_ERR("Failed to read subscription");
 		return;
 	}
@@ -1099,6 +1207,9 @@ The module is typically used together with uORB publisher rules, to specify whic
 The replay module will just publish all messages that are found in the log. It also applies the parameters from
 the log.
 
+On start the data section of the log is indexed, so that the next message of each topic is found without parsing
+the whole file. The index is cached next to the log file (`<log>.idx`) if the directory is writable.
+
 The replay procedure is documented on the [System-wide Replay](https://dev.px4.io/master/en/debug/system_wide_replay.html)
 page.
 )DESCR_STR");
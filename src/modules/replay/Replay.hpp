@@ -41,6 +41,7 @@
 
 #include "definitions.hpp"
 
+#include <lib/ulog/ULogIndex.hpp>
 #include <px4_platform_common/module.h>
 #include <uORB/topics/uORBTopics.hpp>
 #include <uORB/topics/ekf2_timestamps.h>
@@ -136,6 +137,7 @@ protected:
 
 		std::streampos next_read_pos;
 		uint64_t next_timestamp; ///< timestamp of the file
+		int64_t next_index = -1; ///< index of the message at next_read_pos if the file is indexed (-1: none yet)
 
 		CompatBase *compat = nullptr;
 
@@ -206,6 +208,12 @@ protected:
 	 */
 	bool nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id);
 
+	/**
+	 * nextDataMessage() for an indexed file: instead of parsing the file up to the next message,
+	 * it is looked up in the index.
+	 */
+	bool nextIndexedDataMessage(std::ifstream &file, Subscription &subscription, int msg_id);
+
 	virtual uint64_t getTimestampOffset()
 	{
 		//we update the timestamps from the file by a constant offset to match
@@ -231,6 +239,9 @@ private:
 
 	int64_t _read_until_file_position = 1ULL << 60; ///< read limit if log contains appended data
 
+	ulog::ULogIndex _index; ///< index of the data section (if valid, the file is not parsed sequentially)
+	size_t _next_non_data_message{0}; ///< next entry in _index.nonDataMessages() to handle
+
 	float _accumulated_delay{0.f};
 
 	bool readFileHeader(std::ifstream &file);
@@ -254,6 +265,17 @@ private:
 	 */
 	bool readDefinitionsAndApplyParams(std::ifstream &file);
 
+	/**
+	 * Index the data section (or load the cached index).
+	 */
+	void indexDataSection(std::ifstream &file);
+
+	/**
+	 * Add the subscriptions of the data section.
+	 * @return false on file error
+	 */
+	bool addSubscriptions(std::ifstream &file);
+
 	/**
 	 * Read and handle additional messages starting at current file position, while position < end_position.
 	 * This handles dropout and parameter update messages.
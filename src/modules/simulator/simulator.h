@@ -74,6 +74,7 @@
 #include <uORB/topics/vehicle_command.h>
 #include <uORB/topics/vehicle_command_ack.h>
 
+#include <pthread.h>
 #include <random>
 
 #include <v2.0/common/mavlink.h>
@@ -133,6 +134,7 @@ public:
 private:
 	Simulator() : ModuleParams(nullptr)
 	{
+		pthread_mutex_init(&_tx_mutex, nullptr);
 	}
 
 	~Simulator()
@@ -140,6 +142,7 @@ private:
 		// free perf counters
 		perf_free(_perf_sim_delay);
 		perf_free(_perf_sim_interval);
+		perf_free(_perf_sim_tx_errors);
 
 		for (size_t i = 0; i < sizeof(_dist_pubs) / sizeof(_dist_pubs[0]); i++) {
 			delete _dist_pubs[i];
@@ -151,6 +154,8 @@ private:
 			delete _sensor_gps_pubs[i];
 		}
 
+		pthread_mutex_destroy(&_tx_mutex);
+
 		_instance = nullptr;
 	}
 
@@ -188,6 +193,7 @@ private:
 
 	perf_counter_t _perf_sim_delay{perf_alloc(PC_ELAPSED, MODULE_NAME": network delay")};
 	perf_counter_t _perf_sim_interval{perf_alloc(PC_INTERVAL, MODULE_NAME": network interval")};
+	perf_counter_t _perf_sim_tx_errors{perf_alloc(PC_COUNT, MODULE_NAME": tx errors")};
 
 	// uORB publisher handlers
 	uORB::Publication<differential_pressure_s>	_differential_pressure_pub{ORB_ID(differential_pressure)};
@@ -236,7 +242,11 @@ private:
 	void send_controls();
 	void send_heartbeat();
 	void send_mavlink_message(const mavlink_message_t &aMsg);
-	void update_sensors(const hrt_abstime &time, const mavlink_hil_sensor_t &sensors);
+	void queue_mavlink_message(const mavlink_message_t &aMsg);
+	void flush_mavlink_messages();
+	void flush_mavlink_messages_locked();
+	void publish_hil_sensor_batch();
+	void update_sensors(const hrt_abstime &time, const mavlink_hil_sensor_t *sensors, uint8_t count);
 
 	static void *sending_trampoline(void *);
 
@@ -269,6 +279,11 @@ private:
 
 	vehicle_status_s _vehicle_status{};
 
+	// HIL_SENSOR messages received in one packet, published together as one FIFO sample
+	static constexpr uint8_t HIL_SENSOR_BATCH_MAX = sizeof(sensor_gyro_fifo_s::x) / sizeof(sensor_gyro_fifo_s::x[0]);
+	mavlink_hil_sensor_t _hil_sensor_batch[HIL_SENSOR_BATCH_MAX] {};
+	uint8_t _hil_sensor_batch_count{0};
+
 	bool _accel_blocked[ACCEL_COUNT_MAX] {};
 	bool _accel_stuck[ACCEL_COUNT_MAX] {};
 	sensor_accel_fifo_s _last_accel_fifo{};
@@ -298,6 +313,13 @@ private:
 
 	int _lockstep_component{-1};
 
+	// messages of a lockstep step, sent to the simulator as one packet
+	pthread_mutex_t _tx_mutex;
+	uint8_t _tx_buffer[4 * MAVLINK_MAX_PACKET_LEN] {};
+	size_t _tx_buffer_len{0};
+
+	hrt_abstime _last_heartbeat{0};
+
 	DEFINE_PARAMETERS(
 		(ParamInt<px4::params::MAV_TYPE>) _param_mav_type,
 		(ParamInt<px4::params::MAV_SYS_ID>) _param_mav_sys_id,
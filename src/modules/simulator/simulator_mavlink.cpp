@@ -72,7 +72,7 @@ static int openUart(const char *uart_name, int baud);
 #endif
 
 static int _fd;
-static unsigned char _buf[2048];
+static unsigned char _buf[4096];
 static sockaddr_in _srcaddr;
 static unsigned _addrlen = sizeof(_srcaddr);
 
@@ -191,27 +191,68 @@ void Simulator::send_controls()
 
 		PX4_DEBUG("sending controls t=%ld (%ld)", _actuator_outputs.timestamp, hil_act_control.time_usec);
 
-		send_mavlink_message(message);
+		queue_mavlink_message(message);
 	}
 }
 
-void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor_t &sensors)
+void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor_t *sensors, uint8_t count)
 {
+	// time is the sample time of the last message, the others are relative to it
+	const uint64_t time_usec_last = sensors[count - 1].time_usec;
+
+	auto sample_time = [&](uint8_t k) {
+		return (sensors[k].time_usec <= time_usec_last) ? time - (time_usec_last - sensors[k].time_usec) : time;
+	};
+
+	// latest message that updated each sensor
+	int accel_last = -1;
+	int gyro_last = -1;
+	int mag_last = -1;
+	int baro_last = -1;
+	int diff_press_last = -1;
+
+	for (uint8_t k = 0; k < count; k++) {
+		const uint32_t fields_updated = sensors[k].fields_updated;
+
+		if ((fields_updated & SensorSource::ACCEL) == SensorSource::ACCEL) {
+			accel_last = k;
+		}
+
+		if ((fields_updated & SensorSource::GYRO) == SensorSource::GYRO) {
+			gyro_last = k;
+		}
+
+		if ((fields_updated & SensorSource::MAG) == SensorSource::MAG) {
+			mag_last = k;
+		}
+
+		if ((fields_updated & SensorSource::BARO) == SensorSource::BARO) {
+			baro_last = k;
+		}
+
+		if ((fields_updated & SensorSource::DIFF_PRESS) == SensorSource::DIFF_PRESS) {
+			diff_press_last = k;
+		}
+	}
+
 	// temperature only updated with baro
-	if ((sensors.fields_updated & SensorSource::BARO) == SensorSource::BARO) {
-		if (PX4_ISFINITE(sensors.temperature)) {
-			_px4_mag_0.set_temperature(sensors.temperature);
-			_px4_mag_1.set_temperature(sensors.temperature);
+	if (baro_last >= 0) {
+		if (PX4_ISFINITE(sensors[baro_last].temperature)) {
+			_px4_mag_0.set_temperature(sensors[baro_last].temperature);
+			_px4_mag_1.set_temperature(sensors[baro_last].temperature);
 
-			_sensors_temperature = sensors.temperature;
+			_sensors_temperature = sensors[baro_last].temperature;
 		}
 	}
 
 	// accel
-	if ((sensors.fields_updated & SensorSource::ACCEL) == SensorSource::ACCEL) {
+	if (accel_last >= 0) {
+		const mavlink_hil_sensor_t &last = sensors[accel_last];
+		const hrt_abstime time_last = sample_time(accel_last);
+
 		for (int i = 0; i < ACCEL_COUNT_MAX; i++) {
 			if (i == 0) {
-				// accel 0 is simulated FIFO
+				// accel 0 is simulated FIFO, all samples of the batch
 				static constexpr float ACCEL_FIFO_SCALE = CONSTANTS_ONE_G / 2048.f;
 				static constexpr float ACCEL_FIFO_RANGE = 16.f * CONSTANTS_ONE_G;
 
@@ -224,34 +265,51 @@ void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor
 				} else if (!_accel_blocked[i]) {
 					_px4_accel[i].set_temperature(_sensors_temperature);
 
-					_last_accel_fifo.samples = 1;
-					_last_accel_fifo.dt = time - _last_accel_fifo.timestamp_sample;
-					_last_accel_fifo.timestamp_sample = time;
-					_last_accel_fifo.x[0] = sensors.xacc / ACCEL_FIFO_SCALE;
-					_last_accel_fifo.y[0] = sensors.yacc / ACCEL_FIFO_SCALE;
-					_last_accel_fifo.z[0] = sensors.zacc / ACCEL_FIFO_SCALE;
+					uint8_t n = 0;
+					hrt_abstime time_first = 0;
+
+					for (uint8_t k = 0; k < count; k++) {
+						if ((sensors[k].fields_updated & SensorSource::ACCEL) == SensorSource::ACCEL) {
+							if (n == 0) {
+								time_first = sample_time(k);
+							}
+
+							_last_accel_fifo.x[n] = sensors[k].xacc / ACCEL_FIFO_SCALE;
+							_last_accel_fifo.y[n] = sensors[k].yacc / ACCEL_FIFO_SCALE;
+							_last_accel_fifo.z[n] = sensors[k].zacc / ACCEL_FIFO_SCALE;
+							n++;
+						}
+					}
+
+					_last_accel_fifo.samples = n;
+					_last_accel_fifo.dt = (n > 1) ? (time_last - time_first) / (n - 1.f) : time_last - _last_accel_fifo.timestamp_sample;
+					_last_accel_fifo.timestamp_sample = time_last;
 
 					_px4_accel[i].updateFIFO(_last_accel_fifo);
 				}
 
 			} else {
+				// the other instances publish the latest sample
 				if (_accel_stuck[i]) {
-					_px4_accel[i].update(time, _last_accel[i](0), _last_accel[i](1), _last_accel[i](2));
+					_px4_accel[i].update(time_last, _last_accel[i](0), _last_accel[i](1), _last_accel[i](2));
 
 				} else if (!_accel_blocked[i]) {
 					_px4_accel[i].set_temperature(_sensors_temperature);
-					_px4_accel[i].update(time, sensors.xacc, sensors.yacc, sensors.zacc);
-					_last_accel[i] = matrix::Vector3f{sensors.xacc, sensors.yacc, sensors.zacc};
+					_px4_accel[i].update(time_last, last.xacc, last.yacc, last.zacc);
+					_last_accel[i] = matrix::Vector3f{last.xacc, last.yacc, last.zacc};
 				}
 			}
 		}
 	}
 
 	// gyro
-	if ((sensors.fields_updated & SensorSource::GYRO) == SensorSource::GYRO) {
+	if (gyro_last >= 0) {
+		const mavlink_hil_sensor_t &last = sensors[gyro_last];
+		const hrt_abstime time_last = sample_time(gyro_last);
+
 		for (int i = 0; i < GYRO_COUNT_MAX; i++) {
 			if (i == 0) {
-				// gyro 0 is simulated FIFO
+				// gyro 0 is simulated FIFO, all samples of the batch
 				static constexpr float GYRO_FIFO_SCALE = math::radians(2000.f / 32768.f);
 				static constexpr float GYRO_FIFO_RANGE = math::radians(2000.f);
 
@@ -264,67 +322,87 @@ void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor
 				} else if (!_gyro_blocked[i]) {
 					_px4_gyro[i].set_temperature(_sensors_temperature);
 
-					_last_gyro_fifo.samples = 1;
-					_last_gyro_fifo.dt = time - _last_gyro_fifo.timestamp_sample;
-					_last_gyro_fifo.timestamp_sample = time;
-					_last_gyro_fifo.x[0] = sensors.xgyro / GYRO_FIFO_SCALE;
-					_last_gyro_fifo.y[0] = sensors.ygyro / GYRO_FIFO_SCALE;
-					_last_gyro_fifo.z[0] = sensors.zgyro / GYRO_FIFO_SCALE;
+					uint8_t n = 0;
+					hrt_abstime time_first = 0;
+
+					for (uint8_t k = 0; k < count; k++) {
+						if ((sensors[k].fields_updated & SensorSource::GYRO) == SensorSource::GYRO) {
+							if (n == 0) {
+								time_first = sample_time(k);
+							}
+
+							_last_gyro_fifo.x[n] = sensors[k].xgyro / GYRO_FIFO_SCALE;
+							_last_gyro_fifo.y[n] = sensors[k].ygyro / GYRO_FIFO_SCALE;
+							_last_gyro_fifo.z[n] = sensors[k].zgyro / GYRO_FIFO_SCALE;
+							n++;
+						}
+					}
+
+					_last_gyro_fifo.samples = n;
+					_last_gyro_fifo.dt = (n > 1) ? (time_last - time_first) / (n - 1.f) : time_last - _last_gyro_fifo.timestamp_sample;
+					_last_gyro_fifo.timestamp_sample = time_last;
 
 					_px4_gyro[i].updateFIFO(_last_gyro_fifo);
 				}
 
 			} else {
+				// the other instances publish the latest sample
 				if (_gyro_stuck[i]) {
-					_px4_gyro[i].update(time, _last_gyro[i](0), _last_gyro[i](1), _last_gyro[i](2));
+					_px4_gyro[i].update(time_last, _last_gyro[i](0), _last_gyro[i](1), _last_gyro[i](2));
 
 				} else if (!_gyro_blocked[i]) {
 					_px4_gyro[i].set_temperature(_sensors_temperature);
-					_px4_gyro[i].update(time, sensors.xgyro, sensors.ygyro, sensors.zgyro);
-					_last_gyro[i] = matrix::Vector3f{sensors.xgyro, sensors.ygyro, sensors.zgyro};
+					_px4_gyro[i].update(time_last, last.xgyro, last.ygyro, last.zgyro);
+					_last_gyro[i] = matrix::Vector3f{last.xgyro, last.ygyro, last.zgyro};
 				}
 			}
 		}
 	}
 
 	// magnetometer
-	if ((sensors.fields_updated & SensorSource::MAG) == SensorSource::MAG && !_mag_blocked) {
+	if (mag_last >= 0 && !_mag_blocked) {
+		const mavlink_hil_sensor_t &mag = sensors[mag_last];
+		const hrt_abstime mag_time = sample_time(mag_last);
+
 		if (_mag_stuck) {
-			_px4_mag_0.update(time, _last_magx, _last_magy, _last_magz);
-			_px4_mag_1.update(time, _last_magx, _last_magy, _last_magz);
+			_px4_mag_0.update(mag_time, _last_magx, _last_magy, _last_magz);
+			_px4_mag_1.update(mag_time, _last_magx, _last_magy, _last_magz);
 
 		} else {
-			_px4_mag_0.update(time, sensors.xmag, sensors.ymag, sensors.zmag);
-			_px4_mag_1.update(time, sensors.xmag, sensors.ymag, sensors.zmag);
-			_last_magx = sensors.xmag;
-			_last_magy = sensors.ymag;
-			_last_magz = sensors.zmag;
+			_px4_mag_0.update(mag_time, mag.xmag, mag.ymag, mag.zmag);
+			_px4_mag_1.update(mag_time, mag.xmag, mag.ymag, mag.zmag);
+			_last_magx = mag.xmag;
+			_last_magy = mag.ymag;
+			_last_magz = mag.zmag;
 		}
 	}
 
 	// baro
-	if ((sensors.fields_updated & SensorSource::BARO) == SensorSource::BARO && !_baro_blocked) {
+	if (baro_last >= 0 && !_baro_blocked) {
+		const mavlink_hil_sensor_t &baro = sensors[baro_last];
+		const hrt_abstime baro_time = sample_time(baro_last);
+
 		if (_baro_stuck) {
-			_px4_baro_0.update(time, _px4_baro_0.get().pressure);
+			_px4_baro_0.update(baro_time, _px4_baro_0.get().pressure);
 			_px4_baro_0.set_temperature(_px4_baro_0.get().temperature);
-			_px4_baro_1.update(time, _px4_baro_1.get().pressure);
+			_px4_baro_1.update(baro_time, _px4_baro_1.get().pressure);
 			_px4_baro_1.set_temperature(_px4_baro_1.get().temperature);
 
 		} else {
-			_px4_baro_0.update(time, sensors.abs_pressure);
-			_px4_baro_0.set_temperature(sensors.temperature);
-			_px4_baro_1.update(time, sensors.abs_pressure);
-			_px4_baro_1.set_temperature(sensors.temperature);
+			_px4_baro_0.update(baro_time, baro.abs_pressure);
+			_px4_baro_0.set_temperature(baro.temperature);
+			_px4_baro_1.update(baro_time, baro.abs_pressure);
+			_px4_baro_1.set_temperature(baro.temperature);
 		}
 	}
 
 	// differential pressure
-	if ((sensors.fields_updated & SensorSource::DIFF_PRESS) == SensorSource::DIFF_PRESS && !_airspeed_blocked) {
+	if (diff_press_last >= 0 && !_airspeed_blocked) {
 		differential_pressure_s report{};
-		report.timestamp = time;
+		report.timestamp = sample_time(diff_press_last);
 		report.temperature = _sensors_temperature;
-		report.differential_pressure_filtered_pa = sensors.diff_pressure * 100.0f; // convert from millibar to bar;
-		report.differential_pressure_raw_pa = sensors.diff_pressure * 100.0f; // convert from millibar to bar;
+		report.differential_pressure_filtered_pa = sensors[diff_press_last].diff_pressure * 100.0f; // convert from millibar to bar;
+		report.differential_pressure_raw_pa = sensors[diff_press_last].diff_pressure * 100.0f; // convert from millibar to bar;
 
 		_differential_pressure_pub.publish(report);
 	}
@@ -332,6 +410,12 @@ void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor
 
 void Simulator::handle_message(const mavlink_message_t *msg)
 {
+	// the time advances with the HIL_SENSOR batch, publish it before
+	// any other message so that it is stamped with the current time
+	if (msg->msgid != MAVLINK_MSG_ID_HIL_SENSOR) {
+		publish_hil_sensor_batch();
+	}
+
 	switch (msg->msgid) {
 	case MAVLINK_MSG_ID_HIL_SENSOR:
 		handle_message_hil_sensor(msg);
@@ -450,12 +534,26 @@ void Simulator::handle_message_hil_gps(const mavlink_message_t *msg)
 
 void Simulator::handle_message_hil_sensor(const mavlink_message_t *msg)
 {
+	// collect the messages of one packet, published by publish_hil_sensor_batch()
+	mavlink_msg_hil_sensor_decode(msg, &_hil_sensor_batch[_hil_sensor_batch_count++]);
+
+	if (_hil_sensor_batch_count >= HIL_SENSOR_BATCH_MAX) {
+		publish_hil_sensor_batch();
+	}
+}
+
+void Simulator::publish_hil_sensor_batch()
+{
+	if (_hil_sensor_batch_count == 0) {
+		return;
+	}
+
 	if (_lockstep_component == -1) {
 		_lockstep_component = px4_lockstep_register_component();
 	}
 
-	mavlink_hil_sensor_t imu;
-	mavlink_msg_hil_sensor_decode(msg, &imu);
+	// advance the time to the last sample of the batch
+	const mavlink_hil_sensor_t &imu = _hil_sensor_batch[_hil_sensor_batch_count - 1];
 
 	struct timespec ts;
 	abstime_to_ts(&ts, imu.time_usec);
@@ -476,7 +574,8 @@ void Simulator::handle_message_hil_sensor(const mavlink_message_t *msg)
 	last_time = now_us;
 #endif
 
-	update_sensors(now_us, imu);
+	update_sensors(now_us, _hil_sensor_batch, _hil_sensor_batch_count);
+	_hil_sensor_batch_count = 0;
 
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
 
@@ -486,6 +585,7 @@ void Simulator::handle_message_hil_sensor(const mavlink_message_t *msg)
 
 #endif
 
+	// one lockstep step per batch
 	px4_lockstep_progress(_lockstep_component);
 }
 
@@ -653,23 +753,64 @@ void Simulator::handle_message_vision_position_estimate(const mavlink_message_t
 
 void Simulator::send_mavlink_message(const mavlink_message_t &aMsg)
 {
-	uint8_t  buf[MAVLINK_MAX_PACKET_LEN];
-	uint16_t bufLen = 0;
+	queue_mavlink_message(aMsg);
+	flush_mavlink_messages();
+}
 
-	bufLen = mavlink_msg_to_send_buffer(buf, &aMsg);
+void Simulator::queue_mavlink_message(const mavlink_message_t &aMsg)
+{
+	pthread_mutex_lock(&_tx_mutex);
+
+	if (_tx_buffer_len + MAVLINK_MAX_PACKET_LEN > sizeof(_tx_buffer)) {
+		flush_mavlink_messages_locked();
+	}
 
-	ssize_t len;
+	_tx_buffer_len += mavlink_msg_to_send_buffer(&_tx_buffer[_tx_buffer_len], &aMsg);
+
+	pthread_mutex_unlock(&_tx_mutex);
+}
+
+void Simulator::flush_mavlink_messages()
+{
+	pthread_mutex_lock(&_tx_mutex);
+	flush_mavlink_messages_locked();
+	pthread_mutex_unlock(&_tx_mutex);
+}
+
+void Simulator::flush_mavlink_messages_locked()
+{
+	if (_tx_buffer_len == 0) {
+		return;
+	}
 
 	if (_ip == InternetProtocol::UDP) {
-		len = ::sendto(_fd, buf, bufLen, 0, (struct sockaddr *)&_srcaddr, sizeof(_srcaddr));
+		// don't stall the lockstep cycle on a full socket buffer, a dropped packet is counted instead
+		if (::sendto(_fd, _tx_buffer, _tx_buffer_len, MSG_DONTWAIT, (struct sockaddr *)&_srcaddr, sizeof(_srcaddr)) <= 0) {
+			perf_count(_perf_sim_tx_errors);
+		}
 
 	} else {
-		len = ::send(_fd, buf, bufLen, 0);
-	}
+		// the stream needs to stay in sync, send everything
+		size_t sent = 0;
+
+		while (sent < _tx_buffer_len) {
+			const ssize_t len = ::send(_fd, &_tx_buffer[sent], _tx_buffer_len - sent, 0);
+
+			if (len <= 0) {
+				if (len < 0 && errno == EINTR) {
+					continue;
+				}
 
-	if (len <= 0) {
-		PX4_WARN("Failed sending mavlink message: %s", strerror(errno));
+				PX4_WARN("Failed sending mavlink message: %s", strerror(errno));
+				perf_count(_perf_sim_tx_errors);
+				break;
+			}
+
+			sent += len;
+		}
 	}
+
+	_tx_buffer_len = 0;
 }
 
 void *Simulator::sending_trampoline(void * /*unused*/)
@@ -695,6 +836,7 @@ void Simulator::send()
 	// get everything rolling.
 	// Without this, we get stuck at px4_poll which waits for a time update.
 	send_heartbeat();
+	flush_mavlink_messages();
 
 	px4_pollfd_struct_t fds_actuator_outputs[1] = {};
 	fds_actuator_outputs[0].fd = _actuator_outputs_sub;
@@ -717,14 +859,23 @@ void Simulator::send()
 
 		if (fds_actuator_outputs[0].revents & POLLIN) {
 			// Got new data to read, update all topics.
-			parameters_update(false);
-			check_failure_injections();
 			_vehicle_status_sub.update(&_vehicle_status);
 
 			// Wait for other modules, such as logger or ekf2
 			px4_lockstep_wait_for_components();
 
+			// everything due in this step goes out as one packet
 			send_controls();
+
+			if (hrt_elapsed_time(&_last_heartbeat) >= 1_s) {
+				send_heartbeat();
+			}
+
+			flush_mavlink_messages();
+
+			// the simulator can continue, the rest is not on the lockstep round trip
+			parameters_update(false);
+			check_failure_injections();
 		}
 	}
 
@@ -749,7 +900,9 @@ void Simulator::send_heartbeat()
 	hb.autopilot = 12;
 	hb.base_mode |= (_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_ARMED) ? 128 : 0;
 	mavlink_msg_heartbeat_encode(_param_mav_sys_id.get(), _param_mav_comp_id.get(), &message, &hb);
-	send_mavlink_message(message);
+	queue_mavlink_message(message);
+
+	_last_heartbeat = hrt_absolute_time();
 }
 
 void Simulator::run()
@@ -919,6 +1072,9 @@ void Simulator::run()
 						handle_message(&msg);
 					}
 				}
+
+				// all consecutive HIL_SENSOR messages of a packet are one FIFO sample
+				publish_hil_sensor_batch();
 			}
 		}
 
@@ -265,16 +265,8 @@ bool TemperatureCompensation::calc_thermal_offsets_1D(SensorCalData1D &coef, flo
 	}
 
 	// calulate the offset
-	float temp_var = delta_temp;
-	offset = coef.x0 + coef.x1 * temp_var;
-	temp_var *= delta_temp;
-	offset += coef.x2 * temp_var;
-	temp_var *= delta_temp;
-	offset += coef.x3 * temp_var;
-	temp_var *= delta_temp;
-	offset += coef.x4 * temp_var;
-	temp_var *= delta_temp;
-	offset += coef.x5 * temp_var;
+	offset = coef.x0 + delta_temp * (coef.x1 + delta_temp * (coef.x2 + delta_temp * (coef.x3 + delta_temp *
+			 (coef.x4 + delta_temp * coef.x5))));
 
 	return ret;
 
@@ -301,11 +293,8 @@ bool TemperatureCompensation::calc_thermal_offsets_3D(const SensorCalData3D &coe
 	}
 
 	// calulate the offsets
-	float delta_temp_2 = delta_temp * delta_temp;
-	float delta_temp_3 = delta_temp_2 * delta_temp;
-
 	for (uint8_t i = 0; i < 3; i++) {
-		offset[i] = coef.x0[i] + coef.x1[i] * delta_temp + coef.x2[i] * delta_temp_2 + coef.x3[i] * delta_temp_3;
+		offset[i] = coef.x0[i] + delta_temp * (coef.x1[i] + delta_temp * (coef.x2[i] + delta_temp * coef.x3[i]));
 	}
 
 	return ret;
@@ -366,16 +355,17 @@ int TemperatureCompensation::update_offsets_gyro(int topic_instance, float tempe
 		return -1;
 	}
 
+	// Only evaluate the polynomial again once the temperature has changed enough to warrant a new publication
+	if (fabsf(temperature - _gyro_data.last_temperature[topic_instance]) <= TEMPERATURE_CHANGE_THRESHOLD) {
+		return 1;
+	}
+
+	_gyro_data.last_temperature[topic_instance] = temperature;
+
 	// Calculate and update the offsets
 	calc_thermal_offsets_3D(_parameters.gyro_cal_data[mapping], temperature, offsets);
 
-	// Check if temperature delta is large enough to warrant a new publication
-	if (fabsf(temperature - _gyro_data.last_temperature[topic_instance]) > 1.0f) {
-		_gyro_data.last_temperature[topic_instance] = temperature;
-		return 2;
-	}
-
-	return 1;
+	return 2;
 }
 
 int TemperatureCompensation::update_offsets_accel(int topic_instance, float temperature, float *offsets)
@@ -392,16 +382,17 @@ int TemperatureCompensation::update_offsets_accel(int topic_instance, float temp
 		return -1;
 	}
 
+	// Only evaluate the polynomial again once the temperature has changed enough to warrant a new publication
+	if (fabsf(temperature - _accel_data.last_temperature[topic_instance]) <= TEMPERATURE_CHANGE_THRESHOLD) {
+		return 1;
+	}
+
+	_accel_data.last_temperature[topic_instance] = temperature;
+
 	// Calculate and update the offsets
 	calc_thermal_offsets_3D(_parameters.accel_cal_data[mapping], temperature, offsets);
 
-	// Check if temperature delta is large enough to warrant a new publication
-	if (fabsf(temperature - _accel_data.last_temperature[topic_instance]) > 1.0f) {
-		_accel_data.last_temperature[topic_instance] = temperature;
-		return 2;
-	}
-
-	return 1;
+	return 2;
 }
 
 int TemperatureCompensation::update_offsets_baro(int topic_instance, float temperature, float *offsets)
@@ -418,16 +409,17 @@ int TemperatureCompensation::update_offsets_baro(int topic_instance, float tempe
 		return -1;
 	}
 
+	// Only evaluate the polynomial again once the temperature has changed enough to warrant a new publication
+	if (fabsf(temperature - _baro_data.last_temperature[topic_instance]) <= TEMPERATURE_CHANGE_THRESHOLD) {
+		return 1;
+	}
+
+	_baro_data.last_temperature[topic_instance] = temperature;
+
 	// Calculate and update the offsets
 	calc_thermal_offsets_1D(_parameters.baro_cal_data[mapping], temperature, *offsets);
 
-	// Check if temperature delta is large enough to warrant a new publication
-	if (fabsf(temperature - _baro_data.last_temperature[topic_instance]) > 1.0f) {
-		_baro_data.last_temperature[topic_instance] = temperature;
-		return 2;
-	}
-
-	return 1;
+	return 2;
 }
 
 void TemperatureCompensation::print_status()
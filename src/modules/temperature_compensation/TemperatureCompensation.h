@@ -86,7 +86,8 @@ public:
 	 * @param offsets returns offsets that were applied (length = 3, except for baro), depending on return value
 	 * @return -1: error: correction enabled, but no sensor mapping set (@see set_sendor_id_gyro)
 	 *         0: no changes (correction not enabled),
-	 *         1: corrections applied but no changes to offsets,
+	 *         1: corrections applied but no changes to offsets, the temperature changed less than
+	 *            TEMPERATURE_CHANGE_THRESHOLD since the last update and offsets is left untouched
 	 *         2: corrections applied and offsets updated
 	 */
 	int update_offsets_gyro(int topic_instance, float temperature, float *offsets);
@@ -97,6 +98,9 @@ public:
 	void print_status();
 private:
 
+	/** [deg C] change of the temperature after which the offsets are evaluated and published again */
+	static constexpr float TEMPERATURE_CHANGE_THRESHOLD = 1.0f;
+
 	/* Struct containing parameters used by the single axis 5th order temperature compensation algorithm
 
 	Input:
@@ -210,7 +210,13 @@ param_main(int argc, char *argv[])
 				return do_load(argv[2]);
 
 			} else {
-				return do_load(param_get_default_file());
+				int ret = do_load(param_get_default_file());
+
+				if (ret == 0) {
+					param_import_journal();
+				}
+
+				return ret;
 			}
 		}
 
@@ -219,7 +225,13 @@ param_main(int argc, char *argv[])
 				return do_import(argv[2]);
 
 			} else {
-				return do_import();
+				int ret = do_import();
+
+				if (ret == 0) {
+					param_import_journal();
+				}
+
+				return ret;
 			}
 		}
 
@@ -51,6 +51,7 @@ static void print_usage(void)
 	PRINT_MODULE_USAGE_NAME_SIMPLE("perf", "command");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("reset", "Reset all counters");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("latency", "Print HRT timer latency histogram");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("histogram", "Print the latency histograms of all elapsed and interval counters");
 
 	PRINT_MODULE_USAGE_PARAM_COMMENT("Prints all performance counters if no arguments given");
 }
@@ -67,6 +68,11 @@ int perf_main(int argc, char *argv[])
 			perf_print_latency(1 /* stdout */);
 			fflush(stdout);
 			return 0;
+
+		} else if (strcmp(argv[1], "histogram") == 0) {
+			perf_print_all_histograms(1 /* stdout */);
+			fflush(stdout);
+			return 0;
 		}
 
 		print_usage();
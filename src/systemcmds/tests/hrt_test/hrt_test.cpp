@@ -48,6 +48,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <cstring>
+#include <inttypes.h>
 
 px4::AppState HRTTest::appState;
 
@@ -91,5 +92,94 @@ int HRTTest::main()
 	hrt_cancel(&t1);
 	PX4_INFO("HRT_CALL + %d\n", hrt_called(&t1));
 
-	return 0;
+	return jitter_benchmark(200, 5);
+}
+
+struct JitterCall {
+	struct hrt_call call{};
+	hrt_abstime first_deadline;
+	hrt_abstime interval;
+	uint32_t count;
+	hrt_abstime max_latency;
+	hrt_abstime total_latency;
+	uint32_t early;
+};
+
+static void jitter_callout(void *arg)
+{
+	JitterCall *c = (JitterCall *)arg;
+	const hrt_abstime now = hrt_absolute_time();
+
+	// periodic calls are timed between scheduled call times, so this is where it should be called
+	const hrt_abstime deadline = c->first_deadline + c->count * c->interval;
+	c->count++;
+
+	if (now < deadline) {
+		c->early++;
+		return;
+	}
+
+	const hrt_abstime latency = now - deadline;
+	c->total_latency += latency;
+
+	if (latency > c->max_latency) {
+		c->max_latency = latency;
+	}
+}
+
+int HRTTest::jitter_benchmark(int num_calls, unsigned duration_s)
+{
+	JitterCall *calls = new JitterCall[num_calls] {};
+
+	PX4_INFO("jitter benchmark: %i callouts, %u s", num_calls, duration_s);
+
+	const hrt_abstime start = hrt_absolute_time() + 10000;
+
+	for (int i = 0; i < num_calls; i++) {
+		// intervals between 250 us (4 kHz) and 20 ms, not multiples of each other
+		calls[i].interval = 250 + (i * 997) % 19750;
+		calls[i].first_deadline = start;
+		hrt_call_every(&calls[i].call, start - hrt_absolute_time(), calls[i].interval, jitter_callout, &calls[i]);
+	}
+
+	px4_sleep(duration_s);
+
+	for (int i = 0; i < num_calls; i++) {
+		hrt_cancel(&calls[i].call);
+	}
+
+	const hrt_abstime end = hrt_absolute_time();
+
+	uint64_t total_count = 0;
+	uint64_t total_latency = 0;
+	hrt_abstime max_latency = 0;
+	uint32_t early = 0;
+	uint32_t max_missed = 0;
+
+	for (int i = 0; i < num_calls; i++) {
+		total_count += calls[i].count;
+		total_latency += calls[i].total_latency;
+		early += calls[i].early;
+
+		if (calls[i].max_latency > max_latency) {
+			max_latency = calls[i].max_latency;
+		}
+
+		// drift: compare with the number of calls there should have been
+		const uint32_t expected = (end - start) / calls[i].interval + 1;
+		const uint32_t missed = expected > calls[i].count ? expected - calls[i].count : 0;
+
+		if (missed > max_missed) {
+			max_missed = missed;
+		}
+	}
+
+	PX4_INFO("calls: %" PRIu64 ", early: %" PRIu32 ", max missed calls per callout: %" PRIu32,
+		 total_count, early, max_missed);
+	PX4_INFO("latency: mean %.1f us, max %" PRIu64 " us",
+		 total_count > 0 ? (double)total_latency / (double)total_count : 0.0, max_latency);
+
+	delete[] calls;
+
+	return (early == 0 && max_missed <= 1) ? 0 : -1;
 }
@@ -50,5 +50,11 @@ public:
 
 	int main();
 
+	/**
+	 * Schedule num_calls periodic callouts with different intervals and report
+	 * how late they are called compared to their ideal (drift free) schedule.
+	 */
+	int jitter_benchmark(int num_calls, unsigned duration_s);
+
 	static px4::AppState appState; /* track requests to terminate app */
 };
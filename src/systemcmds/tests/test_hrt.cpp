@@ -44,7 +44,7 @@
 
 int test_hrt(int argc, char *argv[])
 {
-	struct hrt_call call;
+	struct hrt_call call{};
 	hrt_abstime prev, now;
 	int i;
 	struct timeval tv1, tv2;
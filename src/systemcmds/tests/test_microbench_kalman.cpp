@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ *  Copyright (C) 2021 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file test_microbench_kalman.cpp
+ * Microbenchmarks of the Kalman filter toolkit against dense matrix implementations,
+ * for a 10-state filter (the size of local_position_estimator).
+ */
+
+#include <unit_test.h>
+
+#include <time.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <perf/perf_counter.h>
+#include <px4_platform_common/px4_config.h>
+#include <px4_platform_common/micro_hal.h>
+
+#include <lib/kalman_filter/KalmanFilter.hpp>
+#include <matrix/math.hpp>
+
+namespace MicroBenchKalman
+{
+
+#ifdef __PX4_NUTTX
+#include <nuttx/irq.h>
+static irqstate_t flags;
+#endif
+
+void lock()
+{
+#ifdef __PX4_NUTTX
+	flags = px4_enter_critical_section();
+#endif
+}
+
+void unlock()
+{
+#ifdef __PX4_NUTTX
+	px4_leave_critical_section(flags);
+#endif
+}
+
+#define PERF(name, op, count) do { \
+		px4_usleep(1000); \
+		reset(); \
+		perf_counter_t p = perf_alloc(PC_ELAPSED, name); \
+		for (int i = 0; i < count; i++) { \
+			px4_usleep(1); \
+			lock(); \
+			perf_begin(p); \
+			op; \
+			perf_end(p); \
+			unlock(); \
+			reset(); \
+		} \
+		perf_print_counter(p); \
+		perf_free(p); \
+	} while (0)
+
+static constexpr size_t N = 10;
+
+class MicroBenchKalman : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+private:
+	bool time_scalar_update();
+	bool time_vector_update();
+	bool time_predict();
+
+	void reset();
+
+	void denseScalarUpdate();
+	void denseVectorUpdate();
+	void densePredict();
+
+	// dense reference filter, as implemented in the estimators today
+	matrix::Vector<float, N> x;
+	matrix::SquareMatrix<float, N> P;
+	matrix::SquareMatrix<float, N> F;
+	matrix::SquareMatrix<float, N> Q;
+	matrix::Matrix<float, 1, N> H1;
+	matrix::Matrix<float, 3, N> H3;
+	matrix::SquareMatrix<float, 3> R3;
+	matrix::Vector<float, 3> y3;
+	float y1{0.f};
+
+	kalman::KalmanFilter<float, N> kf;
+	kalman::KalmanFilter<float, N, kalman::CovarianceUpdate::Joseph> kf_joseph;
+	kalman::SymmetricMatrix<float, N> Q_packed;
+	matrix::Vector<float, N> H1_row;
+	kalman::Innovation<float> results[3];
+};
+
+bool MicroBenchKalman::run_tests()
+{
+	ut_run_test(time_scalar_update);
+	ut_run_test(time_vector_update);
+	ut_run_test(time_predict);
+
+	return (_tests_failed == 0);
+}
+
+template<typename T>
+T random(T min, T max)
+{
+	const T scale = rand() / (T) RAND_MAX; /* [0, 1.0] */
+	return min + scale * (max - min);      /* [min, max] */
+}
+
+void MicroBenchKalman::reset()
+{
+	srand(time(nullptr));
+
+	// random positive definite covariance
+	matrix::SquareMatrix<float, N> A;
+
+	for (size_t i = 0; i < N; i++) {
+		x(i) = random(-10.f, 10.f);
+
+		for (size_t j = 0; j < N; j++) {
+			A(i, j) = random(-1.f, 1.f);
+		}
+	}
+
+	P = A * A.transpose();
+
+	for (size_t i = 0; i < N; i++) {
+		P(i, i) += 0.1f;
+	}
+
+	// position, velocity, bias structure: sparse transition
+	F.setIdentity();
+	F(0, 3) = F(1, 4) = F(2, 5) = 0.004f;
+	F(3, 6) = F(4, 7) = F(5, 8) = -0.004f;
+
+	Q.setZero();
+	Q_packed.setZero();
+
+	for (size_t i = 0; i < N; i++) {
+		Q(i, i) = 0.01f;
+		Q_packed(i, i) = 0.01f;
+	}
+
+	// measurement of state 2, and of states 0 to 2
+	H1.setZero();
+	H1(0, 2) = 1.f;
+	H1_row.setZero();
+	H1_row(2) = 1.f;
+	H3.setZero();
+	H3(0, 0) = H3(1, 1) = H3(2, 2) = 1.f;
+	R3.setZero();
+	R3(0, 0) = R3(1, 1) = R3(2, 2) = 0.5f;
+	y1 = random(-1.f, 1.f);
+
+	for (size_t i = 0; i < 3; i++) {
+		y3(i) = random(-1.f, 1.f);
+	}
+
+	kf.init(x, kalman::SymmetricMatrix<float, N>(P));
+	kf_joseph.init(x, kalman::SymmetricMatrix<float, N>(P));
+}
+
+void MicroBenchKalman::denseScalarUpdate()
+{
+	const float S = (H1 * P * H1.transpose())(0, 0) + 0.5f;
+	const matrix::Matrix<float, N, 1> K = P * H1.transpose() / S;
+	x += K * (y1 - (H1 * x)(0, 0));
+	P = (matrix::eye<float, N>() - K * H1) * P;
+}
+
+void MicroBenchKalman::denseVectorUpdate()
+{
+	const matrix::SquareMatrix<float, 3> S_I = matrix::inv<float, 3>(H3 * P * H3.transpose() + R3);
+	const matrix::Matrix<float, N, 3> K = P * H3.transpose() * S_I;
+	x += K * (y3 - H3 * x);
+	P -= K * H3 * P;
+}
+
+void MicroBenchKalman::densePredict()
+{
+	x = F * x;
+	P = F * P * F.transpose() + Q;
+}
+
+bool MicroBenchKalman::time_scalar_update()
+{
+	PERF("kalman 10-state scalar update, dense matrix", denseScalarUpdate(), 1000);
+	PERF("kalman 10-state scalar update, packed dense row", kf.fuse(H1_row, y1, 0.5f), 1000);
+	PERF("kalman 10-state scalar update, packed direct", kf.fuseDirect<2>(y1, 0.5f), 1000);
+	PERF("kalman 10-state scalar update, packed sparse", (kf.fuseSparse<2, 8>({1.f, -1.f}, y1, 0.5f)), 1000);
+	PERF("kalman 10-state scalar update, packed direct Joseph", kf_joseph.fuseDirect<2>(y1, 0.5f), 1000);
+	return true;
+}
+
+bool MicroBenchKalman::time_vector_update()
+{
+	PERF("kalman 10-state 3-axis update, dense matrix inverse", denseVectorUpdate(), 1000);
+	PERF("kalman 10-state 3-axis update, sequential direct", (kf.fuseDirectSequential<0, 1, 2>({y3(0), y3(1), y3(2)}, {0.5f, 0.5f, 0.5f}, 0.f, results)), 1000);
+	return true;
+}
+
+bool MicroBenchKalman::time_predict()
+{
+	PERF("kalman 10-state predict, dense matrix", densePredict(), 1000);
+	PERF("kalman 10-state predict, packed sparse transition", kf.predict(F, Q_packed), 1000);
+	return true;
+}
+
+ut_declare_test_c(test_microbench_kalman, MicroBenchKalman)
+
+} // namespace MicroBenchKalman
@@ -98,6 +98,7 @@ const struct {
 	{"matrix",		test_matrix,		0},
 	{"microbench_atomic",	test_microbench_atomic,	0},
 	{"microbench_hrt",	test_microbench_hrt,	0},
+	{"microbench_kalman",	test_microbench_kalman,	0},
 	{"microbench_math",	test_microbench_math,	0},
 	{"microbench_matrix",	test_microbench_matrix,	0},
 	{"microbench_uorb",	test_microbench_uorb,	0},
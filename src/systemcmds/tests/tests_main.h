@@ -66,6 +66,7 @@ extern int test_mathlib(int argc, char *argv[]);
 extern int test_matrix(int argc, char *argv[]);
 extern int test_microbench_atomic(int argc, char *argv[]);
 extern int test_microbench_hrt(int argc, char *argv[]);
+extern int test_microbench_kalman(int argc, char *argv[]);
 extern int test_microbench_math(int argc, char *argv[]);
 extern int test_microbench_matrix(int argc, char *argv[]);
 extern int test_microbench_uorb(int argc, char *argv[]);
@@ -45,6 +45,15 @@ extern "C" {
 int
 work_queue_main(int argc, char *argv[])
 {
+	if (argc == 3 && !strcmp(argv[1], "profile")) {
+		if (!strcmp(argv[2], "start")) {
+			return px4::WorkQueueManagerProfile(true);
+
+		} else if (!strcmp(argv[2], "stop")) {
+			return px4::WorkQueueManagerProfile(false);
+		}
+	}
+
 	if (argc != 2) {
 		usage();
 		return 1;
@@ -78,9 +87,16 @@ usage()
 
 Command-line tool to show work queue status.
 
+On Linux, the work queue threads can be profiled with perf_event counters (CPU cycles, instructions,
+cache misses and context switches), which are then shown per work item run in the status output, in `top`,
+and published as `work_item_perf` topic by load_mon.
+Profiling needs access to perf events (see `/proc/sys/kernel/perf_event_paranoid`).
+
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("work_queue", "system");
 	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("profile", "Enable/disable perf_event profiling (Linux only)");
+	PRINT_MODULE_USAGE_ARG("start|stop", "", false);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 }